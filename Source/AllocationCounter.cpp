@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.cpp
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Heap allocation counter implementation (replaced global operator new/delete).
+
+  ==============================================================================
+*/
+
+#include "AllocationCounter.h"
+#include <juce_core/juce_core.h>
+
+#if EXPLICITLY_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Constant-initialised: safe to touch from operator new before main() and on any thread
+    thread_local int realtimeDepth = 0;
+    thread_local uint64_t threadHeapCalls = 0;          // This thread's calls inside a scope
+    std::atomic<uint64_t> realtimeHeapCalls { 0 };      // Every thread's, for reporting only
+    
+    inline void countHeapCall()
+    {
+        if (realtimeDepth > 0)
+            ++threadHeapCalls;
+    }
+    
+    void* countedAllocate(std::size_t size)
+    {
+        countHeapCall();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+    
+    void countedFree(void* pointer) noexcept
+    {
+        if (pointer == nullptr)
+            return;
+        
+        countHeapCall();
+        std::free(pointer);
+    }
+}
+
+//==============================================================================
+// The nothrow forms and the aligned forms keep their library definitions
+// (the nothrow ones forward to these)
+void* operator new(std::size_t size)
+{
+    if (void* pointer = countedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* pointer = countedAllocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer) noexcept { countedFree(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { countedFree(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { countedFree(pointer); }
+
+//==============================================================================
+AllocationCounter::RealtimeScope::RealtimeScope()
+    : heapCallsAtEntry(threadHeapCalls)
+{
+    ++realtimeDepth;
+}
+
+AllocationCounter::RealtimeScope::~RealtimeScope()
+{
+    const uint64_t scopeHeapCalls = threadHeapCalls - heapCallsAtEntry;
+    
+    // The outermost scope reports (an enclosing scope's count includes the nested ones)
+    if (--realtimeDepth == 0 && scopeHeapCalls > 0)
+        realtimeHeapCalls.fetch_add(scopeHeapCalls, std::memory_order_relaxed);
+    
+    // Something in the scope allocated or freed: the audio thread can block on the heap lock
+    jassert(scopeHeapCalls == 0);
+}
+
+uint64_t AllocationCounter::getRealtimeHeapCalls()
+{
+    return realtimeHeapCalls.load(std::memory_order_relaxed);
+}
+
+#else
+
+uint64_t AllocationCounter::getRealtimeHeapCalls()
+{
+    return 0;
+}
+
+#endif
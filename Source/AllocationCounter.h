@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.h
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Heap allocation counter for the real-time audio thread (debug builds).
+
+    Features:
+    - Replaces the global operator new/delete when EXPLICITLY_COUNT_ALLOCATIONS
+      is set (CMake sets it for Debug builds of the app)
+    - Counts only on a thread inside a RealtimeScope, so the Whisper thread,
+      the decode workers and the message thread are not affected
+    - The scope asserts that the code it covered made no heap call
+    - Release builds get an empty scope and no replaced operators
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#ifndef EXPLICITLY_COUNT_ALLOCATIONS
+ #define EXPLICITLY_COUNT_ALLOCATIONS 0
+#endif
+
+/**
+    Counts heap allocations and frees made on real-time threads.
+    
+    Usage (audio callback):
+        AllocationCounter::RealtimeScope realtimeScope;     // jassert on exit if the block allocated
+        ...
+        
+        // After the stream stopped
+        log(AllocationCounter::getRealtimeHeapCalls());
+    
+    Thread Safety:
+    - Each thread counts into a thread_local, so a scope only sees its own
+      thread's heap calls; scopes add their count to one relaxed atomic on
+      exit, for getRealtimeHeapCalls()
+    - Aligned (over-aligned new) allocations are not counted
+*/
+class AllocationCounter
+{
+public:
+    static constexpr bool isEnabled() { return EXPLICITLY_COUNT_ALLOCATIONS != 0; }
+    
+    /**
+        Allocations plus frees made inside a RealtimeScope since start-up
+        (always 0 when counting is compiled out).
+    */
+    static uint64_t getRealtimeHeapCalls();
+
+#if EXPLICITLY_COUNT_ALLOCATIONS
+    class RealtimeScope
+    {
+    public:
+        RealtimeScope();
+        ~RealtimeScope();
+        
+        RealtimeScope(const RealtimeScope&) = delete;
+        RealtimeScope& operator=(const RealtimeScope&) = delete;
+    
+    private:
+        uint64_t heapCallsAtEntry;
+    };
+#else
+    class RealtimeScope
+    {
+    public:
+        RealtimeScope() {}
+    };
+#endif
+};
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    AsrBackend.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Speech recognizer interface for the keyword-spotting front-end.
+
+    Features:
+    - One interface for streaming recognizers (Vosk: a partial hypothesis of
+      the current utterance after every block of audio) and windowed ones
+      (Whisper: a final hypothesis per decoded window)
+    - Audio in: 16kHz mono float, in capture order, no gaps
+    - Words out: start/end in seconds of audio fed since prepare()/reset()
+    - A backend owns no thread; KeywordSpotter drives it
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <string>
+#include <vector>
+
+/**
+    A recognizer KeywordSpotter can feed.
+    
+    Usage (one thread):
+        backend->prepare(16000);
+        backend->acceptAudio(samples, numSamples);
+        
+        AsrBackend::Hypothesis hypothesis;
+        while (backend->popHypothesis(hypothesis))
+            ...                                     // hypothesis.words, hypothesis.isFinal
+    
+    Thread Safety:
+    - Not thread safe; every call comes from the thread that feeds it
+*/
+class AsrBackend
+{
+public:
+    struct Word
+    {
+        std::string text;
+        double start = 0.0;             // Seconds of audio fed since prepare()/reset()
+        double end = 0.0;
+        float confidence = 0.5f;        // 0.0-1.0 (0.5 if the recognizer does not say)
+    };
+    
+    /**
+        Words of one utterance. A partial hypothesis is revised by the next
+        one (same utterance, words may change); a final one is never revised.
+    */
+    struct Hypothesis
+    {
+        std::vector<Word> words;
+        bool isFinal = false;
+    };
+    
+    virtual ~AsrBackend() = default;
+    
+    /**
+        Short name for logs ("vosk", "whisper tiny.en").
+    */
+    virtual std::string getName() const = 0;
+    
+    /**
+        true if hypotheses arrive while the utterance is still being heard
+        (partials), false if words only arrive per finished window.
+    */
+    virtual bool isStreaming() const = 0;
+    
+    /**
+        Load what the recognizer needs and start a new stream at time 0.
+        
+        @param sampleRate   Rate of the audio passed to acceptAudio()
+        @return             false if the recognizer is unavailable (see getLastError())
+    */
+    virtual bool prepare(int sampleRate) = 0;
+    
+    /**
+        Feed the next samples of the stream.
+    */
+    virtual void acceptAudio(const float* samples, int numSamples) = 0;
+    
+    /**
+        Take the oldest hypothesis produced since the last call.
+        
+        @return     false if there is none
+    */
+    virtual bool popHypothesis(Hypothesis& hypothesis) = 0;
+    
+    /**
+        Drop the current utterance and restart the stream clock at 0 (after a gap).
+    */
+    virtual void reset() = 0;
+    
+    virtual juce::String getLastError() const = 0;
+};
@@ -0,0 +1,353 @@
+/*
+  ==============================================================================
+
+    AsyncLogger.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Background formatting and sinks for the real-time log channels.
+
+  ==============================================================================
+*/
+
+#include "AsyncLogger.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+    constexpr size_t TEXT_CAPACITY = sizeof(DebugMessage::text);
+    constexpr int WAKE_INTERVAL_MS = 50;
+    
+    int64_t steadyNowMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    bool isOneOf(char c, const char* set)
+    {
+        return c != '\0' && std::strchr(set, c) != nullptr;
+    }
+}
+
+//==============================================================================
+bool AsyncLogger::Channel::isEnabled(Level level) const
+{
+    return level != Level::Off && (int)level >= owner->minimumLevel.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogger::Channel::admit(Level level, int64_t nowMicros)
+{
+    const double rate = ratePerSecond.load(std::memory_order_relaxed);
+    if (rate <= 0.0 || level == Level::Error)
+        return true;
+    
+    // Token bucket: refill by elapsed time, one token per line
+    const double capacity = std::max(1.0, burst.load(std::memory_order_relaxed));
+    if (lastRefillMicros == 0)
+        tokens = capacity;
+    else
+        tokens = std::min(capacity, tokens + (double)(nowMicros - lastRefillMicros) * 1.0e-6 * rate);
+    lastRefillMicros = nowMicros;
+    
+    if (tokens < 1.0)
+    {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    
+    tokens -= 1.0;
+    return true;
+}
+
+void AsyncLogger::Channel::publish(const Record& record)
+{
+    if (queue.push(record))
+        owner->wake.notify();
+    else
+        dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncLogger::Channel::packText(Record& record, const char* text, size_t length)
+{
+    Arg& arg = record.args[record.numArgs++];
+    arg.type = Arg::Type::Text;
+    
+    // Long strings are cut where the record's buffer ends
+    length = std::min(length, TEXT_CAPACITY - record.textUsed);
+    std::memcpy(record.message.text + record.textUsed, text, length);
+    arg.text.offset = record.textUsed;
+    arg.text.length = (uint16_t)length;
+    record.textUsed = (uint16_t)(record.textUsed + length);
+}
+
+//==============================================================================
+AsyncLogger::AsyncLogger()
+{
+    for (int i = 0; i < NUM_PRODUCERS; ++i)
+    {
+        channels[(size_t)i].reset(new Channel());
+        channels[(size_t)i]->owner = this;
+        channels[(size_t)i]->producer = (Producer)i;
+    }
+    
+    batch.reserve(QUEUE_CAPACITY * NUM_PRODUCERS);
+    startMicros = steadyNowMicros();
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+    
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    if (logFile.is_open())
+        logFile.close();
+}
+
+void AsyncLogger::start()
+{
+    if (running.load())
+        return;
+    
+    stopRequested.store(false);
+    running.store(true);
+    thread = std::thread(&AsyncLogger::threadFunction, this);
+}
+
+void AsyncLogger::stop()
+{
+    if (!running.load())
+        return;
+    
+    stopRequested.store(true);
+    wake.notify();
+    
+    if (thread.joinable())
+        thread.join();
+    
+    running.store(false);
+}
+
+void AsyncLogger::setRateLimit(Producer producer, double messagesPerSecond, double burstSize)
+{
+    Channel& channel = getChannel(producer);
+    channel.burst.store(std::max(1.0, burstSize), std::memory_order_relaxed);
+    channel.ratePerSecond.store(std::max(0.0, messagesPerSecond), std::memory_order_relaxed);
+}
+
+bool AsyncLogger::setLogFile(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    
+    if (logFile.is_open())
+        logFile.close();
+    
+    if (path.empty())
+        return true;
+    
+    logFile.open(path, std::ios::out | std::ios::app);
+    if (!logFile.is_open())
+    {
+        std::cout << "[Log] ERROR: Could not open log file " << path << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+void AsyncLogger::setCallback(Callback newCallback, Level minLevel)
+{
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    callback = std::move(newCallback);
+    callbackLevel = minLevel;
+}
+
+const char* AsyncLogger::getLevelName(Level level)
+{
+    switch (level)
+    {
+        case Level::Debug:      return "DEBUG";
+        case Level::Info:       return "INFO";
+        case Level::Warning:    return "WARN";
+        case Level::Error:      return "ERROR";
+        default:                return "OFF";
+    }
+}
+
+//==============================================================================
+std::string AsyncLogger::formatRecord(const Record& record)
+{
+    std::string line;
+    if (record.format == nullptr)
+        return line;
+    
+    line.reserve(128);
+    int nextArg = 0;
+    
+    for (const char* p = record.format; *p != '\0'; ++p)
+    {
+        if (*p != '%')
+        {
+            line += *p;
+            continue;
+        }
+        
+        if (p[1] == '%')
+        {
+            line += '%';
+            ++p;
+            continue;
+        }
+        
+        // Keep flags, width and precision; the length modifier comes from the argument type
+        std::string spec = "%";
+        const char* q = p + 1;
+        while (isOneOf(*q, "-+ #0"))
+            spec += *q++;
+        while ((*q >= '0' && *q <= '9') || *q == '.')
+            spec += *q++;
+        while (isOneOf(*q, "hlLqjzt"))
+            ++q;
+        
+        const char conversion = *q;
+        if (conversion == '\0')
+            break;
+        p = q;
+        
+        if (nextArg >= record.numArgs)
+        {
+            line += "<?>";
+            continue;
+        }
+        
+        const Arg& arg = record.args[nextArg++];
+        char buffer[128];
+        int written = 0;
+        
+        switch (arg.type)
+        {
+            case Arg::Type::Int:
+                if (isOneOf(conversion, "fFeEgG"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), (double)arg.i);
+                else if (conversion == 'c')
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "c").c_str(), (int)arg.i);
+                else if (isOneOf(conversion, "uxXo"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (long long)arg.i);
+                else
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(), (long long)arg.i);
+                break;
+            
+            case Arg::Type::UInt:
+                if (isOneOf(conversion, "xXo"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), (unsigned long long)arg.u);
+                else if (isOneOf(conversion, "fFeEgG"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), (double)arg.u);
+                else
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "llu").c_str(), (unsigned long long)arg.u);
+                break;
+            
+            case Arg::Type::Double:
+                if (isOneOf(conversion, "fFeEgGaA"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), arg.d);
+                else if (isOneOf(conversion, "di"))
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "lld").c_str(), (long long)arg.d);
+                else
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "g").c_str(), arg.d);
+                break;
+            
+            case Arg::Type::Text:
+                if (spec.size() == 1)
+                    line.append(record.message.text + arg.text.offset, arg.text.length);
+                else
+                    written = std::snprintf(buffer, sizeof(buffer), (spec + "s").c_str(),
+                                            std::string(record.message.text + arg.text.offset, arg.text.length).c_str());
+                break;
+        }
+        
+        if (written > 0)
+            line.append(buffer, (size_t)std::min<int>(written, (int)sizeof(buffer) - 1));
+    }
+    
+    return line;
+}
+
+//==============================================================================
+void AsyncLogger::threadFunction()
+{
+    while (!stopRequested.load())
+    {
+        wake.wait(WAKE_INTERVAL_MS);
+        drain();
+    }
+    
+    // Lines queued before stop()
+    drain();
+}
+
+bool AsyncLogger::drain()
+{
+    batch.clear();
+    
+    for (auto& channel : channels)
+    {
+        while (auto record = channel->queue.pop())
+            batch.push_back(*record);
+    }
+    
+    // Channels are drained one after the other: restore the order lines were logged in
+    std::stable_sort(batch.begin(), batch.end(), [](const Record& a, const Record& b) {
+        return a.timeMicros < b.timeMicros;
+    });
+    
+    for (const auto& record : batch)
+        emit(record.level, record.timeMicros, formatRecord(record));
+    
+    // Report what the producers could not queue
+    const int64_t nowMicros = steadyNowMicros();
+    bool reported = false;
+    for (auto& channel : channels)
+    {
+        const uint32_t suppressed = channel->suppressed.exchange(0, std::memory_order_relaxed);
+        const uint32_t dropped = channel->dropped.exchange(0, std::memory_order_relaxed);
+        if (suppressed == 0 && dropped == 0)
+            continue;
+        
+        emit(Level::Warning, nowMicros,
+             std::string("[Log] ") + (channel->producer == Producer::Audio ? "Audio" : "Whisper") + " channel: "
+             + std::to_string(suppressed) + " line(s) rate limited, " + std::to_string(dropped) + " dropped (queue full)");
+        reported = true;
+    }
+    
+    if (!batch.empty() || reported)
+    {
+        if (consoleEnabled.load())
+            std::cout.flush();
+        
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        if (logFile.is_open())
+            logFile.flush();
+        return true;
+    }
+    
+    return false;
+}
+
+void AsyncLogger::emit(Level level, int64_t timeMicros, const std::string& line)
+{
+    if (consoleEnabled.load())
+        std::cout << line << '\n';
+    
+    std::lock_guard<std::mutex> lock(sinkMutex);
+    
+    if (logFile.is_open())
+    {
+        char prefix[48];
+        std::snprintf(prefix, sizeof(prefix), "%10.3f %-5s ", (double)(timeMicros - startMicros) * 1.0e-6, getLevelName(level));
+        logFile << prefix << line << '\n';
+    }
+    
+    if (callback && (int)level >= (int)callbackLevel)
+        callback(level, line);
+}
@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    AsyncLogger.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Real-time safe logging for the audio callback and the Whisper thread.
+
+    Features:
+    - Producers push binary records (DebugMessage + a static printf format
+      + tagged arguments) into their own lock-free queue: no formatting,
+      no locale, no console I/O on the calling thread
+    - String arguments are copied into the record's text buffer, so they
+      may be temporaries
+    - A background thread formats the records in time order and sinks them
+      to the console, a log file and a callback (UI debug panel)
+    - Minimum level and per-channel rate limit (token bucket) can be
+      changed at runtime; suppressed and dropped lines are reported
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "Types.h"
+#include "LockFreeQueue.h"
+#include "WakeSignal.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+    Asynchronous log channel with one SPSC queue per producing thread.
+    
+    Usage:
+        AsyncLogger::Channel& log = logger.getChannel(AsyncLogger::Producer::Audio);
+        log.warning("[BUFFER UNDERRUN] Buffer dropped to %.2fs (min: %.2fs)", bufferSize, minBufferSize);
+    
+    Formats are printf-style and must be string literals (only the pointer is
+    queued). Integer, floating point, bool, const char* and std::string
+    arguments are supported; the conversion follows the argument's type, so
+    "%d" with a juce::int64 or "%.2f" with a float is fine.
+    
+    Thread Safety:
+    - Channel logging: the channel's producer thread only (real-time safe)
+    - Configuration (levels, rate limits, sinks): any thread
+    - start()/stop(): control thread
+*/
+class AsyncLogger
+{
+public:
+    enum class Level : int
+    {
+        Debug = 0,
+        Info,
+        Warning,
+        Error,
+        Off
+    };
+    
+    enum class Producer
+    {
+        Audio,              // Audio device callback
+        Whisper,            // Whisper thread (decode loop, post-processing)
+        NumProducers
+    };
+    
+    static constexpr int NUM_PRODUCERS = (int)Producer::NumProducers;
+    static constexpr int MAX_ARGS = 8;
+    static constexpr size_t QUEUE_CAPACITY = 256;
+    
+    struct Arg
+    {
+        enum class Type : uint8_t
+        {
+            Int,
+            UInt,
+            Double,
+            Text                // Bytes [offset, offset + length) of the record's text
+        };
+        
+        Type type = Type::Int;
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+            struct
+            {
+                uint16_t offset;
+                uint16_t length;
+            } text;
+        };
+        
+        Arg() : i(0) {}
+    };
+    
+    struct Record
+    {
+        DebugMessage message;           // type Log; text holds copied string arguments
+        const char* format = nullptr;   // Static printf-style format
+        Level level = Level::Info;
+        uint8_t numArgs = 0;
+        uint16_t textUsed = 0;
+        int64_t timeMicros = 0;         // steady_clock, orders lines across channels
+        Arg args[MAX_ARGS];
+    };
+    
+    /**
+        Producer side of the logger for one thread.
+    */
+    class Channel
+    {
+    public:
+        bool isEnabled(Level level) const;
+        
+        template <typename... Args> void debug(const char* format, const Args&... args)   { write(Level::Debug, format, args...); }
+        template <typename... Args> void info(const char* format, const Args&... args)    { write(Level::Info, format, args...); }
+        template <typename... Args> void warning(const char* format, const Args&... args) { write(Level::Warning, format, args...); }
+        template <typename... Args> void error(const char* format, const Args&... args)   { write(Level::Error, format, args...); }
+        
+        /**
+            Queue one line.
+            
+            @param level    Lines below the logger's minimum level cost one atomic load
+            @param format   printf-style string literal
+        */
+        template <typename... Args>
+        void write(Level level, const char* format, const Args&... args)
+        {
+            static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+            
+            if (!isEnabled(level))
+                return;
+            
+            const int64_t nowMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch()).count();
+            if (!admit(level, nowMicros))
+                return;
+            
+            Record record;
+            record.format = format;
+            record.level = level;
+            record.timeMicros = nowMicros;
+            record.message.type = DebugMessage::Type::Log;
+            record.message.timestamp_ms = nowMicros / 1000;
+            record.message.start_sample = 0;
+            record.message.end_sample = 0;
+            record.message.confidence = 0.0;
+            record.message.is_profanity = false;
+            
+            int unused[] = { 0, (pack(record, args), 0)... };
+            (void)unused;
+            
+            publish(record);
+        }
+        
+        /** Lines lost to the rate limit since the logger last reported them. */
+        uint32_t getSuppressedCount() const { return suppressed.load(std::memory_order_relaxed); }
+    
+    private:
+        friend class AsyncLogger;
+        
+        Channel() = default;
+        
+        bool admit(Level level, int64_t nowMicros);
+        void publish(const Record& record);
+        
+        template <typename T>
+        static typename std::enable_if<std::is_integral<T>::value>::type pack(Record& record, const T& value)
+        {
+            Arg& arg = record.args[record.numArgs++];
+            if (std::is_signed<T>::value || std::is_same<T, bool>::value)
+            {
+                arg.type = Arg::Type::Int;
+                arg.i = (int64_t)value;
+            }
+            else
+            {
+                arg.type = Arg::Type::UInt;
+                arg.u = (uint64_t)value;
+            }
+        }
+        
+        template <typename T>
+        static typename std::enable_if<std::is_floating_point<T>::value>::type pack(Record& record, const T& value)
+        {
+            Arg& arg = record.args[record.numArgs++];
+            arg.type = Arg::Type::Double;
+            arg.d = (double)value;
+        }
+        
+        static void pack(Record& record, const char* text) { packText(record, text ? text : "(null)", std::strlen(text ? text : "(null)")); }
+        static void pack(Record& record, const std::string& text) { packText(record, text.data(), text.size()); }
+        
+        static void packText(Record& record, const char* text, size_t length);
+        
+        AsyncLogger* owner = nullptr;
+        Producer producer = Producer::Audio;
+        LockFreeQueue<Record, QUEUE_CAPACITY> queue;
+        
+        // Rate limit (producer thread)
+        double tokens = 0.0;
+        int64_t lastRefillMicros = 0;
+        
+        std::atomic<double> ratePerSecond {0.0};       // 0 = unlimited
+        std::atomic<double> burst {0.0};
+        std::atomic<uint32_t> suppressed {0};
+        std::atomic<uint32_t> dropped {0};
+        
+        Channel(const Channel&) = delete;
+        Channel& operator=(const Channel&) = delete;
+    };
+    
+    using Callback = std::function<void(Level level, const std::string& line)>;
+    
+    AsyncLogger();
+    ~AsyncLogger();
+    
+    /**
+        Start the formatting thread (records queued before start() are kept).
+    */
+    void start();
+    
+    /**
+        Format everything still queued, then stop the thread.
+    */
+    void stop();
+    
+    Channel& getChannel(Producer producer) { return *channels[(size_t)producer]; }
+    
+    // Runtime configuration
+    void setMinimumLevel(Level level) { minimumLevel.store((int)level, std::memory_order_relaxed); }
+    Level getMinimumLevel() const { return (Level)minimumLevel.load(std::memory_order_relaxed); }
+    
+    /**
+        Limit a channel to a sustained rate with bursts (errors are never limited).
+        
+        @param messagesPerSecond    Sustained rate (0 = unlimited)
+        @param burstSize            Lines allowed back to back before the rate applies
+    */
+    void setRateLimit(Producer producer, double messagesPerSecond, double burstSize);
+    
+    void setConsoleEnabled(bool enabled) { consoleEnabled.store(enabled); }
+    
+    /**
+        Append every line (with time and level) to a file; empty path closes it.
+    */
+    bool setLogFile(const std::string& path);
+    
+    /**
+        Forward lines at or above minLevel, e.g. to the UI debug panel.
+        Called on the logger thread.
+    */
+    void setCallback(Callback callback, Level minLevel = Level::Warning);
+    
+    static const char* getLevelName(Level level);
+    
+    /**
+        Expand a record's format with its arguments.
+    */
+    static std::string formatRecord(const Record& record);
+
+private:
+    void threadFunction();
+    bool drain();
+    void emit(Level level, int64_t timeMicros, const std::string& line);
+    
+    std::array<std::unique_ptr<Channel>, NUM_PRODUCERS> channels;
+    std::atomic<int> minimumLevel {(int)Level::Info};
+    
+    WakeSignal wake;
+    std::thread thread;
+    std::atomic<bool> running {false};
+    std::atomic<bool> stopRequested {false};
+    int64_t startMicros = 0;
+    
+    // Sinks (logger thread, configuration under sinkMutex)
+    std::mutex sinkMutex;
+    std::atomic<bool> consoleEnabled {true};
+    std::ofstream logFile;
+    Callback callback;
+    Level callbackLevel = Level::Warning;
+    std::vector<Record> batch;          // Logger thread
+    
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+};
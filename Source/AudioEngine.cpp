@@ -11,6 +11,10 @@
 */
 
 #include "AudioEngine.h"
+#include "AllocationCounter.h"
+#include "MultiStreamEngine.h"
+#include "VoskBackend.h"
+#include "WhisperBackend.h"
 
 // Undefine Windows macros that conflict with std::min/std::max
 #ifdef max
@@ -26,46 +30,10 @@
 #include <cctype>
 #include <chrono>
 #include <iomanip>
-#include <regex>
 #include <thread>
 #include <fstream>
 #include <ctime>
-
-// Helper function to clean Whisper transcript text
-static std::string cleanTranscriptText(const std::string& text)
-{
-    std::string cleaned = text;
-    
-    // Remove parenthetical content like "( up beat music )", "(laughs)", etc.
-    cleaned = std::regex_replace(cleaned, std::regex("\\([^)]*\\)"), "");
-    
-    // Fix Unicode quote characters: ΓÖ¬ (U+00C3 U+0096 U+00AC) -> '
-    cleaned = std::regex_replace(cleaned, std::regex("\xC3\x96\xAC"), "'");
-    
-    // Fix other common Unicode issues
-    cleaned = std::regex_replace(cleaned, std::regex("\xE2\x80\x98"), "'");  // Left single quote
-    cleaned = std::regex_replace(cleaned, std::regex("\xE2\x80\x99"), "'");  // Right single quote
-    cleaned = std::regex_replace(cleaned, std::regex("\xE2\x80\x9C"), "\""); // Left double quote
-    cleaned = std::regex_replace(cleaned, std::regex("\xE2\x80\x9D"), "\""); // Right double quote
-    
-    // Remove any remaining non-alphanumeric characters (except apostrophes and hyphens for contractions/compound words)
-    // Keep: letters, numbers, apostrophes, hyphens, spaces
-    std::string filtered;
-    for (char c : cleaned)
-    {
-        if (std::isalnum(static_cast<unsigned char>(c)) || c == '\'' || c == '-' || c == ' ')
-        {
-            filtered += c;
-        }
-    }
-    cleaned = filtered;
-    
-    // Trim whitespace
-    cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
-    cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
-    
-    return cleaned;
-}
+#include <cstring>
 
 // Add this helper function
 std::string mergeCommonSplits(const std::string& text)
@@ -102,7 +70,27 @@ std::string mergeCommonSplits(const std::string& text)
 }
 
 AudioEngine::AudioEngine()
+    : AudioEngine(nullptr)
+{
+}
+
+AudioEngine::AudioEngine(MultiStreamEngine& sharedHost)
+    : AudioEngine(&sharedHost)
 {
+}
+
+AudioEngine::AudioEngine(MultiStreamEngine* sharedHost)
+    : host(sharedHost),
+      modelManager(sharedHost != nullptr ? sharedHost->getModelManager() : ownModelManager),
+      decodeScheduler(sharedHost != nullptr ? sharedHost->getScheduler() : ownDecodeScheduler)
+{
+    // Audio and Whisper thread diagnostics are formatted and printed off those threads
+    logger.setRateLimit(AsyncLogger::Producer::Audio, 20.0, 40.0);
+    logger.setCallback([this](AsyncLogger::Level, const std::string& line) {
+        uiState.postMessage(line);     // Warnings and errors (logger thread)
+    });
+    logger.start();
+    
     // Phase 4: Load profanity filter
     juce::File lexiconFile("lexicons/profanity_en.txt");
     if (!profanityFilter.loadLexicon(lexiconFile))
@@ -114,27 +102,98 @@ AudioEngine::AudioEngine()
         std::cout << "[Phase4] Profanity filter loaded" << std::endl;
     }
     
-    // Phase 5: Load Whisper model at startup (faster "Start Processing" button response)
-    std::cout << "[Phase5] Loading Whisper model at startup..." << std::endl;
-    whisper_context_params cparams = whisper_context_default_params();
-    cparams.use_gpu = false;  // CPU only for consistency
-    cparams.dtw_token_timestamps = true;  // Enable DTW for better timestamp alignment
-    cparams.dtw_aheads_preset = WHISPER_AHEADS_BASE_EN;  // Use base.en alignment preset
-    whisperCtx = whisper_init_from_file_with_params("Models/ggml-base.en.bin", cparams);
+    // Second decoding pass also re-checks words that sound like lexicon entries
+    redecodePolicy.setLexicon(&profanityFilter.getMatcher());
     
-    if (whisperCtx == nullptr)
+    // Phase 5: Load Whisper models at startup (faster "Start Processing" button response);
+    // a multi-stream host has loaded them once for every stream
+    if (host == nullptr)
+        loadWhisperModels();
+}
+
+AudioEngine::~AudioEngine()
+{
+    stop();
+    keywordSpotter.setBackend(nullptr);     // A Whisper spotter's state belongs to one of the models
+    freeWhisperModels();
+    logger.stop();
+}
+
+void AudioEngine::loadWhisperModels()
+{
+    std::cout << "[Phase5] Loading Whisper models at startup..." << std::endl;
+    
+    // Fallback first and blocking, so start() can succeed right away; the larger tiers
+    // load and warm up in the background and join modelTiers as they become ready
+    modelManager.setLoadLargerModels(allowLargerThanPrimary);
+    if (!modelManager.loadFallback())
     {
-        std::cout << "[Phase5] ERROR: Failed to load Whisper model at startup" << std::endl;
+        std::cout << "[Phase5] ERROR: Failed to load any Whisper model at startup" << std::endl;
+        return;
     }
-    else
+    
+    adoptLoadedModels();
+    modelManager.startBackgroundLoading();
+}
+
+void AudioEngine::adoptLoadedModels()
+{
+    // Multi-stream: the host hands new models to the shared scheduler, and tier i
+    // must be scheduler model i, so only what the scheduler knows is adopted
+    if (host != nullptr)
+        host->adoptLoadedModels();
+    
+    const int numReady = host != nullptr ? decodeScheduler.getNumModels() : modelManager.getNumReady();
+    if ((int)modelTiers.size() >= numReady)
+        return;
+    
+    // Published in catalog order, so appending keeps modelTiers fastest first
+    // and every index the scheduler already knows stays valid
+    for (int i = (int)modelTiers.size(); i < numReady; ++i)
+    {
+        const ModelManager::Model& model = modelManager.getModel(i);
+        
+        WhisperModelTier tier;
+        tier.name = model.name;
+        tier.ctx = model.ctx;
+        tier.rtfEstimate = model.initialRTF;
+        modelTiers.push_back(tier);
+        
+        // While running the model joins the scheduler here (start() adds it otherwise)
+        if (host == nullptr && decodeScheduler.isRunning())
+            decodeScheduler.addModel(model.ctx, modelManager.takeWarmState(i));
+        
+        std::cout << "[Phase5] Whisper " << model.name << " model loaded successfully"
+                  << (model.quantized ? " (quantized)" : "") << std::endl;
+    }
+    
+    // Primary = small.en, or the most accurate model loaded below it
+    primaryModelTier = 0;
+    for (int i = 0; i < (int)modelTiers.size(); ++i)
     {
-        std::cout << "[Phase5] Whisper base.en model loaded successfully" << std::endl;
+        if (modelTiers[i].name != "medium.en")
+            primaryModelTier = i;
     }
+    
+    whisperCtx = modelTiers[primaryModelTier].ctx;
+    whisperCtxTiny = (modelTiers[0].name == "tiny.en" && primaryModelTier > 0) ? modelTiers[0].ctx : nullptr;
+    
+    std::cout << "[ADAPTIVE] Primary model: " << modelTiers[primaryModelTier].name 
+              << ", fallback: " << (whisperCtxTiny ? "tiny.en" : "none (adaptive switching disabled)") 
+              << ", " << modelTiers.size() << " model(s) loaded"
+              << (modelManager.isLoading() ? " (more loading)" : "") << std::endl;
 }
 
-AudioEngine::~AudioEngine()
+void AudioEngine::freeWhisperModels()
 {
-    stop();
+    // A host's models outlive its streams
+    if (host == nullptr)
+        modelManager.shutdown();
+    
+    modelTiers.clear();
+    primaryModelTier = -1;
+    whisperCtx = nullptr;
+    whisperCtxTiny = nullptr;
 }
 
 bool AudioEngine::start(const juce::String& inputDeviceName,
@@ -151,12 +210,9 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
     
     // Store censor mode
     currentCensorMode = mode;
+    remoteInput = false;
     std::cout << "[Phase6] Censor mode: " << (mode == CensorMode::Mute ? "MUTE" : "REVERSE") << std::endl;
     
-    // Phase 8: Start quality analysis session
-    qualityAnalyzer.reset();
-    qualityAnalyzer.startSession();
-    
     // Setup audio device
     juce::AudioDeviceManager::AudioDeviceSetup setup;
     setup.inputDeviceName = inputDeviceName;
@@ -202,7 +258,83 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
     std::cout << "[Phase2] Output device: " << device->getOutputChannelNames().joinIntoString(", ") << std::endl;
     std::cout << "[Phase2] ==============================" << std::endl;
     
-    // Phase 5: Check if Whisper model was loaded at startup
+    if (!startPipeline(bufferSize))
+        return false;
+    
+    // Add audio callback
+    deviceManager.addAudioCallback(this);
+    
+    isRunning = true;
+    
+    std::cout << "[Phase5] Started successfully!" << std::endl;
+    return true;
+}
+
+bool AudioEngine::startRemote(int streamSampleRate, CensorMode mode)
+{
+    std::cout << "[Remote] AudioEngine::startRemote() called (" << streamSampleRate << " Hz)" << std::endl;
+    
+    if (isRunning)
+        stop();
+    
+    currentCensorMode = mode;
+    remoteInput = true;
+    sampleRate = streamSampleRate;
+    numChannels = 1;
+    
+    // Censored output is rendered as usual and discarded (the client plays its own copy)
+    for (auto& channel : remoteOutput)
+        channel.assign(REMOTE_BLOCK_SAMPLES, 0.0f);
+    
+    if (!startPipeline(REMOTE_BLOCK_SAMPLES))
+        return false;
+    
+    // No device: what audioDeviceAboutToStart() resets is reset here
+    resetCallbackState();
+    
+    isRunning = true;
+    
+    std::cout << "[Remote] Started successfully!" << std::endl;
+    return true;
+}
+
+void AudioEngine::processRemoteAudio(const float* samples, int numSamples)
+{
+    if (!isRunning || !remoteInput)
+        return;
+    
+    float* const outputs[2] = { remoteOutput[0].data(), remoteOutput[1].data() };
+    const juce::AudioIODeviceCallbackContext context {};
+    
+    for (int offset = 0; offset < numSamples; offset += REMOTE_BLOCK_SAMPLES)
+    {
+        const float* input = samples + offset;
+        audioDeviceIOCallbackWithContext(&input, 1, outputs, 2,
+                                         std::min(REMOTE_BLOCK_SAMPLES, numSamples - offset), context);
+    }
+}
+
+bool AudioEngine::startPipeline(int bufferSize)
+{
+    // Phase 8: Start quality analysis session
+    qualityAnalyzer.reset();
+    qualityAnalyzer.startSession();
+    uiState.reset();
+    nextUiStatsTime = std::chrono::steady_clock::now();
+    
+    // Testing mode: the full session history goes to disk in the background
+    if (testingMode)
+    {
+        juce::File logsDir = juce::File::getCurrentWorkingDirectory().getChildFile("TestLogs");
+        logsDir.createDirectory();
+        
+        const juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S");
+        qualityAnalyzer.startHistorySpill(logsDir.getChildFile("session_history_" + timestamp + ".csv")
+                                              .getFullPathName().toStdString());
+    }
+    
+    // Phase 5: Check if Whisper model was loaded at startup (pick up tiers that finished loading since)
+    adoptLoadedModels();
     if (whisperCtx == nullptr)
     {
         std::cout << "[Phase5] ERROR: Whisper model not loaded - was there an error at startup?" << std::endl;
@@ -212,47 +344,155 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
     }
     std::cout << "[Phase5] Using pre-loaded Whisper model" << std::endl;
     
-    // Allocate buffer for configurable chunk size
-    int audioBufferSize = (int)(sampleRate * chunkSeconds);
-    audioBuffer.resize(audioBufferSize, 0.0f);
-    processingBuffer.resize(audioBufferSize, 0.0f);
-    bufferWritePos = 0;
+    // Phase 9: Start every session on the primary model
+    usingTinyModel.store(false);
+    lastModelTier = -1;
+    
+    // Allocate rolling window for configurable chunk size
+    // The window holds 16kHz audio: each device block is decimated as it arrives.
+    // 2s of slack past the window lets the Whisper thread copy a published window
+    // while the audio callback keeps writing (overwrites are detected, never locked out)
+    whisperWindow = std::make_unique<CircularAudioBuffer>(1, (int)(WHISPER_SAMPLE_RATE * (chunkSeconds + 2.0)));
+    while (whisperChunkQueue.pop().has_value()) {}
+    
+    const int resamplerBlockSize = std::max(bufferSize, 64);
+    whisperResampler.prepare(sampleRate, WHISPER_SAMPLE_RATE, resamplerBlockSize);
+    monoBlock.assign(resamplerBlockSize, 0.0f);
+    resampledBlock.assign(whisperResampler.getMaxOutputSamples(resamplerBlockSize), 0.0f);
+    
+    std::cout << "[Phase5] Resampler: " << sampleRate << " Hz -> " << WHISPER_SAMPLE_RATE << " Hz, " 
+              << whisperResampler.getTapsPerPhase() << " taps/phase, latency " 
+              << whisperResampler.getLatencyInputSamples() << " samples" << std::endl;
+    
     transcriptionInterval = 0;
+    inputSamplesCaptured = 0;
+    
+    // Streaming decode state
+    streamCommittedSample = 0;
+    streamPromptTokens.clear();
+    streamPromptTokens.reserve(maxPromptTokens + 256);
+    profanityStream.reset();
+    profanityCoveredWord = -1;
+    pushSequence = 0;
+    lyricsFastPath.reset();
+    lyricsFastPath.setSampleRate(sampleRate);
+    fastPathWasEngaged = false;
+    fastPathSkippedUntil = 0;
+    pendingProposals.clear();
+    pendingProposals.reserve(MAX_ACTIVE_CENSOR_EVENTS);
+    censorTimeline.setSampleRate(sampleRate);
+    timelineBlock.assign(WHISPER_SAMPLE_RATE / 10, 0.0f);
+    timelineReadPosition = 0;
+    timelineWasEngaged = false;
+    {
+        std::lock_guard<std::mutex> lock(timelineSongMutex);
+        pendingTimelineSong.reset();
+        timelineSongKey.clear();
+    }
+    timelineSongPending.store(false);
     
-    // Initialize vocal filter
-    vocalFilter.initialize(sampleRate);
-    std::cout << "[Phase5] Vocal filter initialized" << std::endl;
+    std::cout << "[Stream] " << (streamingMode ? "Streaming" : "Chunked") << " decode: window=" 
+              << chunkSeconds << "s, hop=" << getHopSeconds() << "s" << std::endl;
+    
+    // Initialize vocal filter (streams on the 16kHz feed, after the resampler)
+    vocalFilter.initialize(WHISPER_SAMPLE_RATE);
+    std::cout << "[Phase5] Vocal filter " << (useVocalFilter ? "enabled" : "disabled") << std::endl;
+    
+    // Vocal gate runs on the 16kHz Whisper windows
+    vocalGate.initialize(WHISPER_SAMPLE_RATE);
+    vocalGate.setEnabled(useVocalGate);
     
     // Phase 6: Initialize delay buffer
     // Delay buffer capacity should be larger than initial delay to provide safety margin
-    delayBufferSize = (int)(sampleRate * (initialDelaySeconds + 10.0));  // Initial delay + 10s safety margin
-    delayBuffer.clear();
-    delayBuffer.resize(2);  // Stereo
-    for (auto& channel : delayBuffer)
-        channel.resize(delayBufferSize, 0.0f);
+    // (rounded up to a power of two by CircularAudioBuffer)
+    delayLine = std::make_unique<CircularAudioBuffer>(2, (int)(sampleRate * (initialDelaySeconds + 10.0)));  // Stereo, initial delay + 10s safety margin
+    delayBufferSize = delayLine->getCapacity();
     
-    // Start with NO gap - readPos stays at 0 until we've buffered 10 seconds
+    // Start with NO gap - readPos stays at 0 until we've buffered initialDelaySeconds
     delayReadPos = 0;
-    delayWritePos = 0;
+    
+    // Adaptive look-ahead: starts from initialDelaySeconds, then follows the measured decode latency
+    // (2s of the delay line stay free so the reader never laps the writer)
+    latencyController.prepare(initialDelaySeconds, (double)delayBufferSize / sampleRate - 2.0, chunkSeconds + 0.5);
+    
+    // Rate < 2 keeps a block's input span within 2x the block (+ interpolation tail)
+    const int maxPlaybackBlock = std::max(bufferSize, 512);
+    for (auto& scratch : playbackScratch)
+        scratch.assign((size_t)(2 * maxPlaybackBlock + 8), 0.0f);
+    playbackScratchSamples = 0;
+    playbackPhase = 0.0;
     
     std::cout << "[Phase6] Delay buffer initialized: " << delayBufferSize << " samples total (" 
-              << (delayBufferSize / sampleRate) << " seconds capacity)" << std::endl;
+              << ((double)delayBufferSize / sampleRate) << " seconds capacity)" << std::endl;
     std::cout << "[Phase6] Will buffer " << initialDelaySeconds << " seconds before starting playback" << std::endl;
-    std::cout << "[Phase6] Initial positions: writePos=" << delayWritePos 
-              << ", readPos=" << delayReadPos << " (playback paused until buffered)" << std::endl;
+    std::cout << "[Phase6] Initial positions: writePos=" << delayLine->getWritePosition() 
+              << ", readPos=" << delayReadPos.load() << " (playback paused until buffered)" << std::endl;
+    
+    // Phase 5: Decode workers share the loaded models, one whisper_state per in-flight window
+    // (the first start() inherits each model's warmed-up state from the warm-up decode)
+    // Multi-stream: the host's workers are already running; this stream gets its own queue
+    if (host == nullptr)
+    {
+        decodeScheduler.prepare(maxConcurrentDecodes, [this] { whisperWake.notify(); });
+        for (int i = 0; i < (int)modelTiers.size(); ++i)
+            decodeScheduler.addModel(modelTiers[i].ctx, modelManager.takeWarmState(i));
+        decodeStream = 0;
+    }
+    else
+    {
+        decodeStream = decodeScheduler.addStream([this] { whisperWake.notify(); });
+        if (decodeStream < 0)
+        {
+            lastError = "Shared decode scheduler is not running";
+            deviceManager.closeAudioDevice();
+            return false;
+        }
+    }
+    maxChunksInFlight = decodeScheduler.getNumSlots();
+    
+    // Every buffer the Whisper thread needs per window, allocated once per session
+    // (windows in flight, plus the one being copied and the one being post-processed)
+    SessionArena::Layout arenaLayout;
+    arenaLayout.windowSamples = (int)std::ceil(chunkSeconds * WHISPER_SAMPLE_RATE);
+    arenaLayout.maxWindows = maxChunksInFlight + 2;
+    arenaLayout.maxWordsPerWindow = (int)std::ceil(chunkSeconds * 8.0);  // Fast rap tops out around 7 words/s
+    sessionArena.prepare(arenaLayout);
     
     // Phase 5: Start background Whisper thread
     shouldStopThread.store(false);
-    hasNewBuffer.store(false);
+    chunksInFlight.store(0);
     whisperThread = std::thread(&AudioEngine::whisperThreadFunction, this);
     std::cout << "[Phase5] Background Whisper thread started" << std::endl;
     
+    // Two-tier detection: streaming front-end on the same 16kHz feed (optional)
+    if (keywordSpotter.getOptions().backend != KeywordSpotter::Backend::Off)
+        startKeywordSpotter();
+    
+    // Lyrics cache: repeats skip the network fetch and the soundex preprocessing
+    if (lyricsCache.open(LyricsCache::getDefaultDirectory()))
+        songRecognition.setCache(&lyricsCache);
+    
+    // Censor timelines: songs heard before are replayed from the cache instead of decoded
+    if (censorTimeline.getOptions().enabled)
+        censorTimelineCache.open(CensorTimelineCache::getDefaultDirectory());
+    
+    // Idea 2: Song recognition worker (fed with the 16kHz stream, results posted to the message thread)
+    recognitionWorker.start(WHISPER_SAMPLE_RATE, 10.0, [this](const SongRecognition::SongInfo& song) {
+        juce::MessageManager::callAsync([this, song]() {
+            handleRecognitionResult(song);
+        });
+    });
+    
     // Idea 2 Phase 1: Try Windows Media Info first (instant, no buffering needed)
     // Note: This is done AFTER audio starts to avoid blocking startup
     std::cout << "[MediaInfo] Attempting Windows Media Control initialization..." << std::endl;
     
     try
     {
+        // The system media session describes this machine's player, not a room's or a client's input
+        if (host != nullptr || remoteInput)
+            throw std::runtime_error("multi-stream or remote input (no per-stream media session)");
+        
         if (windowsMediaInfo.initialize())
         {
             mediaInfoInitialized = true;
@@ -266,54 +506,20 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
                 lastSongTitle = info.title;
                 lastSongArtist = info.artist;
                 
-                if (songInfoCallback && !info.title.empty())
-                {
-                    juce::MessageManager::callAsync([this, info]() {
-                        songInfoCallback(juce::String(info.artist), 
-                                       juce::String(info.title), 
-                                       1.0f);  // 100% confidence (from system)
-                    });
-                }
+                if (!info.title.empty())
+                    uiState.setSong(info.artist, info.title, 1.0f);  // 100% confidence (from system)
                 
                 // Fetch lyrics ASYNCHRONOUSLY - don't block audio thread
                 if (!info.title.empty() && !info.artist.empty())
                 {
                     std::cout << "[MediaInfo] Fetching lyrics in background..." << std::endl;
                     
-                    // Disable alignment immediately and reset state (use raw Whisper for first ~2s)
-                    useLyricsAlignment = false;
-                    lyricsAlignment.reset();
-                    songLyrics.clear();
-                    
-                    // Copy to local variables for thread capture
-                    std::string artist = info.artist;
-                    std::string title = info.title;
+                    // Alignment off until the new lyrics arrive (raw Whisper for the first ~2s)
+                    queueLyrics({}, {});
                     
-                    // Launch background thread
-                    std::thread([this, artist, title]() {
-                        std::cout << "[LyricsFetch] Background fetch started for: " 
-                                 << artist << " - " << title << std::endl;
-                        
-                        SongInfo lyricsInfo = LyricsAlignment::fetchLyrics(artist, title);
-                        
-                        // Post result back to message thread
-                        juce::MessageManager::callAsync([this, lyricsInfo]() {
-                            if (!lyricsInfo.lyrics.empty())
-                            {
-                                songLyrics = lyricsInfo.lyrics;
-                                lyricsAlignment.reset();
-                                lyricsAlignment.setLyrics(songLyrics);
-                                // useLyricsAlignment = true;  // DISABLED FOR TESTING
-                                
-                                std::cout << "[LyricsFetch] ✓ Lyrics ready! Alignment DISABLED for testing (" 
-                                         << songLyrics.length() << " chars)" << std::endl;
-                            }
-                            else
-                            {
-                                std::cout << "[LyricsFetch] ✗ No lyrics found - using raw Whisper" << std::endl;
-                            }
-                        });
-                    }).detach();
+                    // Cache hit applies immediately; a miss is fetched on the cache's thread
+                    loadLyricsFor(info.artist, info.title, "[LyricsFetch]");
+                    beginCensorTimeline(info.artist, info.title);
                 }
             });
             
@@ -327,44 +533,14 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
                 lastSongTitle = initialInfo.title;
                 lastSongArtist = initialInfo.artist;
                 
-                if (songInfoCallback)
-                {
-                    songInfoCallback(juce::String(initialInfo.artist), 
-                                   juce::String(initialInfo.title), 
-                                   1.0f);
-                }
+                uiState.setSong(initialInfo.artist, initialInfo.title, 1.0f);
                 
                 // Fetch initial lyrics ASYNCHRONOUSLY
                 std::cout << "[MediaInfo] Fetching initial lyrics in background..." << std::endl;
-                useLyricsAlignment = false;  // Use raw Whisper initially
+                queueLyrics({}, {});  // Use raw Whisper initially
                 
-                // Copy to local variables for thread capture
-                std::string artist = initialInfo.artist;
-                std::string title = initialInfo.title;
-                
-                std::thread([this, artist, title]() {
-                    std::cout << "[LyricsFetch] Background fetch started for: " 
-                             << artist << " - " << title << std::endl;
-                    
-                    SongInfo lyricsInfo = LyricsAlignment::fetchLyrics(artist, title);
-                    
-                    juce::MessageManager::callAsync([this, lyricsInfo]() {
-                        if (!lyricsInfo.lyrics.empty())
-                        {
-                            songLyrics = lyricsInfo.lyrics;
-                            lyricsAlignment.reset();
-                            lyricsAlignment.setLyrics(songLyrics);
-                            // useLyricsAlignment = true;  // DISABLED FOR TESTING
-                            
-                            std::cout << "[LyricsFetch] ✓ Initial lyrics ready! Alignment DISABLED for testing (" 
-                                     << songLyrics.length() << " chars)" << std::endl;
-                        }
-                        else
-                        {
-                            std::cout << "[LyricsFetch] ✗ No initial lyrics found" << std::endl;
-                        }
-                    });
-                }).detach();
+                loadLyricsFor(initialInfo.artist, initialInfo.title, "[LyricsFetch]");
+                beginCensorTimeline(initialInfo.artist, initialInfo.title);
             }
             
             // Disable audio fingerprinting since we have Windows Media Control
@@ -399,17 +575,14 @@ bool AudioEngine::start(const juce::String& inputDeviceName,
         
         songIdentificationAttempted = false;
         songIdentified = false;
-        recognitionBuffer.clear();
-        recognitionBuffer.reserve((int)(sampleRate * 10.0));  // Reserve 10s
-        std::cout << "[SongRec] Will attempt song identification after 10s of audio" << std::endl;
+        
+        if (songRecognition.isEnabled())
+        {
+            recognitionWorker.startCapture();
+            std::cout << "[SongRec] Will attempt song identification after 10s of audio" << std::endl;
+        }
     }
     
-    // Add audio callback
-    deviceManager.addAudioCallback(this);
-    
-    isRunning = true;
-    
-    std::cout << "[Phase5] Started successfully!" << std::endl;
     return true;
 }
 
@@ -429,9 +602,16 @@ void AudioEngine::stop()
     deviceManager.removeAudioCallback(this);
     deviceManager.closeAudioDevice();
     
+    // Idea 2: Stop song recognition (an in-flight lookup finishes within its timeout)
+    recognitionWorker.stop();
+    lyricsCache.close();
+    
+    // Proposals still queued are dropped: nothing plays any more
+    keywordSpotter.stop();
+    
     // Phase 5: Stop background thread
     shouldStopThread.store(true);
-    bufferCV.notify_one();  // Wake up thread if waiting
+    whisperWake.notify();  // Wake up thread if waiting
     
     if (whisperThread.joinable())
     {
@@ -440,12 +620,23 @@ void AudioEngine::stop()
         std::cout << "[Phase5] Background thread stopped" << std::endl;
     }
     
-    // Cleanup Whisper
-    if (whisperCtx)
-    {
-        whisper_free(whisperCtx);
-        whisperCtx = nullptr;
-    }
+    // Queued and finished-but-unread decodes are dropped with the states
+    // (multi-stream: only this stream's; the host's workers keep serving the others)
+    if (host == nullptr)
+        decodeScheduler.shutdown();
+    else
+        decodeScheduler.removeStream(decodeStream);
+    
+    // The song playing at stop is cached too (if enough of it was heard)
+    finishCensorTimeline();
+    censorTimelineCache.close();
+    
+    if (sessionArena.getPoolMisses() > 0)
+        std::cout << "[Arena] " << sessionArena.getPoolMisses() << " window(s) did not fit the pool (allocated)" << std::endl;
+    if (AllocationCounter::isEnabled())
+        std::cout << "[Arena] Audio thread heap calls since start-up: " << AllocationCounter::getRealtimeHeapCalls() << std::endl;
+    
+    // Whisper models stay loaded for the next start() (freed in destructor)
     
     isRunning = false;
     
@@ -453,6 +644,20 @@ void AudioEngine::stop()
     qualityAnalyzer.endSession();
     std::cout << "\n" << qualityAnalyzer.generateReport() << std::endl;
     
+    // Testing mode: keep the per-stage timings for tuning chunk size, model and threads
+    if (testingMode)
+    {
+        juce::File logsDir = juce::File::getCurrentWorkingDirectory().getChildFile("TestLogs");
+        logsDir.createDirectory();
+        
+        const juce::String timestamp = juce::Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S");
+        qualityAnalyzer.exportStageProfile(logsDir.getChildFile("stage_profile_" + timestamp + ".json")
+                                               .getFullPathName().toStdString());
+    }
+    
+    // Pipeline threads are stopped: flush and close the history file
+    qualityAnalyzer.stopHistorySpill();
+    
     std::cout << "[Phase5] Stopped" << std::endl;
 }
 
@@ -460,28 +665,144 @@ bool AudioEngine::setSongInfo(const std::string& artist, const std::string& titl
 {
     std::cout << "[Lyrics] Setting song info: " << artist << " - " << title << std::endl;
     
-    // Fetch lyrics from API
-    SongInfo songInfo = LyricsAlignment::fetchLyrics(artist, title);
+    // Fetch lyrics from cache or API
+    LyricsCache::Entry songInfo = lyricsCache.fetchOrLoad(artist, title);
     
-    if (songInfo.lyrics.empty())
+    if (!songInfo.hasLyrics())
     {
         std::cout << "[Lyrics] Failed to fetch lyrics" << std::endl;
-        useLyricsAlignment = false;
+        queueLyrics({}, {});
         return false;
     }
     
-    songLyrics = songInfo.lyrics;
-    // useLyricsAlignment = true;  // DISABLED FOR TESTING
-    
-    std::cout << "[Lyrics] Lyrics loaded successfully (ALIGNMENT DISABLED) (" << songLyrics.length() << " chars)" << std::endl;
+    std::cout << "[Lyrics] Lyrics loaded successfully (" << songInfo.lyrics.length() << " chars)" << std::endl;
+    queueLyrics(songInfo.lyrics, std::move(songInfo.words));
     return true;
 }
 
 void AudioEngine::setManualLyrics(const std::string& lyrics)
 {
     std::cout << "[Lyrics] Setting manual lyrics (" << lyrics.length() << " chars)" << std::endl;
-    songLyrics = lyrics;
-    useLyricsAlignment = !lyrics.empty();
+    queueLyrics(lyrics, {});    // Tokenized by setLyrics() on the Whisper thread
+}
+
+void AudioEngine::queueLyrics(std::string lyrics, std::vector<LyricsWord> words)
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingLyricsMutex);
+        pendingLyrics = PendingLyrics { std::move(lyrics), std::move(words) };
+    }
+    lyricsPending.store(true);
+    whisperWake.notify();
+}
+
+void AudioEngine::adoptPendingLyrics()
+{
+    if (!lyricsPending.exchange(false))
+        return;
+    
+    std::optional<PendingLyrics> pending;
+    {
+        std::lock_guard<std::mutex> lock(pendingLyricsMutex);
+        pending.swap(pendingLyrics);
+    }
+    if (!pending)
+        return;
+    
+    // Between windows: nothing is planning or aligning against the old lyrics
+    songLyrics = std::move(pending->lyrics);
+    lyricsAlignment.reset();
+    
+    if (!songLyrics.empty())
+    {
+        if (pending->words.empty())
+            lyricsAlignment.setLyrics(songLyrics);
+        else
+            lyricsAlignment.setPreprocessedLyrics(std::move(pending->words));
+    }
+    
+    useLyricsAlignment = lyricsAlignment.isReady();
+    
+    if (useLyricsAlignment)
+        whisperLog.info("[Lyrics] Alignment on (%d words)", lyricsAlignment.getTotalWords());
+    else
+        whisperLog.info("[Lyrics] Alignment off (no lyrics)");
+}
+
+void AudioEngine::handleRecognitionResult(const SongRecognition::SongInfo& song)
+{
+    songIdentificationAttempted = true;
+    currentSong = song;
+    
+    if (currentSong.identified)
+    {
+        songIdentified = true;
+        std::cout << "[SongRec] *** SONG IDENTIFIED ***" << std::endl;
+        std::cout << "[SongRec] Artist: " << currentSong.artist << std::endl;
+        std::cout << "[SongRec] Title: " << currentSong.title << std::endl;
+        std::cout << "[SongRec] Album: " << currentSong.album << std::endl;
+        std::cout << "[SongRec] Confidence: " << (currentSong.confidence * 100.0f) << "%" << std::endl;
+        
+        lastSongTitle = currentSong.title;
+        lastSongArtist = currentSong.artist;
+        beginCensorTimeline(currentSong.artist, currentSong.title);
+        
+        // Notify UI of song identification
+        uiState.setSong(currentSong.artist, currentSong.title, currentSong.confidence);
+        
+        if (!currentSong.lyrics.empty())
+        {
+            // fetchLyrics() went through the cache, so the words are normally preprocessed already
+            auto cached = lyricsCache.findByTitle(currentSong.artist, currentSong.title);
+            if (cached && cached->lyrics == currentSong.lyrics)
+                queueLyrics(currentSong.lyrics, std::move(cached->words));
+            else
+                queueLyrics(currentSong.lyrics, {});
+            
+            std::cout << "[SongRec] Lyrics fetched successfully (" 
+                      << currentSong.lyrics.length() << " chars)" << std::endl;
+        }
+        else
+        {
+            std::cout << "[SongRec] WARNING: Could not fetch lyrics" << std::endl;
+        }
+    }
+    else
+    {
+        std::cout << "[SongRec] Song not identified - will continue with Whisper-only mode" << std::endl;
+        
+        // Notify UI that song could not be identified
+        uiState.setSongNotRecognized();
+    }
+}
+
+void AudioEngine::loadLyricsFor(const std::string& artist, const std::string& title, const std::string& logTag)
+{
+    if (artist.empty() || title.empty())
+        return;
+    
+    std::cout << logTag << " Loading lyrics for: " << artist << " - " << title << std::endl;
+    
+    // Runs on the calling thread for a hit, on the cache's prefetch thread for a miss
+    lyricsCache.requestAsync(artist, title, [this, logTag](const LyricsCache::Entry& entry) {
+        juce::MessageManager::callAsync([this, entry, logTag]() {
+            applyCachedLyrics(entry, logTag);
+        });
+    });
+}
+
+void AudioEngine::applyCachedLyrics(const LyricsCache::Entry& entry, const std::string& logTag)
+{
+    if (!entry.hasLyrics())
+    {
+        std::cout << logTag << " ✗ No lyrics found - using raw Whisper" << std::endl;
+        return;
+    }
+    
+    queueLyrics(entry.lyrics, entry.words);
+    
+    std::cout << logTag << " ✓ Lyrics ready! Alignment starts with the next window (" 
+              << entry.lyrics.length() << " chars, " << entry.words.size() << " words)" << std::endl;
 }
 
 double AudioEngine::getCurrentLatency() const
@@ -489,8 +810,8 @@ double AudioEngine::getCurrentLatency() const
     if (!isRunning)
         return -1.0;
     
-    // Latency is constant at initialDelaySeconds (gap between input and output)
-    return initialDelaySeconds * 1000.0;
+    // Gap between input and output (adaptive, steered by latencyController)
+    return getCurrentBufferSize() * 1000.0;
 }
 
 double AudioEngine::getCurrentBufferSize() const
@@ -498,11 +819,14 @@ double AudioEngine::getCurrentBufferSize() const
     if (!isRunning)
         return 0.0;
     
-    // Calculate current delay buffer usage (gap between write and read positions)
-    // Note: These are not atomic, but reading stale values is acceptable for display purposes
-    int writePos = delayWritePos;
-    int readPos = delayReadPos;
-    int gap = (writePos - readPos + delayBufferSize) % delayBufferSize;
+    if (!delayLine)
+        return 0.0;
+    
+    // Calculate current delay buffer usage (gap between absolute write and read positions)
+    // Note: The two loads are not one snapshot, but that is acceptable for display purposes
+    juce::int64 readPos = delayReadPos.load();
+    juce::int64 writePos = delayLine->getWritePosition();
+    juce::int64 gap = std::max<juce::int64>(0, writePos - readPos);
     
     // Convert samples to seconds
     return (double)gap / sampleRate;
@@ -531,21 +855,38 @@ float AudioEngine::getCurrentInputLevel() const
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device)
 {
     std::cout << "[Phase6] Audio device about to start: " << device->getName() << std::endl;
-    bufferWritePos = 0;
+    resetCallbackState();
+}
+
+void AudioEngine::resetCallbackState()
+{
+    if (whisperWindow)
+        whisperWindow->reset();
+    whisperResampler.reset();
     transcriptionInterval = 0;
+    inputSamplesCaptured = 0;
     streamTime = 0.0;
     playbackStarted = false;  // Track when we start playing
     wasWaiting = false;
     debugCounter = 0;
     
-    // Clear delay buffer (pre-filled with silence)
-    for (auto& channel : delayBuffer)
-        std::fill(channel.begin(), channel.end(), 0.0f);
+    // Clear delay buffer (pre-filled with silence), write position back to 0
+    if (delayLine)
+        delayLine->reset();
     
     // Start with both positions at 0
-    // Playback won't start until 10 seconds buffered
+    // Playback won't start until the startup look-ahead is buffered
     delayReadPos = 0;
-    delayWritePos = 0;
+    playbackScratchSamples = 0;
+    playbackPhase = 0.0;
+    playbackStarved = false;
+    lastStretchDirection = 0;  // Measured look-ahead history stays: decode speed did not change
+    
+    // Drop censor events from a previous session (callback not running yet)
+    while (censorEventQueue.pop().has_value()) {}
+    numActiveCensorEvents = 0;
+    censorEventsApplied = 0;
+    censorEventsDropped = 0;
     
     std::cout << "[Phase6] Buffering " << initialDelaySeconds << " seconds before playback starts..." << std::endl;
 }
@@ -562,12 +903,17 @@ void AudioEngine::audioDeviceIOCallbackWithContext(const float* const* inputChan
                                                   int numSamples,
                                                   const juce::AudioIODeviceCallbackContext& context)
 {
-    static std::atomic<int> callbackCount{0};
-    int currentCount = callbackCount.fetch_add(1);
+    // Debug builds: asserts that nothing below touches the heap
+    AllocationCounter::RealtimeScope realtimeScope;
+    
+    StageProfiler& profiler = qualityAnalyzer.getStageProfiler();
+    StageProfiler::ScopedTimer callbackTimer(profiler, StageProfiler::Stage::Callback);
+    
+    const int currentCount = audioCallbackCount++;
     
     if (currentCount == 0)
     {
-        std::cout << "[Phase5] *** FIRST AUDIO CALLBACK *** " << numSamples << " samples" << std::endl;
+        audioLog.info("[Phase5] *** FIRST AUDIO CALLBACK *** %d samples", numSamples);
     }
     
     // Calculate RMS level from first input channel
@@ -583,144 +929,110 @@ void AudioEngine::audioDeviceIOCallbackWithContext(const float* const* inputChan
         currentInputLevel.store(rms);
     }
     
-    // Phase 5: Accumulate audio into buffer (mono downmix)
-    if (numInputChannels > 0 && inputChannelData[0] != nullptr)
+    // Phase 5: Accumulate audio into rolling window (mono downmix, decimated to 16kHz per block)
+    // Every sample is written (silence if no input) so the window stays on the delay buffer timeline
+    const bool hasInput = numInputChannels > 0 && inputChannelData[0] != nullptr;
+    const int monoBlockSize = (int)monoBlock.size();
+    
+    if (whisperWindow && monoBlockSize > 0)
     {
-        for (int i = 0; i < numSamples; ++i)
+        StageProfiler::ScopedTimer captureTimer(profiler, StageProfiler::Stage::Capture);
+        double resampleSeconds = 0.0;
+        
+        for (int offset = 0; offset < numSamples; offset += monoBlockSize)
         {
-            // Downmix stereo to mono
-            float monoSample = inputChannelData[0][i];
-            if (numInputChannels > 1 && inputChannelData[1] != nullptr)
-                monoSample = (monoSample + inputChannelData[1][i]) * 0.5f;
+            const int blockSamples = std::min(monoBlockSize, numSamples - offset);
             
-            // Add to buffer
-            if (bufferWritePos < audioBuffer.size())
+            for (int i = 0; i < blockSamples; ++i)
             {
-                audioBuffer[bufferWritePos] = monoSample;
-                bufferWritePos++;
+                float monoSample = 0.0f;
+                
+                if (hasInput)
+                {
+                    // Downmix stereo to mono
+                    monoSample = inputChannelData[0][offset + i];
+                    if (numInputChannels > 1 && inputChannelData[1] != nullptr)
+                        monoSample = (monoSample + inputChannelData[1][offset + i]) * 0.5f;
+                    
+                }
+                
+                monoBlock[i] = monoSample;
             }
             
-            // Idea 2 Phase 1: Accumulate audio for song recognition (first 10 seconds)
-            if (!songIdentificationAttempted && recognitionBuffer.size() < (size_t)(sampleRate * 10.0))
-            {
-                recognitionBuffer.push_back(monoSample);
-            }
+            // Anti-aliased decimation; filter state carries over to the next block
+            const auto resampleStart = std::chrono::steady_clock::now();
+            const int produced = whisperResampler.process(monoBlock.data(), blockSamples,
+                                                          resampledBlock.data(), (int)resampledBlock.size());
+            resampleSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - resampleStart).count();
+            
+            const float* resampledData = resampledBlock.data();
+            
+            // Idea 2 Phase 1: Feed song recognition (copies into its preallocated ring while armed)
+            // Fingerprints need the full band, so this happens before the vocal filter
+            if (hasInput)
+                recognitionWorker.pushAudio(resampledData, produced);
+            
+            // Vocal emphasis for Whisper; filter state carries over like the resampler's
+            if (useVocalFilter)
+                vocalFilter.process(resampledBlock.data(), produced);
+            
+            whisperWindow->writeSamples(&resampledData, 1, produced);
         }
+        
+        profiler.record(StageProfiler::Stage::Resample, resampleSeconds);
     }
     
-    // Idea 2 Phase 1: Attempt song identification after accumulating 10 seconds
-    if (!songIdentificationAttempted && recognitionBuffer.size() >= (size_t)(sampleRate * 10.0))
+    inputSamplesCaptured += numSamples;
+    
+    // Check if a hop of new audio has arrived AND Whisper is ready
+    // Consecutive windows overlap by overlapSeconds in streaming mode
+    transcriptionInterval += numSamples;
+    const int hopSamples = (int)(sampleRate * getHopSeconds());
+    
+    // Send to Whisper if: (1) we have a hop of new audio, AND (2) Whisper is ready for more
+    if (transcriptionInterval >= hopSamples && chunksInFlight.load() < maxChunksInFlight)
     {
-        songIdentificationAttempted = true;
+        // Phase 5: Publish the newest window's position (no copy, no lock)
+        // The Whisper thread reads the samples straight out of whisperWindow
+        const int windowSize = (int)(WHISPER_SAMPLE_RATE * chunkSeconds);
+        const juce::int64 windowEnd = whisperWindow->getWritePosition();
         
-        std::cout << "[SongRec] Attempting song identification with " 
-                  << (recognitionBuffer.size() / sampleRate) << " seconds of audio..." << std::endl;
+        AudioChunk chunk;
+        chunk.num_samples = (int)std::min<juce::int64>(windowSize, windowEnd);
+        chunk.buffer_position = windowEnd - chunk.num_samples;
+        chunk.num_channels = 1;
+        chunk.timestamp = streamTime;
+        chunk.published_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count();
         
-        // Try to identify the song
-        currentSong = songRecognition.identifySong(recognitionBuffer.data(), 
-                                                    (int)recognitionBuffer.size(), 
-                                                    sampleRate);
+        // Count it in flight BEFORE publishing: the Whisper thread releases the slot when it is done
+        chunksInFlight.fetch_add(1);
         
-        if (currentSong.identified)
+        if (whisperChunkQueue.push(chunk))
         {
-            songIdentified = true;
-            std::cout << "[SongRec] *** SONG IDENTIFIED ***" << std::endl;
-            std::cout << "[SongRec] Artist: " << currentSong.artist << std::endl;
-            std::cout << "[SongRec] Title: " << currentSong.title << std::endl;
-            std::cout << "[SongRec] Album: " << currentSong.album << std::endl;
-            std::cout << "[SongRec] Confidence: " << (currentSong.confidence * 100.0f) << "%" << std::endl;
-            
-            // Notify UI of song identification
-            if (songInfoCallback)
+            if (wasWaiting)
             {
-                songInfoCallback(juce::String(currentSong.artist), 
-                                juce::String(currentSong.title), 
-                                currentSong.confidence);
+                audioLog.info("[FLOW] Whisper finished! Sending next chunk immediately (buffer growing)");
+                wasWaiting = false;
             }
             
-            // Fetch lyrics if not already included
-            if (currentSong.lyrics.empty())
-            {
-                std::cout << "[SongRec] Fetching lyrics..." << std::endl;
-                currentSong.lyrics = songRecognition.fetchLyrics(currentSong.artist, currentSong.title);
-                
-                if (!currentSong.lyrics.empty())
-                {
-                    std::cout << "[SongRec] Lyrics fetched successfully (" 
-                              << currentSong.lyrics.length() << " chars)" << std::endl;
-                    // TODO Phase 1b: Align lyrics with Whisper word timestamps
-                }
-                else
-                {
-                    std::cout << "[SongRec] WARNING: Could not fetch lyrics" << std::endl;
-                }
-            }
+            whisperWake.notify();
         }
         else
         {
-            std::cout << "[SongRec] Song not identified - will continue with Whisper-only mode" << std::endl;
-            
-            // Notify UI that song could not be identified
-            if (songInfoCallback)
-            {
-                songInfoCallback(juce::String("Unknown"), 
-                                juce::String("Song not recognized"), 
-                                0.0f);
-            }
+            chunksInFlight.fetch_sub(1);
         }
         
-        // Free recognition buffer memory (no longer needed)
-        recognitionBuffer.clear();
-        recognitionBuffer.shrink_to_fit();
+        // Rolling window keeps its contents - only the hop counter restarts
+        transcriptionInterval = 0;
     }
-    
-    // Check if we've accumulated chunkSeconds of audio AND Whisper is ready
-    // Send chunks with configurable overlap between them
-    transcriptionInterval += numSamples;
-    
-    // Send to Whisper if: (1) we have chunkSeconds of audio, AND (2) Whisper is ready for more
-    if (transcriptionInterval >= (sampleRate * chunkSeconds) && !hasNewBuffer.load())
+    else if (transcriptionInterval >= hopSamples)
     {
-        // Phase 5: Signal background thread (it's ready for next chunk)
+        // We have a hop of audio but Whisper is still busy - buffer is growing!
+        if (++debugCounter % 100 == 0)  // Log every ~1 second
         {
-            std::lock_guard<std::mutex> lock(bufferMutex);
-            
-            // Copy buffer for background processing (chunkSeconds of audio)
-            int samplesToProcess = std::min(bufferWritePos, (int)(sampleRate * chunkSeconds));
-            std::copy(audioBuffer.begin(), audioBuffer.begin() + samplesToProcess, 
-                     processingBuffer.begin());
-            
-            // Store the CURRENT writePos when we send this chunk
-            // This marks where the END of the chunk is in the delay buffer
-            // The chunk starts chunkSeconds before this position
-            bufferCaptureTime = (double)delayWritePos;  // Store END position of chunk
-            
-            int chunkStartPos = (delayWritePos - (int)(sampleRate * chunkSeconds) + delayBufferSize) % delayBufferSize;
-            std::cout << "[CAPTURE] Sending chunk to Whisper | chunkStart=" << chunkStartPos 
-                      << ", chunkEnd(writePos)=" << delayWritePos << ", readPos=" << delayReadPos << std::endl;
-            
-            if (wasWaiting)
-            {
-                std::cout << "[FLOW] Whisper finished! Sending next chunk immediately (buffer growing)" << std::endl;
-                wasWaiting = false;
-            }
-            
-            hasNewBuffer.store(true);
-            bufferCV.notify_one();
-        }
-        
-        // Reset buffer for next chunk (no overlap)
-        bufferWritePos = 0;
-        transcriptionInterval = 0;
-    }
-    else if (transcriptionInterval >= (sampleRate * chunkSeconds) && hasNewBuffer.load())
-    {
-        // We have chunkSeconds of audio but Whisper is still busy - buffer is growing!
-        if (++debugCounter % 100 == 0)  // Log every ~1 second
-        {
-            double extraTime = (transcriptionInterval - (sampleRate * chunkSeconds)) / sampleRate;
-            std::cout << "[FLOW] Waiting for Whisper to finish... (accumulated " 
-                      << std::fixed << std::setprecision(2) << extraTime << "s extra audio)" << std::endl;
+            double extraTime = (double)(transcriptionInterval - hopSamples) / sampleRate;
+            audioLog.info("[FLOW] Waiting for Whisper to finish... (accumulated %.2fs extra audio)", extraTime);
             wasWaiting = true;
         }
     }
@@ -731,158 +1043,332 @@ void AudioEngine::audioDeviceIOCallbackWithContext(const float* const* inputChan
     // Only check for underrun AFTER we've started playing
     if (playbackStarted.load())
     {
-        // Critical threshold: buffer below minimum safe level (chunkSeconds + 0.5s margin)
-        double minBufferSize = chunkSeconds + 0.5;
-        double recoveryBufferSize = initialDelaySeconds;  // Recover to initial delay level
+        // Critical threshold: below the measured p50 requirement most events would arrive late
+        // (chunkSeconds + 0.5s until the first windows are measured)
+        double minBufferSize = latencyController.getMinimumSafeSeconds();
+        double recoveryBufferSize = latencyController.getRecoverySeconds();  // Recover to the measured tail
         
         if (currentBufferSize < minBufferSize && !bufferUnderrun.load())
         {
             bufferUnderrun.store(true);
-            std::cout << "\n[BUFFER UNDERRUN] Buffer dropped to " << currentBufferSize 
-                      << "s (min: " << minBufferSize << "s) - DISABLING CENSORSHIP to prevent glitches!\n" << std::endl;
+            audioLog.warning("[BUFFER UNDERRUN] Buffer dropped to %.2fs (min: %.2fs) - DISABLING CENSORSHIP to prevent glitches!",
+                             currentBufferSize, minBufferSize);
             lastUnderrunWarningTime = streamTime;
             
             // Phase 8: Record underrun event
             qualityAnalyzer.recordBufferUnderrun();
         }
-        // Recovery threshold: buffer recovered to initial delay level
+        // Recovery threshold: buffer back above the measured tail requirement
         else if (currentBufferSize > recoveryBufferSize && bufferUnderrun.load())
         {
             bufferUnderrun.store(false);
-            std::cout << "\n[BUFFER RECOVERED] Buffer restored to " << currentBufferSize 
-                      << "s - Re-enabling censorship\n" << std::endl;
+            audioLog.info("[BUFFER RECOVERED] Buffer restored to %.2fs - Re-enabling censorship", currentBufferSize);
         }
     }
     // Periodic warning if still in underrun
     else if (bufferUnderrun.load() && (streamTime - lastUnderrunWarningTime) > 5.0)
     {
-        std::cout << "[WARNING] Buffer still low: " << currentBufferSize << "s" << std::endl;
+        audioLog.warning("[WARNING] Buffer still low: %.2fs", currentBufferSize);
         lastUnderrunWarningTime = streamTime;
     }
     
-    // Phase 6: Write input to delay buffer, read from 10 seconds ago
-    for (int i = 0; i < numSamples; ++i)
+    // Phase 6: Write input to delay buffer, read it back one look-ahead later
+    // Block-wise: one write, one rate decision and one read per callback
+    const juce::int64 blockWritePos = delayLine->getWritePosition();
+    delayLine->writeSamples(inputChannelData, std::min(2, numInputChannels), numSamples);
+    
+    juce::int64 readPos = delayReadPos.load(std::memory_order_relaxed);
+    double bufferSeconds = (double)(blockWritePos - readPos) / sampleRate;
+    
+    // Start playback once the startup look-ahead is buffered (less if the first decodes
+    // were measured fast). Afterwards the delay is steered by playback rate, never by pausing.
+    bool canPlay = false;
+    if (!playbackStarted.load() && bufferSeconds >= latencyController.getTargetSeconds())
+    {
+        playbackStarted.store(true);
+        audioLog.info("[Phase6] ✓ %.2f SECONDS BUFFERED - PLAYBACK STARTING NOW!", bufferSeconds);
+        audioLog.info("[Phase6] Censored audio will now be audible");
+    }
+    
+    if (playbackStarted.load())
     {
-        // Write current input to delay buffer
-        for (int ch = 0; ch < std::min(2, numInputChannels); ++ch)
+        const double rate = latencyController.getPlaybackRate(bufferSeconds, (double)numSamples / sampleRate);
+        const int direction = latencyController.getStretchDirection();
+        
+        if (direction != lastStretchDirection)
         {
-            if (inputChannelData[ch] != nullptr)
-            {
-                delayBuffer[ch][delayWritePos] = inputChannelData[ch][i];
-            }
+            audioLog.info("[Latency] %s (look-ahead %.2fs, target %.2fs)",
+                          direction < 0 ? "Growing delay" : (direction > 0 ? "Shrinking delay" : "Holding delay"),
+                          bufferSeconds, latencyController.getTargetSeconds());
+            lastStretchDirection = direction;
         }
         
-        // Dynamic buffer management: pause playback if buffer too low, resume when filled
-        int currentGap = (delayWritePos - delayReadPos + delayBufferSize) % delayBufferSize;
-        double bufferSeconds = (double)currentGap / sampleRate;
+        canPlay = renderDelayedOutput(outputChannelData, numOutputChannels, numSamples, rate);
         
-        // Start playback when buffer reaches 10 seconds
-        // Pause playback if buffer drops below 8 seconds (RTF > 1.0 catching up)
-        // Resume playback when buffer recovers to 10 seconds
-        bool canPlay;
-        if (!playbackStarted.load())
+        if (canPlay == playbackStarved)
         {
-            // Initial buffering: need initialDelaySeconds to start
-            canPlay = (bufferSeconds >= initialDelaySeconds);
-            if (canPlay)
-            {
-                playbackStarted.store(true);
-                std::cout << "\n[Phase6] ✓ " << initialDelaySeconds << " SECONDS BUFFERED - PLAYBACK STARTING NOW!" << std::endl;
-                std::cout << "[Phase6] Censored audio will now be audible\n" << std::endl;
-            }
+            playbackStarved = !canPlay;
+            audioLog.write(canPlay ? AsyncLogger::Level::Info : AsyncLogger::Level::Warning, "[Phase6] %s",
+                           canPlay ? "✓ Delay line refilled - RESUMING playback" : "⚠ Delay line ran dry - outputting silence");
         }
-        else
+    }
+    
+    if (!canPlay)
+    {
+        // Output silence while buffering
+        for (int ch = 0; ch < numOutputChannels; ++ch)
         {
-            // Dynamic buffering: pause if too low, resume when recovered
-            static bool wasPaused = false;
-            
-            double pauseThreshold = initialDelaySeconds - 2.0;  // Pause at initialDelaySeconds - 2s
-            double resumeThreshold = initialDelaySeconds;       // Resume at initialDelaySeconds
+            if (outputChannelData[ch] != nullptr)
+                std::fill(outputChannelData[ch], outputChannelData[ch] + numSamples, 0.0f);
+        }
+    }
+    
+    // Update stream time (tracks the DELAYED output time)
+    streamTime += (double)numSamples / sampleRate;
+    
+    if (currentCount == 0)
+        audioLog.info("[Phase6] Audio passthrough + censorship active");
+}
+
+bool AudioEngine::renderDelayedOutput(float* const* outputChannelData, int numOutputChannels,
+                                      int numSamples, double rate)
+{
+    juce::int64 readPos = delayReadPos.load(std::memory_order_relaxed);
+    
+    // Everything this block consumes must already be in the delay line
+    const juce::int64 worstCaseFetch = (juce::int64)std::ceil(playbackPhase + numSamples * rate) + 2 - playbackScratchSamples;
+    if (delayLine->getWritePosition() - readPos < worstCaseFetch)
+        return false;
+    
+    float* scratch[2] = { playbackScratch[0].data(), playbackScratch[1].data() };
+    const int maxBlock = ((int)playbackScratch[0].size() - 4) / 2;
+    
+    for (int offset = 0; offset < numSamples;)
+    {
+        const int count = std::min(maxBlock, numSamples - offset);
+        
+        // Input span the interpolation touches. Samples held over from the last block were
+        // censored when they were read, so every input sample is read and censored exactly once.
+        const int needed = (int)(playbackPhase + (count - 1) * rate) + 2;
+        const int fetch = needed - playbackScratchSamples;
+        if (fetch > 0)
+        {
+            float* fetchDest[2] = { scratch[0] + playbackScratchSamples, scratch[1] + playbackScratchSamples };
+            delayLine->readSamples(fetchDest, 2, readPos, fetch);
+            applyScheduledCensorship(fetchDest, 2, readPos, fetch);
+            readPos += fetch;
+            playbackScratchSamples = needed;
+        }
+        
+        // Linear interpolation (a plain copy at rate 1 and zero phase);
+        // extra output channels repeat the last channel
+        for (int ch = 0; ch < numOutputChannels; ++ch)
+        {
+            float* out = outputChannelData[ch];
+            if (out == nullptr)
+                continue;
             
-            if (bufferSeconds < pauseThreshold && !wasPaused)
+            const float* in = scratch[std::min(ch, 1)];
+            double position = playbackPhase;
+            for (int i = 0; i < count; ++i)
             {
-                wasPaused = true;
-                std::cout << "\n[Phase6] ⚠ Buffer dropped to " << std::fixed << std::setprecision(2) 
-                         << bufferSeconds << "s - PAUSING playback to rebuild buffer\n" << std::endl;
+                const int index = (int)position;
+                const float frac = (float)(position - index);
+                out[offset + i] = in[index] + frac * (in[index + 1] - in[index]);
+                position += rate;
             }
-            else if (bufferSeconds >= resumeThreshold && wasPaused)
-            {
-                wasPaused = false;
-                std::cout << "\n[Phase6] ✓ Buffer recovered to " << std::fixed << std::setprecision(2) 
-                         << bufferSeconds << "s - RESUMING playback\n" << std::endl;
-            }
-            
-            canPlay = !wasPaused;
         }
         
-        for (int ch = 0; ch < numOutputChannels; ++ch)
+        // Drop what was consumed, keep the interpolation tail for the next block
+        const double end = playbackPhase + count * rate;
+        const int consumed = std::min((int)end, playbackScratchSamples);
+        playbackPhase = end - consumed;
+        playbackScratchSamples -= consumed;
+        for (int ch = 0; ch < 2; ++ch)
+            std::memmove(scratch[ch], scratch[ch] + consumed, (size_t)playbackScratchSamples * sizeof(float));
+        
+        offset += count;
+    }
+    
+    // Back at real time: drop the sub-sample offset so playback is an exact copy again
+    if (rate == 1.0)
+        playbackPhase = std::round(playbackPhase);
+    
+    delayReadPos.store(readPos, std::memory_order_release);
+    delayLine->setReadPosition(readPos);
+    return true;
+}
+
+void AudioEngine::applyScheduledCensorship(float* const* outputChannelData, int numOutputChannels,
+                                           juce::int64 blockStart, int numSamples)
+{
+    // Pull new events into the pending timeline
+    while (auto queued = censorEventQueue.pop())
+    {
+        CensorEvent event = *queued;
+        
+        // Whisper withdrew a proposal: drop its tentative event unless it already started playing
+        if (event.cancel)
         {
-            if (outputChannelData[ch] != nullptr)
+            for (int i = 0; i < numActiveCensorEvents; ++i)
             {
-                if (canPlay)
-                {
-                    int readCh = std::min(ch, 1);  // Stereo only
-                    outputChannelData[ch][i] = delayBuffer[readCh][delayReadPos];
-                }
-                else
+                const CensorEvent& pending = activeCensorEvents[i];
+                if (pending.tentative && pending.start_sample == event.start_sample
+                    && pending.end_sample == event.end_sample && pending.start_sample >= blockStart)
                 {
-                    // Output silence while buffering
-                    outputChannelData[ch][i] = 0.0f;
+                    std::copy(activeCensorEvents.begin() + i + 1, activeCensorEvents.begin() + numActiveCensorEvents,
+                              activeCensorEvents.begin() + i);
+                    --numActiveCensorEvents;
+                    break;
                 }
             }
+            continue;
         }
         
-        // Always advance write position
-        delayWritePos = (delayWritePos + 1) % delayBufferSize;
+        // Deadline slack: how much audio was left before the event starts playing
+        qualityAnalyzer.getStageProfiler().recordDeadlineSlack(event.start_sample - blockStart, sampleRate);
+        
+        // readPos already passed it - the audio is playing/played, leave it alone
+        if (event.end_sample <= blockStart)
+        {
+            censorEventsDropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
         
-        // Only advance read position if we're playing
-        if (canPlay)
+        // Merge with a pending event of the same mode that hasn't started playing yet.
+        // Two tentative events stay apart (each can be withdrawn alone); merging with a
+        // decoded event makes the result final.
+        bool merged = false;
+        for (int i = 0; i < numActiveCensorEvents && !merged; ++i)
         {
-            delayReadPos = (delayReadPos + 1) % delayBufferSize;
+            CensorEvent& pending = activeCensorEvents[i];
+            bool overlaps = event.start_sample <= pending.end_sample && pending.start_sample <= event.end_sample;
+            
+            if (overlaps && pending.mode == event.mode && pending.start_sample >= blockStart && event.start_sample >= blockStart
+                && !(pending.tentative && event.tentative))
+            {
+                pending.start_sample = std::min(pending.start_sample, event.start_sample);
+                pending.end_sample = std::max(pending.end_sample, event.end_sample);
+                pending.tentative = false;
+                merged = true;
+            }
         }
+        
+        if (merged)
+            continue;
+        
+        if (numActiveCensorEvents < MAX_ACTIVE_CENSOR_EVENTS)
+            activeCensorEvents[numActiveCensorEvents++] = event;
+        else
+            censorEventsDropped.fetch_add(1, std::memory_order_relaxed);
     }
     
-    // Update stream time (tracks the DELAYED output time)
-    streamTime += (double)numSamples / sampleRate;
+    // Render overlapping events, retire the ones this block finishes
+    const juce::int64 blockEnd = blockStart + numSamples;
+    int kept = 0;
     
-    if (currentCount == 0)
-        std::cout << "[Phase6] Audio passthrough + censorship active" << std::endl;
+    for (int i = 0; i < numActiveCensorEvents; ++i)
+    {
+        const CensorEvent& event = activeCensorEvents[i];
+        
+        censorshipEngine.applyEventToBlock(outputChannelData, numOutputChannels, blockStart, numSamples,
+                                           event, *delayLine, sampleRate);
+        
+        if (event.end_sample > blockEnd)
+            activeCensorEvents[kept++] = event;
+        else
+            censorEventsApplied.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    numActiveCensorEvents = kept;
 }
 
 void AudioEngine::whisperThreadFunction()
 {
     std::cout << "[Phase5] Whisper background thread running" << std::endl;
     
-    // Local buffer for processing (avoids race condition)
-    std::vector<float> localBuffer(sampleRate * chunkSeconds);
-    
     while (!shouldStopThread.load())
     {
-        std::unique_lock<std::mutex> lock(bufferMutex);
+        bool didWork = false;
         
-        // Wait for new buffer or stop signal
-        bufferCV.wait(lock, [this] { 
-            return hasNewBuffer.load() || shouldStopThread.load(); 
-        });
+        // Larger tiers finish loading in the background while we decode
+        adoptLoadedModels();
+        
+        // New lyrics are installed between windows (never under planWindow()/alignChunk())
+        adoptPendingLyrics();
+        
+        // Known songs: follow the song position, record this play's timeline
+        adoptTimelineSong();
+        feedCensorTimeline();
+        
+        publishUiStats();
         
-        if (shouldStopThread.load())
-            break;
+        StageProfiler& profiler = qualityAnalyzer.getStageProfiler();
         
-        if (hasNewBuffer.load())
+        // Two-tier detection: the spotter's proposals have the most look-ahead left, schedule them first
+        if (keywordSpotter.isRunning() && scheduleProposedCensorship())
+            didWork = true;
+        
+        // Hand every published window to the decode scheduler (the audio callback keeps writing whisperWindow)
+        while (auto chunkOpt = whisperChunkQueue.pop())
+        {
+            didWork = true;
+            const AudioChunk chunk = *chunkOpt;
+            
+            const juce::int64 nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch()).count();
+            profiler.record(StageProfiler::Stage::Handoff, (double)(nowNs - chunk.published_ns) * 1.0e-9);
+            
+            std::vector<float> localBuffer = sessionArena.acquireWindow(chunk.num_samples);
+            float* localData = localBuffer.data();
+            whisperWindow->readSamples(&localData, 1, chunk.buffer_position, chunk.num_samples);
+            
+            // The writer never waits for us: if it lapped the window while we copied, drop it
+            const juce::int64 chunkEnd = chunk.buffer_position + chunk.num_samples;
+            if (whisperWindow->getWritePosition() - chunk.buffer_position > whisperWindow->getCapacity())
+            {
+                whisperLog.warning("[Phase5] WARNING: Window overwritten before it was read - skipping");
+                sessionArena.recycleWindow(std::move(localBuffer));
+                chunksInFlight.fetch_sub(1);
+                continue;
+            }
+            
+            // Map the 16kHz window end onto the device-rate delay line timeline
+            const juce::int64 captureEnd = toCaptureSample(chunkEnd);
+            
+            whisperLog.info("[CAPTURE] Window from Whisper queue | start=%lld, end=%lld, readPos=%lld",
+                            captureEnd - (juce::int64)chunk.num_samples * sampleRate / WHISPER_SAMPLE_RATE,
+                            captureEnd, delayReadPos.load());
+            
+            if (!submitTranscription(localBuffer, captureEnd))
+                sessionArena.recycleWindow(std::move(localBuffer));    // Skipped: the window was not decoded
+        }
+        
+        // Finished decodes come back in window order; the stream state is only touched here
+        WhisperDecodeScheduler::Result decode;
+        while (decodeScheduler.popCompleted(decode, decodeStream))
         {
-            std::cout << "[Phase5] Processing " << chunkSeconds << "-second buffer in background..." << std::endl;
+            didWork = true;
             
-            // Copy to local buffer BEFORE releasing lock
-            std::copy(processingBuffer.begin(), processingBuffer.end(), localBuffer.begin());
-            double captureTime = bufferCaptureTime;  // Copy timestamp
-            hasNewBuffer.store(false);
+            // Worker timings are recorded here so every decode stage has one writer
+            profiler.record(StageProfiler::Stage::DecodeQueue, decode.queueSeconds);
+            if (decode.status == 0)
+            {
+                profiler.record(StageProfiler::Stage::WhisperSetup, decode.setupSeconds);
+                profiler.record(StageProfiler::Stage::WhisperDecode, decode.decodeSeconds - decode.setupSeconds);
+            }
             
-            // NOW release the lock - audio callback can write new data safely
-            lock.unlock();
+            processTranscription(decode);
+            decodeScheduler.release(decode);
+            sessionArena.recycleWindow(std::move(decode.job.samples));
             
-            // Process the LOCAL buffer with its capture timestamp
-            processTranscription(localBuffer, captureTime);
+            // Slot free: the callback publishes the freshest window on its next block
+            chunksInFlight.fetch_sub(1);
         }
+        
+        // Sleep until a window is published or a decode finishes (timeout re-checks shouldStopThread)
+        if (!didWork)
+            whisperWake.wait(100);
     }
     
     std::cout << "[Phase5] Whisper background thread exiting" << std::endl;
@@ -975,200 +1461,420 @@ void AudioEngine::writeTestingLog(const std::string& artist, const std::string&
     std::cout << "[Testing]   Full path: " << filename << std::endl;
 }
 
-std::vector<float> AudioEngine::resampleTo16kHz(const std::vector<float>& input)
+double AudioEngine::getHopSeconds() const
 {
-    if (sampleRate == 16000)
-        return input;
+    if (!streamingMode)
+        return chunkSeconds;
     
-    // Simple linear interpolation resample
-    double ratio = (double)sampleRate / 16000.0;
-    size_t outputSize = (size_t)(input.size() / ratio);
-    std::vector<float> output(outputSize);
+    // Keep at least 100ms of new audio per decode
+    return std::max(0.1, chunkSeconds - overlapSeconds);
+}
+
+int AudioEngine::selectModelTier(juce::int64 captureEndSample)
+{
+    if (modelTiers.size() <= 1 || primaryModelTier <= 0)
+        return std::max(0, primaryModelTier);
+    
+    // Look-ahead left for this window: delay buffer minus how long the window already waited
+    double bufferSeconds = getCurrentBufferSize();
+    double windowAge = (double)(inputSamplesCaptured.load() - captureEndSample) / sampleRate;
+    double lookAhead = bufferSeconds - windowAge;
+    
+    // Hysteresis between emergency tiny.en mode and normal operation
+    if (whisperCtxTiny != nullptr)  // Only if fallback loaded
+    {
+        if (lookAhead < switchToTinyThreshold && !usingTinyModel.load())
+        {
+            usingTinyModel.store(true);
+            whisperLog.warning("[ADAPTIVE] Buffer low (%.2fs) - Switching to tiny.en (faster, lower accuracy)", lookAhead);
+        }
+        else if (lookAhead > switchToSmallThreshold && usingTinyModel.load())
+        {
+            usingTinyModel.store(false);
+            whisperLog.info("[ADAPTIVE] Buffer recovered (%.2fs) - Switching back to %s (better accuracy)",
+                            lookAhead, modelTiers[primaryModelTier].name);
+        }
+        
+        if (usingTinyModel.load())
+            return 0;
+    }
     
-    for (size_t i = 0; i < outputSize; ++i)
+    // Most accurate model whose predicted processing time still leaves switchToTinyThreshold
+    // of look-ahead. Models above the primary are only considered with a healthy buffer.
+    int ceiling = (allowLargerThanPrimary && lookAhead > switchToSmallThreshold) 
+                      ? (int)modelTiers.size() - 1 
+                      : primaryModelTier;
+    double hopSeconds = getHopSeconds();
+    
+    for (int tier = ceiling; tier > 0; --tier)
     {
-        double srcPos = i * ratio;
-        size_t srcIndex = (size_t)srcPos;
-        double frac = srcPos - srcIndex;
+        // rtfEstimate is per slot's share of the budget: one window's wall time spans every slot
+        double predictedSeconds = modelTiers[tier].rtfEstimate * hopSeconds * maxChunksInFlight;
+        bool keepsUp = modelTiers[tier].rtfEstimate < 1.0;
         
-        if (srcIndex + 1 < input.size())
-            output[i] = input[srcIndex] * (1.0f - frac) + input[srcIndex + 1] * frac;
-        else
-            output[i] = input[srcIndex];
+        if (keepsUp && lookAhead - predictedSeconds >= switchToTinyThreshold)
+            return tier;
     }
     
-    return output;
+    return 0;
 }
 
-void AudioEngine::processTranscription(const std::vector<float>& buffer, double captureTime)
+void AudioEngine::recordModelTiming(int tier, double realTimeFactor, double audioSeconds)
 {
-    if (!whisperCtx)
+    if (tier < 0 || tier >= (int)modelTiers.size())
         return;
     
-    try
+    auto& model = modelTiers[tier];
+    model.rtfEstimate = (model.chunksDecoded == 0)
+                            ? realTimeFactor
+                            : (1.0 - rtfSmoothing) * model.rtfEstimate + rtfSmoothing * realTimeFactor;
+    model.chunksDecoded++;
+    
+    qualityAnalyzer.recordModelUsage(model.name, audioSeconds, realTimeFactor);
+}
+
+double AudioEngine::getRequiredLookAheadSeconds(juce::int64 committedFromSample) const
+{
+    // Events of this window start at its earliest new word minus the censor padding; a word is
+    // committed by its midpoint, so it can begin up to half a word before committedFromSample
+    const double halfWordSeconds = 0.15;
+    return (double)(inputSamplesCaptured.load() - committedFromSample) / sampleRate
+         + censorPaddingBeforeSeconds + halfWordSeconds;
+}
+
+void AudioEngine::recordLookAheadRequirement(juce::int64 committedFromSample)
+{
+    const double requiredSeconds = getRequiredLookAheadSeconds(committedFromSample);
+    
+    latencyController.recordRequiredLookAhead(requiredSeconds);
+    qualityAnalyzer.recordLookAhead(requiredSeconds, latencyController.getTargetSeconds());
+}
+
+bool AudioEngine::submitTranscription(std::vector<float>& buffer, juce::int64 captureEndSample)
+{
+    if (modelTiers.empty() || buffer.empty())
+    {
+        chunksInFlight.fetch_sub(1);
+        return false;
+    }
+    
+    const double hopSeconds = getHopSeconds();
+    
+    // Lyrics locked: censor from the lyrics ahead of capture, decode only to verify
+    LyricsFastPath::Decision fastPath = LyricsFastPath::Decision::Full;
+    if (useLyricsAlignment && !songLyrics.empty())
+    {
+        const juce::int64 windowStartSample = captureEndSample - (juce::int64)buffer.size() * sampleRate / WHISPER_SAMPLE_RATE;
+        fastPath = lyricsFastPath.planWindow(lyricsAlignment, windowStartSample, captureEndSample);
+        schedulePredictedCensorship(captureEndSample);
+    }
+    else if (lyricsFastPath.isEngaged())
+    {
+        lyricsFastPath.disengage("lyrics alignment off");
+    }
+    noteFastPathTransition();
+    
+    // Known song replayed: censor from its cached timeline, decode only to spot-verify
+    if (censorTimeline.hasSong())
     {
-        // Calculate delay duration for timestamp calculation
-        double delaySeconds = (double)delayBufferSize / sampleRate;
+        const juce::int64 windowStartSample = captureEndSample - (juce::int64)buffer.size() * sampleRate / WHISPER_SAMPLE_RATE;
+        const LyricsFastPath::Decision replay = censorTimeline.planWindow(windowStartSample, captureEndSample);
+        scheduleCachedCensorship(captureEndSample);
         
-        // Start timing
-        auto startTime = std::chrono::high_resolution_clock::now();
+        // Decisions are ordered by how much they decode: with both engaged the more cautious one wins
+        if (censorTimeline.isEngaged())
+            fastPath = lyricsFastPath.isEngaged() ? std::min(fastPath, replay) : replay;
+    }
+    noteTimelineTransition();
+    
+    if (fastPath == LyricsFastPath::Decision::Skip)
+    {
+        if (lyricsFastPath.isEngaged())
+        {
+            whisperLog.info("[FastPath] Skipping decode (lyrics position %d predicted)",
+                            lyricsFastPath.predictPosition(captureEndSample));
+            qualityAnalyzer.recordFastPathDecision(false, hopSeconds);
+        }
+        if (censorTimeline.isEngaged())
+        {
+            whisperLog.info("[Timeline] Skipping decode (song at %.1fs on the cached timeline)",
+                            censorTimeline.getSongSeconds(captureEndSample));
+            qualityAnalyzer.recordTimelineDecision(false, hopSeconds);
+        }
+        qualityAnalyzer.updateSessionDuration(streamTime);
         
-        // Log current buffer size with detailed analysis
-        double currentBufferSize = getCurrentBufferSize();
-        int rawGap = delayWritePos - delayReadPos;
-        int actualGap = (delayWritePos - delayReadPos + delayBufferSize) % delayBufferSize;
+        // The next decoded window no longer follows the carried prompt; the aligner catches up in processTranscription
+        streamPromptTokens.clear();
+        songElapsedTime += hopSeconds;
+        fastPathSkippedUntil = captureEndSample;
+        chunksInFlight.fetch_sub(1);
+        return false;
+    }
+    
+    if (fastPath != LyricsFastPath::Decision::Full)
+    {
+        if (lyricsFastPath.isEngaged())
+            qualityAnalyzer.recordFastPathDecision(true, hopSeconds);
+        if (censorTimeline.isEngaged())
+            qualityAnalyzer.recordTimelineDecision(true, hopSeconds);
+    }
+    
+    // Phase 9: Pick the model for this chunk from buffer health and measured RTF
+    // (heartbeat verification always runs on the fastest tier)
+    const int modelTier = (fastPath == LyricsFastPath::Decision::Verify) ? 0 : selectModelTier(captureEndSample);
+    const std::string& modelName = modelTiers[modelTier].name;
+    
+    if (modelTier != lastModelTier)
+    {
+        whisperLog.info("[ADAPTIVE] Decoding with %s (estimated RTF %.2fx)", modelName, modelTiers[modelTier].rtfEstimate);
+        lastModelTier = modelTier;
         
-        std::cout << "[BUFFER] Size: " << std::fixed << std::setprecision(2) << currentBufferSize << "s";
-        std::cout << " | writePos=" << delayWritePos << ", readPos=" << delayReadPos;
-        std::cout << " | raw gap=" << rawGap << ", actual gap=" << actualGap << " samples";
-        std::cout << " | bufSize=" << delayBufferSize << std::endl;
+        // Token ids are shared across the .en vocabularies, but a fresh model starts without prompt
+        streamPromptTokens.clear();
+    }
+    
+    // Log current buffer size with detailed analysis
+    double currentBufferSize = getCurrentBufferSize();
+    juce::int64 writePos = delayLine->getWritePosition();
+    juce::int64 readPos = delayReadPos.load();
+    
+    whisperLog.info("[BUFFER] Size: %.2fs | writePos=%lld, readPos=%lld | gap=%lld samples | bufSize=%d",
+                    currentBufferSize, writePos, readPos, writePos - readPos, delayBufferSize);
+    
+    // Phase 8: Record buffer health
+    qualityAnalyzer.recordBufferSize(currentBufferSize);
+    
+    // Skip the decode outright when the window holds no vocals (intros, bridges, gaps
+    // between tracks). Stream state is left alone, so the next decoded window's overlap
+    // still covers the end of this one.
+    const VocalActivityGate::Decision gate = vocalGate.analyze(buffer.data(), (int)buffer.size());
+    qualityAnalyzer.recordGateDecision(gate.decode, hopSeconds);
+    
+    if (!gate.decode)
+    {
+        whisperLog.info("[VocalGate] Skipping decode (%s, vocal frames %.0f%%, peak %.3f)",
+                        gate.reason, gate.vocalFraction * 100.0f, gate.peakLevel);
+        qualityAnalyzer.updateSessionDuration(streamTime);
+        chunksInFlight.fetch_sub(1);
+        return false;
+    }
+    
+    if (std::strcmp(gate.reason, "vocal") != 0)
+        whisperLog.info("[VocalGate] Decoding (%s)", gate.reason);
+    
+    // (Vocal filtering already happened per block in the audio callback: useVocalFilter)
+    
+    // DEBUG: Save first 10 chunks to WAV for quality inspection
+    if (debugChunksSaved < 10)
+    {
+        // Create DebugAudio directory if it doesn't exist
+        juce::File debugDir = juce::File::getCurrentWorkingDirectory().getChildFile("DebugAudio");
+        if (!debugDir.exists())
+        {
+            debugDir.createDirectory();
+            whisperLog.debug("[DEBUG] Created DebugAudio directory: %s", debugDir.getFullPathName().toStdString());
+        }
         
-        // Phase 8: Record buffer health
-        qualityAnalyzer.recordBufferSize(currentBufferSize);
+        std::string filename = debugDir.getChildFile("debug_chunk_" + juce::String(debugChunksSaved++) + ".wav").getFullPathName().toStdString();
+        saveWavFile(filename, buffer, WHISPER_SAMPLE_RATE);
+        whisperLog.debug("[DEBUG] Saved %s for inspection", filename);
+    }
+    
+    // Configure Whisper parameters - OPTIMIZED FOR SPEED
+    // (n_threads comes from the scheduler's core split)
+    WhisperDecodeScheduler::Job job;
+    whisper_full_params& wparams = job.params;
+    wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.print_realtime = false;
+    wparams.print_progress = false;
+    wparams.print_timestamps = true;  // Enable for word-level timing
+    wparams.print_special = false;
+    wparams.translate = false;
+    wparams.language = "en";
+    wparams.single_segment = false;
+    wparams.token_timestamps = false;
+    wparams.max_len = 0;
+    
+    // Streaming: carry the previously emitted tokens as prompt instead of Whisper's internal
+    // context (which would also contain the not-yet-stable tail of the last window).
+    // With decodes overlapping, the prompt stops at the last window finished before this one.
+    wparams.no_context = true;
+    if (streamingMode)
+        job.prompt = streamPromptTokens;
+    
+    // Speed optimizations (valid parameters only)
+    wparams.audio_ctx = 1500;  // Enable audio context for music disambiguation
+    wparams.temperature = 0.0f;  // Start with greedy decoding
+    wparams.temperature_inc = 0.2f;  // Try multiple decoding strategies (0, 0.2, 0.4, 0.6, 0.8, 1.0)
+    wparams.entropy_thold = 5.0f;  // Don't skip uncertain segments (music has high entropy)
+    wparams.logprob_thold = -1.0f;  // Accept lower probability tokens (faster)
+    
+    // Targeted re-decoding: no whole-window fallbacks, the worker re-decodes flagged sub-windows only
+    if (redecodePolicy.isEnabled())
+    {
+        RedecodePolicy::configureFirstPass(wparams);
+        job.redecodePolicy = &redecodePolicy;
+        if (redecodeWithLargerModel && !usingTinyModel.load() && modelTier + 1 < (int)modelTiers.size())
+            job.redecodeModel = modelTier + 1;
+    }
+    
+    whisperLog.info("[Phase5] Window: %zu samples @ 16kHz queued for %s (%d/%d in flight)",
+                    buffer.size(), modelName, chunksInFlight.load(), maxChunksInFlight);
+    
+    // Detection deadline: the latest decode start that still gets this window's first new word
+    // censored (a multi-stream scheduler serves the stream with the least slack first)
+    const double delaySeconds = playbackStarted.load() ? getCurrentBufferSize() : latencyController.getTargetSeconds();
+    const double marginSeconds = streamingMode ? std::min(stableMarginSeconds, overlapSeconds) : 0.0;
+    const juce::int64 firstNewSample = captureEndSample - (juce::int64)((hopSeconds + marginSeconds) * sampleRate);
+    const double expectedDecodeSeconds = modelTiers[modelTier].rtfEstimate * hopSeconds * maxChunksInFlight;
+    const double slackSeconds = delaySeconds - getRequiredLookAheadSeconds(firstNewSample) - expectedDecodeSeconds;
+    
+    whisperLog.debug("[Scheduler] Stream %d: %.2fs slack (look-ahead %.2fs)", decodeStream, slackSeconds, delaySeconds);
+    
+    job.stream = decodeStream;
+    job.deadline = std::chrono::steady_clock::now()
+                 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(slackSeconds));
+    job.model = modelTier;
+    job.samples = std::move(buffer);
+    job.captureEndSample = captureEndSample;
+    
+    if (!decodeScheduler.submit(std::move(job)))
+    {
+        whisperLog.error("[Phase5] ERROR: Decode scheduler not running - window dropped");
+        chunksInFlight.fetch_sub(1);
+    }
+    
+    return true;
+}
+
+void AudioEngine::processTranscription(const WhisperDecodeScheduler::Result& decode)
+{
+    if (modelTiers.empty() || decode.job.samples.empty())
+        return;
+    
+    StageProfiler& profiler = qualityAnalyzer.getStageProfiler();
+    StageProfiler::ScopedTimer postProcessTimer(profiler, StageProfiler::Stage::PostProcess);
+    
+    try
+    {
+        const double hopSeconds = getHopSeconds();
+        const int modelTier = decode.job.model;
+        whisper_context* activeCtx = decode.ctx;
+        whisper_state* activeState = decode.state;
+        const std::string& modelName = modelTiers[modelTier].name;
+        const juce::int64 captureEndSample = decode.job.captureEndSample;
         
-        // Phase 5: Process the buffer passed as parameter (already a local copy in thread)
-        int samplesToProcess = (int)(sampleRate * chunkSeconds);
-        samplesToProcess = std::min(samplesToProcess, (int)buffer.size());
-        std::vector<float> bufferCopy(buffer.begin(), buffer.begin() + samplesToProcess);
+        // Start timing (post-processing; the decode itself was timed by its worker)
+        auto startTime = std::chrono::high_resolution_clock::now();
         
-        // DISABLED: Vocal filtering may be degrading audio quality for Whisper
-        // vocalFilter.processBuffer(bufferCopy);
+        // Already resampled to 16kHz (and vocal-filtered) by the audio callback
+        const std::vector<float>& bufferCopy = decode.job.samples;
+        const double windowSeconds = (double)bufferCopy.size() / WHISPER_SAMPLE_RATE;
         
-        audioBuffer16k = resampleTo16kHz(bufferCopy);
+        // Absolute window position on the delay buffer timeline (device-rate samples)
+        const int samplesToProcess = (int)std::lround(windowSeconds * sampleRate);
+        const juce::int64 windowStartSample = captureEndSample - samplesToProcess;
         
-        // DEBUG: Save first 10 chunks to WAV for quality inspection
-        static int chunkCounter = 0;
-        if (chunkCounter < 10)
-        {
-            // Create DebugAudio directory if it doesn't exist
-            juce::File debugDir = juce::File::getCurrentWorkingDirectory().getChildFile("DebugAudio");
-            if (!debugDir.exists())
-            {
-                debugDir.createDirectory();
-                std::cout << "[DEBUG] Created DebugAudio directory: " << debugDir.getFullPathName() << std::endl;
-            }
-            
-            std::string filename = debugDir.getChildFile("debug_chunk_" + juce::String(chunkCounter++) + ".wav").getFullPathName().toStdString();
-            saveWavFile(filename, audioBuffer16k, 16000);
-            std::cout << "[DEBUG] Saved " << filename << " for inspection" << std::endl;
-        }
+        whisperLog.info("[Phase5] Window: %zu samples @ 16kHz (%d device samples) decoded by %s in %.2fs",
+                        bufferCopy.size(), samplesToProcess, modelName, decode.decodeSeconds);
         
-        std::cout << "[Phase5] Resampled " << samplesToProcess << " samples to " 
-                  << audioBuffer16k.size() << " samples @ 16kHz" << std::endl;
-        
-        // Configure Whisper parameters - OPTIMIZED FOR SPEED
-        whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        wparams.print_realtime = false;
-        wparams.print_progress = false;
-        wparams.print_timestamps = true;  // Enable for word-level timing
-        wparams.print_special = false;
-        wparams.translate = false;
-        wparams.language = "en";
-        wparams.n_threads = 8;  // Increase threads (use all CPU cores)
-        wparams.single_segment = false;
-        wparams.token_timestamps = false;
-        wparams.max_len = 0;
-        
-        // Speed optimizations (valid parameters only)
-        wparams.audio_ctx = 1500;  // Enable audio context for music disambiguation
-        wparams.temperature = 0.0f;  // Start with greedy decoding
-        wparams.temperature_inc = 0.2f;  // Try multiple decoding strategies (0, 0.2, 0.4, 0.6, 0.8, 1.0)
-        wparams.entropy_thold = 5.0f;  // Don't skip uncertain segments (music has high entropy)
-        wparams.logprob_thold = -1.0f;  // Accept lower probability tokens (faster)
-        
-        // Run transcription
-        int result = whisper_full(whisperCtx, wparams, audioBuffer16k.data(), (int)audioBuffer16k.size());
-        
-        if (result != 0)
+        if (decode.status != 0 || activeState == nullptr)
         {
-            std::cout << "[Phase5] Whisper transcription failed with code " << result << std::endl;
+            whisperLog.error("[Phase5] Whisper transcription failed with code %d", decode.status);
             return;
         }
         
-        // CRITICAL: Reset Whisper state to prevent memory accumulation
-        // Without this, KV cache grows indefinitely and RTF increases over time
-        whisper_reset_timings(whisperCtx);
+        // Per-window vectors come from the session arena (cleared, capacity kept)
+        SessionArena::WindowScratch& scratch = sessionArena.beginWindow();
         
         // Extract word-level segments using SEGMENT timestamps (more reliable than token timestamps)
-        int numSegments = whisper_full_n_segments(whisperCtx);
-        std::vector<WordSegment> transcribedWords;
+        std::vector<WordSegment>& transcribedWords = scratch.transcribedWords;
+        std::vector<whisper_token>& transcribedTokens = scratch.transcribedTokens;  // Token id per word (prompt for next window)
+        
+        if (decode.redecode.ran)
+        {
+            // Words were extracted (and partly re-decoded) by the worker
+            transcribedWords = decode.words;
+            transcribedTokens = decode.tokens;
+            profiler.record(StageProfiler::Stage::Redecode, decode.redecode.secondPassSeconds);
+            whisperLog.info("[Redecode] %s", decode.redecode.describe());
+        }
+        else
+        {
+            whisperLog.debug("[Phase6] Using segment-level timestamps (token timestamps unreliable)");
+            WhisperTranscript::extractWords(activeCtx, activeState, windowSeconds, transcribedWords, transcribedTokens);
+        }
+        
+        whisperLog.info("[Phase5] Extracted %zu word segments", transcribedWords.size());
         
-        std::cout << "[Phase6] Using segment-level timestamps (token timestamps unreliable)" << std::endl;
+        // Phase 6: Refine timestamps using audio energy analysis
+        whisperLog.debug("[Phase6] Refining timestamps...");
+        timestampRefiner.prepareEnvelope(bufferCopy, WHISPER_SAMPLE_RATE);  // One pass; each word query is O(1)
+        for (auto& word : transcribedWords)
+        {
+            timestampRefiner.refineWordTimestamp(word, WHISPER_SAMPLE_RATE);
+        }
         
-        for (int i = 0; i < numSegments; ++i)
+        // Streaming: emit only words that became stable in this window.
+        // A word belongs to the window in which its midpoint falls inside [committed, windowEnd - margin),
+        // so words in the overlap are never emitted twice and words cut by the window edge wait for the next one.
+        const double marginSeconds = streamingMode ? std::min(stableMarginSeconds, overlapSeconds) : 0.0;
+        const juce::int64 commitEndSample = captureEndSample - (juce::int64)(marginSeconds * sampleRate);
+        const juce::int64 committedFromSample = std::max(streamCommittedSample, windowStartSample);
         {
-            // Get segment-level timestamps (these are accurate!)
-            int64_t segmentStart = whisper_full_get_segment_t0(whisperCtx, i);
-            int64_t segmentEnd = whisper_full_get_segment_t1(whisperCtx, i);
-            double segStartSec = segmentStart * 0.01;  // centiseconds to seconds
-            double segEndSec = segmentEnd * 0.01;
+            std::vector<WordSegment>& stableWords = scratch.stableWords;
+            size_t heldBack = 0;
             
-            // Get all tokens in this segment
-            int numTokens = whisper_full_n_tokens(whisperCtx, i);
-            std::vector<std::string> segmentWords;
-            
-            for (int j = 0; j < numTokens; ++j)
+            for (size_t k = 0; k < transcribedWords.size(); ++k)
             {
-                whisper_token_data token = whisper_full_get_token_data(whisperCtx, i, j);
+                const auto& word = transcribedWords[k];
+                juce::int64 midSample = windowStartSample + (juce::int64)((word.start + word.end) * 0.5 * sampleRate);
                 
-                // Skip special tokens
-                if (token.id >= whisper_token_eot(whisperCtx))
-                    continue;
+                if (midSample < committedFromSample)
+                    continue;  // Already emitted by the previous window
                 
-                const char* tokenText = whisper_full_get_token_text(whisperCtx, i, j);
-                std::string word = cleanTranscriptText(tokenText);
+                if (midSample >= commitEndSample)
+                {
+                    ++heldBack;
+                    continue;  // Too close to the window edge - next window decides
+                }
                 
-                if (!word.empty())
-                    segmentWords.push_back(word);
+                stableWords.push_back(word);
+                streamPromptTokens.push_back(transcribedTokens[k]);
             }
             
-            // Distribute words evenly across segment duration
-            if (!segmentWords.empty())
+            if (streamingMode)
             {
-                double segmentDuration = segEndSec - segStartSec;
-                double wordDuration = segmentDuration / segmentWords.size();
-                
-                for (size_t k = 0; k < segmentWords.size(); ++k)
-                {
-                    double wordStart = segStartSec + (k * wordDuration);
-                    double wordEnd = wordStart + wordDuration;
-                    
-                    // Clamp to 0-5 second range
-                    wordStart = std::max(0.0, std::min(5.0, wordStart));
-                    wordEnd = std::max(wordStart + 0.05, std::min(5.0, wordEnd));
-                    
-                    transcribedWords.emplace_back(
-                        segmentWords[k],
-                        wordStart,
-                        wordEnd,
-                        0.9f  // Confidence (not available at segment level)
-                    );
-                }
+                whisperLog.info("[Stream] %zu stable / %zu decoded words (%zu held back, prompt=%zu tokens)",
+                                stableWords.size(), transcribedWords.size(), heldBack, streamPromptTokens.size());
             }
+            
+            transcribedWords.swap(stableWords);     // Both buffers stay in the arena
         }
         
-        std::cout << "[Phase5] Extracted " << transcribedWords.size() << " word segments" << std::endl;
-        
-        // Phase 6: Refine timestamps using audio energy analysis
-        std::cout << "[Phase6] Refining timestamps..." << std::endl;
-        for (auto& word : transcribedWords)
+        if ((int)streamPromptTokens.size() > maxPromptTokens)
         {
-            timestampRefiner.refineWordTimestamp(word, bufferCopy, sampleRate);
+            streamPromptTokens.erase(streamPromptTokens.begin(), 
+                                     streamPromptTokens.end() - maxPromptTokens);
         }
         
+        // Seconds of the song newly covered by this decode
+        const double committedSeconds = (double)std::max<juce::int64>(0, commitEndSample - committedFromSample) / sampleRate;
+        streamCommittedSample = std::max(streamCommittedSample, commitEndSample);
+        
         // Apply lyrics alignment if enabled (sliding window approach)
-        std::vector<WordSegment> finalWords = transcribedWords;
+        std::vector<WordSegment>& finalWords = scratch.finalWords;
+        finalWords = transcribedWords;
         
         // Periodic song change detection (works with or without lyrics)
-        static auto lastPeriodicCheck = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
-        auto timeSinceLastCheck = std::chrono::duration_cast<std::chrono::seconds>(now - lastPeriodicCheck).count();
+        auto timeSinceLastCheck = std::chrono::duration_cast<std::chrono::seconds>(now - lastSongCheckTime).count();
         
         bool shouldCheckForNewSong = false;
         
         if (useLyricsAlignment && !songLyrics.empty())
         {
-            std::cout << "[Phase5] Applying lyrics alignment with sliding window..." << std::endl;
+            whisperLog.debug("[Phase5] Applying lyrics alignment with sliding window...");
             
             // Check if we're near end of lyrics (auto-queued song detection)
             if (lyricsAlignment.isReady())
@@ -1182,8 +1888,7 @@ void AudioEngine::processTranscription(const std::vector<float>& buffer, double
                     // Check every 3 seconds when near end
                     if (timeSinceLastCheck >= 3 && mediaInfoInitialized)
                     {
-                        std::cout << "[EndOfSong] Near lyrics end (" << currentPos << "/" << totalWords 
-                                 << ") - checking for queued song..." << std::endl;
+                        whisperLog.info("[EndOfSong] Near lyrics end (%d/%d) - checking for queued song...", currentPos, totalWords);
                         shouldCheckForNewSong = true;
                     }
                 }
@@ -1195,7 +1900,7 @@ void AudioEngine::processTranscription(const std::vector<float>& buffer, double
             // This handles songs without lyrics or failed lyrics fetches
             if (timeSinceLastCheck >= 10 && mediaInfoInitialized)
             {
-                std::cout << "[PeriodicCheck] No lyrics active - checking for song change..." << std::endl;
+                whisperLog.info("[PeriodicCheck] No lyrics active - checking for song change...");
                 shouldCheckForNewSong = true;
             }
         }
@@ -1209,66 +1914,60 @@ void AudioEngine::processTranscription(const std::vector<float>& buffer, double
                 // Check if this is a different song (basic title comparison)
                 if (currentMedia.title != lastSongTitle || currentMedia.artist != lastSongArtist)
                 {
-                    std::cout << "[SongChange] New song detected! " << currentMedia.artist 
-                             << " - " << currentMedia.title << std::endl;
+                    whisperLog.info("[SongChange] New song detected! %s - %s", currentMedia.artist, currentMedia.title);
+                    lyricsFastPath.disengage("song change detected");
+                    noteFastPathTransition();
                     
                     // Testing mode: Write log file for previous song before switching
-                    // Launch background lyrics fetch
-                    std::string artist = currentMedia.artist;
-                    std::string title = currentMedia.title;
-                    
-                    std::thread([this, artist, title]() {
-                        SongInfo lyricsInfo = LyricsAlignment::fetchLyrics(artist, title);
-                        
-                        juce::MessageManager::callAsync([this, lyricsInfo]() {
-                            if (!lyricsInfo.lyrics.empty())
-                            {
-                                songLyrics = lyricsInfo.lyrics;
-                                lyricsAlignment.reset();
-                                lyricsAlignment.setLyrics(songLyrics);
-                                // useLyricsAlignment = true;  // DISABLED FOR TESTING
-                                
-                                std::cout << "[SongChange] ✓ New song lyrics loaded! (ALIGNMENT DISABLED)" << std::endl;
-                            }
-                            else
-                            {
-                                std::cout << "[SongChange] ✗ No lyrics found for new song - using raw Whisper" << std::endl;
-                            }
-                        });
-                    }).detach();
+                    // Usually already prefetched by the media-changed callback
+                    loadLyricsFor(currentMedia.artist, currentMedia.title, "[SongChange]");
+                    beginCensorTimeline(currentMedia.artist, currentMedia.title);
                 }
             }
             
-            lastPeriodicCheck = now;
+            lastSongCheckTime = now;
         }
         
         if (useLyricsAlignment && !songLyrics.empty())
         {
-            finalWords = lyricsAlignment.alignChunk(transcribedWords, songElapsedTime);
+            float verifyScore = -1.0f;
+            {
+                StageProfiler::ScopedTimer alignmentTimer(profiler, StageProfiler::Stage::Alignment);
+                
+                // Windows the fast path skipped since the last decode still moved the song on
+                if (fastPathSkippedUntil > committedFromSample && fastPathSkippedUntil < captureEndSample)
+                    lyricsAlignment.advanceTo(lyricsFastPath.predictPosition(committedFromSample));
+                
+                verifyScore = lyricsAlignment.verifyChunk(transcribedWords);
+                finalWords = lyricsAlignment.alignChunk(transcribedWords, songElapsedTime);
+            }
+            
+            lyricsFastPath.observeWindow(lyricsAlignment, profanityFilter.getMatcher(), finalWords, windowStartSample, verifyScore);
+            noteFastPathTransition();
             
             // Only increment time if we actually had transcribed words (audio was playing)
             if (!transcribedWords.empty())
             {
-                songElapsedTime += chunkSeconds;
+                songElapsedTime += committedSeconds;
             }
             
             // BUGFIX: If alignment returns empty (no match), fall back to raw Whisper
             if (finalWords.empty() && !transcribedWords.empty())
             {
-                std::cout << "[Phase5] ⚠ Alignment returned empty - falling back to raw Whisper" << std::endl;
+                whisperLog.warning("[Phase5] ⚠ Alignment returned empty - falling back to raw Whisper");
                 finalWords = transcribedWords;
             }
             
             // NEW: If Whisper heard NOTHING but we have lyrics loaded, predict next words
             if (finalWords.empty() && transcribedWords.empty() && lyricsAlignment.isReady())
             {
-                std::cout << "[Phase5] Whisper heard nothing - PREDICTING next lyrics words" << std::endl;
-                finalWords = lyricsAlignment.predictNextWords(chunkSeconds);
+                whisperLog.info("[Phase5] Whisper heard nothing - PREDICTING next lyrics words");
+                finalWords = lyricsAlignment.predictNextWords(committedSeconds);
                 
                 if (!finalWords.empty())
                 {
-                    std::cout << "[Phase5] Predicted " << finalWords.size() << " words from lyrics position " 
-                             << lyricsAlignment.getCurrentPosition() << std::endl;
+                    whisperLog.info("[Phase5] Predicted %zu words from lyrics position %d",
+                                    finalWords.size(), lyricsAlignment.getCurrentPosition());
                 }
             }
         }
@@ -1276,285 +1975,700 @@ void AudioEngine::processTranscription(const std::vector<float>& buffer, double
         // If we STILL have no words (no lyrics loaded or prediction failed), skip censorship
         if (finalWords.empty())
         {
-            std::cout << "[Phase5] No words to censor - skipping" << std::endl;
+            whisperLog.info("[Phase5] No words to censor - skipping");
             
             auto endTime = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-            double seconds = duration.count() / 1000.0;
-            double realTimeFactor = seconds / chunkSeconds;
+            double seconds = decode.decodeSeconds + decode.redecode.secondPassSeconds + duration.count() / 1000.0;
+            double realTimeFactor = seconds / (hopSeconds * maxChunksInFlight);  // Overlapping decodes share the budget
             
-            std::cout << "[TIMING] Processed " << chunkSeconds << "s audio in " << seconds 
-                      << "s (RTF: " << std::fixed << std::setprecision(2) << realTimeFactor << "x)" << std::endl;
+            whisperLog.info("[TIMING] Model: %s | Processed %.2fs window (hop %.2fs) in %.2fs (RTF: %.2fx)",
+                            modelName, windowSeconds, hopSeconds, seconds, realTimeFactor);
             
             qualityAnalyzer.recordRTF(realTimeFactor);
+            recordModelTiming(modelTier, realTimeFactor, committedSeconds);
+            recordLookAheadRequirement(committedFromSample);
             qualityAnalyzer.updateSessionDuration(streamTime);
+            resolveProposals(committedFromSample, commitEndSample);
+            censorTimeline.observeDecodedRange(committedFromSample, commitEndSample);
+            noteTimelineTransition();
             return;
         }
         
         // Print transcript and check profanity (including multi-word patterns)
-        std::cout << "[Phase5] ========== TRANSCRIPT (" << finalWords.size() << " words) ==========" << std::endl;
+        whisperLog.info("[Phase5] ========== TRANSCRIPT (%zu words) ==========", finalWords.size());
         
-        std::string fullTranscript;
-        std::vector<std::string> detectedWords;
+        std::string& fullTranscript = scratch.transcript;
         
-        // Send raw Whisper transcription to UI (for comparison)
-        if (lyricsCallback && !transcribedWords.empty())
-        {
-            juce::String whisperWords;
-            for (const auto& wordSeg : transcribedWords)
+        // Raw Whisper transcription and corrected/aligned lyrics for the UI (read on its timer)
+        std::string& uiWords = scratch.uiWords;
+        auto joinWords = [&uiWords](const std::vector<WordSegment>& words) {
+            uiWords.clear();
+            for (const auto& wordSeg : words)
             {
-                whisperWords += juce::String(wordSeg.word) + " ";
+                const size_t first = wordSeg.word.find_first_not_of(' ');
+                if (first == std::string::npos)
+                    continue;
+                if (!uiWords.empty())
+                    uiWords += ' ';
+                uiWords.append(wordSeg.word, first, wordSeg.word.find_last_not_of(' ') + 1 - first);
             }
-            
-            // Call on message thread
-            juce::MessageManager::callAsync([this, whisperWords]() {
-                if (lyricsCallback)
-                    lyricsCallback(whisperWords.trim());
-            });
+        };
+        
+        if (!transcribedWords.empty())
+        {
+            joinWords(transcribedWords);
+            uiState.appendHeardWords(uiWords);
         }
         
-        // Send corrected/aligned lyrics to UI (actual lyrics)
-        if (actualLyricsCallback && !finalWords.empty())
+        joinWords(finalWords);
+        uiState.appendLyricsWords(uiWords);
+        
+        // One streaming pass over the emitted words: single- and multi-word entries,
+        // including phrases that started in an earlier window (matcher state carries over)
+        const ProfanityMatcher& matcher = profanityFilter.getMatcher();
+        
+        std::vector<SessionArena::ProfanityHit>& profanityHits = scratch.profanityHits;
+        auto stageStart = std::chrono::steady_clock::now();
+        
+        for (const auto& wordSeg : finalWords)
         {
-            juce::String correctedWords;
-            for (const auto& wordSeg : finalWords)
-            {
-                correctedWords += juce::String(wordSeg.word) + " ";
-            }
+            fullTranscript += wordSeg.word;
+            fullTranscript += ' ';
             
-            // Call on message thread
-            juce::MessageManager::callAsync([this, correctedWords]() {
-                if (actualLyricsCallback)
-                    actualLyricsCallback(correctedWords.trim());
+            EmittedWord& emitted = recentWords[profanityStream.numWords % recentWords.size()];
+            emitted.startSample = windowStartSample + (juce::int64)(wordSeg.start * sampleRate);
+            emitted.endSample = windowStartSample + (juce::int64)(wordSeg.end * sampleRate);
+            emitted.confidence = (float)wordSeg.confidence;
+            
+            matcher.feedWord(profanityStream, wordSeg.word, [this, &profanityHits](const ProfanityMatcher::Match& match) {
+                // Words already censored by an overlapping earlier match are not censored twice
+                uint64_t firstWord = match.firstWord;
+                if (profanityCoveredWord >= 0 && firstWord <= (uint64_t)profanityCoveredWord)
+                    firstWord = (uint64_t)profanityCoveredWord + 1;
+                if (firstWord > match.lastWord)
+                    return;
+                profanityCoveredWord = (juce::int64)match.lastWord;
+                
+                // Resolve timing now - the ring only holds the last MAX_PHRASE_TOKENS words
+                const EmittedWord& first = recentWords[firstWord % recentWords.size()];
+                const EmittedWord& last = recentWords[match.lastWord % recentWords.size()];
+                profanityHits.push_back({ match, first.startSample, last.endSample, last.confidence });
             });
         }
         
-        // Check for single-word AND multi-word profanity
-        std::vector<bool> wordAlreadyCensored(finalWords.size(), false);  // Track which words are already handled
+        auto stageEnd = std::chrono::steady_clock::now();
+        profiler.record(StageProfiler::Stage::ProfanityMatch, std::chrono::duration<double>(stageEnd - stageStart).count());
+        stageStart = stageEnd;
         
-        for (size_t idx = 0; idx < finalWords.size(); ++idx)
+        // Remote clients get this window's events in one message, as soon as they are scheduled
+        beginPushMessage(captureEndSample);
+        
+        for (const auto& hit : profanityHits)
         {
-            // Skip if this word was already part of a multi-word profanity
-            if (wordAlreadyCensored[idx])
-                continue;
+            std::string& profanityText = scratch.hitText;
+            profanityText.assign(matcher.getEntryText(hit.match.entry));
             
-            const auto& wordSeg = finalWords[idx];
-            fullTranscript += wordSeg.word + " ";
+            // Two-tier: Whisper heard what the spotter proposed (its event merges into the tentative one)
+            const bool confirmsProposal = confirmProposals(hit.startSample, hit.endSample);
             
-            bool foundProfanity = false;
-            std::string profanityText;
-            double profanityStart, profanityEnd;
-            bool isMultiWord = false;
+            // Recorded for this song's timeline (and verifies a cached event on a replay)
+            censorTimeline.observeHit(hit.startSample, hit.endSample, profanityText, hit.confidence);
             
-            // FIRST: Check multi-word profanity patterns (prioritize longer matches)
-            if (idx + 1 < finalWords.size())
-            {
-                const auto& nextWord = finalWords[idx + 1];
-                std::string combined = LyricsAlignment::normalizeText(wordSeg.word + nextWord.word);
-                
-                if (profanityFilter.isProfane(combined))
-                {
-                    foundProfanity = true;
-                    profanityText = wordSeg.word + " " + nextWord.word;
-                    profanityStart = wordSeg.start;
-                    profanityEnd = nextWord.end;
-                    isMultiWord = true;
-                    
-                    // Mark both words as handled
-                    wordAlreadyCensored[idx] = true;
-                    wordAlreadyCensored[idx + 1] = true;
-                }
-            }
+            scratch.detectedList += '"';
+            scratch.detectedList += profanityText;
+            scratch.detectedList += "\" ";
             
-            // SECOND: If no multi-word match, check single word profanity
-            if (!foundProfanity)
-            {
-                std::string normalizedWord = LyricsAlignment::normalizeText(wordSeg.word);
-                
-                if (profanityFilter.isProfane(normalizedWord))
-                {
-                    foundProfanity = true;
-                    profanityText = wordSeg.word;
-                    profanityStart = wordSeg.start;
-                    profanityEnd = wordSeg.end;
-                    isMultiWord = false;
-                    
-                    wordAlreadyCensored[idx] = true;
-                }
-            }
+            // Window-relative seconds (negative when the phrase began in the previous window)
+            whisperLog.info("[Phase6] *** %s: \"%s\" *** (%.2fs - %.2fs in the window)",
+                            hit.match.numTokens > 1 ? "MULTI-WORD PROFANITY" : "PROFANITY", profanityText,
+                            (double)(hit.startSample - windowStartSample) / sampleRate,
+                            (double)(hit.endSample - windowStartSample) / sampleRate);
             
-            // Process the detected profanity (single or multi-word)
-            if (foundProfanity)
+            // Padded range: at most one window back, never past the window end
+            const juce::int64 earliestSample = std::max<juce::int64>(0, windowStartSample - samplesToProcess);
+            const juce::int64 latestSample = windowStartSample + samplesToProcess;
+            
+            // A confirmed proposal was recorded when it was scheduled
+            CensorEvent event;
+            if (!scheduleCensorEvent(hit.startSample, hit.endSample, profanityText, hit.confidence, false, 0.0,
+                                     "[Phase6] Profanity", event, !confirmsProposal, earliestSample, latestSample))
+                continue;
+            
+            const double secondsAhead = (double)(event.start_sample - delayReadPos.load()) / sampleRate;
+            whisperLog.info("[Phase6]     ✓ %s scheduled on censor timeline: %lld - %lld (%.2fs ahead of playback)",
+                            event.mode == CensorEvent::Mode::Reverse ? "REVERSE" : "MUTE",
+                            event.start_sample, event.end_sample, secondsAhead);
+            
+            if (secondsAhead < 1.0)
             {
-                // Skip censorship if buffer is critically low (emergency bypass)
-                if (bufferUnderrun.load())
-                {
-                    std::cout << "[Phase6] Profanity \"" << profanityText
-                              << "\" detected but SKIPPING (buffer underrun)" << std::endl;
-                    
-                    // Phase 8: Record skipped word
-                    qualityAnalyzer.recordCensorshipEvent(profanityText, profanityStart, false, "SKIPPED", isMultiWord);
-                    continue;
-                }
-                
-                detectedWords.push_back(profanityText);
-                
-                // Phase 8: Record censorship event
-                std::string modeStr = (currentCensorMode == CensorMode::Reverse) ? "REVERSE" : "MUTE";
-                qualityAnalyzer.recordCensorshipEvent(profanityText, profanityStart, true, modeStr, isMultiWord);
-                
-                // Testing mode: Track this prediction
-                if (testingMode)
-                {
-                    currentSongPredictions.emplace_back(profanityText, profanityStart, modeStr, isMultiWord);
-                }
-                
-                // Phase 6: Calculate position in delay buffer
-                // captureTime stores where the chunk ENDS (writePos when captured)
-                // wordSeg.start/end are offsets from CHUNK START (0-chunkSeconds)
-                // So: chunkStart = captureTime - chunkSeconds, profanityPos = chunkStart + offset
-                int chunkEndPos = (int)captureTime;
-                int chunkStartPos = (chunkEndPos - (int)(sampleRate * chunkSeconds) + delayBufferSize) % delayBufferSize;
-                
-                // Tiny model tends to timestamp late - use asymmetric padding
-                double paddingBefore = 0.4;  // 400ms before word (catch early starts)
-                double paddingAfter = 0.1;   // 100ms after word (tight end)
-                
-                int startSample = (int)((profanityStart - paddingBefore) * sampleRate);
-                int endSample = (int)((profanityEnd + paddingAfter) * sampleRate);
-                
-                // Clamp to valid range (0 to chunkSeconds)
-                int maxSample = (int)(sampleRate * chunkSeconds);
-                startSample = std::max(0, std::min(startSample, maxSample));
-                endSample = std::max(startSample, std::min(endSample, maxSample));
-                
-                // Calculate actual buffer positions we'll modify
-                int actualStartPos = (chunkStartPos + startSample) % delayBufferSize;
-                int actualEndPos = (chunkStartPos + endSample) % delayBufferSize;
-                int currentReadPos = delayReadPos;  // Snapshot current read position
-                
-                // Calculate how far ahead of readPos we are
-                int distanceFromRead = (actualStartPos - currentReadPos + delayBufferSize) % delayBufferSize;
-                double secondsAhead = (double)distanceFromRead / sampleRate;
-                
-                std::string profanityTypeLabel = isMultiWord ? "MULTI-WORD PROFANITY" : "PROFANITY";
-                std::cout << "[Phase6] *** " << profanityTypeLabel << ": \"" << profanityText << "\" ***" << std::endl;
-                std::cout << "[Phase6]     Whisper timestamp: " << profanityStart << "s - " << profanityEnd << "s" << std::endl;
-                std::cout << "[Phase6]     With padding: " << (profanityStart - paddingBefore) << "s - " 
-                         << (profanityEnd + paddingAfter) << "s" << std::endl;
-                std::cout << "[Phase6]     Sample range in chunk: " << startSample << " - " << endSample 
-                         << " (" << (endSample - startSample) << " samples)" << std::endl;
-                std::cout << "[Phase6]     Buffer positions: chunkEnd=" << chunkEndPos << ", chunkStart=" << chunkStartPos 
-                         << ", profanityStart=" << actualStartPos << ", profanityEnd=" << actualEndPos << std::endl;
-                std::cout << "[Phase6]     Current readPos=" << currentReadPos 
-                         << ", distance ahead=" << distanceFromRead << " samples (" 
-                         << std::fixed << std::setprecision(2) << secondsAhead << "s)" << std::endl;
-                
-                if (secondsAhead < 1.0)
-                {
-                    std::cout << "[Phase6]     ⚠️ WARNING: Too close to readPos! Censorship may be late!" << std::endl;
-                }
-                
-                // Apply censorship based on mode
-                int numSamplesToCensor = endSample - startSample;
-                int fadeSamples = std::min(480, numSamplesToCensor / 4);  // 10ms fade @ 48kHz
-                
-                if (currentCensorMode == CensorMode::Mute)
-                {
-                    // MUTE: Zero out the samples
-                    for (int ch = 0; ch < 2; ++ch)
-                    {
-                        for (int i = startSample; i < endSample; ++i)
-                        {
-                            int delayPos = (chunkStartPos + i) % delayBufferSize;
-                            delayBuffer[ch][delayPos] = 0.0f;
-                        }
-                    }
-                    std::cout << "[Phase6]     ✓ MUTED in delay buffer" << std::endl;
-                }
-                else if (currentCensorMode == CensorMode::Reverse)
-                {
-                    // REVERSE: Flip audio backwards with fade
-                    for (int ch = 0; ch < 2; ++ch)
-                    {
-                        // First, copy the region to temporary buffer
-                        std::vector<float> tempBuffer(numSamplesToCensor);
-                        for (int i = 0; i < numSamplesToCensor; ++i)
-                        {
-                            int delayPos = (chunkStartPos + startSample + i) % delayBufferSize;
-                            tempBuffer[i] = delayBuffer[ch][delayPos];
-                        }
-                        
-                        // Reverse it
-                        std::reverse(tempBuffer.begin(), tempBuffer.end());
-                        
-                        // Apply fade and volume reduction, then write back
-                        for (int i = 0; i < numSamplesToCensor; ++i)
-                        {
-                            float sample = tempBuffer[i];
-                            float volumeReduction = 0.5f;  // 50% volume
-                            
-                            // Fade at edges to prevent clicks
-                            if (i < fadeSamples)
-                            {
-                                float fadeGain = (float)i / fadeSamples;
-                                sample *= fadeGain * volumeReduction;
-                            }
-                            else if (i >= numSamplesToCensor - fadeSamples)
-                            {
-                                float fadeGain = (float)(numSamplesToCensor - i) / fadeSamples;
-                                sample *= fadeGain * volumeReduction;
-                            }
-                            else
-                            {
-                                sample *= volumeReduction;
-                            }
-                            
-                            int delayPos = (chunkStartPos + startSample + i) % delayBufferSize;
-                            delayBuffer[ch][delayPos] = sample;
-                        }
-                    }
-                    std::cout << "[Phase6]     ✓ REVERSED in delay buffer" << std::endl;
-                }
+                whisperLog.warning("[Phase6]     ⚠️ WARNING: Too close to readPos! Censorship may be late!");
             }
         }
         
-        std::cout << "[Phase6] \"" << fullTranscript << "\"" << std::endl;
-        
-        if (!detectedWords.empty())
+        if (pushTranscriptWords)
         {
-            std::cout << "[Phase6] *** PROFANITY DETECTED: ";
-            for (const auto& w : detectedWords)
-                std::cout << "\"" << w << "\" ";
-            std::cout << "***" << std::endl;
+            for (const auto& wordSeg : finalWords)
+                addPushWord(windowStartSample + (juce::int64)(wordSeg.start * sampleRate),
+                            windowStartSample + (juce::int64)(wordSeg.end * sampleRate),
+                            (float)wordSeg.confidence, wordSeg.word);
         }
         
-        // Reset Whisper state to prevent memory/performance degradation
-        whisper_reset_timings(whisperCtx);
+        sendPushMessage();
+        
+        // Proposals inside the decoded range that no hit confirmed were misheard by the spotter
+        resolveProposals(committedFromSample, commitEndSample);
+        
+        // Cached events inside it that no hit verified: the replay may be off
+        censorTimeline.observeDecodedRange(committedFromSample, commitEndSample);
+        noteTimelineTransition();
+        
+        profiler.record(StageProfiler::Stage::CensorSchedule,
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count());
+        
+        whisperLog.info("[Phase6] \"%s\"", fullTranscript);
+        
+        if (!scratch.detectedList.empty())
+            whisperLog.info("[Phase6] *** PROFANITY DETECTED: %s***", scratch.detectedList);
+        
+        whisperLog.info("[Phase6] Censor timeline: %d applied, %d dropped (late)",
+                        censorEventsApplied.load(), censorEventsDropped.load());
         
         // End timing
         auto endTime = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
-        double seconds = duration.count() / 1000.0;
-        double realTimeFactor = seconds / chunkSeconds;
-        
-        std::cout << "[Phase6] ================================================" << std::endl;
-        std::cout << "[TIMING] Processed " << chunkSeconds << "s audio in " << seconds << "s (RTF: " 
-                  << std::fixed << std::setprecision(2) << realTimeFactor << "x)";
-        
-        if (realTimeFactor > 1.0)
-            std::cout << " [WARNING: Processing slower than real-time!]";
+        double seconds = decode.decodeSeconds + decode.redecode.secondPassSeconds + duration.count() / 1000.0;
+        double realTimeFactor = seconds / (hopSeconds * maxChunksInFlight);  // Overlapping decodes share the budget
         
-        std::cout << std::endl;
+        whisperLog.info("[Phase6] ================================================");
+        whisperLog.write(realTimeFactor > 1.0 ? AsyncLogger::Level::Warning : AsyncLogger::Level::Info,
+                         "[TIMING] Model: %s | Processed %.2fs window (hop %.2fs) in %.2fs (RTF: %.2fx)%s",
+                         modelName, windowSeconds, hopSeconds, seconds, realTimeFactor,
+                         realTimeFactor > 1.0 ? " [WARNING: Processing slower than real-time!]" : "");
         
         // Phase 8: Record RTF and update session duration
         qualityAnalyzer.recordRTF(realTimeFactor);
+        recordModelTiming(modelTier, realTimeFactor, committedSeconds);
+        recordLookAheadRequirement(committedFromSample);
         qualityAnalyzer.updateSessionDuration(streamTime);
     }
     catch (const std::exception& e)
     {
-        std::cout << "[Phase6] Exception in processTranscription: " << e.what() << std::endl;
+        whisperLog.error("[Phase6] Exception in processTranscription: %s", e.what());
+    }
+}
+
+void AudioEngine::schedulePredictedCensorship(juce::int64 captureEndSample)
+{
+    const juce::int64 horizon = captureEndSample + (juce::int64)(lyricsFastPath.getOptions().scheduleAheadSeconds * sampleRate);
+    lyricsFastPath.collectDueHits(horizon, predictedHits);
+    if (predictedHits.empty())
+        return;
+    
+    const ProfanityMatcher& matcher = profanityFilter.getMatcher();
+    
+    beginPushMessage(captureEndSample);
+    
+    for (const auto& hit : predictedHits)
+    {
+        // Widened by how far the prediction reaches; predicted, not heard (a decoded hit on the same words merges with it)
+        const std::string profanityText(matcher.getEntryText(hit.entry));
+        CensorEvent event;
+        if (!scheduleCensorEvent(hit.startSample, hit.endSample, profanityText, 0.5f, false,
+                                 hit.uncertaintySeconds, "[FastPath] Predicted", event))
+            continue;
+        
+        whisperLog.info("[FastPath] ✓ Predicted \"%s\" scheduled %.2fs ahead of capture (±%.2fs)",
+                        profanityText, (double)(hit.startSample - captureEndSample) / sampleRate,
+                        hit.uncertaintySeconds);
+        qualityAnalyzer.recordPredictedCensorEvent();
+    }
+    
+    sendPushMessage();
+}
+
+bool AudioEngine::scheduleCensorEvent(juce::int64 startSample, juce::int64 endSample, const std::string& word,
+                                      float confidence, bool tentative, double extraPaddingSeconds,
+                                      const char* label, CensorEvent& event, bool record,
+                                      juce::int64 earliestSample, juce::int64 latestSample)
+{
+    const bool isMultiWord = word.find(' ') != std::string::npos;
+    const double streamSeconds = (double)startSample / sampleRate;
+    
+    if (bufferUnderrun.load())
+    {
+        whisperLog.warning("%s \"%s\" but SKIPPING (buffer underrun)", label, word);
+        if (record)
+            qualityAnalyzer.recordCensorshipEvent(word, streamSeconds, false, "SKIPPED", isMultiWord);
+        return false;
+    }
+    
+    // Same padding as a decoded hit
+    const double paddingBefore = censorPaddingBeforeSeconds + extraPaddingSeconds;
+    const double paddingAfter = 0.1 + extraPaddingSeconds;
+    
+    event = CensorEvent {};
+    event.start_sample = startSample - (juce::int64)(paddingBefore * sampleRate);
+    event.end_sample = endSample + (juce::int64)(paddingAfter * sampleRate);
+    event.start_sample = std::max(earliestSample, std::min(event.start_sample, latestSample));
+    event.end_sample = std::max(event.start_sample, std::min(event.end_sample, latestSample));
+    event.mode = (currentCensorMode == CensorMode::Mute) ? CensorEvent::Mode::Mute : CensorEvent::Mode::Reverse;
+    std::strncpy(event.word, word.c_str(), sizeof(event.word) - 1);
+    event.confidence = confidence;
+    event.tentative = tentative;
+    
+    // Reverse plays the end of the range first: when the look-ahead is shorter than the range,
+    // its end is not captured yet as playback starts (the renderer would mute it) - mute it whole
+    const double delaySeconds = playbackStarted.load() ? getCurrentBufferSize() : latencyController.getTargetSeconds();
+    if (event.mode == CensorEvent::Mode::Reverse && event.end_sample - event.start_sample > (juce::int64)(delaySeconds * sampleRate))
+    {
+        event.mode = CensorEvent::Mode::Mute;
+        whisperLog.debug("%s \"%s\" spans more than the %.2fs look-ahead - muted instead of reversed", label, word, delaySeconds);
+    }
+    
+    if (event.end_sample <= delayReadPos.load())
+    {
+        whisperLog.warning("%s \"%s\" already played - dropping event", label, word);
+        return false;
+    }
+    
+    if (!censorEventQueue.push(event))
+    {
+        whisperLog.error("%s \"%s\" lost - censor queue full", label, word);
+        return false;
+    }
+    
+    if (record)
+    {
+        const char* modeStr = (event.mode == CensorEvent::Mode::Reverse) ? "REVERSE" : "MUTE";
+        qualityAnalyzer.recordCensorshipEvent(word, streamSeconds, true, modeStr, isMultiWord);
+        
+        if (testingMode)
+            currentSongPredictions.emplace_back(word, streamSeconds, modeStr, isMultiWord);
+    }
+    
+    // A tentative event reaches clients as Whisper's own hit once it confirms the words
+    if (!tentative)
+        addPushEvent(event);
+    return true;
+}
+
+void AudioEngine::noteFastPathTransition()
+{
+    const bool engaged = lyricsFastPath.isEngaged();
+    if (engaged == fastPathWasEngaged)
+        return;
+    
+    fastPathWasEngaged = engaged;
+    if (engaged)
+    {
+        whisperLog.info("[FastPath] Engaged: %s (%d lexicon hit(s) in the lyrics) - Whisper drops to verification",
+                        lyricsFastPath.getLastTransition(), lyricsFastPath.getNumLyricsHits());
+    }
+    else
+    {
+        whisperLog.info("[FastPath] Back to full decoding: %s (%d window(s) skipped, %d verified, %d predicted event(s))",
+                        lyricsFastPath.getLastTransition(), lyricsFastPath.getWindowsSkipped(),
+                        lyricsFastPath.getWindowsVerified(), lyricsFastPath.getHitsScheduled());
+    }
+}
+
+void AudioEngine::publishUiStats()
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (now < nextUiStatsTime)
+        return;
+    nextUiStatsTime = now + std::chrono::milliseconds(UI_STATS_INTERVAL_MS);
+    
+    UiStateModel::Stats stats;
+    stats.bufferSeconds = getCurrentBufferSize();
+    stats.underrun = bufferUnderrun.load();
+    stats.inputLevel = currentInputLevel.load();
+    uiState.setStats(stats);
+}
+
+void AudioEngine::beginCensorTimeline(const std::string& artist, const std::string& title)
+{
+    if (artist.empty() || title.empty() || !censorTimeline.getOptions().enabled)
+        return;
+    
+    // The media callback and the periodic song check both report a change: hand it over once
+    const std::string key = LyricsAlignment::normalizeText(artist) + "\n" + LyricsAlignment::normalizeText(title);
+    {
+        std::lock_guard<std::mutex> lock(timelineSongMutex);
+        if (key == timelineSongKey)
+            return;
+        timelineSongKey = key;
+    }
+    
+    // One small file read; the Whisper thread switches songs on its next pass
+    std::shared_ptr<const CensorTimelineCache::Timeline> cached;
+    if (auto found = censorTimelineCache.find(artist, title))
+        cached = std::make_shared<const CensorTimelineCache::Timeline>(std::move(*found));
+    
+    {
+        std::lock_guard<std::mutex> lock(timelineSongMutex);
+        if (key != timelineSongKey)
+            return;     // Another song was reported meanwhile
+        pendingTimelineSong = TimelineSong { artist, title, std::move(cached) };
+    }
+    timelineSongPending.store(true);
+    whisperWake.notify();
+}
+
+void AudioEngine::adoptTimelineSong()
+{
+    if (!timelineSongPending.exchange(false))
+        return;
+    
+    std::optional<TimelineSong> song;
+    {
+        std::lock_guard<std::mutex> lock(timelineSongMutex);
+        song.swap(pendingTimelineSong);
+    }
+    if (!song)
+        return;
+    
+    // The previous song ends where this one begins
+    finishCensorTimeline();
+    noteTimelineTransition();
+    
+    timelineReadPosition = whisperWindow->getWritePosition();
+    censorTimeline.beginSong(song->cached, song->artist, song->title,
+                             toCaptureSample(timelineReadPosition), profanityFilter.getMatcher());
+    
+    if (song->cached != nullptr)
+    {
+        whisperLog.info("[Timeline] \"%s - %s\" is cached (%d event(s), %.0fs, %d play(s)) - syncing to replay it",
+                        song->artist, song->title, censorTimeline.getNumCachedEvents(),
+                        song->cached->getDurationSeconds(), song->cached->plays);
+    }
+    else
+    {
+        whisperLog.info("[Timeline] \"%s - %s\" not cached - recording its censor timeline", song->artist, song->title);
+    }
+}
+
+void AudioEngine::feedCensorTimeline()
+{
+    const juce::int64 writePosition = whisperWindow->getWritePosition();
+    if (!censorTimeline.hasSong())
+    {
+        timelineReadPosition = writePosition;
+        return;
+    }
+    
+    // The writer never waits: audio it already overwrote is a gap (song time keeps running)
+    const int blockSamples = (int)timelineBlock.size();
+    if (writePosition - timelineReadPosition > whisperWindow->getCapacity() - blockSamples)
+    {
+        whisperLog.warning("[Timeline] Feed lapped by %lld samples - recorded as silence", writePosition - timelineReadPosition);
+        censorTimeline.pushGap(writePosition - timelineReadPosition);
+        timelineReadPosition = writePosition;
+        return;
+    }
+    
+    float* data = timelineBlock.data();
+    while (timelineReadPosition < writePosition)
+    {
+        const int numSamples = (int)std::min<juce::int64>(blockSamples, writePosition - timelineReadPosition);
+        whisperWindow->readSamples(&data, 1, timelineReadPosition, numSamples);
+        censorTimeline.pushAudio(data, numSamples);
+        timelineReadPosition += numSamples;
     }
+    
+    // Syncing (and losing the sync) happens as the envelope grows
+    noteTimelineTransition();
+}
+
+void AudioEngine::finishCensorTimeline()
+{
+    if (!censorTimeline.hasSong())
+        return;
+    
+    if (censorTimeline.hasCachedTimeline())
+    {
+        whisperLog.info("[Timeline] Replay done: %d window(s) skipped, %d verified, %d cached event(s) scheduled "
+                        "(%d verified by Whisper, %d not heard)",
+                        censorTimeline.getWindowsSkipped(), censorTimeline.getWindowsVerified(),
+                        censorTimeline.getEventsScheduled(), censorTimeline.getEventsVerified(),
+                        censorTimeline.getEventsMissed());
+    }
+    
+    auto timeline = censorTimeline.endSong();
+    if (!timeline)
+        return;
+    
+    // One small write per song
+    if (censorTimelineCache.store(*timeline))
+    {
+        whisperLog.info("[Timeline] Cached \"%s - %s\": %zu event(s) over %.0fs (play %d)",
+                        timeline->artist, timeline->title, timeline->events.size(),
+                        timeline->getDurationSeconds(), timeline->plays);
+    }
+    else
+    {
+        whisperLog.warning("[Timeline] Could not cache \"%s - %s\"", timeline->artist, timeline->title);
+    }
+}
+
+void AudioEngine::scheduleCachedCensorship(juce::int64 captureEndSample)
+{
+    const CensorTimelineReplay::Options& options = censorTimeline.getOptions();
+    const juce::int64 horizon = captureEndSample + (juce::int64)(options.scheduleAheadSeconds * sampleRate);
+    censorTimeline.collectDueEvents(horizon, dueCachedEvents);
+    if (dueCachedEvents.empty())
+        return;
+    
+    beginPushMessage(captureEndSample);
+    
+    for (const auto& due : dueCachedEvents)
+    {
+        // Widened by the sync resolution; confidence as heard when cached (a decoded hit on the same words merges with it)
+        CensorEvent event;
+        if (!scheduleCensorEvent(due.startSample, due.endSample, due.event->word, due.event->confidence, false,
+                                 options.syncPaddingSeconds, "[Timeline] Cached", event))
+            continue;
+        
+        whisperLog.info("[Timeline] ✓ Cached \"%s\" scheduled %.2fs ahead of capture (song %.2fs)",
+                        due.event->word, (double)(due.startSample - captureEndSample) / sampleRate,
+                        due.event->startSeconds);
+        qualityAnalyzer.recordCachedCensorEvent();
+    }
+    
+    sendPushMessage();
+}
+
+void AudioEngine::noteTimelineTransition()
+{
+    const bool engaged = censorTimeline.isEngaged();
+    if (engaged == timelineWasEngaged)
+        return;
+    
+    timelineWasEngaged = engaged;
+    if (engaged)
+    {
+        qualityAnalyzer.recordTimelineSync();
+        whisperLog.info("[Timeline] Engaged: %s (correlation %.2f, %d cached event(s)) - Whisper drops to spot verification",
+                        censorTimeline.getLastTransition(), censorTimeline.getLastCorrelation(),
+                        censorTimeline.getNumCachedEvents());
+    }
+    else
+    {
+        whisperLog.info("[Timeline] Back to full decoding: %s (%d window(s) skipped, %d verified, %d cached event(s) scheduled)",
+                        censorTimeline.getLastTransition(), censorTimeline.getWindowsSkipped(),
+                        censorTimeline.getWindowsVerified(), censorTimeline.getEventsScheduled());
+    }
+}
+
+void AudioEngine::startKeywordSpotter()
+{
+    const KeywordSpotter::Backend kind = keywordSpotter.getOptions().backend;
+    
+    if (!keywordSpotter.hasBackend() || kind != keywordSpotterBackend)
+    {
+        if (kind == KeywordSpotter::Backend::Vosk)
+        {
+            keywordSpotter.setBackend(std::make_unique<VoskBackend>());
+        }
+        else
+        {
+            // Fastest loaded model on its own state, beside the decode workers
+            WhisperBackend::Options whisperOptions;
+            whisperOptions.threads = WhisperDecodeScheduler::recommendedThreadsPerDecode(maxChunksInFlight + 1);
+            keywordSpotter.setBackend(std::make_unique<WhisperBackend>(modelTiers[0].ctx, modelTiers[0].name, whisperOptions));
+        }
+        keywordSpotterBackend = kind;
+    }
+    
+    if (!keywordSpotter.start(*whisperWindow, profanityFilter.getMatcher(), [this] { whisperWake.notify(); }))
+    {
+        std::cout << "[Spotter] Two-tier detection off - Whisper detects alone" << std::endl;
+        return;
+    }
+    
+    std::cout << "[Spotter] Two-tier detection: proposals censored at once, Whisper confirms "
+              << (keywordSpotter.getOptions().cancelRejected ? "or withdraws" : "(never withdraws)") << std::endl;
+}
+
+bool AudioEngine::scheduleProposedCensorship()
+{
+    KeywordSpotter::Proposal proposal;
+    if (!keywordSpotter.popProposal(proposal))
+        return false;
+    
+    const ProfanityMatcher& matcher = profanityFilter.getMatcher();
+    const KeywordSpotter::Options& options = keywordSpotter.getOptions();
+    
+    // Forget proposals that already played before tracking new ones
+    resolveProposals(0, 0);
+    
+    // Final (untracked) proposals go to clients at once
+    beginPushMessage(toCaptureSample(whisperWindow->getWritePosition()));
+    
+    do
+    {
+        const std::string profanityText(matcher.getEntryText(proposal.entry));
+        const juce::int64 wordStart = toCaptureSample(proposal.startSample);
+        const juce::int64 wordEnd = toCaptureSample(proposal.endSample);
+        
+        // Whisper already decoded this audio (a slow spotter): its verdict stands unless the spotter is sure
+        const bool alreadyDecoded = (wordStart + wordEnd) / 2 < streamCommittedSample;
+        if (alreadyDecoded && proposal.confidence < options.keepAboveConfidence)
+        {
+            whisperLog.debug("[Spotter] Proposed \"%s\" after Whisper decoded it - ignored", profanityText);
+            continue;
+        }
+        
+        // Untracked proposals cannot be withdrawn, so they go out final
+        const bool track = !alreadyDecoded && (int)pendingProposals.size() < MAX_ACTIVE_CENSOR_EVENTS;
+        
+        CensorEvent event;
+        if (!scheduleCensorEvent(wordStart, wordEnd, profanityText, proposal.confidence, track, 0.0,
+                                 "[Spotter] Proposed", event))
+            continue;
+        
+        const double requiredSeconds = getRequiredLookAheadSeconds(wordStart);
+        whisperLog.info("[Spotter] ✓ Proposed \"%s\" (%s, confidence %.2f) - needed %.2fs of look-ahead, %.2fs left",
+                        profanityText, proposal.fromFinal ? "final" : "partial", proposal.confidence,
+                        requiredSeconds, (double)(event.start_sample - delayReadPos.load()) / sampleRate);
+        qualityAnalyzer.recordSpotterProposal(requiredSeconds);
+        
+        if (track)
+            pendingProposals.push_back({ event, wordStart, wordEnd, proposal.confidence, false });
+        else
+            qualityAnalyzer.recordSpotterOutcome(QualityAnalyzer::ProposalOutcome::Kept);
+    }
+    while (keywordSpotter.popProposal(proposal));
+    
+    sendPushMessage();
+    return true;
+}
+
+bool AudioEngine::confirmProposals(juce::int64 startSample, juce::int64 endSample)
+{
+    bool confirmed = false;
+    
+    // Any lexicon hit on the same audio confirms (the spotter may have heard "shit" in "bullshit")
+    for (auto& pending : pendingProposals)
+    {
+        if (pending.wordStartSample < endSample && startSample < pending.wordEndSample)
+        {
+            confirmed = true;
+            if (!pending.confirmed)
+            {
+                pending.confirmed = true;
+                qualityAnalyzer.recordSpotterOutcome(QualityAnalyzer::ProposalOutcome::Confirmed);
+                whisperLog.info("[Spotter] Whisper confirmed \"%s\"", pending.event.word);
+            }
+        }
+    }
+    
+    return confirmed;
+}
+
+void AudioEngine::resolveProposals(juce::int64 decodedFromSample, juce::int64 decodedToSample)
+{
+    const KeywordSpotter::Options& options = keywordSpotter.getOptions();
+    const juce::int64 currentReadPos = delayReadPos.load();
+    
+    size_t kept = 0;
+    for (size_t i = 0; i < pendingProposals.size(); ++i)
+    {
+        PendingProposal& pending = pendingProposals[i];
+        const juce::int64 midSample = (pending.wordStartSample + pending.wordEndSample) / 2;
+        const bool decoded = midSample >= decodedFromSample && midSample < decodedToSample;
+        
+        if (pending.confirmed)
+        {
+            // Done once Whisper has moved past it (a later window may still overlap the phrase)
+            if (decoded || pending.event.end_sample <= currentReadPos)
+                continue;
+        }
+        else if (decoded)
+        {
+            // Whisper decoded this audio and heard no lexicon word
+            if (options.cancelRejected && pending.confidence < options.keepAboveConfidence
+                && pending.event.start_sample > currentReadPos)
+            {
+                CensorEvent cancel = pending.event;
+                cancel.cancel = true;
+                if (censorEventQueue.push(cancel))
+                {
+                    whisperLog.info("[Spotter] ✗ Whisper did not hear \"%s\" - withdrawn %.2fs before playback",
+                                    pending.event.word, (double)(pending.event.start_sample - currentReadPos) / sampleRate);
+                    qualityAnalyzer.recordSpotterOutcome(QualityAnalyzer::ProposalOutcome::Withdrawn);
+                    continue;
+                }
+            }
+            
+            whisperLog.info("[Spotter] Whisper did not hear \"%s\" - kept (confidence %.2f)",
+                            pending.event.word, pending.confidence);
+            qualityAnalyzer.recordSpotterOutcome(QualityAnalyzer::ProposalOutcome::Kept);
+            continue;
+        }
+        else if (pending.event.end_sample <= currentReadPos)
+        {
+            // Played before any decode covered it (gated or fast-path window)
+            qualityAnalyzer.recordSpotterOutcome(QualityAnalyzer::ProposalOutcome::Kept);
+            continue;
+        }
+        
+        pendingProposals[kept++] = pending;
+    }
+    
+    pendingProposals.resize(kept);
+}
+
+juce::int64 AudioEngine::toCaptureSample(juce::int64 whisperSample) const
+{
+    // Resampler group delay and vocal filter pipeline shift the 16kHz stream slightly behind the input
+    const int filterLatency = useVocalFilter ? vocalFilter.getLatencySamples() : 0;
+    return whisperSample * sampleRate / WHISPER_SAMPLE_RATE
+         - (juce::int64)std::lround(whisperResampler.getLatencyInputSamples()
+                                    + (double)filterLatency * sampleRate / WHISPER_SAMPLE_RATE);
+}
+
+juce::int64 AudioEngine::toPushSample(juce::int64 captureSample) const
+{
+    // Capture sample 0 is the first sample this engine was given, at sampleRate
+    if (pushStreamRate <= 0 || pushStreamRate == sampleRate)
+        return pushStreamOrigin + captureSample;
+    
+    return pushStreamOrigin + (juce::int64)std::llround((double)captureSample * pushStreamRate / sampleRate);
+}
+
+void AudioEngine::beginPushMessage(juce::int64 captureEndSample)
+{
+    if (censorPushCallback)
+        pushEncoder.begin(pushSequence, (uint32_t)(pushStreamRate > 0 ? pushStreamRate : sampleRate),
+                          toPushSample(captureEndSample));
+}
+
+void AudioEngine::addPushEvent(const CensorEvent& event)
+{
+    if (!censorPushCallback)
+        return;
+    
+    CensorEvent clientEvent = event;
+    clientEvent.start_sample = toPushSample(event.start_sample);
+    clientEvent.end_sample = toPushSample(event.end_sample);
+    pushEncoder.addEvent(clientEvent);
+}
+
+void AudioEngine::addPushWord(juce::int64 startSample, juce::int64 endSample, float confidence, const std::string& text)
+{
+    if (censorPushCallback)
+        pushEncoder.addWord(toPushSample(startSample), toPushSample(endSample), confidence, text);
+}
+
+void AudioEngine::sendPushMessage()
+{
+    if (!censorPushCallback || pushEncoder.isEmpty())
+        return;
+    
+    censorPushCallback(pushEncoder.finish(), pushEncoder.getSize());
+    ++pushSequence;
 }
 
 void AudioEngine::saveWavFile(const std::string& filename, const std::vector<float>& samples, int sampleRate)
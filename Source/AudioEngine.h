@@ -29,15 +29,41 @@
 #include <vector>
 #include <thread>
 #include "QualityAnalyzer.h"
-#include <mutex>
-#include <condition_variable>
 #include "ProfanityFilter.h"
 #include "LyricsAlignment.h"
+#include "LyricsFastPath.h"
+#include "KeywordSpotter.h"
 #include "VocalFilter.h"
+#include "VocalActivityGate.h"
 #include "TimestampRefiner.h"
 #include "SongRecognition.h"
+#include "RecognitionWorker.h"
+#include "LyricsCache.h"
+#include "CensorTimelineCache.h"
+#include "CensorTimelineReplay.h"
 #include "WindowsMediaInfo.h"
 #include "Types.h"
+#include "CircularBuffer.h"
+#include "CensorshipEngine.h"
+#include "LockFreeQueue.h"
+#include "Resampler.h"
+#include "WakeSignal.h"
+#include "ModelManager.h"
+#include "LatencyController.h"
+#include "WhisperDecodeScheduler.h"
+#include "WhisperTranscript.h"
+#include "RedecodePolicy.h"
+#include "AsyncLogger.h"
+#include "PushProtocol.h"
+#include "SessionArena.h"
+#include "UiStateModel.h"
+#include <array>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+class MultiStreamEngine;
 
 class AudioEngine : public juce::AudioIODeviceCallback
 {
@@ -49,6 +75,14 @@ public:
     };
     
     AudioEngine();
+    
+    /**
+        Multi-stream mode: one stream of the host. The Whisper models and the
+        decode workers are the host's; devices, delay line, censor timeline and
+        statistics stay per engine.
+    */
+    explicit AudioEngine(MultiStreamEngine& sharedHost);
+    
     ~AudioEngine() override;
     
     /**
@@ -63,6 +97,26 @@ public:
                const juce::String& outputDeviceName,
                CensorMode mode);
     
+    /**
+        Start processing a remote input (e.g. a WebSocketServer session) instead
+        of a device. The samples arrive through processRemoteAudio(); the
+        censored output is not played here, the client gets the censor events
+        through the push callback.
+        
+        @param streamSampleRate     Rate of the samples the client sends
+        @param mode                 Censorship mode (Reverse or Mute)
+        @return                     true if started successfully
+    */
+    bool startRemote(int streamSampleRate, CensorMode mode);
+    
+    /**
+        Feed the next mono samples of a remote input (the device callback's
+        pipeline, run on the caller's thread).
+        
+        Thread: One feeding thread (real-time safe)
+    */
+    void processRemoteAudio(const float* samples, int numSamples);
+    
     /**
         Stop audio processing.
     */
@@ -78,16 +132,21 @@ public:
     /**
         Get current buffer capacity in seconds.
         
-        Buffer starts at 5.1s and grows as processing accumulates (RTF < 1.0x).
+        Playback starts once the buffer reaches the LatencyController target
+        (the measured look-ahead tail plus a margin); time-stretching then
+        steers the buffer towards the target as it moves.
         
         @return     Buffer size in seconds
     */
     double getCurrentBufferSize() const;
     
     /**
-        Check if buffer is in underrun state (< 3 seconds).
+        Check if buffer is in underrun state.
         
-        When buffer underruns, censorship is temporarily disabled to prevent glitches.
+        The buffer underruns when it drops below the LatencyController's
+        minimum safe look-ahead (the measured p50 requirement) and recovers
+        once it is back above the measured tail. While it underruns,
+        censorship is temporarily disabled to prevent glitches.
         
         @return     true if buffer is critically low
     */
@@ -125,37 +184,107 @@ public:
     QualityAnalyzer& getQualityAnalyzer() { return qualityAnalyzer; }
     
     /**
-        Set debug callback for UI updates.
+        State for the UI: song, transcript lines, buffer level and pipeline
+        warnings/errors, published by the engine threads as they change.
+        The UI reads it on its own timer (UiStateModel::read(), message thread only).
     */
-    void setDebugCallback(std::function<void(const juce::String&)> callback) 
-    { 
-        debugCallback = callback; 
+    UiStateModel& getUiState() { return uiState; }
+    
+    /**
+        Configure the audio/Whisper thread log channel at runtime.
+        
+        @param level                Lines below this level are discarded on the calling thread
+        @param messagesPerSecond    Sustained per-thread rate (0 = unlimited; errors always pass)
+        @param burst                Lines allowed back to back before the rate applies
+    */
+    void setLogLevel(AsyncLogger::Level level) { logger.setMinimumLevel(level); }
+    void setLogRateLimit(double messagesPerSecond, double burst)
+    {
+        logger.setRateLimit(AsyncLogger::Producer::Audio, messagesPerSecond, burst);
+        logger.setRateLimit(AsyncLogger::Producer::Whisper, messagesPerSecond, burst);
     }
+    bool setLogFile(const std::string& path) { return logger.setLogFile(path); }
     
     /**
-        Set lyrics callback for live display (Whisper transcription).
+        Configure the decoding policy (call while stopped).
+        
+        Enabled: one greedy decode per window, then beam search only on the
+        sub-windows around low-confidence or lexicon-like words. Disabled:
+        whisper.cpp's temperature fallback over the whole window.
+        
+        @param options          Thresholds and per-window budget
+        @param useLargerModel   Run the second pass on the next model tier up when it is loaded
     */
-    void setLyricsCallback(std::function<void(const juce::String&)> callback)
+    void setRedecodeOptions(const RedecodePolicy::Options& options, bool useLargerModel = false)
     {
-        lyricsCallback = callback;
+        redecodePolicy.setOptions(options);
+        redecodeWithLargerModel = useLargerModel;
     }
     
     /**
-        Set actual lyrics callback for displaying aligned/corrected lyrics.
+        Configure the lyrics-locked fast path (call while stopped).
+        
+        While lyrics alignment is locked, lexicon hits in the lyrics are
+        censored ahead of capture from the predicted word timing and Whisper
+        only verifies: windows around a predicted hit, plus a heartbeat window
+        on the fastest model. Everything else is not decoded.
     */
-    void setActualLyricsCallback(std::function<void(const juce::String&)> callback)
+    void setLyricsFastPathOptions(const LyricsFastPath::Options& options)
     {
-        actualLyricsCallback = callback;
+        lyricsFastPath.setOptions(options);
     }
     
     /**
-        Set song info callback for displaying detected song.
+        Configure two-tier detection (call while stopped).
         
-        @param callback Function called with (artist, title, confidence)
+        A streaming recognizer in front of Whisper proposes lexicon hits about
+        100ms after they are sung, and they are censored straight away as
+        tentative events. Whisper confirms a proposal when it decodes the same
+        audio, or withdraws it before it plays if it heard no lexicon word
+        there. QualityAnalyzer reports the look-ahead the proposals needed next
+        to Whisper's own (what initialDelaySeconds has to cover).
     */
-    void setSongInfoCallback(std::function<void(const juce::String&, const juce::String&, float)> callback)
+    void setKeywordSpotterOptions(const KeywordSpotter::Options& options)
     {
-        songInfoCallback = callback;
+        keywordSpotter.setOptions(options);
+    }
+    
+    /**
+        Configure censor timeline replay (call while stopped).
+        
+        Every identified song is cached with its censor events and an energy
+        envelope once it has played. On a replay the song position is found by
+        correlating the envelopes, the cached events are censored ahead of
+        capture and Whisper only spot-verifies: windows around a cached event,
+        plus a heartbeat window on the fastest model.
+    */
+    void setCensorTimelineOptions(const CensorTimelineReplay::Options& options)
+    {
+        censorTimeline.setOptions(options);
+    }
+    
+    /**
+        Set the push channel for a remote client (e.g. WebSocketServer::sendBinary).
+        
+        Called on the Whisper thread once per decoded window that scheduled events
+        (or committed words), straight after scheduling, with one PushProtocol
+        message. The callback must not block; set it before start().
+        
+        Positions in the message count the client's own samples: this engine's
+        first captured sample is streamOrigin, at streamSampleRate.
+        
+        @param callback         Receives the encoded message (valid for the call only)
+        @param includeWords     Also send the window's committed transcript words
+        @param streamSampleRate Rate of the client's sample count (0 = the capture rate)
+        @param streamOrigin     Client samples that came before this engine's capture
+    */
+    void setCensorPushCallback(std::function<void(const uint8_t* data, size_t size)> callback, bool includeWords = false,
+                               int streamSampleRate = 0, juce::int64 streamOrigin = 0)
+    {
+        censorPushCallback = callback;
+        pushTranscriptWords = includeWords;
+        pushStreamRate = streamSampleRate;
+        pushStreamOrigin = streamOrigin;
     }
     
     /**
@@ -186,47 +315,447 @@ public:
     void audioDeviceStopped() override;
 
 private:
+    AudioEngine(MultiStreamEngine* sharedHost);
+    
+    // Declared first: every other member may log until it is destroyed
+    AsyncLogger logger;
+    AsyncLogger::Channel& audioLog = logger.getChannel(AsyncLogger::Producer::Audio);        // Audio callback only
+    AsyncLogger::Channel& whisperLog = logger.getChannel(AsyncLogger::Producer::Whisper);    // Whisper thread only
+    
     // Helper methods
     void whisperThreadFunction();
-    std::vector<float> resampleTo16kHz(const std::vector<float>& input);
-    void processTranscription(const std::vector<float>& buffer, double captureTime);
+    
+    /**
+        Everything start() does once the input is known: models, buffers, decode
+        workers, the Whisper thread and song identification.
+        
+        @param bufferSize   Largest block the callback will be given
+        
+        Thread: Control thread
+    */
+    bool startPipeline(int bufferSize);
+    
+    /**
+        Rewind the callback's timeline for a new session (positions back to 0,
+        delay line cleared, queued censor events dropped).
+        
+        Thread: Before the callback runs (audioDeviceAboutToStart(), startRemote())
+    */
+    void resetCallbackState();
+    
+    /**
+        Look-ahead a window's censor events need: from the newest captured sample
+        back to its first new word, plus the censor padding.
+        
+        @param committedFromSample  First sample the window commits words from
+    */
+    double getRequiredLookAheadSeconds(juce::int64 committedFromSample) const;
+    
+    /**
+        Pick the model, gate and queue one window for decoding.
+        
+        @param buffer               16kHz window; moved into the job only when this returns true
+        @param captureEndSample     Absolute end of the window on the delay buffer timeline
+        @return                     true if the buffer was taken (false: skipped, the caller keeps it)
+        
+        Thread: Whisper thread
+    */
+    bool submitTranscription(std::vector<float>& buffer, juce::int64 captureEndSample);
+    
+    /**
+        Turn a finished decode into stable words, alignment and censor events.
+        Called in window order; the streaming state is only touched here.
+        
+        Thread: Whisper thread
+    */
+    void processTranscription(const WhisperDecodeScheduler::Result& decode);
+    
+    /**
+        Queue a censor event for a word range: a decoded hit, or one Whisper
+        did not decode in this pass (predicted, cached or proposed). Pads the
+        range, skips it on a
+        buffer underrun, drops it if it already played, records it and adds
+        it to the push message in progress (tentative events are not pushed:
+        clients cannot be told to withdraw one). A Reverse event longer than
+        the look-ahead is scheduled as Mute: its end would not be captured
+        yet when it starts playing.
+        
+        @param startSample, endSample   Word range on the delay line timeline (unpadded)
+        @param extraPaddingSeconds      Added on both sides (prediction or sync uncertainty)
+        @param label                    Log prefix, e.g. "[Timeline] Cached"
+        @param event                    Receives the queued event
+        @param record                   Record it (false: already recorded, e.g. a confirmed proposal)
+        @param earliestSample, latestSample     Padded range is clamped to these (a decoded hit's window)
+        @return                         true if it was queued
+        
+        Thread: Whisper thread
+    */
+    bool scheduleCensorEvent(juce::int64 startSample, juce::int64 endSample, const std::string& word,
+                             float confidence, bool tentative, double extraPaddingSeconds,
+                             const char* label, CensorEvent& event, bool record = true,
+                             juce::int64 earliestSample = std::numeric_limits<juce::int64>::min(),
+                             juce::int64 latestSample = std::numeric_limits<juce::int64>::max());
+    
+    /**
+        Lyrics fast path: schedule the predicted lexicon hits that fall within
+        the look-ahead horizon of this capture position.
+        
+        Thread: Whisper thread
+    */
+    void schedulePredictedCensorship(juce::int64 captureEndSample);
+    
+    /**
+        Create the configured spotter backend (when the kind changed) and start
+        the spotter on the 16kHz feed.
+        
+        Thread: Control thread (start())
+    */
+    void startKeywordSpotter();
+    
+    /**
+        Two-tier detection: schedule the spotter's new proposals as tentative
+        censor events and remember them for confirmation.
+        
+        @return     true if there were any
+        
+        Thread: Whisper thread
+    */
+    bool scheduleProposedCensorship();
+    
+    /**
+        Mark the pending proposals a decoded hit overlaps as confirmed.
+        
+        @return     true if the hit confirmed one (it was already counted)
+        
+        Thread: Whisper thread
+    */
+    bool confirmProposals(juce::int64 startSample, juce::int64 endSample);
+    
+    /**
+        Withdraw the unconfirmed proposals Whisper just decoded without a hit
+        (midpoint in [decodedFromSample, decodedToSample)) and forget the ones
+        that already played.
+        
+        Thread: Whisper thread
+    */
+    void resolveProposals(juce::int64 decodedFromSample, juce::int64 decodedToSample);
+    
+    /**
+        Map a 16kHz feed position onto the device-rate delay line timeline
+        (resampler group delay and vocal filter pipeline shift the feed slightly
+        behind the input).
+    */
+    juce::int64 toCaptureSample(juce::int64 whisperSample) const;
+    
+    /**
+        Push channel: start a message, add an event or word, send it if it holds
+        anything. Positions are converted to the client's sample count.
+        
+        Thread: Whisper thread
+    */
+    void beginPushMessage(juce::int64 captureEndSample);
+    void addPushEvent(const CensorEvent& event);
+    void addPushWord(juce::int64 startSample, juce::int64 endSample, float confidence, const std::string& text);
+    void sendPushMessage();
+    
+    /**
+        Map a delay line position onto the push client's stream (see setCensorPushCallback()).
+    */
+    juce::int64 toPushSample(juce::int64 captureSample) const;
+    
+    /**
+        Log (once) when the lyrics fast path engages or steps back to full decoding.
+        
+        Thread: Whisper thread
+    */
+    void noteFastPathTransition();
+    
+    /**
+        A song was identified: look up its cached timeline and hand it to the
+        Whisper thread (repeated notifications for the same song are ignored).
+        
+        Thread: Any (media callback, message thread, Whisper thread)
+    */
+    void beginCensorTimeline(const std::string& artist, const std::string& title);
+    
+    /**
+        Switch the timeline replay to the song beginCensorTimeline() handed over
+        (the previous song's timeline is stored first).
+        
+        Thread: Whisper thread
+    */
+    void adoptTimelineSong();
+    
+    /**
+        Feed the 16kHz stream written since the last call to the timeline replay.
+        
+        Thread: Whisper thread
+    */
+    void feedCensorTimeline();
+    
+    /**
+        End the current song's timeline and cache it if it is worth keeping.
+        
+        Thread: Whisper thread (control thread in stop(), after it exited)
+    */
+    void finishCensorTimeline();
+    
+    /**
+        Timeline replay: schedule the cached events that fall within the
+        look-ahead horizon of this capture position.
+        
+        Thread: Whisper thread
+    */
+    void scheduleCachedCensorship(juce::int64 captureEndSample);
+    
+    /**
+        Log (once) when the timeline replay syncs or steps back to full decoding.
+        
+        Thread: Whisper thread
+    */
+    void noteTimelineTransition();
+    
+    /**
+        Publish buffer level and input level to the UI state (at most every UI_STATS_INTERVAL_MS).
+        
+        Thread: Whisper thread
+    */
+    void publishUiStats();
+    
+    /**
+        Time between successive Whisper decodes.
+        
+        In streaming mode consecutive windows share overlapSeconds of audio,
+        so a new decode is started every (chunkSeconds - overlapSeconds).
+        
+        @return     Hop length in seconds
+    */
+    double getHopSeconds() const;
+    
+    /**
+        Phase 9: Load the fallback model (tiny.en) and start loading the other
+        tiers found in Models/ in the background (tiny.en and small.en required
+        for adaptive switching, base.en and medium.en optional).
+    */
+    void loadWhisperModels();
+    void freeWhisperModels();
+    
+    /**
+        Append models the background loader has published since the last call
+        to modelTiers (and to the decode scheduler when running), then re-pick
+        the primary and fallback tiers.
+        
+        Thread: Whisper thread while running, control thread otherwise
+    */
+    void adoptLoadedModels();
+    
+    /**
+        Phase 9: Pick the model for the next chunk.
+        
+        Tiny.en is forced while the look-ahead is below switchToTinyThreshold and
+        stays active until it recovers above switchToSmallThreshold. Otherwise the
+        most accurate model whose measured RTF still fits the look-ahead is used.
+        
+        @param captureEndSample     Absolute end of the window about to be decoded
+        @return                     Index into modelTiers
+    */
+    int selectModelTier(juce::int64 captureEndSample);
+    
+    /**
+        Phase 9: Feed a chunk's measured RTF back into the model's estimate and
+        report it to QualityAnalyzer.
+    */
+    void recordModelTiming(int tier, double realTimeFactor, double audioSeconds);
+    
+    /**
+        Report how much look-ahead a decoded window needed (capture of its
+        earliest new word, minus censor padding, until now) to latencyController.
+        
+        @param committedFromSample  First sample of the audio this window committed
+    */
+    void recordLookAheadRequirement(juce::int64 committedFromSample);
     
     // Audio device
     juce::AudioDeviceManager deviceManager;
     
+    // Remote input: processRemoteAudio() drives the callback instead of a device
+    static constexpr int REMOTE_BLOCK_SAMPLES = 512;
+    bool remoteInput = false;
+    std::array<std::vector<float>, 2> remoteOutput;   // Discarded output (preallocated in startRemote())
+    
     // Configuration variables (easy tuning)
     double chunkSeconds = 2.0;           // Audio chunk size to process (larger chunks = more context)
     double overlapSeconds = 0.5;         // Overlap between chunks to catch boundary words
-    double initialDelaySeconds = 3.0;   // Initial buffering before playback starts
+    double initialDelaySeconds = 3.0;   // Buffering before playback starts (until decodes are measured; then adaptive)
+    double censorPaddingBeforeSeconds = 0.4;  // Censor lead before a word's timestamp
+    
+    // Streaming decode: rolling window of chunkSeconds, re-decoded every hop
+    bool streamingMode = true;           // false = disjoint chunks (no overlap, no carried prompt)
+    double stableMarginSeconds = 0.25;   // Words this close to the window end wait for the next window
+    int maxPromptTokens = 64;            // Previous tokens carried into the next decode as prompt
+    bool useVocalGate = true;            // Skip whisper_full on windows without vocal activity
+    bool useVocalFilter = true;          // Band-limit the Whisper feed (150 Hz - 5 kHz) in the audio callback
+    bool redecodeWithLargerModel = false;  // Second pass on the next tier up (when loaded and not in tiny mode)
+    RedecodePolicy redecodePolicy;       // Greedy first pass + targeted second pass (replaces temperature fallback)
     
     // Simple level tracking for Phase 1-2
     std::atomic<float> currentInputLevel {0.0f};
     
+    // Phase 9: Adaptive model switching (see ADAPTIVE_MODEL_SWITCHING.md)
+    struct WhisperModelTier
+    {
+        std::string name;                   // e.g. "small.en"
+        whisper_context* ctx = nullptr;
+        double rtfEstimate = 0.0;           // EMA of measured RTF (processing time / hop)
+        int chunksDecoded = 0;
+    };
+    std::vector<WhisperModelTier> modelTiers;    // Loaded models, fastest (tiny.en) first
+    int primaryModelTier = -1;                   // small.en, or the best loaded model below it
+    int lastModelTier = -1;
+    std::atomic<bool> usingTinyModel {false};    // Hysteresis state (emergency tiny.en mode)
+    double switchToTinyThreshold = 1.0;          // Switch to tiny when look-ahead < 1s
+    double switchToSmallThreshold = 2.0;         // Switch back when look-ahead > 2s
+    double rtfSmoothing = 0.3;                   // EMA weight of the newest RTF measurement
+    bool allowLargerThanPrimary = false;         // Load medium.en and use it when it fits the look-ahead
+    int maxConcurrentDecodes = 0;                // Windows decoded side by side (0 = from core topology)
+    ModelManager ownModelManager;                // Owns the contexts: staged and pre-warmed loading
+    WhisperDecodeScheduler ownDecodeScheduler;   // Worker pool + whisper_state per slot (shares modelTiers' contexts)
+    MultiStreamEngine* host = nullptr;           // Multi-stream mode: models and workers belong to the host
+    ModelManager& modelManager;                  // ownModelManager, or the host's
+    WhisperDecodeScheduler& decodeScheduler;     // ownDecodeScheduler, or the host's
+    int decodeStream = 0;                        // This engine's queue on decodeScheduler
+    SessionArena sessionArena;                   // Pooled window buffers + per-window scratch (Whisper thread only)
+    
     // Phase 5: Whisper integration with background thread
-    whisper_context* whisperCtx = nullptr;
-    std::vector<float> audioBuffer;          // Accumulation buffer (audio callback writes here)
-    std::vector<float> processingBuffer;     // Copy for background thread to process
-    std::vector<float> audioBuffer16k;
-    int bufferWritePos = 0;
-    int transcriptionInterval = 0;
+    whisper_context* whisperCtx = nullptr;       // Primary model (small.en)
+    whisper_context* whisperCtxTiny = nullptr;   // Fallback model (tiny.en)
+    std::unique_ptr<CircularAudioBuffer> whisperWindow;  // Mono 16kHz history (audio callback writes, Whisper thread reads)
+    LockFreeQueue<AudioChunk, 64> whisperChunkQueue;      // Window positions published by the audio callback
+    WakeSignal whisperWake;                               // Wakes the Whisper thread when a chunk is published
+    StreamingResampler whisperResampler;     // Device rate -> 16kHz, runs per block on the audio thread
+    std::vector<float> monoBlock;            // Downmix scratch at the device rate (preallocated in start())
+    std::vector<float> resampledBlock;       // Resampler output scratch (preallocated in start())
+    int transcriptionInterval = 0;           // Samples captured since the last handoff
+    std::atomic<juce::int64> inputSamplesCaptured {0};  // Absolute input sample count (same timeline as delay buffer)
+    
+    // Streaming decode state (Whisper thread only)
+    juce::int64 streamCommittedSample = 0;   // Absolute sample up to which words have been emitted
+    std::vector<whisper_token> streamPromptTokens;
+    
+    // Streaming profanity detection (Whisper thread only)
+    struct EmittedWord
+    {
+        juce::int64 startSample = 0;         // Absolute, same timeline as the delay buffer
+        juce::int64 endSample = 0;
+        float confidence = 0.0f;
+    };
+    ProfanityMatcher::Stream profanityStream;                              // Carries phrases across windows
+    std::array<EmittedWord, ProfanityMatcher::MAX_PHRASE_TOKENS> recentWords;  // Timing by word index (ring)
+    juce::int64 profanityCoveredWord = -1;   // Last word index already censored
     ProfanityFilter profanityFilter;
-    VocalFilter vocalFilter;
+    
+    // Two-tier detection: the spotter proposes from the 16kHz feed, Whisper confirms
+    KeywordSpotter keywordSpotter;       // Own thread; reads whisperWindow and profanityFilter's matcher
+    KeywordSpotter::Backend keywordSpotterBackend = KeywordSpotter::Backend::Off;   // Kind the backend was created as
+    struct PendingProposal
+    {
+        CensorEvent event {};            // As scheduled (tentative, padded)
+        juce::int64 wordStartSample = 0; // Unpadded, delay line timeline
+        juce::int64 wordEndSample = 0;
+        float confidence = 0.0f;
+        bool confirmed = false;
+    };
+    std::vector<PendingProposal> pendingProposals;   // Scheduled, awaiting Whisper (Whisper thread only)
+    VocalFilter vocalFilter;            // Streaming, runs on the 16kHz feed in the audio callback
+    VocalActivityGate vocalGate;        // Pre-decode vocal activity check (Whisper thread only)
     TimestampRefiner timestampRefiner;  // Phase 6: Accurate timestamp refinement
-    LyricsAlignment lyricsAlignment;     // Phase 7: Lyrics alignment
+    LyricsAlignment lyricsAlignment;     // Phase 7: Lyrics alignment (Whisper thread only, see queueLyrics())
+    LyricsFastPath lyricsFastPath;       // Censor from locked lyrics, decode to verify (Whisper thread only)
+    std::vector<LyricsFastPath::PredictedHit> predictedHits;   // Scratch for schedulePredictedCensorship()
+    bool fastPathWasEngaged = false;
+    juce::int64 fastPathSkippedUntil = 0;  // Capture end of the last window the fast path skipped
+    LyricsCache lyricsCache;             // On-disk lyrics + fingerprint cache (outlives songRecognition)
+    
+    // Known songs: cached censor timelines replayed instead of decoded
+    CensorTimelineCache censorTimelineCache;     // On disk, one file per song
+    CensorTimelineReplay censorTimeline;         // Records / replays the current song (Whisper thread only)
+    std::vector<CensorTimelineReplay::DueEvent> dueCachedEvents;   // Scratch for scheduleCachedCensorship()
+    std::vector<float> timelineBlock;            // 16kHz scratch for feedCensorTimeline()
+    juce::int64 timelineReadPosition = 0;        // Next whisperWindow sample to feed (Whisper thread)
+    bool timelineWasEngaged = false;
+    struct TimelineSong
+    {
+        std::string artist;
+        std::string title;
+        std::shared_ptr<const CensorTimelineCache::Timeline> cached;    // nullptr on a first play
+    };
+    std::mutex timelineSongMutex;                // Guards the two below
+    std::optional<TimelineSong> pendingTimelineSong;   // Next song for the Whisper thread
+    std::string timelineSongKey;                 // Last song handed over (normalized artist/title)
+    std::atomic<bool> timelineSongPending {false};
     
     // Phase 7 (Idea 2): Song Recognition & Lyrics Alignment
     WindowsMediaInfo windowsMediaInfo;
     bool mediaInfoInitialized = false;
+    std::chrono::steady_clock::time_point lastSongCheckTime = std::chrono::steady_clock::now();   // Whisper thread
     SongRecognition songRecognition;  // Fallback for when Windows Media Control unavailable
+    RecognitionWorker recognitionWorker {songRecognition};  // Fingerprint + lookups off the audio thread
     std::atomic<bool> songIdentificationAttempted{false};
-    std::vector<float> recognitionBuffer;
-    const int recognitionBufferSize = 48000 * 10; // 10 seconds @ 48kHz
+    
+    /**
+        Apply a recognition result: notify the UI and load the fetched lyrics.
+        
+        Thread: Message thread (posted by recognitionWorker)
+    */
+    void handleRecognitionResult(const SongRecognition::SongInfo& song);
+    
+    /**
+        Load lyrics for a song from the cache, fetching them in the background on a miss.
+        The preprocessed words are applied on the message thread.
+        
+        @param artist   Artist name
+        @param title    Song title
+        @param logTag   Log prefix of the caller (e.g. "[SongChange]")
+    */
+    void loadLyricsFor(const std::string& artist, const std::string& title, const std::string& logTag);
+    
+    /**
+        Install cached lyrics into the aligner (no re-tokenization).
+        
+        Thread: Message thread
+    */
+    void applyCachedLyrics(const LyricsCache::Entry& entry, const std::string& logTag);
+    
+    /**
+        Hand lyrics to the Whisper thread (the latest hand-over wins).
+        
+        @param lyrics   Raw lyrics (empty = alignment off until the next song's lyrics)
+        @param words    Preprocessed words (empty = tokenized with setLyrics() on the Whisper thread)
+        
+        Thread: Any (message thread, media callback, control thread)
+    */
+    void queueLyrics(std::string lyrics, std::vector<LyricsWord> words);
+    
+    /**
+        Install the lyrics queueLyrics() handed over, between windows.
+        
+        Thread: Whisper thread
+    */
+    void adoptPendingLyrics();
     
     // Song info
     bool songIdentified = false;
     SongRecognition::SongInfo currentSong;
-    std::string songLyrics;
-    bool useLyricsAlignment = false;
+    std::string songLyrics;                      // Whisper thread (installed by adoptPendingLyrics())
+    bool useLyricsAlignment = false;             // Whisper thread
+    struct PendingLyrics
+    {
+        std::string lyrics;
+        std::vector<LyricsWord> words;
+    };
+    std::mutex pendingLyricsMutex;               // Guards pendingLyrics
+    std::optional<PendingLyrics> pendingLyrics;  // Next lyrics for the Whisper thread
+    std::atomic<bool> lyricsPending {false};
     std::string lastSongTitle;
     std::string lastSongArtist;
     double songElapsedTime = 0.0;  // Estimated position in song (seconds)
@@ -234,15 +763,51 @@ private:
     // Background processing thread
     std::thread whisperThread;
     std::atomic<bool> shouldStop{false};
-    std::mutex bufferMutex;
-    std::condition_variable bufferCV;
-    std::atomic<bool> hasNewBuffer{false};
+    std::atomic<int> chunksInFlight{0};          // Windows published and not yet finished by the Whisper thread
+    int maxChunksInFlight = 1;                   // Decode slots (set from decodeScheduler in start())
     
     // Delay buffer for real-time processing with look-ahead
-    std::vector<std::vector<float>> delayBuffer;
-    int delayBufferSize = 0;
-    int delayReadPos = 0;
-    int delayWritePos = 0;
+    // Positions are absolute samples; delayLine owns the write position
+    std::unique_ptr<CircularAudioBuffer> delayLine;
+    int delayBufferSize = 0;                      // Power-of-two capacity of delayLine
+    std::atomic<juce::int64> delayReadPos {0};    // Next sample to read from delayLine (audio thread writes)
+    
+    // Adaptive look-ahead: the delay grows/shrinks by reading delayLine slightly slower/faster
+    LatencyController latencyController;
+    std::array<std::vector<float>, 2> playbackScratch;   // Censored input samples awaiting interpolation (preallocated in start())
+    int playbackScratchSamples = 0;               // Samples held over from the previous block (start at delayReadPos - this)
+    double playbackPhase = 0.0;                   // Fractional read position into playbackScratch
+    bool playbackStarved = false;                 // Not enough buffered for a block (audio thread only)
+    int lastStretchDirection = 0;                 // For logging changes (audio thread only)
+    
+    /**
+        Read the next block from the delay line at the given rate, censor it on
+        the input timeline and interpolate it into the output.
+        
+        @return     false if the delay line does not hold enough samples yet
+        
+        Thread: Audio callback (real-time safe)
+    */
+    bool renderDelayedOutput(float* const* outputChannelData, int numOutputChannels,
+                             int numSamples, double rate);
+    
+    // Scheduled censorship: ASR thread pushes events, audio thread applies them at read time
+    static constexpr int MAX_ACTIVE_CENSOR_EVENTS = 64;
+    LockFreeQueue<CensorEvent, 256> censorEventQueue;             // Whisper thread -> audio thread
+    std::array<CensorEvent, MAX_ACTIVE_CENSOR_EVENTS> activeCensorEvents;  // Pending timeline (audio thread only)
+    int numActiveCensorEvents = 0;
+    CensorshipEngine censorshipEngine;
+    std::atomic<int> censorEventsApplied {0};     // Events that reached the output
+    std::atomic<int> censorEventsDropped {0};     // Events that arrived after readPos passed them (or overflow)
+    
+    /**
+        Move newly queued censor events into the pending timeline and render
+        every event overlapping the block that was just read into the output.
+        
+        Thread: Audio callback (real-time safe)
+    */
+    void applyScheduledCensorship(float* const* outputChannelData, int numOutputChannels,
+                                  juce::int64 blockStart, int numSamples);
     
     // Runtime state
     std::atomic<bool> isRunning{false};
@@ -256,7 +821,8 @@ private:
     std::atomic<bool> playbackStarted{false};
     std::atomic<bool> wasWaiting{false};
     int debugCounter = 0;
-    double bufferCaptureTime = 0.0;
+    int audioCallbackCount = 0;                  // Audio thread only
+    int debugChunksSaved = 0;                    // Whisper thread only (first windows dumped to DebugAudio/)
     
     // Buffer underrun handling
     std::atomic<bool> bufferUnderrun{false};
@@ -265,11 +831,18 @@ private:
     // Error handling
     juce::String lastError;
     
+    // UI state (published here, read on the message thread)
+    UiStateModel uiState;
+    static constexpr int UI_STATS_INTERVAL_MS = 100;
+    std::chrono::steady_clock::time_point nextUiStatsTime;     // Whisper thread
+    
     // Callbacks
-    std::function<void(const juce::String&)> debugCallback;
-    std::function<void(const juce::String&)> lyricsCallback;           // Whisper transcription
-    std::function<void(const juce::String&)> actualLyricsCallback;     // Aligned/corrected lyrics
-    std::function<void(const juce::String&, const juce::String&, float)> songInfoCallback;
+    std::function<void(const uint8_t*, size_t)> censorPushCallback;   // Binary events/words (Whisper thread)
+    bool pushTranscriptWords = false;
+    PushProtocol::Encoder pushEncoder;      // Whisper thread only
+    uint32_t pushSequence = 0;
+    int pushStreamRate = 0;                 // Client's sample rate (0 = sampleRate)
+    juce::int64 pushStreamOrigin = 0;       // Client sample of capture sample 0
     
     // Quality analysis
     QualityAnalyzer qualityAnalyzer;
@@ -278,7 +851,7 @@ private:
     struct ProfanityPrediction
     {
         std::string word;
-        double timestamp;
+        double timestamp;               // Stream seconds (capture sample / sample rate)
         std::string censorMode;
         bool isMultiWord;
         
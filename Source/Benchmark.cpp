@@ -0,0 +1,924 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    ExplicitlyBench: reproducible ASR benchmark (WhisperTest grown into a harness).
+
+    Runs a labeled corpus of music clips through every model in Models/ over a
+    grid of n_threads, audio_ctx, window/hop sizes and decoding policy
+    (temperature fallback vs. targeted re-decoding), using the live
+    streaming pipeline (block-wise capture, resampler, vocal filter and gate,
+    carried prompt, stable-commit rule, streaming profanity matcher). Results
+    go to one JSON file for comparing releases and hardware classes.
+
+    Usage:
+        ExplicitlyBench --corpus <dir> [options]
+
+    Corpus: <dir>/corpus.json
+        {
+          "clips": [
+            { "file": "clip01.wav",
+              "labels": [ { "word": "fuck", "start": 12.34, "end": 12.71 } ] }
+          ]
+        }
+    Label times are seconds from the start of the clip; clips without
+    labels measure false positives only.
+
+    Metrics per configuration:
+    - RTF percentiles (processing time per hop, as AudioEngine measures it)
+    - Time to first token (decode start -> decoder's first logits)
+    - Model RSS and the run's peak RSS (current RSS sampled after each window)
+    - Per-stage timings (StageProfiler snapshot)
+    - Detection recall/precision, timestamp error and censor coverage
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <whisper.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "EditDistance.h"
+#include "ProfanityFilter.h"
+#include "RedecodePolicy.h"
+#include "Resampler.h"
+#include "StageProfiler.h"
+#include "TimestampRefiner.h"
+#include "VocalActivityGate.h"
+#include "VocalFilter.h"
+#include "WhisperDecodeScheduler.h"
+#include "WhisperTranscript.h"
+
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+#elif defined(__APPLE__)
+ #include <mach/mach.h>
+#else
+ #include <unistd.h>
+ #include <fstream>
+#endif
+
+#ifndef EXPLICITLY_VERSION_STRING
+ #define EXPLICITLY_VERSION_STRING "dev"
+#endif
+
+namespace
+{
+    constexpr int CAPTURE_BLOCK_SAMPLES = 512;      // Audio callback sized blocks, as on a device
+    constexpr double PADDING_BEFORE_SECONDS = 0.4;  // Live censor padding (coverage metric)
+    constexpr double PADDING_AFTER_SECONDS = 0.1;
+    
+    //==========================================================================
+    // Memory
+    
+    int64_t getCurrentRssBytes()
+    {
+       #if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters {};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return (int64_t)counters.WorkingSetSize;
+        return 0;
+       #elif defined(__APPLE__)
+        mach_task_basic_info info {};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            return (int64_t)info.resident_size;
+        return 0;
+       #else
+        std::ifstream statm("/proc/self/statm");
+        int64_t size = 0, resident = 0;
+        statm >> size >> resident;
+        return resident * (int64_t)sysconf(_SC_PAGESIZE);
+       #endif
+    }
+    
+    double toMegabytes(int64_t bytes) { return (double)bytes / (1024.0 * 1024.0); }
+    
+    //==========================================================================
+    // Corpus
+    
+    struct Label
+    {
+        std::string word;
+        double start = 0.0;                         // Seconds from the start of the clip
+        double end = 0.0;
+    };
+    
+    struct Clip
+    {
+        juce::File file;
+        double sampleRate = 0.0;
+        juce::AudioBuffer<float> audio;             // Decoded once, fed block by block per run
+        std::vector<Label> labels;
+    };
+    
+    struct Detection
+    {
+        std::string entry;                          // Lexicon entry that matched
+        double start = 0.0;                         // Unpadded, seconds from the start of the clip
+        double end = 0.0;
+    };
+    
+    bool loadCorpus(const juce::File& directory, std::vector<Clip>& clips)
+    {
+        const juce::File manifest = directory.getChildFile("corpus.json");
+        const juce::var root = juce::JSON::parse(manifest);
+        const juce::Array<juce::var>* entries = root["clips"].getArray();
+        if (entries == nullptr)
+        {
+            std::cout << "[Bench] ERROR: " << manifest.getFullPathName() << " has no \"clips\" array" << std::endl;
+            return false;
+        }
+        
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        
+        for (const auto& entry : *entries)
+        {
+            Clip clip;
+            clip.file = directory.getChildFile(entry["file"].toString());
+            
+            std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(clip.file));
+            if (reader == nullptr || reader->lengthInSamples <= 0)
+            {
+                std::cout << "[Bench] ERROR: Cannot read " << clip.file.getFullPathName() << std::endl;
+                return false;
+            }
+            
+            clip.sampleRate = reader->sampleRate;
+            clip.audio.setSize((int)std::min(2u, reader->numChannels), (int)reader->lengthInSamples);
+            reader->read(&clip.audio, 0, (int)reader->lengthInSamples, 0, true, true);
+            
+            if (const juce::Array<juce::var>* labels = entry["labels"].getArray())
+            {
+                for (const auto& label : *labels)
+                    clip.labels.push_back({ label["word"].toString().toStdString(),
+                                            (double)label["start"], (double)label["end"] });
+            }
+            
+            std::sort(clip.labels.begin(), clip.labels.end(), [](const Label& a, const Label& b) {
+                return a.start < b.start;
+            });
+            clips.push_back(std::move(clip));
+        }
+        
+        return !clips.empty();
+    }
+    
+    //==========================================================================
+    // Configuration grid
+    
+    struct ModelFile
+    {
+        std::string name;                           // e.g. "small.en", "small.en-q5_1"
+        juce::File file;
+    };
+    
+    struct WindowConfig
+    {
+        double windowSeconds = 2.0;
+        double hopSeconds = 1.5;
+    };
+    
+    struct Settings
+    {
+        juce::File corpus;
+        juce::File output = juce::File::getCurrentWorkingDirectory().getChildFile("benchmark.json");
+        juce::File lexicon = juce::File::getCurrentWorkingDirectory().getChildFile("lexicons/profanity_en.txt");
+        std::vector<std::string> modelFilter;       // Empty = every ggml-*.bin in Models/
+        std::vector<int> threads;
+        std::vector<int> audioContexts { 1500, 768 };
+        std::vector<WindowConfig> windows { { 2.0, 1.5 }, { 5.0, 4.0 } };
+        std::vector<bool> targetedRedecode { false, true };    // Decoding policies to compare
+        int repeat = 1;
+        double toleranceSeconds = 0.3;              // Detection/label overlap slack
+        double stableMarginSeconds = 0.25;
+        int maxPromptTokens = 64;
+        bool useGpu = true;
+        bool useVocalGate = true;
+        bool useVocalFilter = true;
+    };
+    
+    std::vector<std::string> splitList(const juce::String& text)
+    {
+        std::vector<std::string> items;
+        for (const auto& item : juce::StringArray::fromTokens(text, ",", ""))
+            if (item.trim().isNotEmpty())
+                items.push_back(item.trim().toStdString());
+        return items;
+    }
+    
+    std::vector<ModelFile> findModels(const Settings& settings)
+    {
+        const juce::File modelsDir = juce::File::getCurrentWorkingDirectory().getChildFile("Models");
+        std::vector<ModelFile> models;
+        
+        for (const auto& file : modelsDir.findChildFiles(juce::File::findFiles, false, "ggml-*.bin"))
+        {
+            const std::string name = file.getFileNameWithoutExtension().fromFirstOccurrenceOf("ggml-", false, false).toStdString();
+            if (!settings.modelFilter.empty()
+                && std::find(settings.modelFilter.begin(), settings.modelFilter.end(), name) == settings.modelFilter.end())
+                continue;
+            models.push_back({ name, file });
+        }
+        
+        // Smallest first, so memory use grows from one model to the next
+        std::sort(models.begin(), models.end(), [](const ModelFile& a, const ModelFile& b) {
+            return a.file.getSize() < b.file.getSize();
+        });
+        return models;
+    }
+    
+    //==========================================================================
+    // Measurements
+    
+    // Timestamps of one whisper_full_with_state() call, filled by Whisper's callbacks
+    struct DecodeProbe
+    {
+        std::chrono::steady_clock::time_point encoderBegin;
+        std::chrono::steady_clock::time_point firstToken;
+        bool began = false;
+        bool gotToken = false;
+    };
+    
+    bool onEncoderBegin(whisper_context*, whisper_state*, void* userData)
+    {
+        auto* probe = static_cast<DecodeProbe*>(userData);
+        if (!probe->began)
+        {
+            probe->encoderBegin = std::chrono::steady_clock::now();
+            probe->began = true;
+        }
+        return true;
+    }
+    
+    void onLogits(whisper_context*, whisper_state*, const whisper_token_data*, int, float*, void* userData)
+    {
+        // First call = logits of the first token (temperature fallbacks call it again)
+        auto* probe = static_cast<DecodeProbe*>(userData);
+        if (!probe->gotToken)
+        {
+            probe->firstToken = std::chrono::steady_clock::now();
+            probe->gotToken = true;
+        }
+    }
+    
+    struct RunResult
+    {
+        std::vector<double> rtf;                    // Processing time / hop, per decoded window
+        std::vector<double> ttftMs;
+        int windowsDecoded = 0;
+        int windowsSkipped = 0;
+        double audioSeconds = 0.0;
+        double processingSeconds = 0.0;
+        int64_t peakRssBytes = 0;                   // Highest current RSS seen after a decoded window
+        int regionsRedecoded = 0;
+        int wordsReplaced = 0;
+        
+        // Detection (summed over clips and repeats)
+        int labels = 0;
+        int detections = 0;
+        int truePositives = 0;
+        int covered = 0;                            // Labels fully inside a padded detection
+        std::vector<double> startErrorMs;
+        std::vector<double> endErrorMs;
+    };
+    
+    struct Percentiles
+    {
+        double mean = 0.0, p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0;
+    };
+    
+    Percentiles summarize(std::vector<double> values)
+    {
+        Percentiles summary;
+        if (values.empty())
+            return summary;
+        
+        std::sort(values.begin(), values.end());
+        auto at = [&](double fraction) {
+            const size_t rank = (size_t)std::ceil(fraction * (double)values.size());
+            return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+        };
+        
+        double total = 0.0;
+        for (double v : values)
+            total += v;
+        
+        summary.mean = total / (double)values.size();
+        summary.p50 = at(0.50);
+        summary.p90 = at(0.90);
+        summary.p99 = at(0.99);
+        summary.max = values.back();
+        return summary;
+    }
+    
+    juce::var toVar(const Percentiles& summary)
+    {
+        juce::DynamicObject::Ptr object = new juce::DynamicObject();
+        object->setProperty("mean", summary.mean);
+        object->setProperty("p50", summary.p50);
+        object->setProperty("p90", summary.p90);
+        object->setProperty("p99", summary.p99);
+        object->setProperty("max", summary.max);
+        return juce::var(object.get());
+    }
+    
+    /**
+        Greedy time-ordered matching of detections to labels.
+    */
+    void score(const std::vector<Label>& labels, const std::vector<Detection>& detections,
+               double tolerance, RunResult& result)
+    {
+        std::vector<bool> used(detections.size(), false);
+        result.labels += (int)labels.size();
+        result.detections += (int)detections.size();
+        
+        for (const auto& label : labels)
+        {
+            for (size_t d = 0; d < detections.size(); ++d)
+            {
+                const Detection& detection = detections[d];
+                if (used[d] || detection.start > label.end + tolerance || detection.end < label.start - tolerance)
+                    continue;
+                
+                used[d] = true;
+                ++result.truePositives;
+                result.startErrorMs.push_back(std::abs(detection.start - label.start) * 1000.0);
+                result.endErrorMs.push_back(std::abs(detection.end - label.end) * 1000.0);
+                
+                if (detection.start - PADDING_BEFORE_SECONDS <= label.start && detection.end + PADDING_AFTER_SECONDS >= label.end)
+                    ++result.covered;
+                break;
+            }
+        }
+    }
+    
+    //==========================================================================
+    // One clip through the streaming pipeline
+    
+    struct PipelineConfig
+    {
+        int threads = 4;
+        int audioContext = 1500;
+        WindowConfig window;
+        bool targetedRedecode = false;
+    };
+    
+    class ClipRunner
+    {
+    public:
+        ClipRunner(whisper_context* context, whisper_state* decodeState, const ProfanityMatcher& profanityMatcher,
+                   const RedecodePolicy& policy, const Settings& benchSettings, StageProfiler& stageProfiler)
+            : ctx(context), state(decodeState), matcher(profanityMatcher), redecodePolicy(policy),
+              settings(benchSettings), profiler(stageProfiler) {}
+        
+        void run(const Clip& clip, const PipelineConfig& config, RunResult& result)
+        {
+            const double inputRate = clip.sampleRate;
+            const int numChannels = clip.audio.getNumChannels();
+            const int totalSamples = clip.audio.getNumSamples();
+            
+            resampler.prepare((int)std::lround(inputRate), WHISPER_SAMPLE_RATE, CAPTURE_BLOCK_SAMPLES);
+            vocalFilter.initialize(WHISPER_SAMPLE_RATE);
+            vocalFilter.reset();
+            vocalGate.initialize(WHISPER_SAMPLE_RATE);
+            vocalGate.setEnabled(settings.useVocalGate);
+            vocalGate.reset();
+            
+            // Capture: device-sized blocks, downmix, resample, filter (timed like the audio callback)
+            std::vector<float> feed;
+            feed.reserve((size_t)std::ceil((double)totalSamples * WHISPER_SAMPLE_RATE / inputRate) + 1024);
+            std::vector<float> mono((size_t)CAPTURE_BLOCK_SAMPLES);
+            std::vector<float> resampled((size_t)resampler.getMaxOutputSamples(CAPTURE_BLOCK_SAMPLES));
+            
+            for (int position = 0; position < totalSamples; position += CAPTURE_BLOCK_SAMPLES)
+            {
+                const int n = std::min(CAPTURE_BLOCK_SAMPLES, totalSamples - position);
+                StageProfiler::ScopedTimer captureTimer(profiler, StageProfiler::Stage::Capture);
+                
+                const float* left = clip.audio.getReadPointer(0, position);
+                const float* right = numChannels > 1 ? clip.audio.getReadPointer(1, position) : nullptr;
+                for (int i = 0; i < n; ++i)
+                    mono[(size_t)i] = right != nullptr ? (left[i] + right[i]) * 0.5f : left[i];
+                
+                int produced = 0;
+                {
+                    StageProfiler::ScopedTimer resampleTimer(profiler, StageProfiler::Stage::Resample);
+                    produced = resampler.process(mono.data(), n, resampled.data(), (int)resampled.size());
+                }
+                
+                if (settings.useVocalFilter)
+                    vocalFilter.process(resampled.data(), produced);
+                feed.insert(feed.end(), resampled.begin(), resampled.begin() + produced);
+            }
+            
+            const double latencySeconds = resampler.getLatencyInputSamples() / inputRate
+                + (settings.useVocalFilter ? (double)vocalFilter.getLatencySamples() / WHISPER_SAMPLE_RATE : 0.0);
+            
+            // Streaming state (as AudioEngine::processTranscription)
+            committedSeconds = 0.0;
+            promptTokens.clear();
+            profanityStream = {};
+            coveredWord = -1;
+            detections.clear();
+            
+            const int windowSamples = (int)std::lround(config.window.windowSeconds * WHISPER_SAMPLE_RATE);
+            const int hopSamples = std::max(1, (int)std::lround(config.window.hopSeconds * WHISPER_SAMPLE_RATE));
+            const int feedLength = (int)feed.size();
+            
+            int64_t lastWindowEnd = 0;
+            for (int64_t start = 0; start + windowSamples <= feedLength; start += hopSamples)
+            {
+                decodeWindow(feed, start, windowSamples, false, latencySeconds, config, result);
+                lastWindowEnd = start + windowSamples;
+            }
+            
+            if (feedLength > lastWindowEnd)
+            {
+                const int64_t start = std::max<int64_t>(0, feedLength - windowSamples);
+                decodeWindow(feed, start, (int)(feedLength - start), true, latencySeconds, config, result);
+            }
+            
+            result.audioSeconds += (double)totalSamples / inputRate;
+            score(clip.labels, detections, settings.toleranceSeconds, result);
+        }
+    
+    private:
+        void decodeWindow(const std::vector<float>& feed, int64_t start, int length, bool isLast,
+                          double latencySeconds, const PipelineConfig& config, RunResult& result)
+        {
+            std::vector<float> samples(feed.begin() + start, feed.begin() + start + length);
+            
+            if (!vocalGate.analyze(samples.data(), (int)samples.size()).decode)
+            {
+                ++result.windowsSkipped;
+                return;
+            }
+            
+            if ((int)samples.size() < WHISPER_SAMPLE_RATE)
+                samples.insert(samples.begin(), (size_t)WHISPER_SAMPLE_RATE - samples.size(), 0.0f);
+            
+            const double windowSeconds = (double)samples.size() / WHISPER_SAMPLE_RATE;
+            const double windowEndSeconds = (double)(start + length) / WHISPER_SAMPLE_RATE - latencySeconds;
+            const double windowStartSeconds = windowEndSeconds - windowSeconds;
+            
+            // Same decode setup as the live engine, with the benchmarked knobs
+            whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+            wparams.print_realtime = false;
+            wparams.print_progress = false;
+            wparams.print_timestamps = false;
+            wparams.print_special = false;
+            wparams.translate = false;
+            wparams.language = "en";
+            wparams.n_threads = config.threads;
+            wparams.single_segment = false;
+            wparams.token_timestamps = false;
+            wparams.no_context = true;
+            wparams.audio_ctx = config.audioContext;
+            wparams.temperature = 0.0f;
+            wparams.temperature_inc = 0.2f;
+            wparams.entropy_thold = 5.0f;
+            wparams.logprob_thold = -1.0f;
+            wparams.prompt_tokens = promptTokens.empty() ? nullptr : promptTokens.data();
+            wparams.prompt_n_tokens = (int)promptTokens.size();
+            if (config.targetedRedecode)
+                RedecodePolicy::configureFirstPass(wparams);
+            
+            DecodeProbe probe;
+            wparams.encoder_begin_callback = onEncoderBegin;
+            wparams.encoder_begin_callback_user_data = &probe;
+            wparams.logits_filter_callback = onLogits;
+            wparams.logits_filter_callback_user_data = &probe;
+            
+            const auto decodeStart = std::chrono::steady_clock::now();
+            const int status = whisper_full_with_state(ctx, state, wparams, samples.data(), (int)samples.size());
+            const auto decodeEnd = std::chrono::steady_clock::now();
+            
+            if (status != 0)
+            {
+                std::cout << "[Bench] WARNING: Whisper failed with code " << status << " - window skipped" << std::endl;
+                return;
+            }
+            
+            auto seconds = [](auto from, auto to) { return std::chrono::duration<double>(to - from).count(); };
+            const auto encoderBegin = probe.began ? probe.encoderBegin : decodeStart;
+            profiler.record(StageProfiler::Stage::WhisperSetup, seconds(decodeStart, encoderBegin));
+            profiler.record(StageProfiler::Stage::WhisperDecode, seconds(encoderBegin, decodeEnd));
+            if (probe.gotToken)
+                result.ttftMs.push_back(seconds(decodeStart, probe.firstToken) * 1000.0);
+            
+            std::vector<WordSegment> words;
+            std::vector<whisper_token> tokens;
+            WhisperTranscript::extractWords(ctx, state, windowSeconds, words, tokens);
+            
+            // Second pass on the same state, as a decode worker runs it
+            if (config.targetedRedecode)
+            {
+                RedecodePolicy::Report report;
+                const auto regions = redecodePolicy.findRegions(words, windowSeconds, scratch, report);
+                if (!regions.empty())
+                {
+                    redecodePolicy.redecodeRegions(ctx, state, wparams, samples.data(), (int)samples.size(), promptTokens,
+                                                   regions, words, tokens, scratch, report);
+                    profiler.record(StageProfiler::Stage::Redecode, report.secondPassSeconds);
+                }
+                result.regionsRedecoded += report.regions;
+                result.wordsReplaced += report.wordsReplaced;
+            }
+            
+            {
+                StageProfiler::ScopedTimer postTimer(profiler, StageProfiler::Stage::PostProcess);
+                commitWords(words, tokens, windowStartSeconds, windowEndSeconds, samples, isLast);
+            }
+            
+            const double processingSeconds = seconds(decodeStart, std::chrono::steady_clock::now());
+            result.rtf.push_back(processingSeconds / config.window.hopSeconds);
+            result.processingSeconds += processingSeconds;
+            ++result.windowsDecoded;
+            
+            // Outside the timed region; Whisper's compute buffers live in the state, so they are still resident
+            result.peakRssBytes = std::max(result.peakRssBytes, getCurrentRssBytes());
+        }
+        
+        void commitWords(std::vector<WordSegment>& words, const std::vector<whisper_token>& tokens,
+                         double windowStartSeconds, double windowEndSeconds, const std::vector<float>& window, bool isLast)
+        {
+            timestampRefiner.prepareEnvelope(window, WHISPER_SAMPLE_RATE);
+            for (auto& word : words)
+                timestampRefiner.refineWordTimestamp(word, WHISPER_SAMPLE_RATE);
+            
+            // Stable-commit rule: midpoint in [committed, windowEnd - margin), last window commits everything
+            const double margin = isLast ? 0.0 : settings.stableMarginSeconds;
+            const double commitEnd = windowEndSeconds - margin;
+            const double committedFrom = std::max(committedSeconds, windowStartSeconds);
+            
+            StageProfiler::ScopedTimer matchTimer(profiler, StageProfiler::Stage::ProfanityMatch);
+            for (size_t k = 0; k < words.size(); ++k)
+            {
+                const double start = windowStartSeconds + words[k].start;
+                const double end = windowStartSeconds + words[k].end;
+                const double mid = (start + end) * 0.5;
+                if (mid < committedFrom || mid >= commitEnd)
+                    continue;
+                
+                promptTokens.push_back(tokens[k]);
+                recentWords[profanityStream.numWords % recentWords.size()] = { start, end };
+                
+                matcher.feedWord(profanityStream, words[k].word, [&](const ProfanityMatcher::Match& match) {
+                    uint64_t firstWord = match.firstWord;
+                    if (coveredWord >= 0 && firstWord <= (uint64_t)coveredWord)
+                        firstWord = (uint64_t)coveredWord + 1;
+                    if (firstWord > match.lastWord)
+                        return;
+                    coveredWord = (int64_t)match.lastWord;
+                    
+                    detections.push_back({ std::string(matcher.getEntryText(match.entry)),
+                                           recentWords[firstWord % recentWords.size()].start,
+                                           recentWords[match.lastWord % recentWords.size()].end });
+                });
+            }
+            
+            if ((int)promptTokens.size() > settings.maxPromptTokens)
+                promptTokens.erase(promptTokens.begin(), promptTokens.end() - settings.maxPromptTokens);
+            
+            committedSeconds = std::max(committedSeconds, commitEnd);
+        }
+        
+        struct WordTime
+        {
+            double start = 0.0;
+            double end = 0.0;
+        };
+        
+        whisper_context* ctx;
+        whisper_state* state;
+        const ProfanityMatcher& matcher;
+        const RedecodePolicy& redecodePolicy;
+        const Settings& settings;
+        StageProfiler& profiler;
+        EditDistance scratch;
+        
+        StreamingResampler resampler;
+        VocalFilter vocalFilter;
+        VocalActivityGate vocalGate;
+        TimestampRefiner timestampRefiner;
+        
+        double committedSeconds = 0.0;
+        std::vector<whisper_token> promptTokens;
+        ProfanityMatcher::Stream profanityStream;
+        std::array<WordTime, ProfanityMatcher::MAX_PHRASE_TOKENS> recentWords;
+        int64_t coveredWord = -1;
+        std::vector<Detection> detections;
+    };
+    
+    //==========================================================================
+    
+    void printUsage()
+    {
+        std::cout << "Usage: ExplicitlyBench --corpus <dir> [options]\n"
+                     "\n"
+                     "Options:\n"
+                     "  --output <file>         JSON results (default: benchmark.json)\n"
+                     "  --models <a,b,...>      Model names, e.g. tiny.en,small.en (default: every Models/ggml-*.bin)\n"
+                     "  --threads <a,b,...>     n_threads values (default: 2,4,<physical cores>)\n"
+                     "  --audio-ctx <a,b,...>   audio_ctx values, 1500 = full context (default: 1500,768)\n"
+                     "  --windows <w:h,...>     Window:hop seconds (default: 2:1.5,5:4)\n"
+                     "  --policy <a,b>          fallback (temperature fallback) and/or targeted (default: both)\n"
+                     "  --repeat <n>            Corpus passes per configuration (default: 1)\n"
+                     "  --tolerance <seconds>   Detection/label overlap slack (default: 0.3)\n"
+                     "  --lexicon <file>        Profanity lexicon (default: lexicons/profanity_en.txt)\n"
+                     "  --cpu                   Disable GPU offload\n"
+                     "  --no-gate               Decode every window\n"
+                     "  --no-filter             Skip the vocal band-pass filter\n"
+                  << std::endl;
+    }
+    
+    bool parseArguments(int argc, char* argv[], Settings& settings)
+    {
+        auto resolve = [](const juce::String& path) { return juce::File::getCurrentWorkingDirectory().getChildFile(path); };
+        
+        for (int i = 1; i < argc; ++i)
+        {
+            const juce::String arg(argv[i]);
+            const bool hasValue = i + 1 < argc;
+            
+            if (arg == "--corpus" && hasValue)
+                settings.corpus = resolve(argv[++i]);
+            else if (arg == "--output" && hasValue)
+                settings.output = resolve(argv[++i]);
+            else if (arg == "--lexicon" && hasValue)
+                settings.lexicon = resolve(argv[++i]);
+            else if (arg == "--models" && hasValue)
+                settings.modelFilter = splitList(argv[++i]);
+            else if (arg == "--threads" && hasValue)
+            {
+                settings.threads.clear();
+                for (const auto& item : splitList(argv[++i]))
+                    settings.threads.push_back(std::max(1, std::stoi(item)));
+            }
+            else if (arg == "--audio-ctx" && hasValue)
+            {
+                settings.audioContexts.clear();
+                for (const auto& item : splitList(argv[++i]))
+                    settings.audioContexts.push_back(std::max(0, std::stoi(item)));
+            }
+            else if (arg == "--windows" && hasValue)
+            {
+                settings.windows.clear();
+                for (const auto& item : splitList(argv[++i]))
+                {
+                    const juce::String pair(item);
+                    WindowConfig window;
+                    window.windowSeconds = pair.upToFirstOccurrenceOf(":", false, false).getDoubleValue();
+                    window.hopSeconds = pair.contains(":") ? pair.fromFirstOccurrenceOf(":", false, false).getDoubleValue()
+                                                           : window.windowSeconds;
+                    if (window.windowSeconds > 0.0 && window.hopSeconds > 0.0 && window.hopSeconds <= window.windowSeconds)
+                        settings.windows.push_back(window);
+                }
+            }
+            else if (arg == "--policy" && hasValue)
+            {
+                settings.targetedRedecode.clear();
+                for (const auto& item : splitList(argv[++i]))
+                    if (item == "fallback" || item == "targeted")
+                        settings.targetedRedecode.push_back(item == "targeted");
+            }
+            else if (arg == "--repeat" && hasValue)
+                settings.repeat = std::max(1, juce::String(argv[++i]).getIntValue());
+            else if (arg == "--tolerance" && hasValue)
+                settings.toleranceSeconds = std::max(0.0, juce::String(argv[++i]).getDoubleValue());
+            else if (arg == "--cpu")
+                settings.useGpu = false;
+            else if (arg == "--no-gate")
+                settings.useVocalGate = false;
+            else if (arg == "--no-filter")
+                settings.useVocalFilter = false;
+            else
+            {
+                if (arg != "-h" && arg != "--help")
+                    std::cout << "[Bench] ERROR: Unknown or incomplete option " << arg << std::endl;
+                return false;
+            }
+        }
+        
+        if (settings.threads.empty())
+        {
+            const int physical = WhisperDecodeScheduler::recommendedThreadsPerDecode(1);
+            settings.threads = { 2, 4, physical };
+            std::sort(settings.threads.begin(), settings.threads.end());
+            settings.threads.erase(std::unique(settings.threads.begin(), settings.threads.end()), settings.threads.end());
+        }
+        
+        if (settings.corpus == juce::File() || settings.windows.empty() || settings.audioContexts.empty()
+            || settings.targetedRedecode.empty())
+        {
+            std::cout << "[Bench] ERROR: --corpus is required (and the grid may not be empty)" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    juce::var describeMachine(const Settings& settings)
+    {
+        juce::DynamicObject::Ptr machine = new juce::DynamicObject();
+        machine->setProperty("os", juce::SystemStats::getOperatingSystemName());
+        machine->setProperty("cpu", juce::SystemStats::getCpuModel());
+        machine->setProperty("physical_cores", juce::SystemStats::getNumPhysicalCpus());
+        machine->setProperty("logical_cores", juce::SystemStats::getNumCpus());
+        machine->setProperty("memory_mb", juce::SystemStats::getMemorySizeInMegabytes());
+        machine->setProperty("gpu_requested", settings.useGpu);
+        machine->setProperty("whisper_system_info", juce::String(whisper_print_system_info()));
+        return juce::var(machine.get());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    if (!parseArguments(argc, argv, settings))
+    {
+        printUsage();
+        return 1;
+    }
+    
+    std::vector<Clip> clips;
+    if (!loadCorpus(settings.corpus, clips))
+        return 1;
+    
+    ProfanityFilter profanityFilter;
+    if (!profanityFilter.loadLexicon(settings.lexicon))
+    {
+        std::cout << "[Bench] ERROR: Could not load profanity lexicon " << settings.lexicon.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    RedecodePolicy redecodePolicy;
+    redecodePolicy.setLexicon(&profanityFilter.getMatcher());
+    
+    const std::vector<ModelFile> models = findModels(settings);
+    if (models.empty())
+    {
+        std::cout << "[Bench] ERROR: No matching ggml-*.bin in Models/" << std::endl;
+        return 1;
+    }
+    
+    double corpusSeconds = 0.0;
+    int corpusLabels = 0;
+    for (const auto& clip : clips)
+    {
+        corpusSeconds += clip.audio.getNumSamples() / clip.sampleRate;
+        corpusLabels += (int)clip.labels.size();
+    }
+    
+    std::cout << "[Bench] Corpus: " << clips.size() << " clip(s), " << std::fixed << std::setprecision(1)
+              << corpusSeconds << "s, " << corpusLabels << " label(s); " << models.size() << " model(s) x "
+              << settings.threads.size() << " thread count(s) x " << settings.audioContexts.size() << " audio_ctx x "
+              << settings.windows.size() << " window size(s) x " << settings.targetedRedecode.size() << " policy/policies" << std::endl;
+    
+    juce::Array<juce::var> configurations;
+    
+    for (const auto& model : models)
+    {
+        const int64_t rssBefore = getCurrentRssBytes();
+        const auto loadStart = std::chrono::steady_clock::now();
+        
+        whisper_context_params cparams = whisper_context_default_params();
+        cparams.use_gpu = settings.useGpu;
+        whisper_context* ctx = whisper_init_from_file_with_params_no_state(model.file.getFullPathName().toRawUTF8(), cparams);
+        whisper_state* state = ctx != nullptr ? whisper_init_state(ctx) : nullptr;
+        
+        const double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+        if (state == nullptr)
+        {
+            std::cout << "[Bench] WARNING: Could not load " << model.file.getFullPathName() << " - skipped" << std::endl;
+            if (ctx != nullptr)
+                whisper_free(ctx);
+            continue;
+        }
+        
+        // Warm-up decode (first-call allocations and GPU kernel setup stay out of the numbers)
+        std::vector<float> silence((size_t)WHISPER_SAMPLE_RATE, 0.0f);
+        whisper_full_params warmup = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+        warmup.print_progress = false;
+        warmup.print_timestamps = false;
+        warmup.n_threads = settings.threads.back();
+        whisper_full_with_state(ctx, state, warmup, silence.data(), (int)silence.size());
+        
+        const int64_t modelRss = getCurrentRssBytes() - rssBefore;
+        std::cout << "[Bench] " << model.name << " loaded in " << std::setprecision(2) << loadSeconds << "s ("
+                  << std::setprecision(0) << toMegabytes(modelRss) << " MB)" << std::endl;
+        
+        for (int threads : settings.threads)
+        {
+            for (int audioContext : settings.audioContexts)
+            {
+                for (const auto& window : settings.windows)
+                {
+                    for (const bool targeted : settings.targetedRedecode)
+                    {
+                        PipelineConfig config { threads, audioContext, window, targeted };
+                        StageProfiler profiler;
+                        RunResult result;
+                        ClipRunner runner(ctx, state, profanityFilter.getMatcher(), redecodePolicy, settings, profiler);
+                        
+                        for (int pass = 0; pass < settings.repeat; ++pass)
+                            for (const auto& clip : clips)
+                                runner.run(clip, config, result);
+                        
+                        const Percentiles rtf = summarize(result.rtf);
+                        const double recall = result.labels > 0 ? (double)result.truePositives / result.labels : 0.0;
+                        const double precision = result.detections > 0 ? (double)result.truePositives / result.detections : 0.0;
+                        
+                        std::cout << "[Bench] " << model.name << " threads=" << threads << " audio_ctx=" << audioContext
+                                  << " window=" << std::setprecision(1) << window.windowSeconds << "/" << window.hopSeconds
+                                  << "s " << (targeted ? "targeted" : "fallback") << ": RTF p50 " << std::setprecision(3) << rtf.p50 << " p99 " << rtf.p99
+                                  << ", recall " << std::setprecision(2) << recall << ", precision " << precision << std::endl;
+                        
+                        juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+                        entry->setProperty("model", juce::String(model.name));
+                        entry->setProperty("model_file", model.file.getFileName());
+                        entry->setProperty("model_bytes", (juce::int64)model.file.getSize());
+                        entry->setProperty("load_seconds", loadSeconds);
+                        entry->setProperty("threads", threads);
+                        entry->setProperty("audio_ctx", audioContext);
+                        entry->setProperty("window_seconds", window.windowSeconds);
+                        entry->setProperty("hop_seconds", window.hopSeconds);
+                        entry->setProperty("policy", targeted ? "targeted" : "fallback");
+                        entry->setProperty("windows_decoded", result.windowsDecoded);
+                        entry->setProperty("windows_skipped", result.windowsSkipped);
+                        entry->setProperty("audio_seconds", result.audioSeconds);
+                        entry->setProperty("processing_seconds", result.processingSeconds);
+                        entry->setProperty("regions_redecoded", result.regionsRedecoded);
+                        entry->setProperty("words_replaced", result.wordsReplaced);
+                        entry->setProperty("rtf", toVar(rtf));
+                        entry->setProperty("ttft_ms", toVar(summarize(result.ttftMs)));
+                        entry->setProperty("model_rss_mb", toMegabytes(modelRss));
+                        entry->setProperty("peak_rss_mb", toMegabytes(result.peakRssBytes));   // This run only
+                        entry->setProperty("stages", juce::JSON::parse(juce::String(profiler.getSnapshot().toJson())));
+                        
+                        juce::DynamicObject::Ptr detection = new juce::DynamicObject();
+                        detection->setProperty("labels", result.labels);
+                        detection->setProperty("detections", result.detections);
+                        detection->setProperty("true_positives", result.truePositives);
+                        detection->setProperty("recall", recall);
+                        detection->setProperty("precision", precision);
+                        detection->setProperty("coverage", result.labels > 0 ? (double)result.covered / result.labels : 0.0);
+                        detection->setProperty("start_error_ms", toVar(summarize(result.startErrorMs)));
+                        detection->setProperty("end_error_ms", toVar(summarize(result.endErrorMs)));
+                        entry->setProperty("detection", juce::var(detection.get()));
+                        
+                        configurations.add(juce::var(entry.get()));
+                    }
+                }
+            }
+        }
+        
+        whisper_free_state(state);
+        whisper_free(ctx);
+    }
+    
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("schema", 1);
+    root->setProperty("version", EXPLICITLY_VERSION_STRING);
+    root->setProperty("timestamp", juce::Time::getCurrentTime().toISO8601(true));
+    root->setProperty("machine", describeMachine(settings));
+    
+    juce::DynamicObject::Ptr corpus = new juce::DynamicObject();
+    corpus->setProperty("path", settings.corpus.getFullPathName());
+    corpus->setProperty("clips", (int)clips.size());
+    corpus->setProperty("seconds", corpusSeconds);
+    corpus->setProperty("labels", corpusLabels);
+    corpus->setProperty("repeat", settings.repeat);
+    corpus->setProperty("tolerance_seconds", settings.toleranceSeconds);
+    corpus->setProperty("vocal_gate", settings.useVocalGate);
+    corpus->setProperty("vocal_filter", settings.useVocalFilter);
+    root->setProperty("corpus", juce::var(corpus.get()));
+    root->setProperty("configurations", configurations);
+    
+    if (!settings.output.replaceWithText(juce::JSON::toString(juce::var(root.get()))))
+    {
+        std::cout << "[Bench] ERROR: Could not write " << settings.output.getFullPathName() << std::endl;
+        return 1;
+    }
+    
+    std::cout << "[Bench] Results written to " << settings.output.getFullPathName() << std::endl;
+    return 0;
+}
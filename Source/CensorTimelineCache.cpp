@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    CensorTimelineCache.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Implementation of the persistent censor timeline cache.
+
+    File format (<16 hex digits of the key hash>.ctl, JUCE stream encoding):
+
+    int32 magic, int32 version
+    string artist, string title, int32 plays
+    int32 n, n x uint8 envelope
+    int32 m, m x (double start, double end, string word, float confidence)
+
+  ==============================================================================
+*/
+
+#include "CensorTimelineCache.h"
+#include "LyricsAlignment.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    constexpr int FILE_MAGIC = 0x4C544343;     // "CCTL"
+    constexpr int FORMAT_VERSION = 1;
+    constexpr int MAX_ENVELOPE_FRAMES = 30 * 60 * 50;  // 30 minutes (sanity bound for corrupt files)
+    constexpr int MAX_EVENTS = 4096;
+    
+    juce::uint64 hashKey(const std::string& key)
+    {
+        // FNV-1a 64-bit (same as LyricsCache)
+        juce::uint64 hash = 14695981039346656037ULL;
+        for (unsigned char c : key)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+}
+
+juce::File CensorTimelineCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("ExplicitlyDesktop")
+               .getChildFile("CensorTimelines");
+}
+
+bool CensorTimelineCache::open(const juce::File& newDirectory)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    if (!newDirectory.isDirectory() && newDirectory.createDirectory().failed())
+    {
+        std::cerr << "[TimelineCache] Cannot create " << newDirectory.getFullPathName() << std::endl;
+        directory = juce::File();
+        return false;
+    }
+    
+    directory = newDirectory;
+    numEntries.store(directory.getNumberOfChildFiles(juce::File::findFiles, "*.ctl"));
+    
+    std::cout << "[TimelineCache] " << numEntries.load() << " cached song timeline(s) in "
+              << directory.getFullPathName() << std::endl;
+    return true;
+}
+
+void CensorTimelineCache::close()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    directory = juce::File();
+}
+
+bool CensorTimelineCache::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return directory != juce::File();
+}
+
+std::string CensorTimelineCache::makeKey(const std::string& artist, const std::string& title)
+{
+    return LyricsAlignment::normalizeText(artist) + "\n" + LyricsAlignment::normalizeText(title);
+}
+
+juce::File CensorTimelineCache::getFileFor(const std::string& artist, const std::string& title) const
+{
+    return directory.getChildFile(juce::String::toHexString((juce::int64)hashKey(makeKey(artist, title)))
+                                      .paddedLeft('0', 16) + ".ctl");
+}
+
+std::optional<CensorTimelineCache::Timeline> CensorTimelineCache::find(const std::string& artist, const std::string& title)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    if (directory == juce::File() || artist.empty() || title.empty())
+        return std::nullopt;
+    
+    const juce::File file = getFileFor(artist, title);
+    juce::MemoryBlock data;
+    if (!file.existsAsFile() || !file.loadFileAsData(data))
+        return std::nullopt;
+    
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != FILE_MAGIC || in.readInt() != FORMAT_VERSION)
+        return std::nullopt;
+    
+    Timeline timeline;
+    timeline.artist = in.readString().toStdString();
+    timeline.title = in.readString().toStdString();
+    timeline.plays = in.readInt();
+    
+    // 64-bit hash collision guard
+    if (makeKey(timeline.artist, timeline.title) != makeKey(artist, title))
+        return std::nullopt;
+    
+    const int numFrames = in.readInt();
+    if (numFrames <= 0 || numFrames > MAX_ENVELOPE_FRAMES || in.getNumBytesRemaining() < numFrames)
+        return std::nullopt;
+    
+    timeline.envelope.resize((size_t)numFrames);
+    in.read(timeline.envelope.data(), numFrames);
+    
+    const int numEvents = in.readInt();
+    if (numEvents < 0 || numEvents > MAX_EVENTS)
+        return std::nullopt;
+    
+    timeline.events.reserve((size_t)numEvents);
+    for (int i = 0; i < numEvents; ++i)
+    {
+        Event event;
+        event.startSeconds = in.readDouble();
+        event.endSeconds = in.readDouble();
+        event.word = in.readString().toStdString();
+        event.confidence = in.readFloat();
+        
+        if (in.isExhausted() && i + 1 < numEvents)
+            return std::nullopt;     // Truncated
+        
+        timeline.events.push_back(std::move(event));
+    }
+    
+    return timeline;
+}
+
+bool CensorTimelineCache::store(const Timeline& timeline)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    if (directory == juce::File() || timeline.envelope.empty())
+        return false;
+    
+    const juce::File file = getFileFor(timeline.artist, timeline.title);
+    const bool existed = file.existsAsFile();
+    
+    juce::TemporaryFile temp(file);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (!out.openedOk())
+            return false;
+        
+        out.writeInt(FILE_MAGIC);
+        out.writeInt(FORMAT_VERSION);
+        out.writeString(juce::String(timeline.artist));
+        out.writeString(juce::String(timeline.title));
+        out.writeInt(timeline.plays);
+        
+        const int numFrames = (int)std::min<size_t>(timeline.envelope.size(), (size_t)MAX_ENVELOPE_FRAMES);
+        out.writeInt(numFrames);
+        out.write(timeline.envelope.data(), (size_t)numFrames);
+        
+        const int numEvents = (int)std::min<size_t>(timeline.events.size(), (size_t)MAX_EVENTS);
+        out.writeInt(numEvents);
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const Event& event = timeline.events[(size_t)i];
+            out.writeDouble(event.startSeconds);
+            out.writeDouble(event.endSeconds);
+            out.writeString(juce::String(event.word));
+            out.writeFloat(event.confidence);
+        }
+        
+        out.flush();
+        if (out.getStatus().failed())
+            return false;
+    }
+    
+    if (!temp.overwriteTargetFileWithTemporary())
+        return false;
+    
+    if (!existed)
+        numEntries.fetch_add(1);
+    return true;
+}
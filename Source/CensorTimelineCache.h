@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    CensorTimelineCache.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Persistent per-song censor timelines (replay known tracks without decoding).
+
+    Once a song has played through, its censor events are known relative to
+    song time. Each cached song keeps:
+    - the events (song seconds, word, confidence)
+    - a coarse log-energy envelope of the 16kHz feed (20ms frames, one byte
+      each), used to find the song position on a replay by correlation
+    - how often it was replayed and verified
+
+    One file per song (<hash>.ctl), keyed by the normalized "artist / title"
+    pair. AcoustID fingerprints already resolve to artist/title through
+    LyricsCache, so both identification paths land on the same entry.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+    Censor timelines of songs already processed, cached on disk.
+    
+    Thread Safety:
+    - All public methods are thread-safe (internal mutex); none are real-time safe
+    - A lookup reads one small file; the engine calls it on song change, off the audio thread
+*/
+class CensorTimelineCache
+{
+public:
+    static constexpr double FRAME_SECONDS = 0.02;      // Envelope resolution
+    
+    struct Event
+    {
+        double startSeconds = 0.0;      // Song time of the first word (unpadded)
+        double endSeconds = 0.0;        // Song time of the end of the last word
+        std::string word;               // Lexicon entry text
+        float confidence = 0.0f;
+    };
+    
+    struct Timeline
+    {
+        std::string artist;
+        std::string title;
+        std::vector<uint8_t> envelope;  // Log energy per FRAME_SECONDS, from song time 0
+        std::vector<Event> events;      // Sorted by startSeconds
+        int plays = 1;                  // Times the song was heard (first play included)
+        
+        double getDurationSeconds() const { return (double)envelope.size() * FRAME_SECONDS; }
+    };
+    
+    CensorTimelineCache() = default;
+    ~CensorTimelineCache() = default;
+    
+    /**
+        Open (or create) the cache directory.
+        
+        @param directory    Cache directory (created if missing)
+        @return             true if the cache is usable
+    */
+    bool open(const juce::File& directory);
+    
+    /**
+        Default location: <user app data>/ExplicitlyDesktop/CensorTimelines
+    */
+    static juce::File getDefaultDirectory();
+    
+    void close();
+    bool isOpen() const;
+    
+    /**
+        Look up a song's timeline by artist/title (normalized - case and punctuation ignored).
+        
+        @return     Cached timeline, or nullopt on a miss (or a corrupt / foreign file)
+    */
+    std::optional<Timeline> find(const std::string& artist, const std::string& title);
+    
+    /**
+        Persist a timeline, replacing the song's previous one.
+        Written to a temporary file first, so a crash never leaves a torn entry.
+        
+        @return     false if the cache is closed or the write failed
+    */
+    bool store(const Timeline& timeline);
+    
+    /**
+        Number of cached songs (diagnostics).
+    */
+    int getNumEntries() const { return numEntries.load(); }
+
+private:
+    juce::File getFileFor(const std::string& artist, const std::string& title) const;
+    static std::string makeKey(const std::string& artist, const std::string& title);
+    
+    juce::File directory;
+    mutable std::mutex cacheMutex;
+    std::atomic<int> numEntries {0};
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CensorTimelineCache)
+};
@@ -0,0 +1,485 @@
+/*
+  ==============================================================================
+
+    CensorTimelineReplay.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Censor timeline recording and replay implementation.
+
+  ==============================================================================
+*/
+
+#include "CensorTimelineReplay.h"
+#include "ProfanityMatcher.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double ENVELOPE_FLOOR_DB = -100.0;    // Byte 0; 0.5dB per step above it
+    constexpr double MIN_FRAME_VARIANCE = 1.0;      // Flatter windows (silence) carry no position
+    constexpr double RUNNER_UP_EXCLUSION = 1.0;     // Seconds around the best match ignored for the runner-up
+    constexpr double RECHECK_RADIUS = 0.5;          // Seconds searched around the expected position when synced
+    constexpr double VERIFY_SLACK = 0.3;            // A decoded hit this close to a cached event verifies it
+    constexpr int AGREEMENT_FRAMES = 2;             // Consecutive matches this close agree
+    constexpr size_t MAX_RECORDED_EVENTS = 4096;
+}
+
+//==============================================================================
+void CensorTimelineReplay::beginSong(std::shared_ptr<const Timeline> cachedTimeline, const std::string& songArtist,
+                                     const std::string& songTitle, int64_t captureSample, const ProfanityMatcher& matcher)
+{
+    songActive = true;
+    artist = songArtist;
+    title = songTitle;
+    cached = std::move(cachedTimeline);
+    
+    replayEvents.clear();
+    cachedSum.clear();
+    cachedSumSquares.clear();
+    if (cached != nullptr)
+    {
+        // A word taken out of the lexicon since the song was cached is not censored any more
+        for (const auto& event : cached->events)
+        {
+            if (matcher.containsPhrase(event.word))
+                replayEvents.push_back(&event);
+        }
+        
+        // Prefix sums: the mean and variance of any cached span in O(1) while correlating
+        const size_t numFrames = cached->envelope.size();
+        cachedSum.assign(numFrames + 1, 0.0);
+        cachedSumSquares.assign(numFrames + 1, 0.0);
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const double value = cached->envelope[i];
+            cachedSum[i + 1] = cachedSum[i] + value;
+            cachedSumSquares[i + 1] = cachedSumSquares[i] + value * value;
+        }
+    }
+    verified.assign(replayEvents.size(), 0);
+    
+    // Room for the cached length plus a little, 10 minutes for a first play
+    const double expectedSeconds = cached != nullptr ? cached->getDurationSeconds() + 30.0 : 600.0;
+    recordOrigin = captureSample;
+    liveEnvelope.clear();
+    liveEnvelope.reserve((size_t)(expectedSeconds / secondsPerFrame()));
+    liveEvents.clear();
+    frameEnergy = 0.0;
+    frameFill = 0;
+    
+    engaged = false;
+    everSynced = false;
+    lag = 0;
+    candidateLag = 0;
+    candidateAgreements = 0;
+    syncMisses = 0;
+    verifyMisses = 0;
+    framesSinceSyncCheck = 0;
+    lastCorrelation = 0.0f;
+    nextEvent = 0;
+    lastDecodedEnd = captureSample;
+    lastTransition = cached != nullptr ? "song cached - syncing" : "first play - recording";
+    
+    windowsSkipped = 0;
+    windowsVerified = 0;
+    eventsScheduled = 0;
+    eventsVerified = 0;
+    eventsMissed = 0;
+}
+
+std::optional<CensorTimelineReplay::Timeline> CensorTimelineReplay::endSong()
+{
+    if (!songActive)
+        return std::nullopt;
+    
+    if (engaged)
+        disengage("song changed");
+    songActive = false;
+    
+    const double liveSeconds = (double)liveEnvelope.size() * secondsPerFrame();
+    
+    auto byStart = [](const CensorTimelineCache::Event& a, const CensorTimelineCache::Event& b) {
+        return a.startSeconds < b.startSeconds;
+    };
+    
+    if (cached != nullptr && everSynced)
+    {
+        // Replayed: the cached timeline plus whatever this play heard that it did not list
+        Timeline merged = *cached;
+        merged.plays += 1;
+        
+        const double lagSeconds = lag * secondsPerFrame();
+        const double duration = merged.getDurationSeconds();
+        
+        for (const auto& hit : liveEvents)
+        {
+            CensorTimelineCache::Event event = hit;
+            event.startSeconds += lagSeconds;
+            event.endSeconds += lagSeconds;
+            if (event.startSeconds < 0.0 || event.endSeconds > duration)
+                continue;   // Outside the cached part of the song
+            
+            const bool known = std::any_of(merged.events.begin(), merged.events.end(), [&event](const auto& existing) {
+                return existing.word == event.word
+                    && existing.startSeconds < event.endSeconds + VERIFY_SLACK
+                    && event.startSeconds < existing.endSeconds + VERIFY_SLACK;
+            });
+            if (!known)
+                merged.events.push_back(std::move(event));
+        }
+        
+        std::stable_sort(merged.events.begin(), merged.events.end(), byStart);
+        return merged;
+    }
+    
+    // First play (or a cached timeline that never synced: a different edit replaces it if it is fuller)
+    if (liveSeconds < options.minRecordSeconds)
+        return std::nullopt;
+    if (cached != nullptr && liveSeconds < cached->getDurationSeconds())
+        return std::nullopt;
+    
+    Timeline recorded;
+    recorded.artist = artist;
+    recorded.title = title;
+    recorded.envelope = std::move(liveEnvelope);
+    recorded.events = std::move(liveEvents);
+    recorded.plays = 1;
+    std::stable_sort(recorded.events.begin(), recorded.events.end(), byStart);
+    
+    liveEnvelope.clear();
+    liveEvents.clear();
+    return recorded;
+}
+
+//==============================================================================
+void CensorTimelineReplay::pushAudio(const float* samples, int numSamples)
+{
+    if (!songActive)
+        return;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        frameEnergy += (double)samples[i] * samples[i];
+        if (++frameFill == FRAME_SAMPLES)
+        {
+            appendFrame(frameEnergy / FRAME_SAMPLES);
+            frameEnergy = 0.0;
+            frameFill = 0;
+        }
+    }
+}
+
+void CensorTimelineReplay::pushGap(int64_t numSamples)
+{
+    if (!songActive || numSamples <= 0)
+        return;
+    
+    // The partial frame is lost with the gap; song time keeps running
+    const int64_t total = frameFill + numSamples;
+    for (int64_t frame = 0; frame < total / FRAME_SAMPLES; ++frame)
+        appendFrame(0.0);
+    
+    frameFill = (int)(total % FRAME_SAMPLES);
+    frameEnergy = 0.0;
+}
+
+void CensorTimelineReplay::appendFrame(double meanSquare)
+{
+    const double db = 10.0 * std::log10(meanSquare + 1.0e-10);
+    liveEnvelope.push_back((uint8_t)std::clamp((int)std::lround((db - ENVELOPE_FLOOR_DB) * 2.0), 0, 255));
+    
+    const int intervalFrames = std::max(1, (int)std::lround(options.syncIntervalSeconds / secondsPerFrame()));
+    if (cached != nullptr && options.enabled && ++framesSinceSyncCheck >= intervalFrames)
+    {
+        framesSinceSyncCheck = 0;
+        checkSync();
+    }
+}
+
+//==============================================================================
+void CensorTimelineReplay::checkSync()
+{
+    const int window = (int)std::lround(options.syncWindowSeconds / secondsPerFrame());
+    const int numCached = (int)cached->envelope.size();
+    if ((int)liveEnvelope.size() < window || numCached < window)
+        return;
+    
+    const int liveStart = (int)liveEnvelope.size() - window;
+    
+    if (!engaged)
+    {
+        const Match match = correlate(liveStart, 0, numCached - window);
+        if (match.offset < 0)
+            return;     // Silence: no position either way
+        
+        lastCorrelation = match.score;
+        if (match.score < options.minCorrelation || match.score - match.runnerUp < options.minCorrelationMargin)
+        {
+            candidateAgreements = 0;
+            return;
+        }
+        
+        // The same position found again a second later: trust it
+        const int newLag = match.offset - liveStart;
+        const bool agrees = candidateAgreements > 0 && std::abs(newLag - candidateLag) <= AGREEMENT_FRAMES;
+        candidateAgreements = agrees ? candidateAgreements + 1 : 1;
+        candidateLag = newLag;
+        
+        if (candidateAgreements >= options.engageAfterSyncs)
+            engage(newLag);
+        return;
+    }
+    
+    // Synced: re-check near the expected position only (follows slow drift, catches a seek or the next song)
+    const int expected = liveStart + lag;
+    if (expected + window > numCached)
+        return;     // Past the cached part: planWindow() ends the replay
+    
+    const int radius = (int)std::lround(RECHECK_RADIUS / secondsPerFrame());
+    const Match match = correlate(liveStart, std::max(0, expected - radius), std::min(numCached - window, expected + radius));
+    if (match.offset < 0)
+        return;
+    
+    lastCorrelation = match.score;
+    if (match.score >= options.minCorrelation)
+    {
+        syncMisses = 0;
+        lag = match.offset - liveStart;
+    }
+    else if (++syncMisses >= options.maxSyncMisses)
+    {
+        disengage("lost sync with the cached timeline");
+    }
+}
+
+CensorTimelineReplay::Match CensorTimelineReplay::correlate(int liveStart, int firstOffset, int lastOffset) const
+{
+    Match match;
+    if (firstOffset > lastOffset)
+        return match;
+    
+    const int window = (int)liveEnvelope.size() - liveStart;
+    const uint8_t* live = liveEnvelope.data() + liveStart;
+    const uint8_t* reference = cached->envelope.data();
+    
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    for (int i = 0; i < window; ++i)
+    {
+        sum += live[i];
+        sumSquares += (double)live[i] * live[i];
+    }
+    
+    const double mean = sum / window;
+    const double variance = sumSquares / window - mean * mean;
+    if (variance < MIN_FRAME_VARIANCE)
+        return match;
+    
+    // Normalized cross-correlation: gain and level differences between plays cancel out
+    const double liveNorm = std::sqrt(variance * window);
+    const int exclusion = (int)std::lround(RUNNER_UP_EXCLUSION / secondsPerFrame());
+    
+    scores.assign((size_t)(lastOffset - firstOffset + 1), -1.0f);
+    int bestOffset = -1;
+    
+    for (int offset = firstOffset; offset <= lastOffset; ++offset)
+    {
+        const double spanSum = cachedSum[(size_t)(offset + window)] - cachedSum[(size_t)offset];
+        const double spanSquares = cachedSumSquares[(size_t)(offset + window)] - cachedSumSquares[(size_t)offset];
+        const double spanVariance = spanSquares / window - (spanSum / window) * (spanSum / window);
+        if (spanVariance < MIN_FRAME_VARIANCE)
+            continue;
+        
+        // Centering the live side is enough: the cached mean multiplies a zero sum
+        double dot = 0.0;
+        for (int i = 0; i < window; ++i)
+            dot += ((double)live[i] - mean) * reference[offset + i];
+        
+        const float score = (float)(dot / (liveNorm * std::sqrt(spanVariance * window)));
+        scores[(size_t)(offset - firstOffset)] = score;
+        if (bestOffset < 0 || score > scores[(size_t)(bestOffset - firstOffset)])
+            bestOffset = offset;
+    }
+    
+    if (bestOffset < 0)
+        return match;
+    
+    // Runner-up: the best score at a clearly different position (a repeated chorus scores close)
+    float runnerUp = -1.0f;
+    for (int offset = firstOffset; offset <= lastOffset; ++offset)
+    {
+        if (std::abs(offset - bestOffset) > exclusion)
+            runnerUp = std::max(runnerUp, scores[(size_t)(offset - firstOffset)]);
+    }
+    
+    match.offset = bestOffset;
+    match.score = scores[(size_t)(bestOffset - firstOffset)];
+    match.runnerUp = runnerUp;
+    return match;
+}
+
+void CensorTimelineReplay::engage(int newLag)
+{
+    engaged = true;
+    everSynced = true;
+    lag = newLag;
+    syncMisses = 0;
+    verifyMisses = 0;
+    candidateAgreements = 0;
+    lastTransition = "synced to the cached timeline";
+    
+    // Events before the current position went through the regular decode
+    const int64_t now = recordOrigin + (int64_t)std::llround((double)liveEnvelope.size() * secondsPerFrame() * sampleRate);
+    nextEvent = 0;
+    while (nextEvent < replayEvents.size() && toCapture(replayEvents[nextEvent]->startSeconds) < now)
+        ++nextEvent;
+}
+
+void CensorTimelineReplay::disengage(const char* reason)
+{
+    // Events already scheduled stay: recall first, like the lyrics fast path
+    engaged = false;
+    syncMisses = 0;
+    verifyMisses = 0;
+    candidateAgreements = 0;
+    lastTransition = reason;
+}
+
+int64_t CensorTimelineReplay::toCapture(double songSeconds) const
+{
+    return recordOrigin + (int64_t)std::llround((songSeconds - lag * secondsPerFrame()) * sampleRate);
+}
+
+double CensorTimelineReplay::getSongSeconds(int64_t captureSample) const
+{
+    return (double)(captureSample - recordOrigin) / sampleRate + lag * secondsPerFrame();
+}
+
+//==============================================================================
+CensorTimelineReplay::Decision CensorTimelineReplay::planWindow(int64_t windowStartSample, int64_t windowEndSample)
+{
+    if (!options.enabled || !engaged)
+    {
+        lastDecodedEnd = windowEndSample;
+        return Decision::Full;
+    }
+    
+    // The cached play ended here (it may have been cut short): the rest is new audio
+    if (getSongSeconds(windowEndSample) > cached->getDurationSeconds())
+    {
+        disengage("past the cached part of the song");
+        lastDecodedEnd = windowEndSample;
+        return Decision::Full;
+    }
+    
+    // A cached event in (or near) the window: decode it as usual, Whisper spot-verifies it
+    const int64_t margin = (int64_t)(options.hitMarginSeconds * sampleRate);
+    for (const auto* event : replayEvents)
+    {
+        if (toCapture(event->startSeconds) > windowEndSample + margin)
+            break;
+        
+        if (toCapture(event->endSeconds) >= windowStartSample - margin)
+        {
+            lastDecodedEnd = windowEndSample;
+            ++windowsVerified;
+            return Decision::VerifyHit;
+        }
+    }
+    
+    // Heartbeat: new hits the cache does not list still get heard now and then
+    if ((double)(windowEndSample - lastDecodedEnd) >= options.verifyIntervalSeconds * sampleRate)
+    {
+        lastDecodedEnd = windowEndSample;
+        ++windowsVerified;
+        return Decision::Verify;
+    }
+    
+    ++windowsSkipped;
+    return Decision::Skip;
+}
+
+void CensorTimelineReplay::collectDueEvents(int64_t untilSample, std::vector<DueEvent>& events)
+{
+    events.clear();
+    if (!engaged)
+        return;
+    
+    while (nextEvent < replayEvents.size())
+    {
+        const CensorTimelineCache::Event* event = replayEvents[nextEvent];
+        const int64_t start = toCapture(event->startSeconds);
+        if (start >= untilSample)
+            break;
+        
+        events.push_back({ start, std::max(start + 1, toCapture(event->endSeconds)), event });
+        ++eventsScheduled;
+        ++nextEvent;
+    }
+}
+
+void CensorTimelineReplay::observeHit(int64_t startSample, int64_t endSample, const std::string& word, float confidence)
+{
+    if (!songActive)
+        return;
+    
+    if (liveEvents.size() < MAX_RECORDED_EVENTS)
+    {
+        CensorTimelineCache::Event event;
+        event.startSeconds = (double)(startSample - recordOrigin) / sampleRate;
+        event.endSeconds = (double)(endSample - recordOrigin) / sampleRate;
+        event.word = word;
+        event.confidence = confidence;
+        liveEvents.push_back(std::move(event));
+    }
+    
+    if (!engaged)
+        return;
+    
+    const int64_t slack = (int64_t)(VERIFY_SLACK * sampleRate);
+    for (size_t i = 0; i < replayEvents.size(); ++i)
+    {
+        const int64_t start = toCapture(replayEvents[i]->startSeconds);
+        if (start > endSample + slack)
+            break;
+        
+        if (startSample < toCapture(replayEvents[i]->endSeconds) + slack && !verified[i])
+        {
+            verified[i] = 1;
+            ++eventsVerified;
+        }
+    }
+}
+
+void CensorTimelineReplay::observeDecodedRange(int64_t fromSample, int64_t toSample)
+{
+    if (!engaged)
+        return;
+    
+    // Each event's midpoint falls in exactly one committed range, so it is judged once
+    for (size_t i = 0; i < replayEvents.size(); ++i)
+    {
+        const int64_t start = toCapture(replayEvents[i]->startSeconds);
+        if (start >= toSample)
+            break;
+        
+        const int64_t mid = (start + toCapture(replayEvents[i]->endSeconds)) / 2;
+        if (mid < fromSample || mid >= toSample)
+            continue;
+        
+        if (verified[i])
+        {
+            verifyMisses = 0;
+            continue;
+        }
+        
+        ++eventsMissed;
+        if (++verifyMisses >= options.maxVerifyMisses)
+        {
+            disengage("cached events not heard");
+            return;
+        }
+    }
+}
@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    CensorTimelineReplay.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Replays a known song's cached censor timeline instead of decoding it.
+
+    For the song currently playing this:
+    - records a log-energy envelope of the 16kHz feed and every lexicon hit
+      Whisper decodes, in song time (the timeline stored when the song ends)
+    - if the song is cached, finds the song position by normalized
+      cross-correlation of the live envelope against the cached one, and
+      requires a few agreeing matches before trusting it
+    - once synced, schedules the cached events ahead of capture and throttles
+      Whisper to spot verification (same decisions as LyricsFastPath): windows
+      around a cached event are decoded as usual, a heartbeat window every few
+      seconds on the fastest model, everything else is skipped
+    - re-checks the sync every second near the expected position and steps
+      back to full decoding when it no longer correlates (seek, different
+      edit, next song started), when cached events stop being heard, or past
+      the end of the cached part of the song
+    - merges what a replay decoded into the cached timeline (recall first:
+      cached events are never removed, new hits are added)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "CensorTimelineCache.h"
+#include "LyricsFastPath.h"
+
+class ProfanityMatcher;
+
+/**
+    Records and replays per-song censor timelines.
+    
+    Usage (Whisper thread):
+        replay.setSampleRate(sampleRate);
+        replay.beginSong(cachedOrNull, artist, title, captureSampleOfNextAudio, matcher);
+        
+        replay.pushAudio(samples16k, n);                         // Continuous 16kHz feed
+        
+        // Submit: per window
+        decision = replay.planWindow(windowStart, windowEnd);    // LyricsFastPath::Decision
+        replay.collectDueEvents(captureEnd + ahead, events);     // Schedule these
+        
+        // After a decode
+        replay.observeHit(start, end, word, confidence);         // Every lexicon hit
+        replay.observeDecodedRange(committedFrom, committedTo);
+        
+        if (auto timeline = replay.endSong())                    // Song changed / stopped
+            cache.store(*timeline);
+    
+    Thread Safety:
+    - Whisper thread only (beginSong()/endSong() also from the control thread once it stopped)
+*/
+class CensorTimelineReplay
+{
+public:
+    using Decision = LyricsFastPath::Decision;
+    using Timeline = CensorTimelineCache::Timeline;
+    
+    static constexpr int FEED_SAMPLE_RATE = 16000;
+    static constexpr int FRAME_SAMPLES = 320;       // CensorTimelineCache::FRAME_SECONDS at 16kHz
+    
+    struct Options
+    {
+        bool enabled = true;
+        double syncWindowSeconds = 8.0;         // Live envelope correlated against the cached one
+        double syncIntervalSeconds = 1.0;       // Search (not synced) / re-check (synced) this often
+        float minCorrelation = 0.8f;            // Normalized cross-correlation of a match
+        float minCorrelationMargin = 0.1f;      // Over the best match elsewhere (repeated choruses)
+        int engageAfterSyncs = 2;               // Consecutive agreeing matches before throttling
+        int maxSyncMisses = 2;                  // Consecutive failed re-checks that end the replay
+        int maxVerifyMisses = 2;                // Consecutive cached events decoded but not heard
+        double scheduleAheadSeconds = 3.0;      // Cached events are scheduled this far past the capture point
+        double verifyIntervalSeconds = 8.0;     // Heartbeat decode at least this often
+        double hitMarginSeconds = 0.75;         // Windows this close to a cached event are decoded in full
+        double syncPaddingSeconds = 0.06;       // Extra padding of a cached event (envelope resolution + drift)
+        double minRecordSeconds = 30.0;         // Shorter plays are not cached
+    };
+    
+    /**
+        A cached event placed on the stream timeline.
+    */
+    struct DueEvent
+    {
+        int64_t startSample;                            // Device rate, unpadded
+        int64_t endSample;
+        const CensorTimelineCache::Event* event;        // Valid until the next beginSong()
+    };
+    
+    CensorTimelineReplay() = default;
+    
+    void setOptions(const Options& newOptions) { options = newOptions; }
+    const Options& getOptions() const { return options; }
+    
+    /**
+        @param rate     Device sample rate of every capture position
+    */
+    void setSampleRate(double rate) { sampleRate = rate; }
+    
+    /**
+        Start following a song (the previous one is dropped: endSong() first to keep it).
+        
+        @param cached           Cached timeline of this song, or nullptr (first play)
+        @param artist           Identification (stored with the recorded timeline)
+        @param title
+        @param captureSample    Capture position (device rate) of the next pushAudio() sample
+        @param matcher          Current lexicon: cached events it no longer contains are not replayed
+    */
+    void beginSong(std::shared_ptr<const Timeline> cached, const std::string& artist, const std::string& title,
+                   int64_t captureSample, const ProfanityMatcher& matcher);
+    
+    /**
+        Stop following the song and return the timeline worth caching: the cached
+        one updated with this play's hits if the replay synced, otherwise this
+        play's recording if it is long enough (and at least as long as a cached
+        timeline that never synced).
+        
+        @return     nullopt if there is nothing (new) to store
+    */
+    std::optional<Timeline> endSong();
+    
+    bool hasSong() const { return songActive; }
+    bool hasCachedTimeline() const { return cached != nullptr; }
+    bool isEngaged() const { return engaged; }
+    
+    /**
+        Feed the 16kHz stream (continuous from beginSong()).
+    */
+    void pushAudio(const float* samples, int numSamples);
+    
+    /**
+        Samples the feed lost (reader lapped): keeps song time, records silence.
+    */
+    void pushGap(int64_t numSamples);
+    
+    /**
+        Decide what to do with a window before it is submitted.
+        Records the window as decoded unless the decision is Skip.
+        
+        @return     Full when not engaged
+    */
+    Decision planWindow(int64_t windowStartSample, int64_t windowEndSample);
+    
+    /**
+        Cached events whose start is before untilSample that were not handed out yet.
+        
+        @param events   Cleared, then filled in song order
+    */
+    void collectDueEvents(int64_t untilSample, std::vector<DueEvent>& events);
+    
+    /**
+        A lexicon hit Whisper decoded (recorded; verifies a cached event on the same audio).
+    */
+    void observeHit(int64_t startSample, int64_t endSample, const std::string& word, float confidence);
+    
+    /**
+        Whisper committed the words of this range: cached events in it that no hit verified are misses.
+    */
+    void observeDecodedRange(int64_t fromSample, int64_t toSample);
+    
+    /**
+        Back to full decoding; the sync has to be found again.
+        
+        @param reason   For the log (see getLastTransition())
+    */
+    void disengage(const char* reason);
+    
+    /**
+        Why the replay last engaged or disengaged (static string).
+    */
+    const char* getLastTransition() const { return lastTransition; }
+    
+    /**
+        Cached song time at a capture position (valid once synced).
+    */
+    double getSongSeconds(int64_t captureSample) const;
+    
+    //==========================================================================
+    // Statistics (since beginSong)
+    
+    int getWindowsSkipped() const { return windowsSkipped; }
+    int getWindowsVerified() const { return windowsVerified; }
+    int getEventsScheduled() const { return eventsScheduled; }
+    int getEventsVerified() const { return eventsVerified; }
+    int getEventsMissed() const { return eventsMissed; }
+    int getNumCachedEvents() const { return (int)replayEvents.size(); }
+    float getLastCorrelation() const { return lastCorrelation; }
+
+private:
+    struct Match
+    {
+        int offset = -1;            // Cached frame of the first live window frame
+        float score = -1.0f;
+        float runnerUp = -1.0f;     // Best score away from offset
+    };
+    
+    void appendFrame(double meanSquare);
+    void checkSync();
+    Match correlate(int liveStart, int firstOffset, int lastOffset) const;
+    void engage(int newLag);
+    
+    int64_t toCapture(double songSeconds) const;
+    double secondsPerFrame() const { return CensorTimelineCache::FRAME_SECONDS; }
+    
+    Options options;
+    double sampleRate = 44100.0;
+    
+    // Song being followed
+    bool songActive = false;
+    std::string artist;
+    std::string title;
+    std::shared_ptr<const Timeline> cached;
+    std::vector<const CensorTimelineCache::Event*> replayEvents;   // Cached events still in the lexicon
+    std::vector<uint8_t> verified;                                  // Per replayEvents entry
+    std::vector<double> cachedSum;                                  // Prefix sums of the cached envelope
+    std::vector<double> cachedSumSquares;
+    mutable std::vector<float> scores;                              // correlate() scratch
+    
+    // This play's recording (live frame 0 is at recordOrigin)
+    int64_t recordOrigin = 0;
+    std::vector<uint8_t> liveEnvelope;
+    std::vector<CensorTimelineCache::Event> liveEvents;     // Live song time
+    double frameEnergy = 0.0;
+    int frameFill = 0;
+    
+    // Sync: cached frame = live frame + lag
+    bool engaged = false;
+    bool everSynced = false;
+    int lag = 0;
+    int candidateLag = 0;
+    int candidateAgreements = 0;
+    int syncMisses = 0;
+    int verifyMisses = 0;
+    int framesSinceSyncCheck = 0;
+    float lastCorrelation = 0.0f;
+    size_t nextEvent = 0;
+    int64_t lastDecodedEnd = 0;
+    const char* lastTransition = "";
+    
+    int windowsSkipped = 0;
+    int windowsVerified = 0;
+    int eventsScheduled = 0;
+    int eventsVerified = 0;
+    int eventsMissed = 0;
+};
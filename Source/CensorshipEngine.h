@@ -12,6 +12,7 @@
     - Mute samples (silence with fade in/out)
     - 3-5ms fade to prevent clicks/pops
     - Real-time safe (no allocations)
+    - Scheduled events applied at read time, one output block at a time
 
   ==============================================================================
 */
@@ -21,6 +22,8 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <algorithm>
 #include <cmath>
+#include "CircularBuffer.h"
+#include "Types.h"
 
 /**
     Censorship DSP engine.
@@ -33,6 +36,9 @@
         
         // Or mute it
         engine.muteSamples(audio_buffer, 1000, 2000, 48000);
+        
+        // Or apply a scheduled event to the block about to be played
+        engine.applyEventToBlock(output, 2, block_start, 512, event, delay_line, 48000);
 */
 class CensorshipEngine
 {
@@ -164,6 +170,99 @@ public:
         }
     }
     
+    /**
+        Apply a scheduled censor event to the output block being played.
+        
+        The output must already contain the dry audio read from delay_line
+        starting at block_start. Only the part of the event that overlaps
+        [block_start, block_start + num_samples) is touched, so an event spanning
+        several callbacks is rendered seamlessly block by block. Reverse reads its
+        mirrored source straight from the delay line, which is never modified.
+        An event scheduled ahead of capture can start playing before its end was
+        written; until the mirrored sample is written the output is muted (the
+        reversed audio fades in once it is), never the ring's stale contents.
+        
+        @param output               Output channel pointers (nullptr entries skipped)
+        @param num_output_channels  Number of output channels
+        @param block_start          Absolute delay line position of output[ch][0]
+        @param num_samples          Block length
+        @param event                Event with absolute start/end samples
+        @param delay_line           Dry audio source (must still hold the written part of [start, end))
+        @param sample_rate          Sample rate in Hz
+        @param reverse_gain         Level of the reversed audio (0.5 = -6dB)
+        
+        Thread: Audio thread (real-time safe)
+    */
+    void applyEventToBlock(float* const* output,
+                           int num_output_channels,
+                           int64_t block_start,
+                           int num_samples,
+                           const CensorEvent& event,
+                           const CircularAudioBuffer& delay_line,
+                           int sample_rate,
+                           float reverse_gain = 0.5f) const
+    {
+        const int64_t length = event.end_sample - event.start_sample;
+        const int64_t from = std::max(event.start_sample, block_start);
+        const int64_t to = std::min(event.end_sample, block_start + num_samples);
+        if (length <= 0 || from >= to)
+            return;
+        
+        // Fades never take more than a quarter of the event each
+        const int fade_samples = std::max(1, static_cast<int>(std::min<int64_t>(calculateFadeSamples(sample_rate), length / 4)));
+        const int source_channels = delay_line.getNumChannels();
+        
+        // Reverse: offsets below this mirror samples not yet written (capture has not reached them)
+        const int64_t first_written_offset = std::max<int64_t>(0, event.end_sample - delay_line.getWritePosition());
+        
+        for (int ch = 0; ch < num_output_channels; ++ch)
+        {
+            float* channel_data = output[ch];
+            if (channel_data == nullptr)
+                continue;
+            
+            const int source_channel = std::min(ch, source_channels - 1);
+            
+            for (int64_t pos = from; pos < to; ++pos)
+            {
+                const int64_t offset = pos - event.start_sample;  // 0 .. length-1
+                float& sample = channel_data[pos - block_start];
+                
+                if (event.mode == CensorEvent::Mode::Reverse)
+                {
+                    // Fade in at the start, fade out at the end of the reversed region
+                    float gain = reverse_gain;
+                    if (offset < fade_samples)
+                        gain *= static_cast<float>(offset) / fade_samples;
+                    else if (offset >= length - fade_samples)
+                        gain *= static_cast<float>(length - offset) / fade_samples;
+                    
+                    if (offset < first_written_offset)
+                    {
+                        sample = 0.0f;
+                        continue;
+                    }
+                    if (first_written_offset > 0 && offset - first_written_offset < fade_samples)
+                        gain *= static_cast<float>(offset - first_written_offset) / fade_samples;
+                    
+                    const int64_t mirrored = event.end_sample - 1 - offset;
+                    sample = delay_line.getSampleAt(source_channel, mirrored) * gain;
+                }
+                else
+                {
+                    // Fade out into silence, fade back in at the end
+                    float gain = 0.0f;
+                    if (offset < fade_samples)
+                        gain = 1.0f - static_cast<float>(offset) / fade_samples;
+                    else if (offset >= length - fade_samples)
+                        gain = static_cast<float>(offset - (length - fade_samples)) / fade_samples;
+                    
+                    sample *= gain;
+                }
+            }
+        }
+    }
+    
 private:
     /**
         Calculate fade duration in samples (3-5ms).
@@ -8,7 +8,7 @@
     Lock-free circular buffer for ultra-low latency audio streaming.
     
     This implements a thread-safe circular buffer that:
-    - Holds 150-300ms of audio samples
+    - Holds anything from 150-300ms (ASR feed) to several seconds (delay line)
     - Supports lock-free concurrent read/write
     - Handles wraparound automatically
     - Real-time safe (no allocations in hot path)
@@ -22,6 +22,7 @@
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
 #include <atomic>
+#include <cstring>
 #include <vector>
 
 /**
@@ -29,18 +30,20 @@
     
     Thread Safety Model:
     - Single writer (audio callback thread)
-    - Single reader (ASR processing thread)
+    - Single reader (ASR processing thread or the playback side of the callback)
     - No locks, uses atomic operations for synchronization
     
-    Memory Layout (300ms @ 48kHz stereo = 28,800 samples):
-    [====================]
-     ^read         ^write
-     
-    When write catches up to read, oldest data is overwritten (ring behavior).
+    Memory Layout (capacity rounded up to a power of two, channels contiguous):
+    [ch0 ====================][ch1 ====================]
+          ^read       ^write
+    
+    Positions are absolute 64-bit sample counts since the last reset(); the
+    storage index is (position & mask). When write catches up to read, oldest
+    data is overwritten (ring behavior).
     
     Performance Characteristics:
-    - Write: O(1), lock-free, real-time safe
-    - Read: O(n) where n = samples to read, lock-free
+    - Write: O(n), at most two memcpy spans per channel, real-time safe
+    - Read: O(n), at most two memcpy spans per channel, lock-free
     - No dynamic allocation after construction
     - Cache-friendly linear memory access
 */
@@ -48,36 +51,35 @@ class CircularAudioBuffer
 {
 public:
     /**
-        Create a circular buffer with specified capacity.
+        Create a circular buffer with at least the specified capacity.
+        
+        The capacity is rounded up to the next power of two so wraparound is a mask.
         
         @param num_channels     Number of audio channels (1=mono, 2=stereo)
-        @param capacity_samples Total number of samples to store per channel
+        @param capacity_samples Minimum number of samples to store per channel
         
         Example for 300ms at 48kHz:
-            CircularAudioBuffer(2, 14400)  // 0.3 * 48000 = 14.4k samples per channel
+            CircularAudioBuffer(2, 14400)  // 0.3 * 48000 = 14.4k -> 16384 samples per channel
     */
     CircularAudioBuffer(int num_channels, int capacity_samples)
         : numChannels(num_channels)
-        , capacitySamples(capacity_samples)
+        , capacitySamples(roundUpToPowerOfTwo(capacity_samples))
+        , capacityMask(capacitySamples - 1)
         , writePosition(0)
         , readPosition(0)
     {
-        // Allocate buffer memory (150-300ms at 48kHz: 7,200-14,400 samples/channel)
-        buffer.resize(numChannels);
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            buffer[ch].resize(capacitySamples, 0.0f);
-        }
-        
         jassert(numChannels > 0);
-        jassert(capacitySamples > 0);
+        jassert(capacity_samples > 0);
         
-        juce::Logger::writeToLog(juce::String("[CircularBuffer] Created: ") 
-            + juce::String(numChannels) + " channels, " 
+        // Allocate buffer memory once: all channels in one contiguous block
+        buffer.resize((size_t)numChannels * (size_t)capacitySamples, 0.0f);
+        
+        juce::Logger::writeToLog(juce::String("[CircularBuffer] Created: ")
+            + juce::String(numChannels) + " channels, "
             + juce::String(capacitySamples) + " samples ("
             + juce::String(capacitySamples / 48000.0, 3) + " seconds @ 48kHz)");
     }
-
+    
     /**
         Write audio samples to the buffer (called by audio thread).
         
@@ -92,32 +94,55 @@ public:
     void writeSamples(const juce::AudioBuffer<float>& source, int num_samples)
     {
         // Safety check: ensure channel count matches
-        if (source.getNumChannels() != numChannels || num_samples > capacitySamples || num_samples < 0)
+        if (source.getNumChannels() != numChannels)
+            return;
+        
+        writeSamples(source.getArrayOfReadPointers(), numChannels, num_samples);
+    }
+    
+    /**
+        Write raw channel pointers to the buffer (called by audio thread).
+        
+        Channels missing from the source (index >= num_source_channels or a
+        nullptr) are written as silence so all channels stay in step.
+        
+        @param channel_data         Source channel pointers (device callback layout)
+        @param num_source_channels  Number of entries in channel_data
+        @param num_samples          Number of samples to write
+        
+        Thread: Audio callback (real-time critical)
+    */
+    void writeSamples(const float* const* channel_data, int num_source_channels, int num_samples)
+    {
+        if (num_samples <= 0 || num_samples > capacitySamples)
             return;
         
-        const int write_pos = writePosition.load(std::memory_order_acquire);
+        const int64_t write_pos = writePosition.load(std::memory_order_relaxed);
+        const int start = static_cast<int>(write_pos & capacityMask);
+        const int first = juce::jmin(num_samples, capacitySamples - start);
+        const int second = num_samples - first;
         
         for (int ch = 0; ch < numChannels; ++ch)
         {
-            const float* src = source.getReadPointer(ch);
-            if (src == nullptr)
+            float* dest = channelData(ch);
+            const float* src = (channel_data != nullptr && ch < num_source_channels) ? channel_data[ch] : nullptr;
+            
+            if (src != nullptr)
             {
-                juce::Logger::writeToLog("[CircularBuffer] ERROR: Null source pointer for channel " + juce::String(ch));
-                continue;
+                std::memcpy(dest + start, src, (size_t)first * sizeof(float));
+                std::memcpy(dest, src + first, (size_t)second * sizeof(float));
             }
-            
-            for (int i = 0; i < num_samples; ++i)
+            else
             {
-                const int idx = (write_pos + i) % capacitySamples;
-                buffer[ch][idx] = src[i];
+                std::memset(dest + start, 0, (size_t)first * sizeof(float));
+                std::memset(dest, 0, (size_t)second * sizeof(float));
             }
         }
         
-        // Update write position atomically
-        const int new_write_pos = (write_pos + num_samples) % capacitySamples;
-        writePosition.store(new_write_pos, std::memory_order_release);
+        // Publish new absolute write position
+        writePosition.store(write_pos + num_samples, std::memory_order_release);
     }
-
+    
     /**
         Read the last N seconds of audio from the buffer (called by ML thread).
         
@@ -139,41 +164,17 @@ public:
         // Ensure output buffer is sized correctly
         output.setSize(numChannels, samples_to_read, false, false, true);
         
-        const int write_pos = writePosition.load(std::memory_order_acquire);
-        
-        // Calculate start position (going backward from write position)
-        int start_pos = write_pos - samples_to_read;
-        if (start_pos < 0)
-            start_pos += capacitySamples;
-        
-        // Copy samples handling wraparound
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            float* dest = output.getWritePointer(ch);
-            
-            if (start_pos + samples_to_read <= capacitySamples)
-            {
-                // Simple case: no wraparound
-                std::memcpy(dest, buffer[ch].data() + start_pos, samples_to_read * sizeof(float));
-            }
-            else
-            {
-                // Wraparound case: copy in two parts
-                const int samples_until_end = capacitySamples - start_pos;
-                const int samples_from_start = samples_to_read - samples_until_end;
-                
-                std::memcpy(dest, buffer[ch].data() + start_pos, samples_until_end * sizeof(float));
-                std::memcpy(dest + samples_until_end, buffer[ch].data(), samples_from_start * sizeof(float));
-            }
-        }
+        const int64_t write_pos = writePosition.load(std::memory_order_acquire);
+        const int64_t start_pos = juce::jmax<int64_t>(0, write_pos - samples_to_read);
         
+        readSamples(output.getArrayOfWritePointers(), numChannels, start_pos, samples_to_read);
         return samples_to_read;
     }
-
+    
     /**
-        Read samples from specific buffer position (for ASRThread processing).
+        Read samples from specific buffer position (for Whisper and keyword-spotter processing).
         
-        Used by ASRThread to read audio data using metadata from queue.
+        Used by the reader threads to read audio data by absolute position.
         Handles wraparound automatically.
         
         @param output           Destination buffer to copy samples to
@@ -189,7 +190,6 @@ public:
             return false;
         
         // Ensure we have valid data to read (avoid reading uninitialized memory)
-        // Buffer must be initialized with zeros in constructor, so this is just a sanity check
         if (start_position < 0)
             return false;
         
@@ -202,22 +202,45 @@ public:
             return false;
         }
         
-        for (int ch = 0; ch < numChannels; ++ch)
+        readSamples(output.getArrayOfWritePointers(), numChannels, start_position, num_samples);
+        return true;
+    }
+    
+    /**
+        Read samples from an absolute position into raw channel pointers.
+        
+        Destination channels beyond the buffer's channel count repeat the last
+        channel (mono buffer -> stereo output). nullptr destinations are skipped.
+        
+        @param dest_channels        Destination channel pointers
+        @param num_dest_channels    Number of entries in dest_channels
+        @param start_position       Starting absolute sample position
+        @param num_samples          Number of samples to read (<= capacity)
+        
+        Thread: Any single reader (real-time safe)
+    */
+    void readSamples(float* const* dest_channels, int num_dest_channels,
+                     int64_t start_position, int num_samples) const
+    {
+        if (num_samples <= 0 || num_samples > capacitySamples || dest_channels == nullptr)
+            return;
+        
+        const int start = static_cast<int>(start_position & capacityMask);
+        const int first = juce::jmin(num_samples, capacitySamples - start);
+        const int second = num_samples - first;
+        
+        for (int ch = 0; ch < num_dest_channels; ++ch)
         {
-            float* dest = output.getWritePointer(ch);
-            if (!dest)
-                return false;
+            float* dest = dest_channels[ch];
+            if (dest == nullptr)
+                continue;
             
-            for (int i = 0; i < num_samples; ++i)
-            {
-                const int idx = static_cast<int>((start_position + i) % capacitySamples);
-                dest[i] = buffer[ch][idx];
-            }
+            const float* src = channelData(juce::jmin(ch, numChannels - 1));
+            std::memcpy(dest, src + start, (size_t)first * sizeof(float));
+            std::memcpy(dest + first, src, (size_t)second * sizeof(float));
         }
-        
-        return true;
     }
-
+    
     /**
         Get sample at specific absolute position (for timestamp-based access).
         
@@ -233,10 +256,9 @@ public:
     {
         jassert(channel >= 0 && channel < numChannels);
         
-        const int idx = static_cast<int>(absolute_sample % capacitySamples);
-        return buffer[channel][idx];
+        return channelData(channel)[absolute_sample & capacityMask];
     }
-
+    
     /**
         Set sample at specific absolute position (for in-place censorship).
         
@@ -252,10 +274,9 @@ public:
     {
         jassert(channel >= 0 && channel < numChannels);
         
-        const int idx = static_cast<int>(absolute_sample % capacitySamples);
-        buffer[channel][idx] = value;
+        channelData(channel)[absolute_sample & capacityMask] = value;
     }
-
+    
     /**
         Get current write position (total samples written since start).
         
@@ -265,9 +286,29 @@ public:
     {
         return writePosition.load(std::memory_order_acquire);
     }
-
+    
     /**
-        Get buffer capacity in samples.
+        Record how far the reader has consumed (diagnostics / gap display).
+        
+        @param absolute_sample  Absolute read position
+    */
+    void setReadPosition(int64_t absolute_sample)
+    {
+        readPosition.store(absolute_sample, std::memory_order_release);
+    }
+    
+    /**
+        Get last read position published with setReadPosition().
+        
+        @return Absolute read position
+    */
+    int64_t getReadPosition() const
+    {
+        return readPosition.load(std::memory_order_acquire);
+    }
+    
+    /**
+        Get buffer capacity in samples (always a power of two).
         
         @return Total capacity per channel
     */
@@ -275,7 +316,7 @@ public:
     {
         return capacitySamples;
     }
-
+    
     /**
         Get number of channels.
         
@@ -285,7 +326,7 @@ public:
     {
         return numChannels;
     }
-
+    
     /**
         Reset the buffer (clear all audio data).
         
@@ -293,10 +334,7 @@ public:
     */
     void reset()
     {
-        for (int ch = 0; ch < numChannels; ++ch)
-        {
-            std::fill(buffer[ch].begin(), buffer[ch].end(), 0.0f);
-        }
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
         
         writePosition.store(0, std::memory_order_release);
         readPosition.store(0, std::memory_order_release);
@@ -305,15 +343,34 @@ public:
     }
 
 private:
+    static int roundUpToPowerOfTwo(int value)
+    {
+        int result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+    
+    float* channelData(int channel)
+    {
+        return buffer.data() + (size_t)channel * (size_t)capacitySamples;
+    }
+    
+    const float* channelData(int channel) const
+    {
+        return buffer.data() + (size_t)channel * (size_t)capacitySamples;
+    }
+    
     int numChannels;
     int capacitySamples;
+    int capacityMask;
     
-    // Lock-free atomic positions
-    std::atomic<int> writePosition;  // Current write position (wraps at capacity)
-    std::atomic<int> readPosition;   // Last read position (for diagnostics)
+    // Lock-free atomic positions (absolute, never wrap)
+    std::atomic<int64_t> writePosition;  // Total samples written since reset
+    std::atomic<int64_t> readPosition;   // Last read position (for diagnostics)
     
-    // Audio data storage [channel][sample]
-    std::vector<std::vector<float>> buffer;
+    // Audio data storage: channel ch occupies [ch * capacity, (ch + 1) * capacity)
+    std::vector<float> buffer;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CircularAudioBuffer)
 };
@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    EditDistance.cpp
+    Created: 10 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Edit-distance kernel implementation.
+
+  ==============================================================================
+*/
+
+#include "EditDistance.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+int EditDistance::characterDistance(std::string_view a, std::string_view b)
+{
+    if (a.empty()) return (int)b.size();
+    if (b.empty()) return (int)a.size();
+    if (a == b) return 0;
+    
+    // The shorter string becomes the bit-vector pattern
+    if (a.size() > b.size())
+        std::swap(a, b);
+    
+    if ((int)a.size() <= MAX_BIT_PARALLEL_LENGTH)
+        return bitParallelDistance(a, b);
+    
+    return twoRowDistance(a, b);
+}
+
+int EditDistance::bitParallelDistance(std::string_view pattern, std::string_view text)
+{
+    // Myers (1999) / Hyyro (2001) global edit distance: each DP column is held as
+    // vertical +1/-1 delta bit-vectors (Pv/Mv), updated in a handful of word ops
+    const int m = (int)pattern.size();
+    const uint64_t lastBit = 1ULL << (m - 1);
+    
+    for (int i = 0; i < m; ++i)
+        peq[(unsigned char)pattern[i]] |= 1ULL << i;
+    
+    uint64_t pv = (m == 64) ? ~0ULL : ((1ULL << m) - 1);
+    uint64_t mv = 0;
+    int score = m;
+    
+    for (char c : text)
+    {
+        const uint64_t eq = peq[(unsigned char)c];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        
+        if (ph & lastBit)
+            ++score;
+        else if (mh & lastBit)
+            --score;
+        
+        // Row 0 is D[0][j] = j, so a +1 horizontal delta enters at the top
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    
+    // Leave the table clean for the next call (cheaper than clearing all 256)
+    for (char c : pattern)
+        peq[(unsigned char)c] = 0;
+    
+    return score;
+}
+
+int EditDistance::twoRowDistance(std::string_view a, std::string_view b)
+{
+    const int m = (int)a.size();
+    const int n = (int)b.size();
+    
+    if ((int)intRows.size() < 2 * (n + 1))
+        intRows.resize((size_t)2 * (n + 1));
+    
+    int* prev = intRows.data();
+    int* cur = prev + (n + 1);
+    
+    for (int j = 0; j <= n; ++j)
+        prev[j] = j;
+    
+    for (int i = 1; i <= m; ++i)
+    {
+        cur[0] = i;
+        const char ca = a[i - 1];
+        
+        for (int j = 1; j <= n; ++j)
+        {
+            if (ca == b[j - 1])
+                cur[j] = prev[j - 1];
+            else
+                cur[j] = 1 + std::min({ prev[j], cur[j - 1], prev[j - 1] });
+        }
+        
+        std::swap(prev, cur);
+    }
+    
+    return prev[n];
+}
+
+float EditDistance::weightedWordDistance(const std::vector<std::string>& a,
+                                         const std::vector<float>& substitutionCost,
+                                         const std::string_view* b, int n)
+{
+    const int m = (int)a.size();
+    
+    if (m == 0) return (float)n;
+    if (n == 0) return (float)m;
+    
+    // Leaving the band costs more than band indels, so a result <= band is exact;
+    // otherwise widen and retry (chunk-vs-window comparisons rarely need a retry)
+    const int maxBand = std::max(m, n);
+    int band = std::max(std::abs(m - n), 2);
+    
+    while (true)
+    {
+        band = std::min(band, maxBand);
+        const float distance = bandedWordDistance(a, substitutionCost, b, n, band);
+        
+        if (distance <= (float)band || band >= maxBand)
+            return distance;
+        
+        band *= 2;
+    }
+}
+
+float EditDistance::bandedWordDistance(const std::vector<std::string>& a,
+                                       const std::vector<float>& substitutionCost,
+                                       const std::string_view* b, int n,
+                                       int band)
+{
+    const int m = (int)a.size();
+    const float INF = std::numeric_limits<float>::infinity();
+    
+    if ((int)floatRows.size() < 2 * (n + 1))
+        floatRows.resize((size_t)2 * (n + 1));
+    
+    float* prev = floatRows.data();
+    float* cur = prev + (n + 1);
+    
+    for (int j = 0; j <= n; ++j)
+        prev[j] = (j <= band) ? (float)j : INF;
+    
+    for (int i = 1; i <= m; ++i)
+    {
+        const int jLow = std::max(1, i - band);
+        const int jHigh = std::min(n, i + band);
+        
+        // Cells just outside the band read as infinity
+        cur[jLow - 1] = (jLow == 1 && i <= band) ? (float)i : INF;
+        if (jHigh < n)
+            cur[jHigh + 1] = INF;
+        
+        const std::string& word = a[i - 1];
+        const float replaceCost = substitutionCost[i - 1];
+        
+        for (int j = jLow; j <= jHigh; ++j)
+        {
+            if (word == b[j - 1])
+                cur[j] = prev[j - 1];
+            else
+                cur[j] = std::min({ prev[j] + 1.0f,              // Delete
+                                    cur[j - 1] + 1.0f,           // Insert
+                                    prev[j - 1] + replaceCost }); // Replace (weighted)
+        }
+        
+        std::swap(prev, cur);
+    }
+    
+    return prev[n];
+}
+
+const EditDistance::Matrix& EditDistance::wordDistanceMatrix(const std::vector<std::string>& a,
+                                                             const std::vector<std::string>& b)
+{
+    const int m = (int)a.size();
+    const int n = (int)b.size();
+    
+    matrix.rows = m + 1;
+    matrix.cols = n + 1;
+    matrix.cells.resize((size_t)matrix.rows * matrix.cols);   // Keeps capacity between calls
+    
+    int* cells = matrix.cells.data();
+    const int cols = matrix.cols;
+    
+    for (int i = 0; i <= m; ++i)
+        cells[(size_t)i * cols] = i;
+    for (int j = 0; j <= n; ++j)
+        cells[j] = j;
+    
+    for (int i = 1; i <= m; ++i)
+    {
+        int* row = cells + (size_t)i * cols;
+        const int* above = row - cols;
+        
+        for (int j = 1; j <= n; ++j)
+        {
+            if (a[i - 1] == b[j - 1])
+                row[j] = above[j - 1];
+            else
+                row[j] = 1 + std::min({ above[j], row[j - 1], above[j - 1] });
+        }
+    }
+    
+    return matrix;
+}
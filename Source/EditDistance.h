@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    EditDistance.h
+    Created: 10 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Shared edit-distance kernels for lyrics alignment.
+
+    Features:
+    - Myers/Hyyro bit-parallel Levenshtein for strings up to 64 characters
+      (a single word or short phrase: O(n) word operations, no table)
+    - Two-row DP on reusable scratch for longer strings
+    - Banded (Ukkonen) two-row DP for confidence-weighted word sequences,
+      widened automatically until the result is provably exact
+    - Full matrix (flat, reused) only when a backtrace is needed
+    - No allocations once the scratch buffers have grown to the working size
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+    Edit-distance engine with reusable scratch storage.
+    
+    Usage:
+        EditDistance engine;                               // One per thread
+        int d = engine.characterDistance("hello", "yellow");
+        float w = engine.weightedWordDistance(heard, costs, lyrics);
+    
+    Thread Safety:
+    - Not thread-safe; give each thread its own instance
+*/
+class EditDistance
+{
+public:
+    /**
+        (rows x cols) distance table for backtracking; cell(i, j) is the distance
+        between the first i words of one sequence and the first j of the other.
+    */
+    struct Matrix
+    {
+        int rows = 0;
+        int cols = 0;
+        std::vector<int> cells;
+        
+        int operator()(int i, int j) const { return cells[(size_t)i * cols + j]; }
+    };
+    
+    EditDistance() = default;
+    
+    /**
+        Character-level Levenshtein distance.
+        
+        @return     Minimum number of single-character insertions, deletions
+                    and substitutions turning a into b
+    */
+    int characterDistance(std::string_view a, std::string_view b);
+    
+    /**
+        Word-level edit distance with a per-word substitution cost.
+        
+        Insertions and deletions cost 1; substituting word i of a costs
+        substitutionCost[i] (must be >= 1 for the banded search to be exact).
+        
+        @param a                    First word sequence (e.g. transcribed words)
+        @param substitutionCost     One cost per word of a
+        @param b                    Second word sequence (e.g. lyrics window, viewed in place)
+        @param n                    Words in b
+        @return                     Weighted edit distance
+    */
+    float weightedWordDistance(const std::vector<std::string>& a,
+                               const std::vector<float>& substitutionCost,
+                               const std::string_view* b, int n);
+    
+    /**
+        Full unit-cost word distance table (for alignment backtracking).
+        
+        @return     Reference to internal scratch, valid until the next call
+    */
+    const Matrix& wordDistanceMatrix(const std::vector<std::string>& a,
+                                     const std::vector<std::string>& b);
+
+private:
+    static constexpr int MAX_BIT_PARALLEL_LENGTH = 64;
+    
+    int bitParallelDistance(std::string_view pattern, std::string_view text);
+    int twoRowDistance(std::string_view a, std::string_view b);
+    float bandedWordDistance(const std::vector<std::string>& a,
+                             const std::vector<float>& substitutionCost,
+                             const std::string_view* b, int n,
+                             int band);
+    
+    uint64_t peq[256] = {};             // Match masks per character (cleared after each use)
+    std::vector<int> intRows;           // Two rows for the character DP
+    std::vector<float> floatRows;       // Two rows for the weighted word DP
+    Matrix matrix;
+    
+    EditDistance(const EditDistance&) = delete;
+    EditDistance& operator=(const EditDistance&) = delete;
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    KeywordSpotter.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Keyword spotter implementation.
+
+  ==============================================================================
+*/
+
+#include "KeywordSpotter.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+KeywordSpotter::~KeywordSpotter()
+{
+    stop();
+}
+
+void KeywordSpotter::setBackend(std::unique_ptr<AsrBackend> newBackend)
+{
+    jassert(!isRunning());
+    backend = std::move(newBackend);
+    backendPrepared = false;
+}
+
+bool KeywordSpotter::start(const CircularAudioBuffer& ring, const ProfanityMatcher& lexicon, std::function<void()> callback)
+{
+    if (isRunning() || backend == nullptr)
+        return false;
+    
+    if (!backendPrepared)
+    {
+        backendPrepared = backend->prepare(SAMPLE_RATE);
+        if (!backendPrepared)
+        {
+            std::cout << "[Spotter] ERROR: " << backend->getName() << " unavailable: " << backend->getLastError() << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        backend->reset();
+    }
+    
+    source = &ring;
+    matcher = &lexicon;
+    onProposal = std::move(callback);
+    
+    const int blockSamples = std::max(160, (int)std::lround(options.partialIntervalSeconds * SAMPLE_RATE));
+    block.assign((size_t)blockSamples, 0.0f);
+    hypothesis.words.reserve(64);
+    numRecentProposals = 0;
+    nextRecentProposal = 0;
+    while (proposals.pop().has_value()) {}
+    
+    hypothesesMatched.store(0);
+    proposalsMade.store(0);
+    proposalsLost.store(0);
+    gaps.store(0);
+    
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&KeywordSpotter::run, this);
+    
+    std::cout << "[Spotter] " << backend->getName() << (backend->isStreaming() ? " (streaming)" : " (windowed)")
+              << " proposing lexicon hits every " << (int)std::lround(1000.0 * blockSamples / SAMPLE_RATE)
+              << " ms" << std::endl;
+    return true;
+}
+
+void KeywordSpotter::stop()
+{
+    if (!running.exchange(false))
+        return;
+    
+    stopSignal.notify();
+    if (thread.joinable())
+        thread.join();
+    
+    std::cout << "[Spotter] Stopped: " << proposalsMade.load() << " proposal(s) from "
+              << hypothesesMatched.load() << " hypotheses, " << gaps.load() << " gap(s)" << std::endl;
+}
+
+bool KeywordSpotter::popProposal(Proposal& proposal)
+{
+    auto queued = proposals.pop();
+    if (!queued.has_value())
+        return false;
+    
+    proposal = *queued;
+    return true;
+}
+
+void KeywordSpotter::run()
+{
+    const int blockSamples = (int)block.size();
+    const int intervalMs = std::max(1, blockSamples * 1000 / SAMPLE_RATE);
+    
+    int64_t readPosition = source->getWritePosition();
+    streamOrigin = readPosition;
+    
+    while (running.load(std::memory_order_acquire))
+    {
+        // Paced by the audio: at most one interval between checks, stop() wakes it early
+        stopSignal.wait(intervalMs);
+        
+        proposedThisBlock = false;
+        
+        while (running.load(std::memory_order_relaxed) && source->getWritePosition() - readPosition >= blockSamples)
+        {
+            float* data = block.data();
+            source->readSamples(&data, 1, readPosition, blockSamples);
+            
+            // The writer never waits: if it lapped us the block is torn, restart the backend past it
+            const int64_t writePosition = source->getWritePosition();
+            if (writePosition - readPosition > source->getCapacity())
+            {
+                backend->reset();
+                readPosition = writePosition;
+                streamOrigin = readPosition;
+                gaps.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            
+            backend->acceptAudio(data, blockSamples);
+            readPosition += blockSamples;
+            
+            while (backend->popHypothesis(hypothesis))
+                matchHypothesis(hypothesis);
+        }
+        
+        if (proposedThisBlock && onProposal)
+            onProposal();
+    }
+}
+
+void KeywordSpotter::matchHypothesis(const AsrBackend::Hypothesis& current)
+{
+    hypothesesMatched.fetch_add(1, std::memory_order_relaxed);
+    
+    // A partial restates the whole utterance: match it from scratch, word index = vector index
+    ProfanityMatcher::Stream stream;
+    const auto& words = current.words;
+    
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        matcher->feedWord(stream, words[i].text, [this, &words, &current](const ProfanityMatcher::Match& match) {
+            const size_t first = (size_t)match.firstWord;
+            const size_t last = std::min((size_t)match.lastWord, words.size() - 1);
+            
+            Proposal proposal;
+            proposal.entry = match.entry;
+            proposal.startSample = streamOrigin + (int64_t)std::llround(words[first].start * SAMPLE_RATE);
+            proposal.endSample = streamOrigin + (int64_t)std::llround(words[last].end * SAMPLE_RATE);
+            proposal.confidence = 1.0f;
+            for (size_t w = first; w <= last; ++w)
+                proposal.confidence = std::min(proposal.confidence, words[w].confidence);
+            proposal.fromFinal = current.isFinal;
+            
+            if (wasRecentlyProposed(proposal))
+                return;
+            
+            recentProposals[(size_t)nextRecentProposal] = proposal;
+            nextRecentProposal = (nextRecentProposal + 1) % RECENT_PROPOSALS;
+            numRecentProposals = std::min(numRecentProposals + 1, RECENT_PROPOSALS);
+            
+            if (proposals.push(proposal))
+            {
+                proposalsMade.fetch_add(1, std::memory_order_relaxed);
+                proposedThisBlock = true;
+            }
+            else
+            {
+                proposalsLost.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+}
+
+bool KeywordSpotter::wasRecentlyProposed(const Proposal& proposal) const
+{
+    // Partials shift word times a little as the utterance grows; 200ms of slack treats that as the same word
+    const int64_t slack = SAMPLE_RATE / 5;
+    
+    for (int i = 0; i < numRecentProposals; ++i)
+    {
+        const Proposal& recent = recentProposals[(size_t)i];
+        if (recent.entry == proposal.entry
+            && proposal.startSample <= recent.endSample + slack
+            && recent.startSample <= proposal.endSample + slack)
+            return true;
+    }
+    
+    return false;
+}
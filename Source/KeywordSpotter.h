@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    KeywordSpotter.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Low-latency lexicon spotting in front of Whisper (two-tier detection).
+
+    Features:
+    - Feeds a streaming AsrBackend from the 16kHz capture ring every
+      partialIntervalSeconds (100ms), on its own thread
+    - Every hypothesis (partial or final) goes through the compiled
+      ProfanityMatcher; a lexicon hit becomes a Proposal as soon as it is heard,
+      well before the 2s Whisper window around it has been captured
+    - A word already proposed (same entry, overlapping time) is not proposed
+      again when a later partial revises the utterance
+    - The consumer schedules proposals as tentative censor events; Whisper
+      then confirms or withdraws them within the look-ahead window
+    - If the capture ring laps the spotter, the backend restarts at the
+      current position (a gap, never a stall)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "AsrBackend.h"
+#include "CircularBuffer.h"
+#include "LockFreeQueue.h"
+#include "ProfanityMatcher.h"
+#include "WakeSignal.h"
+
+/**
+    Drives one AsrBackend over the capture ring and proposes lexicon hits.
+    
+    Usage:
+        spotter.setBackend(std::make_unique<VoskBackend>());
+        spotter.start(*whisperWindow, matcher, [this] { whisperWake.notify(); });
+        
+        KeywordSpotter::Proposal proposal;          // Consumer thread
+        while (spotter.popProposal(proposal))
+            ...
+        
+        spotter.stop();
+    
+    Thread Safety:
+    - setBackend()/setOptions()/start()/stop(): control thread, while stopped
+    - popProposal(): one consumer thread (the Whisper thread)
+    - Counters: any thread
+    - The source ring is only read; the matcher must not be recompiled while running
+*/
+class KeywordSpotter
+{
+public:
+    static constexpr int SAMPLE_RATE = 16000;   // Capture ring rate (WHISPER_SAMPLE_RATE)
+    
+    enum class Backend
+    {
+        Off,
+        Vosk,               // VoskBackend (needs EXPLICITLY_USE_VOSK)
+        WhisperTiny         // WhisperBackend on the fastest loaded model
+    };
+    
+    struct Options
+    {
+        Backend backend = Backend::Off;
+        double partialIntervalSeconds = 0.1;    // Audio fed per backend call (one partial each)
+        bool cancelRejected = true;             // Withdraw proposals Whisper decoded and did not hear
+        float keepAboveConfidence = 0.9f;       // ...unless the spotter was at least this sure
+    };
+    
+    /**
+        A lexicon hit heard by the spotter. Times are on the source ring's
+        timeline (16kHz absolute samples).
+    */
+    struct Proposal
+    {
+        int entry = -1;                 // ProfanityMatcher::getEntryText()
+        int64_t startSample = 0;
+        int64_t endSample = 0;
+        float confidence = 0.0f;        // Lowest word confidence of the phrase
+        bool fromFinal = false;         // From a closed utterance (else a partial)
+    };
+    
+    KeywordSpotter() = default;
+    ~KeywordSpotter();
+    
+    /**
+        Set the recognizer (prepared on the next start()). nullptr turns the spotter off.
+    */
+    void setBackend(std::unique_ptr<AsrBackend> newBackend);
+    bool hasBackend() const { return backend != nullptr; }
+    AsrBackend* getBackend() const { return backend.get(); }
+    
+    void setOptions(const Options& newOptions) { options = newOptions; }
+    const Options& getOptions() const { return options; }
+    
+    /**
+        Prepare the backend (first start only) and start spotting from the
+        ring's current write position.
+        
+        @param source       16kHz mono capture ring (written by the audio callback)
+        @param matcher      Compiled lexicon
+        @param onProposal   Called on the spotter thread after proposals were queued
+        @return             false if there is no backend or it failed to prepare
+    */
+    bool start(const CircularAudioBuffer& source, const ProfanityMatcher& matcher, std::function<void()> onProposal);
+    void stop();
+    
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    
+    /**
+        Take the oldest queued proposal.
+        
+        @return     false if there is none
+    */
+    bool popProposal(Proposal& proposal);
+    
+    int getHypothesesMatched() const { return hypothesesMatched.load(std::memory_order_relaxed); }
+    int getProposalsMade() const { return proposalsMade.load(std::memory_order_relaxed); }
+    int getProposalsLost() const { return proposalsLost.load(std::memory_order_relaxed); }
+    int getGaps() const { return gaps.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int RECENT_PROPOSALS = 32;
+    
+    void run();
+    void matchHypothesis(const AsrBackend::Hypothesis& hypothesis);
+    bool wasRecentlyProposed(const Proposal& proposal) const;
+    
+    std::unique_ptr<AsrBackend> backend;
+    bool backendPrepared = false;
+    Options options;
+    
+    const CircularAudioBuffer* source = nullptr;
+    const ProfanityMatcher* matcher = nullptr;
+    std::function<void()> onProposal;
+    
+    std::thread thread;
+    std::atomic<bool> running {false};
+    WakeSignal stopSignal;
+    
+    // Spotter thread only
+    int64_t streamOrigin = 0;                   // Ring sample of backend time 0
+    std::vector<float> block;                   // One partial interval of samples
+    AsrBackend::Hypothesis hypothesis;
+    std::array<Proposal, RECENT_PROPOSALS> recentProposals;   // Ring, for de-duplication
+    int numRecentProposals = 0;
+    int nextRecentProposal = 0;
+    bool proposedThisBlock = false;
+    
+    LockFreeQueue<Proposal, 64> proposals;      // Spotter thread -> consumer
+    
+    std::atomic<int> hypothesesMatched {0};
+    std::atomic<int> proposalsMade {0};
+    std::atomic<int> proposalsLost {0};         // Queue full
+    std::atomic<int> gaps {0};                  // Ring lapped the spotter
+    
+    KeywordSpotter(const KeywordSpotter&) = delete;
+    KeywordSpotter& operator=(const KeywordSpotter&) = delete;
+};
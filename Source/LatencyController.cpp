@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    LatencyController.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Look-ahead targeting from measured decode latency.
+
+  ==============================================================================
+*/
+
+#include "LatencyController.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+void LatencyController::prepare(double startupSeconds, double maxSeconds, double fallbackMinimum)
+{
+    maxTarget = std::max(MIN_TARGET_SECONDS, maxSeconds);
+    startupTarget = std::max(MIN_TARGET_SECONDS, std::min(startupSeconds, maxTarget));
+    fallbackMinimumSeconds = std::min(fallbackMinimum, startupTarget);
+    
+    reset();
+    
+    std::cout << "[Latency] Startup look-ahead " << std::fixed << std::setprecision(2) << startupTarget
+              << "s, adaptive " << MIN_TARGET_SECONDS << "-" << maxTarget << "s (playback rate "
+              << (1.0 - MAX_SLOW_DOWN) << "-" << (1.0 + MAX_SPEED_UP) << "x)" << std::endl;
+}
+
+void LatencyController::reset()
+{
+    historyCount = 0;
+    historyNext = 0;
+    lastLoggedTarget = startupTarget;
+    
+    targetSeconds.store(startupTarget);
+    minimumSafeSeconds.store(fallbackMinimumSeconds);
+    recoverySeconds.store(startupTarget);
+    p50Seconds.store(0.0);
+    p99Seconds.store(0.0);
+    windowsMeasured.store(0);
+    
+    currentRate = 1.0;
+    stretchDirection = 0;
+}
+
+void LatencyController::recordRequiredLookAhead(double seconds)
+{
+    if (!(seconds >= 0.0))
+        return;
+    
+    history[(size_t)historyNext] = seconds;
+    historyNext = (historyNext + 1) % HISTORY_WINDOWS;
+    historyCount = std::min(historyCount + 1, HISTORY_WINDOWS);
+    
+    std::array<double, HISTORY_WINDOWS> sorted;
+    std::copy(history.begin(), history.begin() + historyCount, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + historyCount);
+    
+    const double p50 = sorted[(size_t)(historyCount - 1) / 2];
+    const double p99 = sorted[(size_t)std::lround(0.99 * (historyCount - 1))];
+    
+    // Few samples say little about the tail: plan for the worst seen, with extra room
+    const bool warmingUp = historyCount < WARMUP_WINDOWS;
+    const double tail = warmingUp ? sorted[(size_t)(historyCount - 1)] : p99;
+    const double margin = SAFETY_MARGIN_SECONDS + (warmingUp ? WARMUP_MARGIN_SECONDS : 0.0);
+    const double target = std::max(MIN_TARGET_SECONDS, std::min(maxTarget, tail + margin));
+    
+    p50Seconds.store(p50);
+    p99Seconds.store(p99);
+    minimumSafeSeconds.store(std::min(p50, target));
+    recoverySeconds.store(std::min(tail, target));
+    targetSeconds.store(target);
+    windowsMeasured.fetch_add(1);
+    
+    if (std::abs(target - lastLoggedTarget) >= LOG_CHANGE_SECONDS)
+    {
+        std::cout << "[Latency] Look-ahead target " << std::fixed << std::setprecision(2) << lastLoggedTarget
+                  << "s -> " << target << "s (required p50 " << p50 << "s, p99 " << p99 << "s over "
+                  << historyCount << " windows)" << std::endl;
+        lastLoggedTarget = target;
+    }
+}
+
+double LatencyController::getPlaybackRate(double lookAheadSeconds, double blockSeconds)
+{
+    const double error = lookAheadSeconds - getTargetSeconds();
+    
+    // Proportional inside the stretch range, nothing inside the deadband
+    double rateTarget = 1.0;
+    if (error < -DEADBAND_SECONDS)
+        rateTarget = 1.0 - MAX_SLOW_DOWN * std::min(1.0, (-error - DEADBAND_SECONDS) / FULL_STRETCH_ERROR);
+    else if (error > DEADBAND_SECONDS)
+        rateTarget = 1.0 + MAX_SPEED_UP * std::min(1.0, (error - DEADBAND_SECONDS) / FULL_STRETCH_ERROR);
+    
+    // One-pole glide so the pitch never steps
+    const double alpha = 1.0 - std::exp(-blockSeconds / RATE_TIME_CONSTANT);
+    currentRate += (rateTarget - currentRate) * alpha;
+    
+    if (rateTarget == 1.0 && std::abs(currentRate - 1.0) < 1.0e-4)
+        currentRate = 1.0;
+    
+    stretchDirection = (currentRate < 1.0) ? -1 : (currentRate > 1.0 ? 1 : 0);
+    return currentRate;
+}
@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    LatencyController.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Adaptive look-ahead for the delay line.
+
+    Features:
+    - Measures, per decoded window, how much look-ahead its censor events
+      needed (capture of the earliest new word -> events queued)
+    - Target delay = p99 of recent windows + safety margin, so fast machines
+      settle near the floor set by the hop and slow ones keep what they need
+    - The delay changes by playing slightly slower or faster (resampling,
+      at most a few percent) instead of pausing into silence
+    - Censorship bypass thresholds follow the measured p50/p99
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/**
+    Sets the delay line's look-ahead from the measured decode latency.
+    
+    The Whisper thread reports each window's required look-ahead; the audio
+    callback asks for the playback rate of every block. Reading the delay
+    line at rate < 1 grows the gap between write and read position, rate > 1
+    shrinks it.
+    
+    Thread Safety:
+    - prepare()/reset(): control thread, while the audio callback is stopped
+    - recordRequiredLookAhead(): Whisper thread
+    - getPlaybackRate(): audio thread (real-time safe)
+    - Getters: any thread
+*/
+class LatencyController
+{
+public:
+    LatencyController() = default;
+    
+    /**
+        Configure the controller for a session.
+        
+        @param startupSeconds       Look-ahead buffered before playback starts (until measured)
+        @param maxSeconds           Largest look-ahead the delay line can hold
+        @param fallbackMinimum      Bypass threshold until the first windows are measured
+    */
+    void prepare(double startupSeconds, double maxSeconds, double fallbackMinimum);
+    
+    /**
+        Forget measurements and start from the startup target again.
+    */
+    void reset();
+    
+    /**
+        Report how far ahead of playback a window's events had to be.
+        
+        @param seconds  Time between capturing the window's earliest new audio
+                        and its censor events being queued
+        
+        Thread: Whisper thread
+    */
+    void recordRequiredLookAhead(double seconds);
+    
+    /**
+        Playback rate for the next block (1.0 = real time).
+        
+        @param lookAheadSeconds     Current gap between write and read position
+        @param blockSeconds         Duration of the block about to be played
+        
+        Thread: Audio callback (real-time safe)
+    */
+    double getPlaybackRate(double lookAheadSeconds, double blockSeconds);
+    
+    /** Look-ahead the controller steers towards. */
+    double getTargetSeconds() const { return targetSeconds.load(std::memory_order_relaxed); }
+    
+    /** Below this, most windows' events arrive late (censorship is bypassed). */
+    double getMinimumSafeSeconds() const { return minimumSafeSeconds.load(std::memory_order_relaxed); }
+    
+    /** At or above this, censorship can be trusted again. */
+    double getRecoverySeconds() const { return recoverySeconds.load(std::memory_order_relaxed); }
+    
+    double getP50Seconds() const { return p50Seconds.load(std::memory_order_relaxed); }
+    double getP99Seconds() const { return p99Seconds.load(std::memory_order_relaxed); }
+    int getWindowsMeasured() const { return windowsMeasured.load(std::memory_order_relaxed); }
+    
+    /** -1 = growing the delay (slower playback), 0 = holding, +1 = shrinking. */
+    int getStretchDirection() const { return stretchDirection; }
+
+private:
+    // Parameters
+    static constexpr int HISTORY_WINDOWS = 64;              // Percentiles over the last ~30s of windows
+    static constexpr int WARMUP_WINDOWS = 8;                // Use the maximum (plus extra margin) until then
+    static constexpr double SAFETY_MARGIN_SECONDS = 0.25;
+    static constexpr double WARMUP_MARGIN_SECONDS = 0.5;
+    static constexpr double MIN_TARGET_SECONDS = 0.3;
+    static constexpr double DEADBAND_SECONDS = 0.1;         // No stretching this close to the target
+    static constexpr double FULL_STRETCH_ERROR = 1.0;       // Error (seconds) at which the maximum rate applies
+    static constexpr double MAX_SLOW_DOWN = 0.04;           // Grow: up to 4% slower (~0.7 semitone)
+    static constexpr double MAX_SPEED_UP = 0.02;            // Shrink: gentler, there is no hurry
+    static constexpr double RATE_TIME_CONSTANT = 0.5;       // Seconds for rate changes to settle
+    static constexpr double LOG_CHANGE_SECONDS = 0.1;       // Log the target when it moves this much
+    
+    // Whisper thread
+    std::array<double, HISTORY_WINDOWS> history {};
+    int historyCount = 0;
+    int historyNext = 0;
+    double lastLoggedTarget = 0.0;
+    
+    // Configuration
+    double startupTarget = 3.0;
+    double maxTarget = 10.0;
+    double fallbackMinimumSeconds = 2.5;
+    
+    // Published
+    std::atomic<double> targetSeconds {3.0};
+    std::atomic<double> minimumSafeSeconds {2.5};
+    std::atomic<double> recoverySeconds {3.0};
+    std::atomic<double> p50Seconds {0.0};
+    std::atomic<double> p99Seconds {0.0};
+    std::atomic<int> windowsMeasured {0};
+    
+    // Audio thread
+    double currentRate = 1.0;
+    int stretchDirection = 0;
+};
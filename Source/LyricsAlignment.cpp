@@ -17,33 +17,45 @@
 #include <regex>
 #include <algorithm>
 
+namespace
+{
+    // Alignment runs on the Whisper thread; the static helpers share one engine per thread
+    EditDistance& scratchEditDistance()
+    {
+        thread_local EditDistance engine;
+        return engine;
+    }
+}
+
 // Normalize text: lowercase, remove punctuation, trim whitespace
 std::string LyricsAlignment::normalizeText(const std::string& text)
 {
-    std::string result = text;
-    
-    // Convert to lowercase
-    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-    
-    // Remove punctuation (keep only alphanumeric and spaces)
-    result.erase(std::remove_if(result.begin(), result.end(), 
-        [](char c) { return !std::isalnum(c) && !std::isspace(c); }), result.end());
-    
-    // Remove extra whitespace
-    std::istringstream iss(result);
-    std::string word;
-    std::vector<std::string> words;
-    while (iss >> word)
-        words.push_back(word);
-    
+    std::string result;
+    normalizeTextInto(text, result);
+    return result;
+}
+
+void LyricsAlignment::normalizeTextInto(const std::string& text, std::string& result)
+{
     result.clear();
-    for (size_t i = 0; i < words.size(); ++i)
+    
+    // Lowercase, drop punctuation, single spaces between words, none at the ends
+    bool pendingSpace = false;
+    for (const char c : text)
     {
-        if (i > 0) result += " ";
-        result += words[i];
+        const unsigned char u = (unsigned char)c;
+        if (std::isspace(u))
+        {
+            pendingSpace = !result.empty();
+        }
+        else if (std::isalnum(u))
+        {
+            if (pendingSpace)
+                result += ' ';
+            pendingSpace = false;
+            result += (char)std::tolower(u);
+        }
     }
-    
-    return result;
 }
 
 // Split text into individual words
@@ -174,50 +186,17 @@ std::string LyricsAlignment::urlEncode(const std::string& value)
 }
 
 // Calculate edit distance matrix using dynamic programming
-std::vector<std::vector<int>> LyricsAlignment::calculateEditDistance(
+const EditDistance::Matrix& LyricsAlignment::calculateEditDistance(
     const std::vector<std::string>& seq1,
     const std::vector<std::string>& seq2)
 {
-    int m = seq1.size();
-    int n = seq2.size();
-    
-    // Create matrix (m+1) x (n+1)
-    std::vector<std::vector<int>> matrix(m + 1, std::vector<int>(n + 1, 0));
-    
-    // Initialize first row and column
-    for (int i = 0; i <= m; ++i)
-        matrix[i][0] = i;
-    for (int j = 0; j <= n; ++j)
-        matrix[0][j] = j;
-    
-    // Fill matrix using dynamic programming
-    for (int i = 1; i <= m; ++i)
-    {
-        for (int j = 1; j <= n; ++j)
-        {
-            if (seq1[i-1] == seq2[j-1])
-            {
-                // Words match - no cost
-                matrix[i][j] = matrix[i-1][j-1];
-            }
-            else
-            {
-                // Words differ - take minimum of insert, delete, replace
-                matrix[i][j] = 1 + std::min({
-                    matrix[i-1][j],     // Delete
-                    matrix[i][j-1],     // Insert
-                    matrix[i-1][j-1]    // Replace
-                });
-            }
-        }
-    }
-    
-    return matrix;
+    // Full table only because backtrackAlignment() walks it
+    return scratchEditDistance().wordDistanceMatrix(seq1, seq2);
 }
 
 // Backtrack through edit distance matrix to create aligned segments
 std::vector<WordSegment> LyricsAlignment::backtrackAlignment(
-    const std::vector<std::vector<int>>& matrix,
+    const EditDistance::Matrix& matrix,
     const std::vector<std::string>& transcribedWords,
     const std::vector<std::string>& lyricsWords,
     const std::vector<WordSegment>& originalSegments)
@@ -238,13 +217,13 @@ std::vector<WordSegment> LyricsAlignment::backtrackAlignment(
             alignments.push_back({i-1, j-1});
             i--; j--;
         }
-        else if (i > 0 && j > 0 && matrix[i][j] == matrix[i-1][j-1] + 1)
+        else if (i > 0 && j > 0 && matrix(i, j) == matrix(i-1, j-1) + 1)
         {
             // Replace - align these positions
             alignments.push_back({i-1, j-1});
             i--; j--;
         }
-        else if (j > 0 && matrix[i][j] == matrix[i][j-1] + 1)
+        else if (j > 0 && matrix(i, j) == matrix(i, j-1) + 1)
         {
             // Insert from lyrics - create estimated timing
             alignments.push_back({-1, j-1});
@@ -327,7 +306,7 @@ std::vector<WordSegment> LyricsAlignment::alignLyricsToTranscription(
     }
     
     // Calculate edit distance matrix
-    std::vector<std::vector<int>> matrix = calculateEditDistance(transcribedText, lyricsWords);
+    const EditDistance::Matrix& matrix = calculateEditDistance(transcribedText, lyricsWords);
     
     // Backtrack to create aligned segments
     std::vector<WordSegment> correctedSegments = backtrackAlignment(
@@ -428,28 +407,9 @@ float LyricsAlignment::calculateSimilarity(const std::string& text1, const std::
     if (s1.empty() || s2.empty()) return 0.0f;
     if (s1 == s2) return 1.0f;
     
-    int m = s1.length();
-    int n = s2.length();
-    
-    // Use simple character-level edit distance
-    std::vector<std::vector<int>> dp(m + 1, std::vector<int>(n + 1, 0));
-    
-    for (int i = 0; i <= m; ++i) dp[i][0] = i;
-    for (int j = 0; j <= n; ++j) dp[0][j] = j;
-    
-    for (int i = 1; i <= m; ++i)
-    {
-        for (int j = 1; j <= n; ++j)
-        {
-            if (s1[i-1] == s2[j-1])
-                dp[i][j] = dp[i-1][j-1];
-            else
-                dp[i][j] = 1 + std::min({dp[i-1][j], dp[i][j-1], dp[i-1][j-1]});
-        }
-    }
-    
-    int distance = dp[m][n];
-    int maxLen = std::max(m, n);
+    // Character-level edit distance (bit-parallel for word-sized strings)
+    int distance = scratchEditDistance().characterDistance(s1, s2);
+    int maxLen = (int)std::max(s1.length(), s2.length());
     
     return 1.0f - (float)distance / maxLen;
 }
@@ -458,22 +418,37 @@ void LyricsAlignment::setLyrics(const std::string& lyrics)
 {
     std::cout << "[ForceAlign] Initializing forced alignment (" << lyrics.length() << " chars)" << std::endl;
     
-    preprocessedLyrics.clear();
-    currentPosition = 0;
-    locked = false;
-    consecutiveMatches = 0;
+    setPreprocessedLyrics(preprocessLyrics(lyrics));
+}
+
+std::vector<LyricsWord> LyricsAlignment::preprocessLyrics(const std::string& lyrics)
+{
+    std::vector<LyricsWord> result;
     
     // Tokenize and preprocess
     std::vector<std::string> words = splitIntoWords(lyrics);
+    result.reserve(words.size());
     
     for (size_t i = 0; i < words.size(); ++i)
     {
         std::string word = words[i];
         std::string soundex = soundexEncode(word);
-        preprocessedLyrics.emplace_back(i, word, soundex, false);
+        result.emplace_back((int)i, word, soundex, false);
     }
     
+    return result;
+}
+
+void LyricsAlignment::setPreprocessedLyrics(std::vector<LyricsWord> words)
+{
+    preprocessedLyrics = std::move(words);
+    currentPosition = 0;
+    locked = false;
+    consecutiveMatches = 0;
+    
+    buildSearchIndex();
     initialized = true;
+    ++lyricsVersion;
     
     std::cout << "[ForceAlign] Loaded " << preprocessedLyrics.size() << " words" << std::endl;
     std::cout << "[ForceAlign] Example: \"" << (preprocessedLyrics.empty() ? "" : preprocessedLyrics[0].word) 
@@ -486,59 +461,42 @@ void LyricsAlignment::reset()
     locked = false;
     consecutiveMatches = 0;
     initialized = false;
+    ++lyricsVersion;
     preprocessedLyrics.clear();
+    ngramPositions.clear();
+    soundexPositions.clear();
     std::cout << "[ForceAlign] Reset" << std::endl;
 }
 
-float LyricsAlignment::calculateWeightedEditDistance(
-    const std::vector<WordSegment>& transcribed,
-    const std::vector<std::string>& lyricsSegment)
+void LyricsAlignment::buildSearchIndex()
 {
-    int m = transcribed.size();
-    int n = lyricsSegment.size();
-    
-    if (m == 0) return (float)n;
-    if (n == 0) return (float)m;
+    ngramPositions.clear();
+    soundexPositions.clear();
     
-    // Create weighted distance matrix
-    std::vector<std::vector<float>> dp(m + 1, std::vector<float>(n + 1, 0.0f));
+    const int numWords = (int)preprocessedLyrics.size();
     
-    // Initialize first row and column
-    for (int i = 0; i <= m; ++i)
-        dp[i][0] = (float)i;
-    for (int j = 0; j <= n; ++j)
-        dp[0][j] = (float)j;
-    
-    // Fill matrix with confidence weighting
-    for (int i = 1; i <= m; ++i)
+    // Positions are appended in order, so every list stays sorted
+    for (int i = 0; i < numWords; ++i)
     {
-        for (int j = 1; j <= n; ++j)
+        soundexPositions[preprocessedLyrics[i].soundex].push_back(i);
+        
+        if (i + 1 < numWords)
         {
-            std::string transWord = normalizeText(transcribed[i-1].word);
-            std::string lyricsWord = lyricsSegment[j-1];
-            float confidence = transcribed[i-1].confidence;
+            std::string bigram = preprocessedLyrics[i].word + " " + preprocessedLyrics[i + 1].word;
             
-            if (transWord == lyricsWord)
-            {
-                // Match - no cost
-                dp[i][j] = dp[i-1][j-1];
-            }
-            else
-            {
-                // Mismatch - use confidence to weight the cost
-                // Low confidence words have lower mismatch penalty
-                float mismatchCost = 1.0f + confidence;  // Range: 1.0 to 2.0
-                
-                dp[i][j] = std::min({
-                    dp[i-1][j] + 1.0f,              // Delete
-                    dp[i][j-1] + 1.0f,              // Insert
-                    dp[i-1][j-1] + mismatchCost     // Replace (weighted)
-                });
-            }
+            if (i + 2 < numWords)
+                ngramPositions[bigram + " " + preprocessedLyrics[i + 2].word].push_back(i);
+            
+            ngramPositions[std::move(bigram)].push_back(i);
         }
     }
-    
-    return dp[m][n];
+}
+
+float LyricsAlignment::calculateWeightedEditDistance(
+    const std::string_view* lyricsSegment,
+    int numWords)
+{
+    return scratchEditDistance().weightedWordDistance(alignWords, alignCosts, lyricsSegment, numWords);
 }
 
 LyricsAlignment::AlignmentResult LyricsAlignment::findBestAlignment(
@@ -554,20 +512,35 @@ LyricsAlignment::AlignmentResult LyricsAlignment::findBestAlignment(
     if (transcribedSize == 0 || searchStart >= searchEnd)
         return best;
     
+    // Normalize the transcribed words once per search (every candidate offset compares them)
+    alignWords.resize(transcribed.size());      // Lyrics words fit the strings' inline buffer
+    alignCosts.clear();
+    
+    for (int i = 0; i < transcribedSize; ++i)
+    {
+        normalizeTextInto(transcribed[i].word, alignWords[i]);
+        
+        // Mismatch - use confidence to weight the cost
+        // Low confidence words have lower mismatch penalty
+        alignCosts.push_back(1.0f + (float)transcribed[i].confidence);  // Range: 1.0 to 2.0
+    }
+    
+    // Every word a candidate window can reach, viewed in place
+    const int viewEnd = std::min(searchEnd - 1 + transcribedSize, (int)preprocessedLyrics.size());
+    lyricsViews.clear();
+    for (int i = searchStart; i < viewEnd; ++i)
+        lyricsViews.push_back(preprocessedLyrics[i].word);
+    
     // Try different window positions
     for (int startPos = searchStart; startPos < searchEnd; ++startPos)
     {
-        // Extract lyrics window of same size as transcribed
+        // Lyrics window of same size as transcribed
         int endPos = std::min(startPos + transcribedSize, (int)preprocessedLyrics.size());
         if (endPos - startPos < transcribedSize / 2)
             break;  // Window too small
         
-        std::vector<std::string> lyricsWindow;
-        for (int i = startPos; i < endPos; ++i)
-            lyricsWindow.push_back(preprocessedLyrics[i].word);
-        
         // Calculate weighted edit distance
-        float distance = calculateWeightedEditDistance(transcribed, lyricsWindow);
+        float distance = calculateWeightedEditDistance(lyricsViews.data() + (startPos - searchStart), endPos - startPos);
         
         // Normalize by transcription length
         float normalizedDistance = distance / transcribedSize;
@@ -636,6 +609,52 @@ float LyricsAlignment::verifyWord(
     return textSim;  // Return text similarity even if no match
 }
 
+void LyricsAlignment::advanceTo(int position)
+{
+    position = std::min(position, (int)preprocessedLyrics.size());
+    if (position > currentPosition)
+        currentPosition = position;
+}
+
+float LyricsAlignment::verifyChunk(const std::vector<WordSegment>& transcribedWords)
+{
+    if (!isReady() || transcribedWords.empty() || isNonLyricalContent(transcribedWords))
+        return -1.0f;
+    
+    const int numLyrics = (int)preprocessedLyrics.size();
+    int expected = currentPosition;
+    float total = 0.0f;
+    int scored = 0;
+    std::string method;
+    
+    for (const auto& word : transcribedWords)
+    {
+        WordSegment heard = word;
+        heard.word = normalizeText(word.word);
+        if (heard.word.empty())
+            continue;
+        
+        // Allow the singer one word of slip either way
+        float best = 0.0f;
+        int bestIndex = expected;
+        for (int i = std::max(0, expected - 1); i <= expected + 1 && i < numLyrics; ++i)
+        {
+            float score = verifyWord(heard, preprocessedLyrics[i], method);
+            if (score > best)
+            {
+                best = score;
+                bestIndex = i;
+            }
+        }
+        
+        total += best;
+        ++scored;
+        expected = bestIndex + 1;
+    }
+    
+    return scored > 0 ? total / scored : -1.0f;
+}
+
 // Find best starting position for Whisper chunk in lyrics
 int LyricsAlignment::findBestStartPosition(
     const std::vector<WordSegment>& transcribedWords,
@@ -645,6 +664,12 @@ int LyricsAlignment::findBestStartPosition(
 {
     int bestPosition = -1;
     float bestScore = 0.0f;
+    outScore = 0.0f;
+    
+    searchStart = std::max(0, searchStart);
+    searchEnd = std::min(searchEnd, (int)preprocessedLyrics.size());
+    if (searchStart >= searchEnd)
+        return -1;
     
     // Build transcribed text
     std::string transcribedText;
@@ -652,9 +677,67 @@ int LyricsAlignment::findBestStartPosition(
         transcribedText += word.word + " ";
     transcribedText = normalizeText(transcribedText);
     
-    // Search through lyrics window
-    for (int pos = searchStart; pos < searchEnd && pos < (int)preprocessedLyrics.size(); ++pos)
+    std::vector<std::string> heard = splitIntoWords(transcribedText);
+    if (heard.empty())
+        return -1;
+    
+    // Step 1: Vote - transcribed word i found at lyrics index p suggests start (p - i)
+    std::vector<int> votes(searchEnd - searchStart, 0);
+    
+    auto castVotes = [&](const std::vector<int>& positions, int wordIndex, int weight)
+    {
+        // Only positions whose implied start lands inside [searchStart, searchEnd)
+        auto it = std::lower_bound(positions.begin(), positions.end(), searchStart + wordIndex);
+        for (; it != positions.end() && *it - wordIndex < searchEnd; ++it)
+            votes[*it - wordIndex - searchStart] += weight;
+    };
+    
+    const int numHeard = (int)heard.size();
+    for (int i = 0; i < numHeard; ++i)
+    {
+        auto sx = soundexPositions.find(soundexEncode(heard[i]));
+        if (sx != soundexPositions.end())
+            castVotes(sx->second, i, 1);
+        
+        if (i + 1 < numHeard)
+        {
+            std::string bigram = heard[i] + " " + heard[i + 1];
+            
+            auto bi = ngramPositions.find(bigram);
+            if (bi != ngramPositions.end())
+                castVotes(bi->second, i, 2);
+            
+            if (i + 2 < numHeard)
+            {
+                auto tri = ngramPositions.find(bigram + " " + heard[i + 2]);
+                if (tri != ngramPositions.end())
+                    castVotes(tri->second, i, 3);
+            }
+        }
+    }
+    
+    // Step 2: Keep the most-voted offsets (ties go to the earlier position, as the old linear scan did)
+    std::vector<int> candidates;
+    for (int offset = 0; offset < (int)votes.size(); ++offset)
     {
+        if (votes[offset] > 0)
+            candidates.push_back(offset);
+    }
+    
+    if (candidates.empty())
+        return -1;
+    
+    const size_t numScored = std::min(candidates.size(), (size_t)MAX_SCORED_CANDIDATES);
+    std::partial_sort(candidates.begin(), candidates.begin() + numScored, candidates.end(),
+                      [&votes](int a, int b) { return votes[a] != votes[b] ? votes[a] > votes[b] : a < b; });
+    candidates.resize(numScored);
+    std::sort(candidates.begin(), candidates.end());
+    
+    // Step 3: Exact scoring on the shortlist only
+    for (int offset : candidates)
+    {
+        const int pos = searchStart + offset;
+        
         // Build lyrics window of same size
         std::string lyricsText;
         int endPos = std::min(pos + (int)transcribedWords.size(), (int)preprocessedLyrics.size());
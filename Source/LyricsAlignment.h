@@ -13,10 +13,14 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <unordered_map>
+#include "EditDistance.h"
 
 /**
     Word segment with timing information from Whisper.
@@ -98,6 +102,22 @@ public:
     */
     void setLyrics(const std::string& lyrics);
     
+    /**
+        Initialize alignment with lyrics already run through preprocessLyrics()
+        (e.g. loaded from LyricsCache), skipping tokenization and soundex.
+        
+        @param words        Preprocessed lyrics words
+    */
+    void setPreprocessedLyrics(std::vector<LyricsWord> words);
+    
+    /**
+        Tokenize lyrics and compute the soundex code of every word.
+        
+        @param lyrics       Full song lyrics text
+        @return             Words in lyrics order (index = position)
+    */
+    static std::vector<LyricsWord> preprocessLyrics(const std::string& lyrics);
+    
     /**
         Align a new transcription chunk using forced alignment.
         
@@ -161,6 +181,33 @@ public:
     */
     bool isReady() const { return initialized && !preprocessedLyrics.empty(); }
     
+    /**
+        Changes whenever the lyrics are replaced or reset (song change detection).
+    */
+    uint32_t getLyricsVersion() const { return lyricsVersion; }
+    
+    /**
+        Get the loaded lyrics words (index = position).
+    */
+    const std::vector<LyricsWord>& getLyricsWords() const { return preprocessedLyrics; }
+    
+    /**
+        Move the position forward over words that were not transcribed
+        (windows the lyrics fast path skipped), keeping the lock.
+        
+        @param position     Lyrics index of the next expected word
+    */
+    void advanceTo(int position);
+    
+    /**
+        Score a transcription chunk against the words expected at the current
+        position with verifyWord(), without moving the position.
+        
+        @param transcribedWords     Word segments from Whisper
+        @return                     Mean match score 0.0-1.0, or -1 if there is nothing to verify
+    */
+    float verifyChunk(const std::vector<WordSegment>& transcribedWords);
+    
     /**
         Align lyrics with transcribed word segments (legacy full-song alignment).
         
@@ -184,6 +231,11 @@ public:
     */
     static std::string normalizeText(const std::string& text);
     
+    /**
+        normalizeText() into an existing string (its capacity is reused).
+    */
+    static void normalizeTextInto(const std::string& text, std::string& result);
+    
     /**
         Split text into individual words.
         
@@ -209,6 +261,7 @@ private:
     bool locked = false;                          // Are we confident in sequence?
     int consecutiveMatches = 0;                   // Track match confidence
     bool initialized = false;
+    uint32_t lyricsVersion = 0;                   // Bumped by setPreprocessedLyrics() and reset()
     
     // Configuration thresholds
     const float TEXT_MATCH_THRESHOLD = 0.20f;     // 20% text similarity for match
@@ -217,6 +270,23 @@ private:
     const float CONFIDENCE_GATE = 0.50f;          // Below this, snap to expected
     const int LOCK_REQUIRED_MATCHES = 2;          // Consecutive matches to lock
     const int SEARCH_WINDOW = 50;                 // Words to search when unlocked
+    const int MAX_SCORED_CANDIDATES = 4;          // Voted offsets given the full similarity DP
+    
+    // Inverted index over preprocessedLyrics (rebuilt by setPreprocessedLyrics)
+    // Position lists are ascending word indices
+    std::unordered_map<std::string, std::vector<int>> ngramPositions;    // "w1 w2" / "w1 w2 w3" -> index of w1
+    std::unordered_map<std::string, std::vector<int>> soundexPositions;  // Soundex code -> word indices
+    
+    // findBestAlignment() scratch: the transcribed words normalized once per search,
+    // the lyrics viewed in place (capacity kept between searches)
+    std::vector<std::string> alignWords;
+    std::vector<float> alignCosts;
+    std::vector<std::string_view> lyricsViews;
+    
+    /**
+        Index word bigrams, trigrams and soundex codes of preprocessedLyrics.
+    */
+    void buildSearchIndex();
     
     /**
         Verify if Whisper token matches expected lyrics word.
@@ -237,6 +307,10 @@ private:
         Find best starting position in lyrics for Whisper chunk.
         Used for initial lock or when sequence is lost.
         
+        Transcribed n-grams and soundex codes vote for candidate offsets via
+        the inverted index; only the top MAX_SCORED_CANDIDATES are scored with
+        calculateSimilarity(), so the cost does not grow with song length.
+        
         @param transcribedWords     Whisper words
         @param searchStart          Start of search range
         @param searchEnd            End of search range
@@ -287,15 +361,16 @@ private:
     );
     
     /**
-        Calculate confidence-weighted edit distance.
+        Calculate confidence-weighted edit distance between the transcribed
+        words prepared in alignWords/alignCosts and a lyrics segment.
         
-        @param transcribed      Transcribed words with confidence scores
-        @param lyricsSegment    Segment of lyrics words
+        @param lyricsSegment    First word of the segment (views of preprocessedLyrics)
+        @param numWords         Words in the segment
         @return                 Weighted edit distance
     */
     float calculateWeightedEditDistance(
-        const std::vector<WordSegment>& transcribed,
-        const std::vector<std::string>& lyricsSegment
+        const std::string_view* lyricsSegment,
+        int numWords
     );
     
     /**
@@ -303,9 +378,9 @@ private:
         
         @param seq1     First sequence
         @param seq2     Second sequence
-        @return         2D edit distance matrix
+        @return         Edit distance matrix (thread-local scratch, valid until the next call)
     */
-    static std::vector<std::vector<int>> calculateEditDistance(
+    static const EditDistance::Matrix& calculateEditDistance(
         const std::vector<std::string>& seq1,
         const std::vector<std::string>& seq2
     );
@@ -320,7 +395,7 @@ private:
         @return                     Aligned word segments with corrected text
     */
     static std::vector<WordSegment> backtrackAlignment(
-        const std::vector<std::vector<int>>& matrix,
+        const EditDistance::Matrix& matrix,
         const std::vector<std::string>& seq1,
         const std::vector<std::string>& seq2,
         const std::vector<WordSegment>& transcribedWords
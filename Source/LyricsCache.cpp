@@ -0,0 +1,715 @@
+/*
+  ==============================================================================
+
+    LyricsCache.cpp
+    Created: 20 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Implementation of the persistent lyrics cache.
+
+    File formats (little-endian, native layout):
+
+    lyrics.idx  IndexHeader, then slotCount x IndexSlot
+                Linear probing, keyHash == 0 marks an empty slot.
+                Grown (doubled and rebuilt from the store) above 70% load.
+
+    lyrics.dat  StoreHeader, then records:
+                uint32 payloadSize, uint32 type, payload
+                RECORD_LYRICS:      artist, title, lyrics, uint32 n, n x (word, soundex)
+                RECORD_FINGERPRINT: fingerprint, artist, title
+                Strings are uint32 length + bytes. A later record for the same
+                key supersedes an earlier one.
+
+  ==============================================================================
+*/
+
+#include "LyricsCache.h"
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+
+namespace
+{
+    constexpr juce::uint32 INDEX_MAGIC = 0x5849594C;   // "LYIX"
+    constexpr juce::uint32 STORE_MAGIC = 0x4452594C;   // "LYRD"
+    constexpr juce::uint32 FORMAT_VERSION = 1;
+    constexpr int INITIAL_SLOTS = 1024;
+    constexpr double MAX_LOAD_FACTOR = 0.7;
+    
+    constexpr juce::uint32 RECORD_LYRICS = 1;
+    constexpr juce::uint32 RECORD_FINGERPRINT = 2;
+    
+    struct IndexHeader
+    {
+        juce::uint32 magic;
+        juce::uint32 version;
+        juce::uint32 slotCount;
+        juce::uint32 usedSlots;
+    };
+    
+    struct IndexSlot
+    {
+        juce::uint64 keyHash;
+        juce::int64 offset;
+    };
+    
+    struct StoreHeader
+    {
+        juce::uint32 magic;
+        juce::uint32 version;
+    };
+    
+    void appendU32(std::string& out, juce::uint32 value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    
+    void appendString(std::string& out, const std::string& value)
+    {
+        appendU32(out, (juce::uint32)value.size());
+        out.append(value);
+    }
+    
+    /** Bounds-checked reader over a mapped record. */
+    struct RecordReader
+    {
+        const char* data;
+        size_t size;
+        size_t pos = 0;
+        
+        bool readU32(juce::uint32& value)
+        {
+            if (size - pos < sizeof(value))
+                return false;
+            
+            std::memcpy(&value, data + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        }
+        
+        bool readString(std::string& value)
+        {
+            juce::uint32 length = 0;
+            if (!readU32(length) || size - pos < length)
+                return false;
+            
+            value.assign(data + pos, length);
+            pos += length;
+            return true;
+        }
+    };
+}
+
+LyricsCache::~LyricsCache()
+{
+    close();
+}
+
+juce::File LyricsCache::getDefaultDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("ExplicitlyDesktop")
+               .getChildFile("LyricsCache");
+}
+
+bool LyricsCache::open(const juce::File& directory)
+{
+    close();
+    
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        
+        if (!directory.isDirectory() && directory.createDirectory().failed())
+        {
+            std::cerr << "[LyricsCache] Cannot create " << directory.getFullPathName() << std::endl;
+            return false;
+        }
+        
+        indexFile = directory.getChildFile("lyrics.idx");
+        storeFile = directory.getChildFile("lyrics.dat");
+        
+        // A store with a foreign header is discarded (index is rebuilt below)
+        bool storeValid = false;
+        if (storeFile.getSize() >= (juce::int64)sizeof(StoreHeader))
+        {
+            juce::MemoryMappedFile probe(storeFile, juce::MemoryMappedFile::readOnly);
+            if (probe.getData() != nullptr)
+            {
+                StoreHeader header;
+                std::memcpy(&header, probe.getData(), sizeof(header));
+                storeValid = header.magic == STORE_MAGIC && header.version == FORMAT_VERSION;
+            }
+        }
+        
+        if (!storeValid)
+        {
+            const StoreHeader header { STORE_MAGIC, FORMAT_VERSION };
+            if (!storeFile.replaceWithData(&header, sizeof(header)))
+            {
+                std::cerr << "[LyricsCache] Cannot write " << storeFile.getFullPathName() << std::endl;
+                return false;
+            }
+            indexFile.deleteFile();
+        }
+        
+        if (!mapFiles())
+        {
+            std::cout << "[LyricsCache] Index missing or invalid, rebuilding..." << std::endl;
+            
+            if (!createIndex(INITIAL_SLOTS) || !rebuildIndex())
+            {
+                std::cerr << "[LyricsCache] Failed to build index" << std::endl;
+                indexMap.reset();
+                storeMap.reset();
+                return false;
+            }
+        }
+        
+        std::cout << "[LyricsCache] Opened " << directory.getFullPathName() << " ("
+                  << numEntries.load() << " songs, "
+                  << (storeFile.getSize() / 1024) << " KB)" << std::endl;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopPrefetch = false;
+    }
+    prefetchThread = std::thread(&LyricsCache::prefetchThreadFunction, this);
+    
+    return true;
+}
+
+void LyricsCache::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopPrefetch = true;
+        jobs.clear();
+    }
+    jobCV.notify_all();
+    
+    if (prefetchThread.joinable())
+        prefetchThread.join();
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    indexMap.reset();
+    storeMap.reset();
+}
+
+//==============================================================================
+// Keys
+
+std::string LyricsCache::makeTitleKey(const std::string& artist, const std::string& title)
+{
+    return LyricsAlignment::normalizeText(artist) + "\n" + LyricsAlignment::normalizeText(title);
+}
+
+juce::uint64 LyricsCache::hashKey(const std::string& prefix, const std::string& key)
+{
+    // FNV-1a 64-bit; 0 is reserved for empty slots
+    juce::uint64 hash = 14695981039346656037ULL;
+    
+    for (const std::string* part : { &prefix, &key })
+    {
+        for (unsigned char c : *part)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+    }
+    
+    return hash == 0 ? 1 : hash;
+}
+
+//==============================================================================
+// Index (caller holds cacheMutex)
+
+bool LyricsCache::createIndex(int slotCount)
+{
+    indexMap.reset();
+    
+    const size_t bytes = sizeof(IndexHeader) + (size_t)slotCount * sizeof(IndexSlot);
+    std::vector<char> blank(bytes, 0);
+    
+    const IndexHeader header { INDEX_MAGIC, FORMAT_VERSION, (juce::uint32)slotCount, 0 };
+    std::memcpy(blank.data(), &header, sizeof(header));
+    
+    if (!indexFile.replaceWithData(blank.data(), blank.size()))
+        return false;
+    
+    indexMap = std::make_unique<juce::MemoryMappedFile>(indexFile, juce::MemoryMappedFile::readWrite);
+    return indexMap->getData() != nullptr && indexMap->getSize() == bytes;
+}
+
+bool LyricsCache::mapFiles()
+{
+    storeMap = std::make_unique<juce::MemoryMappedFile>(storeFile, juce::MemoryMappedFile::readOnly);
+    if (storeMap->getData() == nullptr)
+        return false;
+    
+    if (!indexFile.existsAsFile())
+        return false;
+    
+    indexMap = std::make_unique<juce::MemoryMappedFile>(indexFile, juce::MemoryMappedFile::readWrite);
+    if (indexMap->getData() == nullptr || indexMap->getSize() < sizeof(IndexHeader))
+        return false;
+    
+    IndexHeader header;
+    std::memcpy(&header, indexMap->getData(), sizeof(header));
+    
+    if (header.magic != INDEX_MAGIC || header.version != FORMAT_VERSION || header.slotCount == 0
+        || indexMap->getSize() != sizeof(IndexHeader) + (size_t)header.slotCount * sizeof(IndexSlot))
+        return false;
+    
+    // Entry count is diagnostic only: peek at the type of every indexed record
+    int entries = 0;
+    const auto* slots = reinterpret_cast<const IndexSlot*>(static_cast<const char*>(indexMap->getData()) + sizeof(IndexHeader));
+    const auto* store = static_cast<const char*>(storeMap->getData());
+    for (juce::uint32 i = 0; i < header.slotCount; ++i)
+    {
+        if (slots[i].keyHash == 0)
+            continue;
+        
+        // An offset past the end means the store was replaced under the index
+        if (slots[i].offset < (juce::int64)sizeof(StoreHeader) || (size_t)slots[i].offset + 8 > storeMap->getSize())
+            return false;
+        
+        juce::uint32 type = 0;
+        std::memcpy(&type, store + slots[i].offset + 4, sizeof(type));
+        if (type == RECORD_LYRICS)
+            ++entries;
+    }
+    numEntries.store(entries);
+    
+    return true;
+}
+
+bool LyricsCache::rebuildIndex()
+{
+    if (storeMap == nullptr || storeMap->getData() == nullptr)
+        return false;
+    
+    int entries = 0;
+    juce::int64 offset = sizeof(StoreHeader);
+    const juce::int64 storeSize = (juce::int64)storeMap->getSize();
+    
+    while (offset < storeSize)
+    {
+        Entry entry;
+        std::string fingerprint;
+        juce::int64 next = 0;
+        const int type = readRecord(offset, entry, &fingerprint, &next);
+        
+        if (type == (int)RECORD_LYRICS)
+        {
+            insertOrGrow(hashKey("t:", makeTitleKey(entry.artist, entry.title)), offset);
+            ++entries;
+        }
+        else if (type == (int)RECORD_FINGERPRINT)
+        {
+            insertOrGrow(hashKey("f:", fingerprint), offset);
+        }
+        else
+        {
+            break;
+        }
+        
+        offset = next;
+    }
+    
+    // Torn write at the tail (crash mid-append): drop it so new records stay reachable
+    if (offset < storeSize)
+    {
+        std::cout << "[LyricsCache] Truncating " << (storeSize - offset) << " corrupt bytes" << std::endl;
+        
+        storeMap.reset();
+        if (auto stream = storeFile.createOutputStream())
+        {
+            stream->setPosition(offset);
+            stream->truncate();
+        }
+        storeMap = std::make_unique<juce::MemoryMappedFile>(storeFile, juce::MemoryMappedFile::readOnly);
+    }
+    
+    numEntries.store(entries);
+    return true;
+}
+
+juce::int64 LyricsCache::findOffset(juce::uint64 keyHash) const
+{
+    if (indexMap == nullptr || indexMap->getData() == nullptr)
+        return -1;
+    
+    const auto* base = static_cast<const char*>(indexMap->getData());
+    const auto* header = reinterpret_cast<const IndexHeader*>(base);
+    const auto* slots = reinterpret_cast<const IndexSlot*>(base + sizeof(IndexHeader));
+    
+    for (juce::uint32 probe = 0, i = (juce::uint32)(keyHash % header->slotCount);
+         probe < header->slotCount;
+         ++probe, i = (i + 1) % header->slotCount)
+    {
+        if (slots[i].keyHash == 0)
+            return -1;
+        if (slots[i].keyHash == keyHash)
+            return slots[i].offset;
+    }
+    
+    return -1;
+}
+
+bool LyricsCache::insertSlot(juce::uint64 keyHash, juce::int64 offset)
+{
+    auto* base = static_cast<char*>(indexMap->getData());
+    auto* header = reinterpret_cast<IndexHeader*>(base);
+    auto* slots = reinterpret_cast<IndexSlot*>(base + sizeof(IndexHeader));
+    
+    for (juce::uint32 probe = 0, i = (juce::uint32)(keyHash % header->slotCount);
+         probe < header->slotCount;
+         ++probe, i = (i + 1) % header->slotCount)
+    {
+        if (slots[i].keyHash == keyHash)
+        {
+            slots[i].offset = offset;   // Newer record supersedes
+            return true;
+        }
+        
+        if (slots[i].keyHash == 0)
+        {
+            if (header->usedSlots + 1 > (juce::uint32)(header->slotCount * MAX_LOAD_FACTOR))
+                return false;
+            
+            slots[i].offset = offset;
+            slots[i].keyHash = keyHash;
+            ++header->usedSlots;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void LyricsCache::insertOrGrow(juce::uint64 keyHash, juce::int64 offset)
+{
+    if (insertSlot(keyHash, offset))
+        return;
+    
+    // Full: double the table and re-index the whole store (superseded records drop out)
+    const auto* header = static_cast<const IndexHeader*>(indexMap->getData());
+    const int newSlots = (int)header->slotCount * 2;
+    
+    std::cout << "[LyricsCache] Growing index to " << newSlots << " slots" << std::endl;
+    
+    if (createIndex(newSlots) && rebuildIndex())
+        insertSlot(keyHash, offset);
+}
+
+//==============================================================================
+// Store (caller holds cacheMutex)
+
+juce::int64 LyricsCache::appendRecord(const std::string& record)
+{
+    // Unmap while appending (Windows cannot extend a file with an open view)
+    storeMap.reset();
+    
+    const juce::int64 offset = storeFile.getSize();
+    const bool ok = storeFile.appendData(record.data(), record.size());
+    
+    storeMap = std::make_unique<juce::MemoryMappedFile>(storeFile, juce::MemoryMappedFile::readOnly);
+    
+    return ok ? offset : -1;
+}
+
+int LyricsCache::readRecord(juce::int64 offset, Entry& entry, std::string* fingerprint, juce::int64* nextOffset) const
+{
+    if (storeMap == nullptr || storeMap->getData() == nullptr || offset < (juce::int64)sizeof(StoreHeader))
+        return 0;
+    
+    const size_t storeSize = storeMap->getSize();
+    if ((size_t)offset + 8 > storeSize)
+        return 0;
+    
+    const char* base = static_cast<const char*>(storeMap->getData()) + offset;
+    
+    juce::uint32 payloadSize = 0, type = 0;
+    std::memcpy(&payloadSize, base, sizeof(payloadSize));
+    std::memcpy(&type, base + 4, sizeof(type));
+    
+    if (payloadSize > storeSize - (size_t)offset - 8)
+        return 0;
+    
+    RecordReader reader { base + 8, payloadSize };
+    
+    if (type == RECORD_LYRICS)
+    {
+        juce::uint32 numWords = 0;
+        if (!reader.readString(entry.artist) || !reader.readString(entry.title)
+            || !reader.readString(entry.lyrics) || !reader.readU32(numWords))
+            return 0;
+        
+        entry.words.clear();
+        entry.words.reserve(juce::jmin((size_t)numWords, (size_t)payloadSize / 8));
+        
+        for (juce::uint32 i = 0; i < numWords; ++i)
+        {
+            std::string word, soundex;
+            if (!reader.readString(word) || !reader.readString(soundex))
+                return 0;
+            
+            entry.words.emplace_back((int)i, word, soundex, false);
+        }
+    }
+    else if (type == RECORD_FINGERPRINT)
+    {
+        std::string print;
+        if (!reader.readString(print) || !reader.readString(entry.artist) || !reader.readString(entry.title))
+            return 0;
+        
+        if (fingerprint != nullptr)
+            *fingerprint = std::move(print);
+    }
+    else
+    {
+        return 0;
+    }
+    
+    if (nextOffset != nullptr)
+        *nextOffset = offset + 8 + payloadSize;
+    
+    return (int)type;
+}
+
+//==============================================================================
+// Lookups
+
+std::optional<LyricsCache::Entry> LyricsCache::findByTitleLocked(const std::string& artist, const std::string& title) const
+{
+    const std::string key = makeTitleKey(artist, title);
+    const juce::int64 offset = findOffset(hashKey("t:", key));
+    if (offset < 0)
+        return std::nullopt;
+    
+    Entry entry;
+    if (readRecord(offset, entry, nullptr) != (int)RECORD_LYRICS)
+        return std::nullopt;
+    
+    // 64-bit hash collision guard
+    if (makeTitleKey(entry.artist, entry.title) != key)
+        return std::nullopt;
+    
+    return entry;
+}
+
+std::optional<LyricsCache::Entry> LyricsCache::findByTitle(const std::string& artist, const std::string& title)
+{
+    if (artist.empty() || title.empty())
+        return std::nullopt;
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return findByTitleLocked(artist, title);
+}
+
+std::optional<LyricsCache::Entry> LyricsCache::findByFingerprint(const std::string& fingerprint)
+{
+    if (fingerprint.empty())
+        return std::nullopt;
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    const juce::int64 offset = findOffset(hashKey("f:", fingerprint));
+    if (offset < 0)
+        return std::nullopt;
+    
+    Entry song;
+    std::string storedPrint;
+    if (readRecord(offset, song, &storedPrint) != (int)RECORD_FINGERPRINT || storedPrint != fingerprint)
+        return std::nullopt;
+    
+    if (auto withLyrics = findByTitleLocked(song.artist, song.title))
+        return withLyrics;
+    
+    return song;
+}
+
+//==============================================================================
+// Writes
+
+LyricsCache::Entry LyricsCache::store(const std::string& artist, const std::string& title, const std::string& lyrics)
+{
+    Entry entry;
+    entry.artist = artist;
+    entry.title = title;
+    entry.lyrics = lyrics;
+    entry.words = LyricsAlignment::preprocessLyrics(lyrics);   // Outside the lock
+    
+    std::string payload;
+    appendString(payload, artist);
+    appendString(payload, title);
+    appendString(payload, lyrics);
+    appendU32(payload, (juce::uint32)entry.words.size());
+    for (const auto& word : entry.words)
+    {
+        appendString(payload, word.word);
+        appendString(payload, word.soundex);
+    }
+    
+    std::string record;
+    appendU32(record, (juce::uint32)payload.size());
+    appendU32(record, RECORD_LYRICS);
+    record += payload;
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    if (indexMap == nullptr)
+        return entry;   // Not opened: still usable as an in-memory result
+    
+    const bool isNew = !findByTitleLocked(artist, title).has_value();
+    const juce::int64 offset = appendRecord(record);
+    
+    if (offset >= 0)
+    {
+        // Counted first: a grow re-derives the count from the store
+        if (isNew)
+            ++numEntries;
+        insertOrGrow(hashKey("t:", makeTitleKey(artist, title)), offset);
+        
+        std::cout << "[LyricsCache] Stored \"" << title << "\" by " << artist
+                  << " (" << entry.words.size() << " words)" << std::endl;
+    }
+    
+    return entry;
+}
+
+void LyricsCache::storeFingerprint(const std::string& fingerprint, const std::string& artist, const std::string& title)
+{
+    if (fingerprint.empty() || artist.empty() || title.empty())
+        return;
+    
+    std::string payload;
+    appendString(payload, fingerprint);
+    appendString(payload, artist);
+    appendString(payload, title);
+    
+    std::string record;
+    appendU32(record, (juce::uint32)payload.size());
+    appendU32(record, RECORD_FINGERPRINT);
+    record += payload;
+    
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    
+    if (indexMap == nullptr)
+        return;
+    
+    const juce::int64 offset = appendRecord(record);
+    if (offset >= 0)
+        insertOrGrow(hashKey("f:", fingerprint), offset);
+}
+
+//==============================================================================
+// Fetching
+
+LyricsCache::Entry LyricsCache::fetchOrLoad(const std::string& artist, const std::string& title)
+{
+    if (auto cached = findByTitle(artist, title))
+    {
+        std::cout << "[LyricsCache] Hit: \"" << title << "\" by " << artist << std::endl;
+        return *cached;
+    }
+    
+    std::cout << "[LyricsCache] Miss: fetching \"" << title << "\" by " << artist << std::endl;
+    
+    SongInfo fetched = LyricsAlignment::fetchLyrics(artist, title);
+    
+    if (fetched.lyrics.empty())
+    {
+        Entry missing;
+        missing.artist = artist;
+        missing.title = title;
+        return missing;
+    }
+    
+    // Keyed by the requested names - that is what the next lookup will use
+    return store(artist, title, fetched.lyrics);
+}
+
+void LyricsCache::prefetch(const std::string& artist, const std::string& title)
+{
+    if (artist.empty() || title.empty() || findByTitle(artist, title))
+        return;
+    
+    requestAsync(artist, title, nullptr);
+}
+
+void LyricsCache::requestAsync(const std::string& artist, const std::string& title, EntryCallback onReady)
+{
+    if (auto cached = findByTitle(artist, title))
+    {
+        if (onReady)
+            onReady(*cached);
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        
+        if (stopPrefetch || !prefetchThread.joinable())
+        {
+            // Not opened: nothing to run the job on
+            if (onReady)
+            {
+                Entry missing;
+                missing.artist = artist;
+                missing.title = title;
+                onReady(missing);
+            }
+            return;
+        }
+        
+        const std::string key = makeTitleKey(artist, title);
+        for (auto& job : jobs)
+        {
+            if (makeTitleKey(job.artist, job.title) == key)
+            {
+                // Already queued (e.g. by prefetch): attach the callback
+                if (onReady)
+                {
+                    auto previous = std::move(job.callback);
+                    job.callback = [previous, onReady](const Entry& entry)
+                    {
+                        if (previous)
+                            previous(entry);
+                        onReady(entry);
+                    };
+                }
+                return;
+            }
+        }
+        
+        jobs.push_back({ artist, title, std::move(onReady) });
+    }
+    
+    jobCV.notify_one();
+}
+
+void LyricsCache::prefetchThreadFunction()
+{
+    while (true)
+    {
+        PrefetchJob job;
+        
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobCV.wait(lock, [this] { return stopPrefetch || !jobs.empty(); });
+            
+            if (stopPrefetch)
+                return;
+            
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        
+        Entry entry = fetchOrLoad(job.artist, job.title);
+        
+        if (job.callback)
+            job.callback(entry);
+    }
+}
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    LyricsCache.h
+    Created: 20 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Persistent on-disk lyrics cache with background prefetch.
+
+    Playlists repeat heavily, so every lyrics fetch (and the preprocess /
+    soundex pass in LyricsAlignment::setLyrics) is stored once and reused:
+    - lyrics.idx: memory-mapped open-addressing hash table (key hash -> offset)
+    - lyrics.dat: append-only record store (raw lyrics + preprocessed words)
+
+    Keys are the normalized "artist / title" pair and the AcoustID
+    fingerprint (an alias record pointing back at the artist/title).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include "LyricsAlignment.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+    Lyrics + preprocessed alignment words, cached on disk.
+    
+    Thread Safety:
+    - All public methods are thread-safe (internal mutex); none are real-time safe
+    - Network fetches run on the cache's own prefetch thread (requestAsync/prefetch)
+      or on the caller's thread (fetchOrLoad) - never inside the mutex
+*/
+class LyricsCache
+{
+public:
+    struct Entry
+    {
+        std::string artist;
+        std::string title;
+        std::string lyrics;
+        std::vector<LyricsWord> words;   // Output of LyricsAlignment::preprocessLyrics()
+        
+        bool hasLyrics() const { return !lyrics.empty(); }
+    };
+    
+    using EntryCallback = std::function<void(const Entry&)>;
+    
+    LyricsCache() = default;
+    ~LyricsCache();
+    
+    /**
+        Open (or create) the cache files in a directory and start the prefetch thread.
+        
+        @param directory    Cache directory (created if missing)
+        @return             true if the cache is usable
+    */
+    bool open(const juce::File& directory);
+    
+    /**
+        Default location: <user app data>/ExplicitlyDesktop/LyricsCache
+    */
+    static juce::File getDefaultDirectory();
+    
+    /**
+        Stop the prefetch thread and unmap the files.
+    */
+    void close();
+    
+    /**
+        Look up lyrics by artist/title (normalized - case and punctuation ignored).
+        
+        @return     Cached entry, or nullopt on a miss
+    */
+    std::optional<Entry> findByTitle(const std::string& artist, const std::string& title);
+    
+    /**
+        Look up a song by AcoustID fingerprint.
+        
+        @return     Entry with artist/title (lyrics too if cached), or nullopt on a miss
+    */
+    std::optional<Entry> findByFingerprint(const std::string& fingerprint);
+    
+    /**
+        Preprocess and persist lyrics for a song.
+        
+        @return     The stored entry (words filled in)
+    */
+    Entry store(const std::string& artist, const std::string& title, const std::string& lyrics);
+    
+    /**
+        Remember which song a fingerprint identified (skips AcoustID next time).
+    */
+    void storeFingerprint(const std::string& fingerprint, const std::string& artist, const std::string& title);
+    
+    /**
+        Return cached lyrics, or fetch from the network and cache them (blocking).
+        
+        @return     Entry (hasLyrics() == false if the fetch failed)
+    */
+    Entry fetchOrLoad(const std::string& artist, const std::string& title);
+    
+    /**
+        Fetch in the background if not cached (e.g. on track change).
+    */
+    void prefetch(const std::string& artist, const std::string& title);
+    
+    /**
+        Resolve lyrics on the prefetch thread and call back with the result.
+        
+        A cache hit calls back immediately on the calling thread.
+        
+        @param onReady  Called with the entry (hasLyrics() == false if unavailable)
+    */
+    void requestAsync(const std::string& artist, const std::string& title, EntryCallback onReady);
+    
+    /**
+        Number of songs with cached lyrics (diagnostics).
+    */
+    int getNumEntries() const { return numEntries.load(); }
+
+private:
+    struct PrefetchJob
+    {
+        std::string artist;
+        std::string title;
+        EntryCallback callback;
+    };
+    
+    static std::string makeTitleKey(const std::string& artist, const std::string& title);
+    static juce::uint64 hashKey(const std::string& prefix, const std::string& key);
+    
+    // All of the following require cacheMutex
+    bool createIndex(int slotCount);
+    bool mapFiles();
+    bool rebuildIndex();
+    juce::int64 findOffset(juce::uint64 keyHash) const;
+    bool insertSlot(juce::uint64 keyHash, juce::int64 offset);
+    void insertOrGrow(juce::uint64 keyHash, juce::int64 offset);
+    juce::int64 appendRecord(const std::string& record);
+    int readRecord(juce::int64 offset, Entry& entry, std::string* fingerprint, juce::int64* nextOffset = nullptr) const;
+    std::optional<Entry> findByTitleLocked(const std::string& artist, const std::string& title) const;
+    
+    void prefetchThreadFunction();
+    
+    juce::File indexFile;
+    juce::File storeFile;
+    std::unique_ptr<juce::MemoryMappedFile> indexMap;   // Read-write hash table
+    std::unique_ptr<juce::MemoryMappedFile> storeMap;   // Read-only view of the record store
+    mutable std::mutex cacheMutex;
+    std::atomic<int> numEntries {0};
+    
+    // Background fetches (one at a time, de-duplicated by title key)
+    std::thread prefetchThread;
+    std::mutex jobMutex;
+    std::condition_variable jobCV;
+    std::deque<PrefetchJob> jobs;
+    bool stopPrefetch = false;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LyricsCache)
+};
@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    LyricsFastPath.cpp
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Lyrics-locked fast path implementation.
+
+  ==============================================================================
+*/
+
+#include "LyricsFastPath.h"
+#include "ProfanityMatcher.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double MIN_WORDS_PER_SECOND = 0.5;
+    constexpr double MAX_WORDS_PER_SECOND = 8.0;
+    constexpr double RATE_SMOOTHING = 0.3;          // Weight of the newest window's tempo
+    constexpr double TEMPO_ERROR = 0.1;             // Assumed drift per second predicted ahead
+}
+
+//==============================================================================
+LyricsFastPath::Decision LyricsFastPath::planWindow(const LyricsAlignment& alignment,
+                                                    int64_t windowStartSample, int64_t windowEndSample)
+{
+    if (engaged && alignment.getLyricsVersion() != lyricsVersion)
+        disengage("lyrics changed");
+    else if (engaged && !alignment.isLocked())
+        disengage("alignment lost its lock");
+    
+    if (!options.enabled || !engaged)
+    {
+        lastDecodedEnd = windowEndSample;
+        return Decision::Full;
+    }
+    
+    // A predicted hit in (or near) the window: decode it as usual, its real timing wins
+    const int64_t margin = (int64_t)(options.hitMarginSeconds * sampleRate);
+    for (const auto& hit : lyricsHits)
+    {
+        if (hit.lastWord < anchorIndex)
+            continue;
+        
+        const int64_t start = predictWordStart(hit.firstWord);
+        if (start > windowEndSample + margin)
+            break;
+        
+        if (predictWordStart(hit.lastWord + 1) >= windowStartSample - margin)
+        {
+            lastDecodedEnd = windowEndSample;
+            ++windowsVerified;
+            return Decision::VerifyHit;
+        }
+    }
+    
+    // Heartbeat: keeps the anchor fresh and verifyWord honest
+    if ((double)(windowEndSample - lastDecodedEnd) >= options.verifyIntervalSeconds * sampleRate)
+    {
+        lastDecodedEnd = windowEndSample;
+        ++windowsVerified;
+        return Decision::Verify;
+    }
+    
+    ++windowsSkipped;
+    return Decision::Skip;
+}
+
+void LyricsFastPath::collectDueHits(int64_t untilSample, std::vector<PredictedHit>& hits)
+{
+    hits.clear();
+    if (!engaged)
+        return;
+    
+    while (nextHit < lyricsHits.size())
+    {
+        const LyricsHit& hit = lyricsHits[nextHit];
+        
+        // Already sung and decoded: the regular detection path had it
+        if (hit.firstWord < anchorIndex)
+        {
+            ++nextHit;
+            continue;
+        }
+        
+        const int64_t start = predictWordStart(hit.firstWord);
+        if (start >= untilSample)
+            break;
+        
+        PredictedHit predicted;
+        predicted.entry = hit.entry;
+        predicted.startSample = start;
+        predicted.endSample = std::max(start + 1, predictWordStart(hit.lastWord + 1));
+        predicted.uncertaintySeconds = std::min(options.maxUncertaintySeconds,
+                                                TEMPO_ERROR * (double)std::max<int64_t>(0, start - anchorSample) / sampleRate);
+        hits.push_back(predicted);
+        
+        ++hitsScheduled;
+        ++nextHit;
+    }
+}
+
+int LyricsFastPath::predictPosition(int64_t sample) const
+{
+    if (!engaged)
+        return -1;
+    
+    const double seconds = (double)(sample - anchorSample) / sampleRate;
+    return anchorIndex + std::max(0, (int)std::floor(seconds * wordsPerSecond));
+}
+
+int64_t LyricsFastPath::predictWordStart(int index) const
+{
+    return anchorSample + (int64_t)std::llround((double)(index - anchorIndex) / wordsPerSecond * sampleRate);
+}
+
+//==============================================================================
+void LyricsFastPath::observeWindow(const LyricsAlignment& alignment, const ProfanityMatcher& matcher,
+                                   const std::vector<WordSegment>& alignedWords, int64_t windowStartSample,
+                                   float verifyScore)
+{
+    if (!options.enabled)
+        return;
+    
+    if (alignment.getLyricsVersion() != lyricsVersion)
+    {
+        reset();
+        lyricsVersion = alignment.getLyricsVersion();
+        if (alignment.isReady())
+            rebuildHits(alignment, matcher);
+    }
+    
+    if (!alignment.isLocked())
+    {
+        if (engaged)
+            disengage("alignment lost its lock");
+        lockedWindows = 0;
+        return;
+    }
+    
+    // Nothing heard (instrumental, or the words were predicted): neither a hit nor a miss
+    if (verifyScore < 0.0f || alignedWords.empty())
+        return;
+    
+    if (verifyScore < options.minVerifyScore)
+    {
+        lockedWindows = 0;
+        if (++verifyMisses >= options.maxVerifyMisses && engaged)
+            disengage("verifyWord scores dropped");
+        return;
+    }
+    verifyMisses = 0;
+    
+    // Tempo from word onsets (onset to onset, so word length does not bias it)
+    const WordSegment& first = alignedWords.front();
+    const WordSegment& last = alignedWords.back();
+    const double span = last.start - first.start;
+    if (alignedWords.size() >= 2 && span > 0.2)
+    {
+        const double rate = std::clamp((double)(alignedWords.size() - 1) / span, MIN_WORDS_PER_SECOND, MAX_WORDS_PER_SECOND);
+        wordsPerSecond = wordsPerSecond > 0.0 ? (1.0 - RATE_SMOOTHING) * wordsPerSecond + RATE_SMOOTHING * rate : rate;
+    }
+    
+    if (wordsPerSecond <= 0.0)
+        return;
+    
+    // Re-anchor: the word after the last aligned one starts one beat after its onset
+    anchorIndex = alignment.getCurrentPosition();
+    anchorSample = windowStartSample + (int64_t)((last.start + 1.0 / wordsPerSecond) * sampleRate);
+    
+    if (!engaged && ++lockedWindows >= options.engageAfterWindows)
+    {
+        engaged = true;
+        lastTransition = "lyrics locked and verified";
+        
+        // Hits before the anchor went through the regular detection path
+        nextHit = 0;
+        while (nextHit < lyricsHits.size() && lyricsHits[nextHit].firstWord < anchorIndex)
+            ++nextHit;
+    }
+}
+
+void LyricsFastPath::disengage(const char* reason)
+{
+    // Events already scheduled stay: recall first, like the decode path
+    engaged = false;
+    lockedWindows = 0;
+    verifyMisses = 0;
+    lastTransition = reason;
+}
+
+void LyricsFastPath::reset()
+{
+    if (engaged)
+        disengage("song changed");
+    
+    lyricsHits.clear();
+    lyricsVersion = 0;
+    nextHit = 0;
+    anchorIndex = 0;
+    anchorSample = 0;
+    wordsPerSecond = 0.0;
+    lockedWindows = 0;
+    verifyMisses = 0;
+    lastDecodedEnd = 0;
+    windowsSkipped = 0;
+    windowsVerified = 0;
+    hitsScheduled = 0;
+}
+
+void LyricsFastPath::rebuildHits(const LyricsAlignment& alignment, const ProfanityMatcher& matcher)
+{
+    // One pass over the whole song: multi-word entries match across line breaks like the live stream
+    ProfanityMatcher::Stream stream;
+    for (const auto& word : alignment.getLyricsWords())
+    {
+        matcher.feedWord(stream, word.word, [this](const ProfanityMatcher::Match& match) {
+            lyricsHits.push_back({ match.entry, (int)match.firstWord, (int)match.lastWord });
+        });
+    }
+    
+    // Matches complete on their last word; scheduling walks them by first word
+    std::stable_sort(lyricsHits.begin(), lyricsHits.end(),
+                     [](const LyricsHit& a, const LyricsHit& b) { return a.firstWord < b.firstWord; });
+}
@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+    LyricsFastPath.h
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Lyrics-locked fast path: censor from the aligned lyrics, decode to verify.
+
+    Once LyricsAlignment is locked to a recognized song, the words coming up
+    are known before they are sung. This mode:
+    - finds every lexicon hit in the lyrics once (multi-word entries included)
+    - tracks where the song is (lyrics index at a stream sample, words per
+      second) from the windows the aligner maps
+    - schedules censor events for upcoming hits ahead of capture, so their
+      timing no longer depends on decode latency
+    - throttles Whisper to verification: windows around a predicted hit are
+      decoded as usual, a heartbeat window every few seconds is decoded on
+      the fastest model, everything else is skipped
+    - steps back to full decoding when verifyWord scores drop, the aligner
+      loses its lock, or the song changes
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LyricsAlignment.h"
+
+class ProfanityMatcher;
+
+/**
+    Plans which windows to decode while the lyrics are locked, and predicts
+    the lexicon hits ahead of them.
+    
+    Usage (Whisper thread):
+        fastPath.setSampleRate(sampleRate);
+        
+        // Submit: per window
+        switch (fastPath.planWindow(lyricsAlignment, windowStart, windowEnd))
+        {
+            case LyricsFastPath::Decision::Skip:    ... no decode
+            case LyricsFastPath::Decision::Verify:  ... decode on the fastest model
+            default:                                ... decode as usual
+        }
+        fastPath.collectDueHits(captureEnd + ahead, hits);     // Schedule these
+        
+        // After alignChunk() of a decoded window
+        fastPath.observeWindow(lyricsAlignment, matcher, alignedWords, windowStart, verifyScore);
+    
+    Thread Safety:
+    - Whisper thread only (the aligner it reads is driven from the same thread)
+*/
+class LyricsFastPath
+{
+public:
+    struct Options
+    {
+        bool enabled = true;
+        int engageAfterWindows = 3;             // Consecutive locked, verified windows before throttling
+        float minVerifyScore = 0.45f;           // Mean verifyWord score below this is a miss
+        int maxVerifyMisses = 2;                // Consecutive misses that end the fast path
+        double scheduleAheadSeconds = 3.0;      // Hits are scheduled this far past the capture point
+        double verifyIntervalSeconds = 4.0;     // Heartbeat decode at least this often
+        double hitMarginSeconds = 0.75;         // Windows this close to a predicted hit are decoded in full
+        double maxUncertaintySeconds = 0.4;     // Cap on the extra padding of a predicted event
+    };
+    
+    enum class Decision
+    {
+        Full,           // Not engaged: decode as usual
+        VerifyHit,      // Engaged, a predicted hit is in the window: decode as usual
+        Verify,         // Engaged, heartbeat: decode on the fastest model
+        Skip            // Engaged: no decode
+    };
+    
+    /**
+        A lexicon hit in the lyrics, placed on the stream timeline.
+    */
+    struct PredictedHit
+    {
+        int entry;                      // ProfanityMatcher entry
+        int64_t startSample;            // Predicted start of the first word (device rate)
+        int64_t endSample;              // Predicted end of the last word
+        double uncertaintySeconds;      // Grows with the distance from the last verified word
+    };
+    
+    LyricsFastPath() = default;
+    
+    void setOptions(const Options& newOptions) { options = newOptions; }
+    const Options& getOptions() const { return options; }
+    
+    /**
+        @param rate     Device sample rate of every sample position
+    */
+    void setSampleRate(double rate) { sampleRate = rate; }
+    
+    bool isEngaged() const { return engaged; }
+    
+    /**
+        Decide what to do with a window before it is submitted.
+        Records the window as decoded unless the decision is Skip; drops back
+        to Full if the aligner lost its lock or switched songs meanwhile.
+        
+        @param alignment            The aligner
+        @param windowStartSample    First sample of the window (device rate)
+        @param windowEndSample      Capture end of the window
+    */
+    Decision planWindow(const LyricsAlignment& alignment, int64_t windowStartSample, int64_t windowEndSample);
+    
+    /**
+        Hits whose predicted start is before untilSample that were not handed out yet.
+        
+        @param untilSample  Scheduling horizon (device rate)
+        @param hits         Cleared, then filled in lyrics order
+    */
+    void collectDueHits(int64_t untilSample, std::vector<PredictedHit>& hits);
+    
+    /**
+        Lyrics index predicted at a stream position (for windows the fast path skipped).
+        
+        @return     -1 when not engaged
+    */
+    int predictPosition(int64_t sample) const;
+    
+    /**
+        Feed back a decoded window after alignment.
+        
+        @param alignment            The aligner, after alignChunk()
+        @param matcher              Compiled lexicon (used when the lyrics change)
+        @param alignedWords         alignChunk() output (window-relative seconds)
+        @param windowStartSample    First sample of the window (device rate)
+        @param verifyScore          LyricsAlignment::verifyChunk() before alignment (< 0 = nothing to verify)
+    */
+    void observeWindow(const LyricsAlignment& alignment, const ProfanityMatcher& matcher,
+                       const std::vector<WordSegment>& alignedWords, int64_t windowStartSample, float verifyScore);
+    
+    /**
+        Back to full decoding (song change, alignment switched off).
+        The lock has to be earned again; the lyrics hit list is kept.
+        
+        @param reason   For the log (see getLastTransition())
+    */
+    void disengage(const char* reason);
+    
+    /**
+        Why the fast path last engaged or disengaged (static string).
+    */
+    const char* getLastTransition() const { return lastTransition; }
+    
+    /**
+        Forget the lyrics and the timing (new song, stream restart).
+    */
+    void reset();
+    
+    //==========================================================================
+    // Statistics (since reset)
+    
+    int getWindowsSkipped() const { return windowsSkipped; }
+    int getWindowsVerified() const { return windowsVerified; }
+    int getHitsScheduled() const { return hitsScheduled; }
+    int getNumLyricsHits() const { return (int)lyricsHits.size(); }
+
+private:
+    struct LyricsHit
+    {
+        int entry;
+        int firstWord;                  // Lyrics word indices (inclusive)
+        int lastWord;
+    };
+    
+    void rebuildHits(const LyricsAlignment& alignment, const ProfanityMatcher& matcher);
+    int64_t predictWordStart(int index) const;
+    
+    Options options;
+    double sampleRate = 44100.0;
+    
+    std::vector<LyricsHit> lyricsHits;
+    uint32_t lyricsVersion = 0;         // LyricsAlignment::getLyricsVersion() the hits belong to
+    size_t nextHit = 0;                 // First hit not handed out yet
+    
+    // Song position model: word anchorIndex starts at anchorSample, then wordsPerSecond
+    int anchorIndex = 0;
+    int64_t anchorSample = 0;
+    double wordsPerSecond = 0.0;
+    
+    bool engaged = false;
+    int lockedWindows = 0;
+    int verifyMisses = 0;
+    int64_t lastDecodedEnd = 0;
+    const char* lastTransition = "";
+    
+    int windowsSkipped = 0;
+    int windowsVerified = 0;
+    int hitsScheduled = 0;
+};
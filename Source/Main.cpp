@@ -12,12 +12,29 @@
     with <150ms total latency. NO vocal separation, NO heavy ML models.
     
     Purpose: Latency testing harness for embedded hardware feasibility study.
+    
+    Headless mode (no window):
+        ExplicitlyDesktop --serve [port]    Filter the browser extension's audio
+                                            (WebSocket sessions, default port 8765)
+        ExplicitlyDesktop --stream "<input>|<output>[|mute|reverse]" ...
+                                            Filter one device pair per --stream
+                                            (repeatable, shared Whisper models)
+        --decodes <n>                       Concurrent decodes over every stream
+        --spotter off|vosk|whisper          Two-tier detection backend for every
+                                            stream (default: vosk when built with
+                                            the Vosk SDK, else off)
+    
+    --serve and --stream combine: every stream and session runs on one
+    MultiStreamEngine.
 
   ==============================================================================
 */
 
 #include <juce_gui_basics/juce_gui_basics.h>
 #include "MainComponent.h"
+#include "MultiStreamEngine.h"
+#include "RemoteSessionHost.h"
+#include "VoskBackend.h"
 
 //==============================================================================
 /**
@@ -34,7 +51,7 @@ class ExplicitlyDesktopApplication  : public juce::JUCEApplication
 public:
     //==============================================================================
     ExplicitlyDesktopApplication() {}
-
+    
     const juce::String getApplicationName() override       
     { 
         // Create startup log
@@ -55,7 +72,7 @@ public:
         // Only allow one instance to prevent audio device conflicts
         return false; 
     }
-
+    
     //==============================================================================
     /**
         Initialize the application and create the main window.
@@ -78,7 +95,14 @@ public:
         juce::Logger::writeToLog(" Version: " + getApplicationVersion());
         juce::Logger::writeToLog("================================================================================");
         juce::Logger::writeToLog("");
-
+        
+        const juce::StringArray args = juce::StringArray::fromTokens(commandLine, true);
+        if (args.contains("--serve") || args.contains("--stream"))
+        {
+            startHeadless(args);
+            return;
+        }
+        
         logFile.appendText("Creating main window\n");
         
         // Create main application window
@@ -89,7 +113,7 @@ public:
         juce::Logger::writeToLog("[Main] Application initialized successfully");
         juce::Logger::writeToLog("[Main] Main window created");
     }
-
+    
     /**
         Shutdown the application and cleanup resources.
         
@@ -106,9 +130,18 @@ public:
         // Destroy main window (this will trigger proper cleanup)
         mainWindow = nullptr;
         
+        // Headless mode: sessions end before the streams and models go
+        remoteSessionHost = nullptr;
+        if (multiStreamEngine != nullptr)
+        {
+            multiStreamEngine->stopAll();
+            juce::Logger::writeToLog(multiStreamEngine->generateReport());
+            multiStreamEngine = nullptr;
+        }
+        
         juce::Logger::writeToLog("[Main] Shutdown complete");
     }
-
+    
     //==============================================================================
     /**
         Handle system quit request (user closing app or system shutdown).
@@ -118,7 +151,7 @@ public:
         juce::Logger::writeToLog("[Main] System requested quit");
         quit();
     }
-
+    
     /**
         Handle another instance attempting to start (blocked by moreThanOneInstanceAllowed).
     */
@@ -132,7 +165,7 @@ public:
             mainWindow->toFront(true);
         }
     }
-
+    
     //==============================================================================
     /**
         Main application window that hosts the audio processing GUI.
@@ -151,7 +184,7 @@ public:
         {
             setUsingNativeTitleBar (true);
             setContentOwned (new MainComponent(), true);
-
+           
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
            #else
@@ -159,12 +192,12 @@ public:
             setResizable (true, true);
             centreWithSize (getWidth(), getHeight());
            #endif
-
+           
             setVisible (true);
             
             juce::Logger::writeToLog("[MainWindow] Window created and visible");
         }
-
+        
         /**
             Handle window close button click.
             
@@ -175,13 +208,121 @@ public:
             juce::Logger::writeToLog("[MainWindow] Close button pressed");
             JUCEApplication::getInstance()->systemRequestedQuit();
         }
-
+    
     private:
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainWindow)
     };
 
 private:
+    /**
+        Run without a window: one MultiStreamEngine for the --stream device
+        pairs and, with --serve, the WebSocket sessions of the browser extension.
+    */
+    void startHeadless(const juce::StringArray& args)
+    {
+        std::vector<MultiStreamEngine::StreamConfig> deviceStreams;
+        int concurrentDecodes = 0;
+        KeywordSpotter::Backend spotter = VoskBackend::isAvailable() ? KeywordSpotter::Backend::Vosk
+                                                                     : KeywordSpotter::Backend::Off;
+        
+        for (int i = 0; i + 1 < args.size(); ++i)
+        {
+            if (args[i] == "--decodes")
+                concurrentDecodes = args[++i].getIntValue();
+            else if (args[i] == "--spotter")
+            {
+                const juce::String backend = args[++i].toLowerCase();
+                if (backend == "off")
+                    spotter = KeywordSpotter::Backend::Off;
+                else if (backend == "vosk")
+                    spotter = KeywordSpotter::Backend::Vosk;
+                else if (backend == "whisper")
+                    spotter = KeywordSpotter::Backend::WhisperTiny;
+                else
+                {
+                    juce::Logger::writeToLog("[Main] ERROR: Unknown spotter " + backend + " (off, vosk or whisper)");
+                    failHeadless();
+                    return;
+                }
+            }
+            else if (args[i] == "--stream")
+            {
+                // "<input>|<output>[|mode]" (quoted when the device names have spaces)
+                const juce::StringArray fields = juce::StringArray::fromTokens(args[++i].unquoted(), "|", "");
+                if (fields.size() < 2 || fields.size() > 3)
+                {
+                    juce::Logger::writeToLog("[Main] ERROR: --stream takes \"<input>|<output>[|mute|reverse]\", got " + args[i]);
+                    failHeadless();
+                    return;
+                }
+                
+                MultiStreamEngine::StreamConfig config;
+                config.inputDevice = fields[0].trim();
+                config.outputDevice = fields[1].trim();
+                config.name = config.inputDevice.toStdString();
+                
+                const juce::String mode = fields[2].trim().toLowerCase();
+                if (mode == "reverse")
+                    config.mode = AudioEngine::CensorMode::Reverse;
+                else if (mode.isNotEmpty() && mode != "mute")
+                {
+                    juce::Logger::writeToLog("[Main] ERROR: Unknown censor mode " + mode + " (mute or reverse)");
+                    failHeadless();
+                    return;
+                }
+                
+                deviceStreams.push_back(config);
+            }
+        }
+        
+        const int serveIndex = args.indexOf("--serve");
+        
+        juce::Logger::writeToLog("[Main] Headless mode (" + juce::String((int)deviceStreams.size()) + " device stream(s)"
+                                 + (serveIndex >= 0 ? ", WebSocket sessions)" : ")"));
+        
+        multiStreamEngine = std::make_unique<MultiStreamEngine>();
+        multiStreamEngine->setMaxConcurrentDecodes(concurrentDecodes);
+        
+        if (!deviceStreams.empty())
+        {
+            for (auto& config : deviceStreams)
+            {
+                config.spotter = spotter;
+                multiStreamEngine->addStream(config);
+            }
+            
+            // Every stream or none: a missing device is a typo, not something to filter around
+            if (multiStreamEngine->startAll() != (int)deviceStreams.size())
+            {
+                failHeadless();
+                return;
+            }
+        }
+        
+        if (serveIndex >= 0)
+        {
+            RemoteSessionHost::Options options;
+            options.spotter = spotter;
+            if (serveIndex + 1 < args.size() && args[serveIndex + 1].containsOnly("0123456789"))
+                options.port = args[serveIndex + 1].getIntValue();
+            
+            remoteSessionHost = std::make_unique<RemoteSessionHost>(*multiStreamEngine);
+            if (!remoteSessionHost->start(options))
+                failHeadless();
+        }
+    }
+    
+    void failHeadless()
+    {
+        setApplicationReturnValue(1);
+        quit();
+    }
+    
     std::unique_ptr<MainWindow> mainWindow;
+    
+    // Headless mode (--serve, --stream); the host is declared last so it goes first
+    std::unique_ptr<MultiStreamEngine> multiStreamEngine;
+    std::unique_ptr<RemoteSessionHost> remoteSessionHost;
 };
 
 //==============================================================================
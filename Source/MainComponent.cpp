@@ -11,6 +11,7 @@
 */
 
 #include "MainComponent.h"
+#include "VoskBackend.h"
 
 #ifdef max
 #undef max
@@ -54,6 +55,17 @@ MainComponent::MainComponent()
     censorModeCombo.setSelectedId (1);  // Default: Reverse
     addAndMakeVisible (censorModeCombo);
     
+    // Keyword spotter (two-tier detection)
+    spotterLabel.setText ("Keyword Spotter:", juce::dontSendNotification);
+    addAndMakeVisible (spotterLabel);
+    
+    spotterCombo.addItem ("Off", 1);
+    spotterCombo.addItem ("Vosk", 2);
+    spotterCombo.addItem ("Whisper tiny.en", 3);
+    spotterCombo.setItemEnabled (2, VoskBackend::isAvailable());
+    spotterCombo.setSelectedId (VoskBackend::isAvailable() ? 2 : 1);  // Default: Vosk when built with it
+    addAndMakeVisible (spotterCombo);
+    
     // Start/Stop Button
     startStopButton.setButtonText ("Start Processing");
     startStopButton.onClick = [this] 
@@ -169,61 +181,10 @@ MainComponent::MainComponent()
     // Initialize audio engine
     audioEngine = std::make_unique<AudioEngine>();
     
-    // Set debug callback
-    audioEngine->setDebugCallback ([this](const juce::String& msg) {
-        auto msgCopy = msg;  // Ensure message is copied
-        juce::MessageManager::callAsync ([this, msgCopy]() {
-            if (isVisible())  // Safety check
-                addDebugMessage (msgCopy, false);
-        });
-    });
-    
-    // Set lyrics callback (for Whisper transcription)
-    audioEngine->setLyricsCallback ([this](const juce::String& words) {
-        updateLiveLyrics(words);
-    });
-    
-    // Set actual lyrics callback (for aligned/corrected lyrics)
-    audioEngine->setActualLyricsCallback ([this](const juce::String& words) {
-        updateActualLyrics(words);
-    });
-    
-    // Set song info callback
-    audioEngine->setSongInfoCallback ([this](const juce::String& artist, const juce::String& title, float confidence) {
-        juce::MessageManager::callAsync ([this, artist, title, confidence]() {
-            if (artist.isEmpty() || title.isEmpty())
-            {
-                songInfoDisplay.setText("Pending...", juce::dontSendNotification);
-                songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::yellow);
-            }
-            else if (artist == "Unknown" && confidence == 0.0f)
-            {
-                // Song not recognized
-                songInfoDisplay.setText("Song Not Recognized", juce::dontSendNotification);
-                songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::orange);
-            }
-            else
-            {
-                // Song identified - UPDATE UI TO SHOW NEW SONG
-                juce::String songText = artist + " - " + title + " (" + juce::String((int)(confidence * 100)) + "%)";
-                songInfoDisplay.setText(songText, juce::dontSendNotification);
-                songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::lightgreen);
-                
-                // Clear actual lyrics display to show "Loading new lyrics..."
-                recentActualLyrics.clear();
-                actualLyricsDisplay.setText("🔄 Loading lyrics...", juce::dontSendNotification);
-                actualLyricsDisplay.setColour(juce::Label::textColourId, juce::Colours::cyan);
-                
-                // Also flash the background to indicate song change
-                actualLyricsDisplay.setColour(juce::Label::backgroundColourId, juce::Colours::darkblue);
-            }
-        });
-    });
-    
     // Populate device lists
     updateDeviceList();
     
-    // Start timer for status updates (every 100ms)
+    // Engine state is picked up on the timer (every 100ms); the engine never calls into the UI
     startTimer (100);
 }
 
@@ -263,6 +224,9 @@ void MainComponent::resized()
     auto censorRow = area.removeFromTop (30);
     censorModeLabel.setBounds (censorRow.removeFromLeft (120));
     censorModeCombo.setBounds (censorRow.removeFromLeft (200));
+    censorRow.removeFromLeft (20);
+    spotterLabel.setBounds (censorRow.removeFromLeft (120));
+    spotterCombo.setBounds (censorRow.removeFromLeft (200));
     area.removeFromTop (20);
     
     // Start/Stop Button
@@ -327,19 +291,45 @@ void MainComponent::resized()
 
 void MainComponent::timerCallback()
 {
-    if (isProcessing)
+    if (!isProcessing)
+        return;
+    
+    // Latest published engine state: nothing to repaint until the engine published again
+    const UiStateModel::Snapshot& state = audioEngine->getUiState().read();
+    if (state.version == shownUiVersion)
+        return;
+    shownUiVersion = state.version;
+    
+    if (state.statsVersion != shownStatsVersion)
     {
-        updateLatencyDisplay();
-        
-        // Phase 1: Update level meter
-        float level = audioEngine->getCurrentInputLevel();
-        levelValueLabel.setText (juce::String (level, 3), juce::dontSendNotification);
-        
-        // Color code: green if detecting audio (>0.01), grey if silent
-        if (level > 0.01f)
-            levelValueLabel.setColour (juce::Label::textColourId, juce::Colours::green);
-        else
-            levelValueLabel.setColour (juce::Label::textColourId, juce::Colours::grey);
+        shownStatsVersion = state.statsVersion;
+        updateLatencyDisplay (state.stats);
+        updateLevelDisplay (state.stats.inputLevel);
+    }
+    
+    if (state.songVersion != shownSongVersion)
+    {
+        shownSongVersion = state.songVersion;
+        updateSongInfo (state.song);
+    }
+    
+    if (state.heardVersion != shownHeardVersion)
+    {
+        shownHeardVersion = state.heardVersion;
+        updateLiveLyrics (state.heardWords);
+    }
+    
+    if (state.lyricsVersion != shownLyricsVersion)
+    {
+        shownLyricsVersion = state.lyricsVersion;
+        updateActualLyrics (state);
+    }
+    
+    // Log lines posted since the last tick (a burst longer than the snapshot's history loses the oldest)
+    for (; shownMessages < state.messagesPosted; ++shownMessages)
+    {
+        if (const std::string* message = state.getMessage (shownMessages))
+            addDebugMessage (juce::String::fromUTF8 (message->c_str()), false);
     }
 }
 
@@ -362,6 +352,14 @@ void MainComponent::startProcessing()
         ? AudioEngine::CensorMode::Reverse 
         : AudioEngine::CensorMode::Mute;
     
+    // Keyword spotter (the engine is stopped, so the backend can change)
+    KeywordSpotter::Options spotterOptions;
+    if (spotterCombo.getSelectedId() == 2)
+        spotterOptions.backend = KeywordSpotter::Backend::Vosk;
+    else if (spotterCombo.getSelectedId() == 3)
+        spotterOptions.backend = KeywordSpotter::Backend::WhisperTiny;
+    audioEngine->setKeywordSpotterOptions (spotterOptions);
+    
     // Debug log
     juce::File logFile = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
         .getChildFile("ExplicitlyStartup.log");
@@ -403,6 +401,7 @@ void MainComponent::startProcessing()
         inputDeviceCombo.setEnabled (false);
         outputDeviceCombo.setEnabled (false);
         censorModeCombo.setEnabled (false);
+        spotterCombo.setEnabled (false);
     }
     else
     {
@@ -428,11 +427,9 @@ void MainComponent::stopProcessing()
     levelValueLabel.setColour (juce::Label::textColourId, getLookAndFeel().findColour (juce::Label::textColourId));
     
     // Clear live lyrics
-    recentLyrics.clear();
     liveLyricsDisplay.setText("", juce::dontSendNotification);
     
     // Clear actual lyrics
-    recentActualLyrics.clear();
     actualLyricsDisplay.setText("", juce::dontSendNotification);
     
     // Reset song info
@@ -443,15 +440,16 @@ void MainComponent::stopProcessing()
     inputDeviceCombo.setEnabled (true);
     outputDeviceCombo.setEnabled (true);
     censorModeCombo.setEnabled (true);
+    spotterCombo.setEnabled (true);
 }
 
-void MainComponent::updateLatencyDisplay()
+void MainComponent::updateLatencyDisplay(const UiStateModel::Stats& stats)
 {
     // Display buffer size (grows over time as processing accumulates)
-    double bufferSize = audioEngine->getCurrentBufferSize();
-    bool isUnderrun = audioEngine->isBufferUnderrun();
+    double bufferSize = stats.bufferSeconds;
+    bool isUnderrun = stats.underrun;
     
-    // Debug: Log every 50 calls (every 5 seconds @ 100ms timer)
+    // Debug: Log every 50 calls (about every 5 seconds, stats are published every 100ms)
     static int callCount = 0;
     if (++callCount % 50 == 0)
     {
@@ -483,6 +481,17 @@ void MainComponent::updateLatencyDisplay()
     }
 }
 
+void MainComponent::updateLevelDisplay(float level)
+{
+    levelValueLabel.setText (juce::String (level, 3), juce::dontSendNotification);
+    
+    // Color code: green if detecting audio (>0.01), grey if silent
+    if (level > 0.01f)
+        levelValueLabel.setColour (juce::Label::textColourId, juce::Colours::green);
+    else
+        levelValueLabel.setColour (juce::Label::textColourId, juce::Colours::grey);
+}
+
 void MainComponent::updateDeviceList()
 {
     // Create a temporary device manager just for enumeration
@@ -612,56 +621,50 @@ void MainComponent::exportDebugLog()
     }
 }
 
-void MainComponent::updateLiveLyrics(const juce::String& words)
+void MainComponent::updateSongInfo(const UiStateModel::Song& song)
 {
-    // Keep last ~10 words visible (Whisper transcription)
-    recentLyrics += " " + words;
-    
-    // Trim to last 10 words
-    juce::StringArray wordArray;
-    wordArray.addTokens(recentLyrics, " ", "");
-    
-    if (wordArray.size() > 10)
+    if (song.state == UiStateModel::SongState::Pending)
     {
-        int startIndex = wordArray.size() - 10;
-        juce::String trimmed;
-        for (int i = startIndex; i < wordArray.size(); ++i)
-        {
-            if (i > startIndex)
-                trimmed += " ";
-            trimmed += wordArray[i];
-        }
-        recentLyrics = trimmed;
+        songInfoDisplay.setText("Pending...", juce::dontSendNotification);
+        songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::yellow);
+    }
+    else if (song.state == UiStateModel::SongState::NotRecognized)
+    {
+        // Song not recognized
+        songInfoDisplay.setText("Song Not Recognized", juce::dontSendNotification);
+        songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::orange);
+    }
+    else
+    {
+        // Song identified - UPDATE UI TO SHOW NEW SONG
+        juce::String songText = juce::String::fromUTF8(song.artist.c_str()) + " - " + juce::String::fromUTF8(song.title.c_str())
+                              + " (" + juce::String((int)(song.confidence * 100)) + "%)";
+        songInfoDisplay.setText(songText, juce::dontSendNotification);
+        songInfoDisplay.setColour(juce::Label::textColourId, juce::Colours::lightgreen);
     }
-    
-    // Update display
-    liveLyricsDisplay.setText(recentLyrics, juce::dontSendNotification);
 }
 
-void MainComponent::updateActualLyrics(const juce::String& words)
+void MainComponent::updateLiveLyrics(const std::string& words)
 {
-    // Keep last ~10 words visible (actual aligned lyrics)
-    recentActualLyrics += " " + words;
-    
-    // Trim to last 10 words
-    juce::StringArray wordArray;
-    wordArray.addTokens(recentActualLyrics, " ", "");
-    
-    if (wordArray.size() > 10)
+    // The engine keeps the last ~10 words (Whisper transcription)
+    liveLyricsDisplay.setText(juce::String::fromUTF8(words.c_str()), juce::dontSendNotification);
+}
+
+void MainComponent::updateActualLyrics(const UiStateModel::Snapshot& state)
+{
+    // A new song clears the line: show it loading until its first aligned words arrive
+    if (state.lyricsWords.empty() && state.song.state == UiStateModel::SongState::Identified)
     {
-        int startIndex = wordArray.size() - 10;
-        juce::String trimmed;
-        for (int i = startIndex; i < wordArray.size(); ++i)
-        {
-            if (i > startIndex)
-                trimmed += " ";
-            trimmed += wordArray[i];
-        }
-        recentActualLyrics = trimmed;
+        actualLyricsDisplay.setText("🔄 Loading lyrics...", juce::dontSendNotification);
+        actualLyricsDisplay.setColour(juce::Label::textColourId, juce::Colours::cyan);
+        
+        // Also flash the background to indicate song change
+        actualLyricsDisplay.setColour(juce::Label::backgroundColourId, juce::Colours::darkblue);
+        return;
     }
     
     // Update display and restore normal colors (in case showing "Loading...")
-    actualLyricsDisplay.setText(recentActualLyrics, juce::dontSendNotification);
+    actualLyricsDisplay.setText(juce::String::fromUTF8(state.lyricsWords.c_str()), juce::dontSendNotification);
     actualLyricsDisplay.setColour(juce::Label::textColourId, juce::Colours::white);
     actualLyricsDisplay.setColour(juce::Label::backgroundColourId, juce::Colours::black);
 }
@@ -13,6 +13,7 @@
     - Censor mode selector (Reverse/Mute)
     - Real-time latency indicator
     - Status text display
+    - Engine state read from AudioEngine::getUiState() on the timer
 
   ==============================================================================
 */
@@ -28,7 +29,7 @@ class MainComponent  : public juce::Component,
 public:
     MainComponent();
     ~MainComponent() override;
-
+    
     void paint (juce::Graphics&) override;
     void resized() override;
     
@@ -37,12 +38,14 @@ public:
 private:
     void startProcessing();
     void stopProcessing();
-    void updateLatencyDisplay();
+    void updateLatencyDisplay(const UiStateModel::Stats& stats);
+    void updateLevelDisplay(float level);
     void updateDeviceList();
     void addDebugMessage(const juce::String& message, bool isProfanity = false);
     void exportDebugLog();
-    void updateLiveLyrics(const juce::String& words);
-    void updateActualLyrics(const juce::String& words);
+    void updateSongInfo(const UiStateModel::Song& song);
+    void updateLiveLyrics(const std::string& words);
+    void updateActualLyrics(const UiStateModel::Snapshot& state);
     
     // GUI Components - Controls
     juce::Label titleLabel;
@@ -56,6 +59,10 @@ private:
     juce::Label censorModeLabel;
     juce::ComboBox censorModeCombo;
     
+    // Two-tier detection backend
+    juce::Label spotterLabel;
+    juce::ComboBox spotterCombo;
+    
     juce::TextButton startStopButton;
     
     juce::Label statusLabel;
@@ -106,8 +113,14 @@ private:
     std::unique_ptr<AudioEngine> audioEngine;
     bool isProcessing = false;
     juce::String debugLog;
-    juce::String recentLyrics;         // Store recent words for live display (Whisper)
-    juce::String recentActualLyrics;   // Store recent words for actual lyrics display
-
+    
+    // Engine UI state on screen: a section is repainted when its version advances
+    uint64_t shownUiVersion = 0;
+    uint64_t shownSongVersion = 0;
+    uint64_t shownHeardVersion = 0;
+    uint64_t shownLyricsVersion = 0;
+    uint64_t shownStatsVersion = 0;
+    uint64_t shownMessages = 0;        // Log lines added to the debug displays
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
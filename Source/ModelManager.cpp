@@ -0,0 +1,215 @@
+/*
+  ==============================================================================
+
+    ModelManager.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Staged and pre-warmed Whisper model loading.
+
+  ==============================================================================
+*/
+
+#include "ModelManager.h"
+#include "WhisperDecodeScheduler.h"
+#include <juce_core/juce_core.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Fastest first: the adaptive switcher relies on this order
+const ModelManager::CatalogEntry ModelManager::catalog[MAX_MODELS] =
+{
+    { "tiny.en",   WHISPER_AHEADS_TINY_EN,   0.08, true,  false },
+    { "base.en",   WHISPER_AHEADS_BASE_EN,   0.12, false, false },
+    { "small.en",  WHISPER_AHEADS_SMALL_EN,  0.20, true,  false },
+    { "medium.en", WHISPER_AHEADS_MEDIUM_EN, 0.45, false, true  }
+};
+
+ModelManager::~ModelManager()
+{
+    shutdown();
+}
+
+bool ModelManager::loadFallback()
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    
+    // The first model that loads becomes the fallback; the loader thread continues after it
+    while (nextEntry < MAX_MODELS)
+    {
+        const CatalogEntry& entry = catalog[nextEntry++];
+        if (entry.larger && !loadLargerModels)
+            continue;
+        
+        // Smallest file available: this load is on the critical path to playback
+        if (loadEntry(entry, true))
+        {
+            std::cout << "[Models] Fallback ready after " << std::fixed << std::setprecision(0)
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count()
+                      << " ms" << std::endl;
+            return true;
+        }
+    }
+    
+    std::cout << "[Models] ERROR: No Whisper model could be loaded from Models/" << std::endl;
+    return false;
+}
+
+void ModelManager::startBackgroundLoading()
+{
+    if (loading.load() || loaderThread.joinable() || nextEntry >= MAX_MODELS)
+        return;
+    
+    cancelLoading.store(false);
+    loading.store(true);
+    loaderThread = std::thread(&ModelManager::backgroundLoad, this);
+}
+
+void ModelManager::shutdown()
+{
+    cancelLoading.store(true);
+    
+    // A load in progress cannot be interrupted; it is freed below once published
+    if (loaderThread.joinable())
+        loaderThread.join();
+    
+    const int count = numReady.load();
+    for (int i = 0; i < count; ++i)
+    {
+        if (whisper_state* state = warmStates[(size_t)i].exchange(nullptr))
+            whisper_free_state(state);
+        
+        if (models[(size_t)i].ctx)
+            whisper_free(models[(size_t)i].ctx);
+        
+        models[(size_t)i] = Model();
+    }
+    
+    numReady.store(0);
+    nextEntry = 0;
+    loading.store(false);
+    cancelLoading.store(false);
+}
+
+whisper_state* ModelManager::takeWarmState(int index)
+{
+    if (index < 0 || index >= getNumReady())
+        return nullptr;
+    
+    return warmStates[(size_t)index].exchange(nullptr);
+}
+
+void ModelManager::backgroundLoad()
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    
+    for (; nextEntry < MAX_MODELS && !cancelLoading.load(); ++nextEntry)
+    {
+        const CatalogEntry& entry = catalog[nextEntry];
+        if (entry.larger && !loadLargerModels)
+            continue;
+        
+        loadEntry(entry, preferQuantized);
+    }
+    
+    std::cout << "[Models] Background loading " << (cancelLoading.load() ? "cancelled" : "finished") << " after "
+              << std::fixed << std::setprecision(1)
+              << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()
+              << "s, " << getNumReady() << " model(s) ready" << std::endl;
+    
+    loading.store(false);
+}
+
+bool ModelManager::loadEntry(const CatalogEntry& entry, bool quantizedFirst)
+{
+    static const char* const quantizedOrder[] = { "-q5_0", "-q8_0", "" };
+    static const char* const fullOrder[] = { "", "-q8_0", "-q5_0" };
+    const char* const* suffixes = quantizedFirst ? quantizedOrder : fullOrder;
+    
+    // First variant present in Models/
+    juce::File file;
+    std::string path;
+    bool quantized = false;
+    for (int i = 0; i < 3; ++i)
+    {
+        path = std::string("Models/ggml-") + entry.name + suffixes[i] + ".bin";
+        file = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+        if (file.existsAsFile())
+        {
+            quantized = suffixes[i][0] != '\0';
+            break;
+        }
+        path.clear();
+    }
+    
+    if (path.empty())
+    {
+        if (entry.required)
+            std::cout << "[Models] ERROR: " << entry.name << " not found in Models/" << std::endl;
+        return false;
+    }
+    
+    whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = false;  // CPU only for consistency
+    cparams.dtw_token_timestamps = true;  // Enable DTW for better timestamp alignment
+    cparams.dtw_aheads_preset = entry.alignmentHeads;  // Per-model alignment preset
+    
+    const auto loadStart = std::chrono::steady_clock::now();
+    // whisper.cpp reads the file straight into its own tensor buffers (a mapping
+    // would only add a second view of the same bytes)
+    whisper_context* ctx = whisper_init_from_file_with_params_no_state(file.getFullPathName().toRawUTF8(), cparams);
+    const auto loadEnd = std::chrono::steady_clock::now();
+    
+    if (ctx == nullptr)
+    {
+        std::cout << "[Models] " << (entry.required ? "ERROR" : "WARNING") << ": Failed to load "
+                  << entry.name << " (" << path << ")" << std::endl;
+        return false;
+    }
+    
+    // Warm-up on the state the first real window will use
+    whisper_state* state = whisper_init_state(ctx);
+    if (state != nullptr && !warmUp(ctx, state))
+        std::cout << "[Models] WARNING: Warm-up decode failed for " << entry.name << std::endl;
+    const auto warmEnd = std::chrono::steady_clock::now();
+    
+    const int index = numReady.load();
+    Model& model = models[(size_t)index];
+    model.name = entry.name;
+    model.path = path;
+    model.ctx = ctx;
+    model.initialRTF = entry.initialRTF;
+    model.quantized = quantized;
+    model.loadSeconds = std::chrono::duration<double>(loadEnd - loadStart).count();
+    model.warmupSeconds = std::chrono::duration<double>(warmEnd - loadEnd).count();
+    warmStates[(size_t)index].store(state);
+    numReady.store(index + 1, std::memory_order_release);
+    
+    std::cout << "[Models] " << entry.name << " ready (" << path << "): load "
+              << std::fixed << std::setprecision(0) << (model.loadSeconds * 1000.0) << " ms, warm-up "
+              << (model.warmupSeconds * 1000.0) << " ms" << std::endl;
+    return true;
+}
+
+bool ModelManager::warmUp(whisper_context* ctx, whisper_state* state)
+{
+    // Same shape as a live decode (audio_ctx, greedy) so the same kernels and buffers get touched
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.n_threads = WhisperDecodeScheduler::recommendedThreadsPerDecode(
+                            WhisperDecodeScheduler::recommendedConcurrentDecodes());
+    wparams.print_realtime = false;
+    wparams.print_progress = false;
+    wparams.print_timestamps = false;
+    wparams.print_special = false;
+    wparams.translate = false;
+    wparams.language = "en";
+    wparams.no_context = true;
+    wparams.single_segment = true;
+    wparams.audio_ctx = 1500;
+    wparams.temperature_inc = 0.0f;  // One pass is enough
+    
+    std::vector<float> silence((size_t)WHISPER_SAMPLE_RATE, 0.0f);
+    return whisper_full_with_state(ctx, state, wparams, silence.data(), (int)silence.size()) == 0;
+}
@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    ModelManager.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Fast Whisper model startup.
+
+    Features:
+    - The fallback model (tiny.en) loads first and synchronously, so start()
+      can succeed straight away
+    - Larger tiers load one by one on a background thread, preferring
+      quantized variants (q5_0, then q8_0) when they are present in Models/
+    - Every model runs a warm-up decode on silence before it is published;
+      the warmed whisper_state is handed to the decode scheduler, so the
+      first real window does not pay the cold start
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+    Loads the Whisper model tiers for AudioEngine, fastest first.
+    
+    Models are published in catalog order (tiny.en, base.en, small.en,
+    medium.en), so index i of the ready list never changes once published.
+    
+    Usage:
+        models.loadFallback();            // blocking, tiny.en (or the first model present)
+        models.startBackgroundLoading();  // the rest, one at a time
+        
+        for (int i = known; i < models.getNumReady(); ++i)
+            adopt(models.getModel(i), models.takeWarmState(i));
+    
+    Thread Safety:
+    - loadFallback()/startBackgroundLoading()/shutdown(): control thread
+    - getNumReady()/getModel(): any thread (a published model is immutable)
+    - takeWarmState(): one consumer at a time
+*/
+class ModelManager
+{
+public:
+    static constexpr int MAX_MODELS = 4;
+    
+    struct Model
+    {
+        std::string name;                   // e.g. "small.en"
+        std::string path;                   // File actually loaded (may be a quantized variant)
+        whisper_context* ctx = nullptr;
+        double initialRTF = 0.0;            // Starting estimate until the model has been measured
+        bool quantized = false;
+        double loadSeconds = 0.0;
+        double warmupSeconds = 0.0;
+    };
+    
+    ModelManager() = default;
+    ~ModelManager();
+    
+    /**
+        Include medium.en in the catalog (AudioEngine::allowLargerThanPrimary).
+        Must be set before loadFallback().
+    */
+    void setLoadLargerModels(bool shouldLoad) { loadLargerModels = shouldLoad; }
+    
+    /**
+        Prefer q5_0/q8_0 files over full precision for the background tiers.
+        The fallback always uses the smallest file available.
+    */
+    void setPreferQuantized(bool shouldPrefer) { preferQuantized = shouldPrefer; }
+    
+    /**
+        Load and warm up the fallback model on the calling thread.
+        
+        @return     false if no model could be loaded at all
+    */
+    bool loadFallback();
+    
+    /**
+        Load the remaining catalog on a background thread.
+    */
+    void startBackgroundLoading();
+    
+    /**
+        Stop background loading, then free every model and unclaimed warm state.
+        Decoders using the contexts must be shut down first.
+    */
+    void shutdown();
+    
+    int getNumReady() const { return numReady.load(std::memory_order_acquire); }
+    const Model& getModel(int index) const { return models[(size_t)index]; }
+    bool isLoading() const { return loading.load(); }
+    
+    /**
+        Take ownership of the model's warmed-up state (nullptr once taken).
+    */
+    whisper_state* takeWarmState(int index);
+
+private:
+    struct CatalogEntry
+    {
+        const char* name;                   // Models/ggml-<name>[-q5_0|-q8_0].bin
+        whisper_alignment_heads_preset alignmentHeads;
+        double initialRTF;
+        bool required;
+        bool larger;                        // Above the primary (medium.en)
+    };
+    
+    static const CatalogEntry catalog[MAX_MODELS];
+    
+    /**
+        Load and warm up one catalog entry, then publish it.
+        
+        @return     false if no file for the entry exists or loading failed
+    */
+    bool loadEntry(const CatalogEntry& entry, bool quantizedFirst);
+    
+    /**
+        Decode one second of silence so first-use costs land here.
+    */
+    static bool warmUp(whisper_context* ctx, whisper_state* state);
+    
+    void backgroundLoad();
+    
+    std::array<Model, MAX_MODELS> models;
+    std::array<std::atomic<whisper_state*>, MAX_MODELS> warmStates {};
+    std::atomic<int> numReady {0};
+    int nextEntry = 0;                      // Catalog position the loader continues from
+    
+    std::thread loaderThread;
+    std::atomic<bool> loading {false};
+    std::atomic<bool> cancelLoading {false};
+    bool loadLargerModels = false;
+    bool preferQuantized = true;
+    
+    ModelManager(const ModelManager&) = delete;
+    ModelManager& operator=(const ModelManager&) = delete;
+};
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    MultiStreamEngine.cpp
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Multi-stream engine implementation.
+
+  ==============================================================================
+*/
+
+#include "MultiStreamEngine.h"
+#include <iostream>
+
+MultiStreamEngine::MultiStreamEngine()
+{
+    std::cout << "[MultiStream] Loading shared Whisper models..." << std::endl;
+    
+    // Same staging as a single AudioEngine: fallback now, the larger tiers in the background
+    if (!models.loadFallback())
+    {
+        std::cout << "[MultiStream] ERROR: Failed to load any Whisper model" << std::endl;
+        return;
+    }
+    
+    models.startBackgroundLoading();
+}
+
+MultiStreamEngine::~MultiStreamEngine()
+{
+    stopAll();
+    
+    // Engines first (they only borrow the scheduler and the contexts), then the workers, then the models
+    streams.clear();
+    scheduler.shutdown();
+    models.shutdown();
+}
+
+int MultiStreamEngine::addStream(const StreamConfig& config)
+{
+    configs.push_back(config);
+    streams.push_back(std::make_unique<AudioEngine>(*this));
+    
+    KeywordSpotter::Options spotterOptions;
+    spotterOptions.backend = config.spotter;
+    streams.back()->setKeywordSpotterOptions(spotterOptions);
+    
+    if (config.isRemote())
+        std::cout << "[MultiStream] Stream " << (streams.size() - 1) << " \"" << config.name << "\": remote input, "
+                  << config.remoteSampleRate << " Hz" << std::endl;
+    else
+        std::cout << "[MultiStream] Stream " << (streams.size() - 1) << " \"" << config.name << "\": "
+                  << config.inputDevice << " -> " << config.outputDevice << std::endl;
+    return (int)streams.size() - 1;
+}
+
+bool MultiStreamEngine::startStream(int index)
+{
+    if (index < 0 || index >= (int)streams.size())
+        return false;
+    
+    if (models.getNumReady() == 0)
+    {
+        std::cout << "[MultiStream] ERROR: No Whisper model loaded" << std::endl;
+        return false;
+    }
+    
+    // Workers start with the first stream (no stream is running, so nothing decodes yet)
+    {
+        std::lock_guard<std::mutex> lock(startMutex);
+        if (!scheduler.isRunning())
+            scheduler.prepare(maxConcurrentDecodes, nullptr);
+    }
+    adoptLoadedModels();
+    
+    const StreamConfig& config = configs[(size_t)index];
+    const bool started = config.isRemote()
+                             ? streams[(size_t)index]->startRemote(config.remoteSampleRate, config.mode)
+                             : streams[(size_t)index]->start(config.inputDevice, config.outputDevice, config.mode);
+    if (!started)
+    {
+        std::cout << "[MultiStream] ERROR: Stream \"" << config.name << "\" failed to start: "
+                  << streams[(size_t)index]->getLastError() << std::endl;
+        return false;
+    }
+    
+    std::cout << "[MultiStream] Stream \"" << config.name << "\" running ("
+              << scheduler.getNumSlots() << " shared decode slot(s), "
+              << scheduler.getNumModels() << " shared model(s))" << std::endl;
+    return true;
+}
+
+void MultiStreamEngine::stopStream(int index)
+{
+    if (index >= 0 && index < (int)streams.size())
+        streams[(size_t)index]->stop();
+}
+
+int MultiStreamEngine::startAll()
+{
+    int running = 0;
+    for (int i = 0; i < (int)streams.size(); ++i)
+        if (!configs[(size_t)i].isRemote())
+            running += startStream(i) ? 1 : 0;
+    
+    return running;
+}
+
+void MultiStreamEngine::stopAll()
+{
+    // Remote streams belong to their feeding thread (RemoteSessionHost::stop() ends them)
+    for (size_t i = 0; i < streams.size(); ++i)
+        if (!configs[i].isRemote())
+            streams[i]->stop();
+}
+
+std::string MultiStreamEngine::generateReport() const
+{
+    std::string report;
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        report += "\n========== STREAM " + std::to_string(i) + ": " + configs[i].name + " ==========\n";
+        report += streams[i]->getQualityAnalyzer().generateReport();
+        report += "\n";
+    }
+    
+    return report;
+}
+
+void MultiStreamEngine::adoptLoadedModels()
+{
+    std::lock_guard<std::mutex> lock(adoptMutex);
+    
+    if (!scheduler.isRunning())
+        return;
+    
+    // Published in catalog order, so appending keeps the indices aligned with ModelManager's
+    for (int i = scheduler.getNumModels(); i < models.getNumReady(); ++i)
+    {
+        if (scheduler.addModel(models.getModel(i).ctx, models.takeWarmState(i)) < 0)
+            break;
+        
+        std::cout << "[MultiStream] Whisper " << models.getModel(i).name << " shared by every stream" << std::endl;
+    }
+}
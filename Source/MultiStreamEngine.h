@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    MultiStreamEngine.h
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Several input devices filtered by one process, on one set of Whisper models.
+
+    Features:
+    - The Whisper models are loaded once (ModelManager) and shared by every
+      stream; the decode workers are shared too (WhisperDecodeScheduler), each
+      concurrent decode on its own whisper_state
+    - A free worker takes the window with the least detection-deadline slack
+      left, across streams (each stream still decodes its windows in order)
+    - Each stream is a full AudioEngine: its own device, delay line, censor
+      timeline, lyrics alignment and QualityAnalyzer statistics
+    - Memory and GPU use are fixed by the models and the decode slots, not by
+      the number of streams
+    - Remote streams take their input from a client instead of a device
+      (RemoteSessionHost feeds them from WebSocketServer sessions)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "AudioEngine.h"
+#include "ModelManager.h"
+#include "WhisperDecodeScheduler.h"
+
+/**
+    Owns the shared models and decode workers, and one AudioEngine per stream.
+    
+    Usage:
+        MultiStreamEngine engine;                       // Loads the models
+        engine.setMaxConcurrentDecodes(4);
+        engine.addStream({ "Room 1", "Line In 1", "Speakers 1", AudioEngine::CensorMode::Mute });
+        engine.addStream({ "Room 2", "Line In 2", "Speakers 2", AudioEngine::CensorMode::Reverse });
+        engine.startAll();
+        ...
+        engine.stopAll();
+        std::cout << engine.generateReport();
+    
+    Thread Safety:
+    - addStream()/startAll()/stopAll()/setMaxConcurrentDecodes(): control thread
+    - startStream()/stopStream(): the thread that owns the stream (the control
+      thread; a remote stream's feeding thread)
+    - adoptLoadedModels(): any thread (the streams' Whisper threads call it)
+*/
+class MultiStreamEngine
+{
+public:
+    struct StreamConfig
+    {
+        std::string name;                   // For logs and the report
+        juce::String inputDevice;
+        juce::String outputDevice;
+        AudioEngine::CensorMode mode = AudioEngine::CensorMode::Mute;
+        int remoteSampleRate = 0;           // > 0: no devices, fed with AudioEngine::processRemoteAudio()
+        KeywordSpotter::Backend spotter = KeywordSpotter::Backend::Off;     // Two-tier detection
+        
+        bool isRemote() const { return remoteSampleRate > 0; }
+    };
+    
+    MultiStreamEngine();
+    ~MultiStreamEngine();
+    
+    /**
+        Decodes in flight at once over every stream (0 = from core topology).
+        Takes effect when the first stream starts.
+    */
+    void setMaxConcurrentDecodes(int decodes) { maxConcurrentDecodes = decodes; }
+    
+    /**
+        Create a stream (not started).
+        
+        @return     Stream index
+    */
+    int addStream(const StreamConfig& config);
+    
+    /**
+        Open the stream's devices (a remote stream: get ready for its input)
+        and start filtering.
+        
+        @return     false if the models are missing or the device failed
+                    (see getStream(index).getLastError())
+    */
+    bool startStream(int index);
+    void stopStream(int index);
+    
+    /**
+        Start every device stream (remote streams start when their client connects).
+        
+        @return     Number of streams running afterwards
+    */
+    int startAll();
+    void stopAll();                         // Device streams (remote ones stop with their host)
+    
+    int getNumStreams() const { return (int)streams.size(); }
+    AudioEngine& getStream(int index) { return *streams[(size_t)index]; }
+    const StreamConfig& getStreamConfig(int index) const { return configs[(size_t)index]; }
+    
+    /**
+        Every stream's quality report, one after the other.
+    */
+    std::string generateReport() const;
+    
+    //==========================================================================
+    // Shared by the streams' AudioEngines
+    
+    ModelManager& getModelManager() { return models; }
+    WhisperDecodeScheduler& getScheduler() { return scheduler; }
+    
+    /**
+        Hand models the background loader has published since the last call to
+        the running scheduler (scheduler model i is ModelManager model i).
+    */
+    void adoptLoadedModels();
+
+private:
+    ModelManager models;
+    WhisperDecodeScheduler scheduler;
+    std::mutex adoptMutex;
+    std::mutex startMutex;                  // Streams may start on different threads (first one starts the workers)
+    int maxConcurrentDecodes = 0;
+    
+    // Declared last: the streams close their scheduler queues before the workers and models go
+    std::vector<StreamConfig> configs;
+    std::vector<std::unique_ptr<AudioEngine>> streams;
+    
+    MultiStreamEngine(const MultiStreamEngine&) = delete;
+    MultiStreamEngine& operator=(const MultiStreamEngine&) = delete;
+};
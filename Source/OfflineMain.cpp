@@ -0,0 +1,247 @@
+/*
+  ==============================================================================
+
+    OfflineMain.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    ExplicitlyBatch: command-line front end of the OfflineProcessor.
+
+    Usage:
+        ExplicitlyBatch [options] <file or folder>...
+
+    Folders are searched recursively for every format JUCE can read. Output
+    files keep their names and go to --output (default: "censored" next to
+    each input). Models/ and lexicons/ are looked up in the working
+    directory, as for the desktop app.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "OfflineProcessor.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: ExplicitlyBatch [options] <file or folder>...\n"
+                     "\n"
+                     "Options:\n"
+                     "  -o, --output <dir>    Output folder (default: <input folder>/censored)\n"
+                     "  --format wav|flac     Output format (default: from the input, FLAC stays FLAC)\n"
+                     "  --mode mute|reverse   Censor mode (default: mute)\n"
+                     "  --model <name>        Whisper model, e.g. small.en, medium.en (default: small.en)\n"
+                     "  --decodes <n>         Concurrent decodes (default: from the core topology)\n"
+                     "  --lexicon <file>      Profanity lexicon (default: lexicons/profanity_en.txt)\n"
+                     "  --lyrics <file>       Lyrics text for alignment (single input file only)\n"
+                     "  --no-gate             Decode every window (no vocal activity gate)\n"
+                     "  --no-filter           Skip the vocal band-pass filter\n"
+                     "  --no-redecode         Whole-window temperature fallback instead of targeted re-decoding\n"
+                     "  --no-sidecar          Do not write <output>.censor.json\n"
+                  << std::endl;
+    }
+    
+    juce::File resolvePath(const juce::String& path)
+    {
+        // getChildFile() keeps absolute paths as they are
+        return juce::File::getCurrentWorkingDirectory().getChildFile(path);
+    }
+    
+    bool isAudioFile(const juce::AudioFormatManager& formats, const juce::File& file)
+    {
+        for (int i = 0; i < formats.getNumKnownFormats(); ++i)
+            if (formats.getKnownFormat(i)->canHandleFile(file))
+                return true;
+        return false;
+    }
+    
+    struct Input
+    {
+        juce::File file;
+        juce::File root;        // Folder the file was found in (output mirrors the layout below it)
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    OfflineProcessor::Options options;
+    juce::File outputDir;
+    juce::File lexiconFile = resolvePath("lexicons/profanity_en.txt");
+    juce::File lyricsFile;
+    std::vector<juce::String> paths;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+        
+        if ((arg == "-o" || arg == "--output") && hasValue)
+            outputDir = resolvePath(argv[++i]);
+        else if (arg == "--format" && hasValue)
+        {
+            const juce::String format = juce::String(argv[++i]).toLowerCase();
+            if (format == "flac")
+                options.format = OfflineProcessor::OutputFormat::Flac;
+            else if (format == "wav")
+                options.format = OfflineProcessor::OutputFormat::Wav;
+            else
+            {
+                std::cout << "[Batch] ERROR: Unknown output format " << format << " (wav or flac)" << std::endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--mode" && hasValue)
+        {
+            const juce::String mode = juce::String(argv[++i]).toLowerCase();
+            if (mode == "mute")
+                options.mode = CensorEvent::Mode::Mute;
+            else if (mode == "reverse")
+                options.mode = CensorEvent::Mode::Reverse;
+            else
+            {
+                std::cout << "[Batch] ERROR: Unknown censor mode " << mode << " (mute or reverse)" << std::endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--model" && hasValue)
+            options.modelName = argv[++i];
+        else if (arg == "--decodes" && hasValue)
+            options.concurrentDecodes = juce::String(argv[++i]).getIntValue();
+        else if (arg == "--lexicon" && hasValue)
+            lexiconFile = resolvePath(argv[++i]);
+        else if (arg == "--lyrics" && hasValue)
+            lyricsFile = resolvePath(argv[++i]);
+        else if (arg == "--no-gate")
+            options.useVocalGate = false;
+        else if (arg == "--no-filter")
+            options.useVocalFilter = false;
+        else if (arg == "--no-redecode")
+            options.targetedRedecode = false;
+        else if (arg == "--no-sidecar")
+            options.writeSidecar = false;
+        else if (arg == "-h" || arg == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else if (arg.startsWith("-"))
+        {
+            std::cout << "[Batch] ERROR: Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+        else
+            paths.push_back(arg);
+    }
+    
+    if (paths.empty())
+    {
+        printUsage();
+        return 1;
+    }
+    
+    // Collect inputs (folders recursively)
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    
+    std::vector<Input> inputs;
+    for (const auto& path : paths)
+    {
+        const juce::File file = resolvePath(path);
+        if (file.isDirectory())
+        {
+            // Earlier runs' output is not input
+            const juce::File skipDir = outputDir != juce::File() ? outputDir : file.getChildFile("censored");
+            for (const auto& child : file.findChildFiles(juce::File::findFiles, true, formats.getWildcardForAllFormats()))
+                if (!child.isAChildOf(skipDir))
+                    inputs.push_back({ child, file });
+        }
+        else if (file.existsAsFile() && isAudioFile(formats, file))
+            inputs.push_back({ file, file.getParentDirectory() });
+        else
+            std::cout << "[Batch] WARNING: Skipping " << file.getFullPathName() << " (not an audio file)" << std::endl;
+    }
+    
+    if (inputs.empty())
+    {
+        std::cout << "[Batch] ERROR: No input files" << std::endl;
+        return 1;
+    }
+    
+    std::string lyrics;
+    if (lyricsFile != juce::File())
+    {
+        if (inputs.size() != 1)
+            std::cout << "[Batch] WARNING: --lyrics ignored (more than one input file)" << std::endl;
+        else
+            lyrics = lyricsFile.loadFileAsString().toStdString();
+    }
+    
+    OfflineProcessor processor;
+    if (!processor.prepare(options, lexiconFile))
+        return 1;
+    
+    double totalAudio = 0.0;
+    double totalWall = 0.0;
+    int failures = 0;
+    size_t totalEvents = 0;
+    
+    for (const auto& input : inputs)
+    {
+        // Same relative path below the output folder; never overwrite the input
+        const juce::File outputRoot = outputDir != juce::File() ? outputDir : input.root.getChildFile("censored");
+        juce::File output = outputRoot.getChildFile(input.file.getRelativePathFrom(input.root));
+        
+        if (options.format == OfflineProcessor::OutputFormat::Flac)
+            output = output.withFileExtension(".flac");
+        else if (options.format == OfflineProcessor::OutputFormat::Wav || !output.hasFileExtension(".flac"))
+            output = output.withFileExtension(".wav");
+        
+        if (output == input.file)
+        {
+            std::cout << "[Batch] ERROR: Output would overwrite " << input.file.getFullPathName() << std::endl;
+            ++failures;
+            continue;
+        }
+        
+        output.getParentDirectory().createDirectory();
+        
+        const OfflineProcessor::FileResult result = processor.processFile(input.file, output, lyrics);
+        if (!result.success)
+        {
+            std::cout << "[Batch] FAILED " << input.file.getFullPathName() << ": " << result.error << std::endl;
+            ++failures;
+            continue;
+        }
+        
+        totalAudio += result.audioSeconds;
+        totalWall += result.wallSeconds;
+        totalEvents += result.events.size();
+        
+        std::cout << "[Batch] " << input.file.getFileName() << " -> " << output.getFullPathName() << ": "
+                  << std::fixed << std::setprecision(1) << result.audioSeconds << "s audio in "
+                  << std::setprecision(2) << result.wallSeconds << "s ("
+                  << std::setprecision(1) << result.getSpeedFactor() << "x real time), "
+                  << result.events.size() << " event(s), "
+                  << result.windowsDecoded << " window(s) decoded, " << result.windowsSkipped << " skipped, "
+                  << result.regionsRedecoded << " region(s) re-decoded"
+                  << (result.aligned ? ", lyrics aligned" : "") << std::endl;
+    }
+    
+    processor.shutdown();
+    
+    std::cout << "[Batch] Done: " << (inputs.size() - (size_t)failures) << "/" << inputs.size() << " file(s), "
+              << std::fixed << std::setprecision(1) << totalAudio << "s audio in " << totalWall << "s ("
+              << (totalWall > 0.0 ? totalAudio / totalWall : 0.0) << "x real time), "
+              << totalEvents << " event(s)" << std::endl;
+    
+    return failures == 0 ? 0 : 2;
+}
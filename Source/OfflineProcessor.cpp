@@ -0,0 +1,661 @@
+/*
+  ==============================================================================
+
+    OfflineProcessor.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Headless file-to-file censorship (batch mode).
+
+  ==============================================================================
+*/
+
+#include "OfflineProcessor.h"
+#include "CircularBuffer.h"
+#include "WhisperTranscript.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    constexpr int READ_BLOCK_SAMPLES = 16384;       // Input samples per read in both passes
+    constexpr double MAX_EVENT_SECONDS = 30.0;      // Longer events are clamped (render look-ahead)
+}
+
+OfflineProcessor::OfflineProcessor()
+{
+    formatManager.registerBasicFormats();
+}
+
+OfflineProcessor::~OfflineProcessor()
+{
+    shutdown();
+}
+
+bool OfflineProcessor::prepare(const Options& newOptions, const juce::File& lexiconFile)
+{
+    shutdown();
+    options = newOptions;
+    options.windowSeconds = std::max(1.0, std::min(30.0, options.windowSeconds));
+    options.overlapSeconds = std::max(0.0, std::min(options.windowSeconds * 0.5, options.overlapSeconds));
+    
+    if (!profanityFilter.loadLexicon(lexiconFile))
+    {
+        std::cout << "[Batch] ERROR: Could not load profanity lexicon " << lexiconFile.getFullPathName() << std::endl;
+        return false;
+    }
+    
+    RedecodePolicy::Options redecodeOptions = redecodePolicy.getOptions();
+    redecodeOptions.enabled = options.targetedRedecode;
+    redecodePolicy.setOptions(redecodeOptions);
+    redecodePolicy.setLexicon(&profanityFilter.getMatcher());
+    
+    // The requested tier and everything below it; only medium.en needs the larger catalog
+    modelManager.setPreferQuantized(options.preferQuantized);
+    modelManager.setLoadLargerModels(options.modelName == "medium.en");
+    if (!modelManager.loadFallback())
+        return false;
+    
+    // Nothing to overlap loading with here: wait until the requested model is ready
+    auto findModel = [this]() {
+        for (int i = 0; i < modelManager.getNumReady(); ++i)
+            if (modelManager.getModel(i).name == options.modelName)
+                return i;
+        return -1;
+    };
+    
+    modelManager.startBackgroundLoading();
+    while (findModel() < 0 && modelManager.isLoading())
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    
+    int chosen = findModel();
+    if (chosen < 0)
+    {
+        chosen = modelManager.getNumReady() - 1;    // Most accurate one that loaded
+        std::cout << "[Batch] WARNING: " << options.modelName << " not available - using "
+                  << modelManager.getModel(chosen).name << std::endl;
+    }
+    
+    const ModelManager::Model& model = modelManager.getModel(chosen);
+    ctx = model.ctx;
+    modelName = model.name;
+    
+    decodeScheduler.prepare(options.concurrentDecodes, [this] { resultWake.notify(); });
+    modelIndex = decodeScheduler.addModel(ctx, modelManager.takeWarmState(chosen));
+    if (modelIndex < 0)
+    {
+        std::cout << "[Batch] ERROR: Decode scheduler failed to start" << std::endl;
+        shutdown();
+        return false;
+    }
+    
+    if (options.windowsInFlight <= 0)
+        options.windowsInFlight = 2 * decodeScheduler.getNumSlots();
+    
+    std::cout << "[Batch] Model " << modelName << (model.quantized ? " (quantized)" : "")
+              << ", " << decodeScheduler.getNumSlots() << " decode slot(s) x "
+              << decodeScheduler.getThreadsPerDecode() << " thread(s), "
+              << options.windowsInFlight << " window(s) in flight" << std::endl;
+    
+    prepared = true;
+    return true;
+}
+
+void OfflineProcessor::shutdown()
+{
+    // Workers hold states of the models: stop them before the models are freed
+    decodeScheduler.shutdown();
+    modelManager.shutdown();
+    ctx = nullptr;
+    prepared = false;
+}
+
+juce::File OfflineProcessor::getSidecarFile(const juce::File& output)
+{
+    return output.getSiblingFile(output.getFileNameWithoutExtension() + ".censor.json");
+}
+
+OfflineProcessor::FileResult OfflineProcessor::processFile(const juce::File& input, const juce::File& output,
+                                                           const std::string& lyrics)
+{
+    FileResult result;
+    const auto startTime = std::chrono::steady_clock::now();
+    
+    if (!prepared)
+    {
+        result.error = "processor not prepared";
+        return result;
+    }
+    
+    std::unique_ptr<juce::AudioFormatReader> reader = openReader(input);
+    if (reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+    {
+        result.error = "unsupported or empty input file";
+        return result;
+    }
+    
+    result.audioSeconds = (double)reader->lengthInSamples / reader->sampleRate;
+    
+    Session session;
+    session.inputRate = reader->sampleRate;
+    session.promptTokens.reserve((size_t)options.maxPromptTokens + 256);
+    
+    lyricsAlignment.reset();
+    if (!lyrics.empty())
+    {
+        lyricsAlignment.setLyrics(lyrics);
+        session.useLyrics = lyricsAlignment.isReady();
+        result.aligned = session.useLyrics;
+    }
+    
+    if (!analyze(*reader, session, result))
+        return result;
+    
+    result.analysisSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    result.events = mergeEvents(std::move(result.events));
+    
+    if (!render(*reader, output, result))
+        return result;
+    
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    if (options.writeSidecar && !writeSidecar(input, output, result, reader->sampleRate))
+        std::cout << "[Batch] WARNING: Could not write " << getSidecarFile(output).getFullPathName() << std::endl;
+    
+    result.success = true;
+    return result;
+}
+
+std::unique_ptr<juce::AudioFormatReader> OfflineProcessor::openReader(const juce::File& input)
+{
+    // Memory-mapped where the format allows it: both passes then read straight from the page cache
+    for (int i = 0; i < formatManager.getNumKnownFormats(); ++i)
+    {
+        juce::AudioFormat* format = formatManager.getKnownFormat(i);
+        if (!format->canHandleFile(input))
+            continue;
+        
+        std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(input));
+        if (mapped != nullptr && mapped->mapEntireFile())
+            return std::move(mapped);
+    }
+    
+    // Compressed formats: streamed block by block
+    return std::unique_ptr<juce::AudioFormatReader>(formatManager.createReaderFor(input));
+}
+
+whisper_full_params OfflineProcessor::makeParams() const
+{
+    // Same decoding setup as the live engine (AudioEngine::submitTranscription)
+    whisper_full_params wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    wparams.print_realtime = false;
+    wparams.print_progress = false;
+    wparams.print_timestamps = true;
+    wparams.print_special = false;
+    wparams.translate = false;
+    wparams.language = "en";
+    wparams.single_segment = false;
+    wparams.token_timestamps = false;
+    wparams.max_len = 0;
+    wparams.no_context = true;          // Prompt carried explicitly (job.prompt)
+    wparams.audio_ctx = 1500;
+    wparams.temperature = 0.0f;
+    wparams.temperature_inc = 0.2f;
+    wparams.entropy_thold = 5.0f;
+    wparams.logprob_thold = -1.0f;
+    if (redecodePolicy.isEnabled())
+        RedecodePolicy::configureFirstPass(wparams);
+    return wparams;
+}
+
+//==============================================================================
+bool OfflineProcessor::analyze(juce::AudioFormatReader& reader, Session& session, FileResult& result)
+{
+    const double inputRate = reader.sampleRate;
+    const int64_t totalSamples = reader.lengthInSamples;
+    const int numChannels = (int)std::max(1u, reader.numChannels);
+    
+    resampler.prepare((int)std::lround(inputRate), WHISPER_SAMPLE_RATE, READ_BLOCK_SAMPLES);
+    vocalFilter.initialize(WHISPER_SAMPLE_RATE);
+    vocalFilter.reset();
+    vocalGate.initialize(WHISPER_SAMPLE_RATE);
+    vocalGate.setEnabled(options.useVocalGate);
+    vocalGate.reset();
+    
+    const int windowSamples = (int)std::lround(options.windowSeconds * WHISPER_SAMPLE_RATE);
+    const int hopSamples = std::max(WHISPER_SAMPLE_RATE / 10,
+                                    (int)std::lround((options.windowSeconds - options.overlapSeconds) * WHISPER_SAMPLE_RATE));
+    const int filterLatency = options.useVocalFilter ? vocalFilter.getLatencySamples() : 0;
+    const double latencyInputSamples = resampler.getLatencyInputSamples() + (double)filterLatency * inputRate / WHISPER_SAMPLE_RATE;
+    
+    // 16kHz feed; only the part later windows still need is kept
+    std::vector<float> feed;
+    int64_t feedStart = 0;                  // 16kHz position of feed[0]
+    int64_t nextWindowStart = 0;
+    int64_t lastWindowEnd = 0;
+    feed.reserve((size_t)windowSamples * 2);
+    
+    juce::AudioBuffer<float> block(numChannels, READ_BLOCK_SAMPLES);
+    std::vector<float> mono((size_t)READ_BLOCK_SAMPLES);
+    std::vector<float> resampled((size_t)resampler.getMaxOutputSamples(READ_BLOCK_SAMPLES));
+    
+    int inFlight = 0;
+    bool failed = false;
+    
+    auto consumeReady = [&](bool wait) {
+        WhisperDecodeScheduler::Result decode;
+        while (true)
+        {
+            if (decodeScheduler.popCompleted(decode))
+            {
+                consumeResult(decode, session, result);
+                decodeScheduler.release(decode);
+                --inFlight;
+                continue;
+            }
+            
+            if (!wait)
+                return;
+            
+            resultWake.wait(100);
+            wait = inFlight >= options.windowsInFlight;
+            if (!wait)
+                return;
+        }
+    };
+    
+    auto submitWindow = [&](int64_t windowStart, int length, bool isLast) {
+        std::vector<float> samples(feed.begin() + (windowStart - feedStart),
+                                   feed.begin() + (windowStart - feedStart) + length);
+        
+        // Map the 16kHz window end onto the input timeline (filter pipeline and resampler delay)
+        const int64_t windowEnd = windowStart + length;
+        const int64_t captureEnd = std::min<int64_t>(totalSamples,
+            (int64_t)std::llround((double)windowEnd * inputRate / WHISPER_SAMPLE_RATE - latencyInputSamples));
+        
+        const VocalActivityGate::Decision gate = vocalGate.analyze(samples.data(), (int)samples.size());
+        if (!gate.decode)
+        {
+            ++result.windowsSkipped;
+            return;
+        }
+        
+        // Files under a second are padded in front, so the window still ends at captureEnd
+        if ((int)samples.size() < WHISPER_SAMPLE_RATE)
+            samples.insert(samples.begin(), (size_t)WHISPER_SAMPLE_RATE - samples.size(), 0.0f);
+        
+        WhisperDecodeScheduler::Job job;
+        job.params = makeParams();
+        job.prompt = session.promptTokens;
+        job.model = modelIndex;
+        job.samples = std::move(samples);
+        job.captureEndSample = captureEnd;
+        if (redecodePolicy.isEnabled())
+            job.redecodePolicy = &redecodePolicy;
+        if (isLast)
+            session.finalCaptureEnd = captureEnd;
+        
+        if (!decodeScheduler.submit(std::move(job)))
+        {
+            result.error = "decode scheduler not running";
+            failed = true;
+            return;
+        }
+        
+        ++inFlight;
+        ++result.windowsDecoded;
+    };
+    
+    // mono[0, numSamples) -> resampler -> vocal filter -> feed
+    auto appendToFeed = [&](int numSamples) {
+        const int produced = resampler.process(mono.data(), numSamples, resampled.data(), (int)resampled.size());
+        if (options.useVocalFilter)
+            vocalFilter.process(resampled.data(), produced);
+        feed.insert(feed.end(), resampled.begin(), resampled.begin() + produced);
+    };
+    
+    for (int64_t position = 0; position < totalSamples && !failed; position += READ_BLOCK_SAMPLES)
+    {
+        const int numSamples = (int)std::min<int64_t>(READ_BLOCK_SAMPLES, totalSamples - position);
+        if (!reader.read(&block, 0, numSamples, position, true, true))
+        {
+            result.error = "read error";
+            failed = true;
+            break;
+        }
+        
+        // Downmix to mono like the audio callback
+        const float* left = block.getReadPointer(0);
+        const float* right = numChannels > 1 ? block.getReadPointer(1) : nullptr;
+        for (int i = 0; i < numSamples; ++i)
+            mono[(size_t)i] = right != nullptr ? (left[i] + right[i]) * 0.5f : left[i];
+        
+        appendToFeed(numSamples);
+        
+        while (!failed && nextWindowStart + windowSamples <= feedStart + (int64_t)feed.size())
+        {
+            submitWindow(nextWindowStart, windowSamples, false);
+            lastWindowEnd = nextWindowStart + windowSamples;
+            nextWindowStart += hopSamples;
+            
+            consumeReady(inFlight >= options.windowsInFlight);
+        }
+        
+        // Drop audio neither the next window nor the tail window can reach
+        const int64_t keepFrom = nextWindowStart - windowSamples;
+        if (keepFrom - feedStart > (int64_t)windowSamples)
+        {
+            feed.erase(feed.begin(), feed.begin() + (keepFrom - feedStart));
+            feedStart = keepFrom;
+        }
+    }
+    
+    // End of file: push silence through the resampler and vocal filter delay, so the
+    // last input samples reach the feed (captureEnd is clamped to the file length)
+    if (!failed && totalSamples > 0)
+    {
+        std::fill(mono.begin(), mono.end(), 0.0f);
+        for (int64_t remaining = (int64_t)std::ceil(latencyInputSamples) + 1; remaining > 0; remaining -= READ_BLOCK_SAMPLES)
+            appendToFeed((int)std::min<int64_t>(READ_BLOCK_SAMPLES, remaining));
+    }
+    
+    // Tail: one more window (ending at the end of the file) if the last full window stopped short
+    const int64_t feedEnd = feedStart + (int64_t)feed.size();
+    if (!failed && feedEnd > lastWindowEnd)
+    {
+        const int64_t tailStart = std::max<int64_t>(feedStart, feedEnd - windowSamples);
+        submitWindow(tailStart, (int)(feedEnd - tailStart), true);
+    }
+    
+    while (inFlight > 0)
+        consumeReady(true);
+    
+    return !failed;
+}
+
+void OfflineProcessor::consumeResult(const WhisperDecodeScheduler::Result& decode, Session& session, FileResult& result)
+{
+    const double inputRate = session.inputRate;
+    const std::vector<float>& window = decode.job.samples;
+    const double windowSeconds = (double)window.size() / WHISPER_SAMPLE_RATE;
+    const int64_t captureEndSample = decode.job.captureEndSample;
+    const bool isLast = captureEndSample == session.finalCaptureEnd;
+    
+    const int64_t windowSamples = (int64_t)std::lround(windowSeconds * inputRate);
+    const int64_t windowStartSample = captureEndSample - windowSamples;
+    
+    if (decode.status != 0 || decode.state == nullptr)
+    {
+        std::cout << "[Batch] WARNING: Whisper failed with code " << decode.status << " - window skipped" << std::endl;
+        return;
+    }
+    
+    std::vector<WordSegment> words;
+    std::vector<whisper_token> tokens;
+    if (decode.redecode.ran)
+    {
+        words = decode.words;
+        tokens = decode.tokens;
+        result.regionsRedecoded += decode.redecode.regions;
+        result.redecodeSeconds += decode.redecode.secondPassSeconds;
+    }
+    else
+        WhisperTranscript::extractWords(decode.ctx, decode.state, windowSeconds, words, tokens);
+    
+    timestampRefiner.prepareEnvelope(window, WHISPER_SAMPLE_RATE);
+    for (auto& word : words)
+        timestampRefiner.refineWordTimestamp(word, WHISPER_SAMPLE_RATE);
+    
+    // Words whose midpoint falls in [committed, windowEnd - margin) belong to this window
+    // (same rule as live streaming; the last window commits everything)
+    const double marginSeconds = isLast ? 0.0 : std::min(options.stableMarginSeconds, options.overlapSeconds);
+    const int64_t commitEndSample = captureEndSample - (int64_t)(marginSeconds * inputRate);
+    const int64_t committedFromSample = std::max(session.committedSample, windowStartSample);
+    
+    std::vector<WordSegment> stableWords;
+    for (size_t k = 0; k < words.size(); ++k)
+    {
+        const int64_t midSample = windowStartSample + (int64_t)((words[k].start + words[k].end) * 0.5 * inputRate);
+        if (midSample < committedFromSample || midSample >= commitEndSample)
+            continue;
+        
+        stableWords.push_back(words[k]);
+        session.promptTokens.push_back(tokens[k]);
+    }
+    
+    if ((int)session.promptTokens.size() > options.maxPromptTokens)
+        session.promptTokens.erase(session.promptTokens.begin(), session.promptTokens.end() - options.maxPromptTokens);
+    
+    const double committedSeconds = (double)std::max<int64_t>(0, commitEndSample - committedFromSample) / inputRate;
+    session.committedSample = std::max(session.committedSample, commitEndSample);
+    
+    std::vector<WordSegment> finalWords = stableWords;
+    if (session.useLyrics)
+    {
+        finalWords = lyricsAlignment.alignChunk(stableWords, session.songElapsedSeconds);
+        if (!stableWords.empty())
+            session.songElapsedSeconds += committedSeconds;
+        
+        if (finalWords.empty())
+            finalWords = stableWords;
+    }
+    
+    result.wordsEmitted += (int)finalWords.size();
+    
+    // Streaming matcher over the emitted words, phrases may begin in an earlier window
+    const ProfanityMatcher& matcher = profanityFilter.getMatcher();
+    const int64_t paddingBefore = (int64_t)(options.paddingBeforeSeconds * inputRate);
+    const int64_t paddingAfter = (int64_t)(options.paddingAfterSeconds * inputRate);
+    
+    for (const auto& wordSeg : finalWords)
+    {
+        EmittedWord& emitted = session.recentWords[session.profanityStream.numWords % session.recentWords.size()];
+        emitted.startSample = windowStartSample + (int64_t)(wordSeg.start * inputRate);
+        emitted.endSample = windowStartSample + (int64_t)(wordSeg.end * inputRate);
+        emitted.confidence = (float)wordSeg.confidence;
+        
+        matcher.feedWord(session.profanityStream, wordSeg.word, [&](const ProfanityMatcher::Match& match) {
+            uint64_t firstWord = match.firstWord;
+            if (session.coveredWord >= 0 && firstWord <= (uint64_t)session.coveredWord)
+                firstWord = (uint64_t)session.coveredWord + 1;
+            if (firstWord > match.lastWord)
+                return;
+            session.coveredWord = (int64_t)match.lastWord;
+            
+            const EmittedWord& first = session.recentWords[firstWord % session.recentWords.size()];
+            const EmittedWord& last = session.recentWords[match.lastWord % session.recentWords.size()];
+            
+            CensorEvent event {};
+            event.start_sample = std::max<int64_t>(0, first.startSample - paddingBefore);
+            event.end_sample = std::max(event.start_sample, last.endSample + paddingAfter);
+            event.mode = options.mode;
+            event.confidence = last.confidence;
+            
+            const std::string_view text = matcher.getEntryText(match.entry);
+            const size_t length = std::min(text.size(), sizeof(event.word) - 1);
+            std::memcpy(event.word, text.data(), length);
+            event.word[length] = '\0';
+            
+            result.events.push_back(event);
+        });
+    }
+}
+
+std::vector<CensorEvent> OfflineProcessor::mergeEvents(std::vector<CensorEvent> events)
+{
+    std::sort(events.begin(), events.end(), [](const CensorEvent& a, const CensorEvent& b) {
+        return a.start_sample < b.start_sample;
+    });
+    
+    // Overlapping ranges become one event (all share the file's mode)
+    std::vector<CensorEvent> merged;
+    for (const auto& event : events)
+    {
+        if (!merged.empty() && event.start_sample <= merged.back().end_sample && event.mode == merged.back().mode)
+        {
+            CensorEvent& previous = merged.back();
+            previous.end_sample = std::max(previous.end_sample, event.end_sample);
+            previous.confidence = std::max(previous.confidence, event.confidence);
+            
+            const size_t used = std::strlen(previous.word);
+            if (used + 1 < sizeof(previous.word))
+            {
+                std::strncat(previous.word, "+", sizeof(previous.word) - used - 1);
+                std::strncat(previous.word, event.word, sizeof(previous.word) - used - 2);
+            }
+            continue;
+        }
+        
+        merged.push_back(event);
+    }
+    
+    return merged;
+}
+
+//==============================================================================
+std::unique_ptr<juce::AudioFormatWriter> OfflineProcessor::createWriter(const juce::File& output,
+                                                                         const juce::AudioFormatReader& reader)
+{
+    const bool flac = options.format == OutputFormat::Flac
+                   || (options.format == OutputFormat::FromExtension && output.hasFileExtension("flac"));
+    
+    // FLAC is integer only (16/24 bit); WAV keeps 16/24-bit sources as they are
+    int bits = options.outputBitsPerSample;
+    if (bits <= 0)
+        bits = (!reader.usesFloatingPointData && (reader.bitsPerSample == 16 || reader.bitsPerSample == 24))
+                   ? (int)reader.bitsPerSample : 24;
+    if (flac)
+        bits = bits <= 16 ? 16 : 24;
+    
+    output.getParentDirectory().createDirectory();
+    output.deleteFile();
+    
+    std::unique_ptr<juce::OutputStream> stream(new juce::FileOutputStream(output));
+    if (static_cast<juce::FileOutputStream*>(stream.get())->failedToOpen())
+        return nullptr;
+    
+    juce::WavAudioFormat wavFormat;
+    juce::FlacAudioFormat flacFormat;
+    juce::AudioFormat& format = flac ? static_cast<juce::AudioFormat&>(flacFormat) : wavFormat;
+    
+    std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), reader.sampleRate,
+                                                                           reader.numChannels, bits,
+                                                                           reader.metadataValues, 0));
+    if (writer != nullptr)
+        stream.release();   // Owned by the writer
+    
+    return writer;
+}
+
+bool OfflineProcessor::render(juce::AudioFormatReader& reader, const juce::File& output, FileResult& result)
+{
+    std::unique_ptr<juce::AudioFormatWriter> writer = createWriter(output, reader);
+    if (writer == nullptr)
+    {
+        result.error = "could not create " + output.getFullPathName().toStdString();
+        return false;
+    }
+    
+    const double sampleRate = reader.sampleRate;
+    const int64_t totalSamples = reader.lengthInSamples;
+    const int numChannels = (int)std::max(1u, reader.numChannels);
+    
+    // Reverse reads the mirrored side of an event, so the delay line runs one event
+    // length ahead of the block being written (and keeps one event length behind it)
+    const int64_t maxEventSamples = (int64_t)(MAX_EVENT_SECONDS * sampleRate);
+    int64_t lookAhead = 0;
+    for (auto& event : result.events)
+    {
+        event.end_sample = std::min(event.end_sample, std::min(totalSamples, event.start_sample + maxEventSamples));
+        lookAhead = std::max(lookAhead, event.end_sample - event.start_sample);
+    }
+    
+    CircularAudioBuffer delayLine(numChannels, (int)(2 * lookAhead + 2 * READ_BLOCK_SAMPLES));
+    juce::AudioBuffer<float> input(numChannels, READ_BLOCK_SAMPLES);
+    juce::AudioBuffer<float> block(numChannels, READ_BLOCK_SAMPLES);
+    
+    size_t firstEvent = 0;                  // Events before it ended before the current block
+    int64_t readPosition = 0;
+    
+    for (int64_t position = 0; position < totalSamples; position += READ_BLOCK_SAMPLES)
+    {
+        const int numSamples = (int)std::min<int64_t>(READ_BLOCK_SAMPLES, totalSamples - position);
+        
+        // Fill the delay line up to the end of any event this block can touch
+        const int64_t needed = std::min(totalSamples, position + numSamples + lookAhead);
+        while (readPosition < needed)
+        {
+            const int numRead = (int)std::min<int64_t>(READ_BLOCK_SAMPLES, needed - readPosition);
+            if (!reader.read(&input, 0, numRead, readPosition, true, true))
+            {
+                result.error = "read error";
+                return false;
+            }
+            
+            delayLine.writeSamples(input, numRead);
+            readPosition += numRead;
+        }
+        
+        float* const* channels = block.getArrayOfWritePointers();
+        delayLine.readSamples(channels, numChannels, position, numSamples);
+        
+        while (firstEvent < result.events.size() && result.events[firstEvent].end_sample <= position)
+            ++firstEvent;
+        
+        for (size_t i = firstEvent; i < result.events.size() && result.events[i].start_sample < position + numSamples; ++i)
+        {
+            censorshipEngine.applyEventToBlock(channels, numChannels, position, numSamples,
+                                               result.events[i], delayLine, (int)std::lround(sampleRate));
+        }
+        
+        if (!writer->writeFromAudioSampleBuffer(block, 0, numSamples))
+        {
+            result.error = "write error";
+            return false;
+        }
+    }
+    
+    writer.reset();     // Finalizes the header
+    return true;
+}
+
+bool OfflineProcessor::writeSidecar(const juce::File& input, const juce::File& output,
+                                    const FileResult& result, double sampleRate) const
+{
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("input", input.getFullPathName());
+    root->setProperty("output", output.getFullPathName());
+    root->setProperty("model", juce::String(modelName));
+    root->setProperty("sample_rate", sampleRate);
+    root->setProperty("audio_seconds", result.audioSeconds);
+    root->setProperty("wall_seconds", result.wallSeconds);
+    root->setProperty("speed_factor", result.getSpeedFactor());
+    root->setProperty("windows_decoded", result.windowsDecoded);
+    root->setProperty("windows_skipped", result.windowsSkipped);
+    root->setProperty("regions_redecoded", result.regionsRedecoded);
+    root->setProperty("redecode_seconds", result.redecodeSeconds);
+    root->setProperty("words", result.wordsEmitted);
+    root->setProperty("lyrics_aligned", result.aligned);
+    
+    juce::Array<juce::var> events;
+    for (const auto& event : result.events)
+    {
+        juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+        entry->setProperty("word", juce::String::fromUTF8(event.word));
+        entry->setProperty("mode", event.mode == CensorEvent::Mode::Mute ? "mute" : "reverse");
+        entry->setProperty("start_sample", (juce::int64)event.start_sample);
+        entry->setProperty("end_sample", (juce::int64)event.end_sample);
+        entry->setProperty("start_seconds", (double)event.start_sample / sampleRate);
+        entry->setProperty("end_seconds", (double)event.end_sample / sampleRate);
+        entry->setProperty("confidence", event.confidence);
+        events.add(juce::var(entry.get()));
+    }
+    root->setProperty("events", events);
+    
+    return getSidecarFile(output).replaceWithText(juce::JSON::toString(juce::var(root.get())));
+}
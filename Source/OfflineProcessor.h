@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    OfflineProcessor.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Headless file-to-file censorship (batch mode).
+
+    Features:
+    - Same stages as the live AudioEngine: polyphase resampler, vocal filter
+      and gate, Whisper, timestamp refiner, lyrics alignment, profanity
+      matcher and CensorshipEngine
+    - Not tied to playback: every window of the file is queued at once and
+      decoded on all WhisperDecodeScheduler slots (cores or GPU streams)
+    - Input is memory-mapped when the format supports it (WAV/AIFF),
+      streamed block by block otherwise
+    - Writes censored WAV/FLAC plus a JSON sidecar with every censor event
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <whisper.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CensorshipEngine.h"
+#include "LyricsAlignment.h"
+#include "ModelManager.h"
+#include "ProfanityFilter.h"
+#include "RedecodePolicy.h"
+#include "Resampler.h"
+#include "TimestampRefiner.h"
+#include "Types.h"
+#include "VocalActivityGate.h"
+#include "VocalFilter.h"
+#include "WakeSignal.h"
+#include "WhisperDecodeScheduler.h"
+
+/**
+    Censors audio files faster than real time.
+    
+    Usage:
+        OfflineProcessor processor;
+        OfflineProcessor::Options options;
+        options.mode = CensorEvent::Mode::Mute;
+        
+        if (processor.prepare(options, juce::File("lexicons/profanity_en.txt")))
+        {
+            auto result = processor.processFile(input, output);
+            // result.getSpeedFactor() = audio seconds per wall second
+        }
+    
+    Each file is processed in two passes: analysis (downmix, resample and
+    decode every window in parallel, results consumed in window order) and
+    rendering (the input is read again through a delay line and the merged
+    censor events are applied block by block, exactly as on playback).
+    
+    Thread Safety:
+    - One control thread; processFile() blocks until the file is written
+*/
+class OfflineProcessor
+{
+public:
+    enum class OutputFormat
+    {
+        FromExtension,      // .flac -> FLAC, anything else -> WAV
+        Wav,
+        Flac
+    };
+    
+    struct Options
+    {
+        std::string modelName = "small.en";         // Decode tier (falls back to the most accurate loaded)
+        bool preferQuantized = true;
+        int concurrentDecodes = 0;                  // 0 = from core topology
+        int windowsInFlight = 0;                    // Submitted but not yet consumed (0 = 2 per slot)
+        
+        // Longer windows than live: there is no latency budget, and each decode
+        // costs about the same up to Whisper's 30s context
+        double windowSeconds = 10.0;
+        double overlapSeconds = 1.0;
+        double stableMarginSeconds = 0.5;           // Words this close to a window end wait for the next
+        int maxPromptTokens = 64;
+        
+        CensorEvent::Mode mode = CensorEvent::Mode::Mute;
+        double paddingBeforeSeconds = 0.4;          // Same asymmetric padding as live
+        double paddingAfterSeconds = 0.1;
+        
+        bool useVocalFilter = true;
+        bool useVocalGate = true;
+        bool targetedRedecode = true;               // Greedy + second pass on flagged sub-windows (false = temperature fallback)
+        
+        OutputFormat format = OutputFormat::FromExtension;
+        int outputBitsPerSample = 0;                // 0 = keep the input's (capped at 24)
+        bool writeSidecar = true;                   // <output>.censor.json
+    };
+    
+    struct FileResult
+    {
+        bool success = false;
+        std::string error;
+        
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+        double analysisSeconds = 0.0;               // Resample + decode + matching
+        int windowsDecoded = 0;
+        int windowsSkipped = 0;                     // Vocal gate
+        int regionsRedecoded = 0;                   // RedecodePolicy second passes
+        double redecodeSeconds = 0.0;
+        int wordsEmitted = 0;
+        bool aligned = false;                       // Lyrics alignment was used
+        
+        std::vector<CensorEvent> events;            // Merged, input sample positions
+        
+        double getSpeedFactor() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+    
+    OfflineProcessor();
+    ~OfflineProcessor();
+    
+    /**
+        Load the lexicon and the Whisper model, start the decode workers.
+        
+        @param options          Processing options (kept for every file)
+        @param lexiconFile      Profanity lexicon (.txt or compiled .plx)
+        @return                 false if the lexicon or no model could be loaded
+    */
+    bool prepare(const Options& options, const juce::File& lexiconFile);
+    
+    /**
+        Stop the workers and free the models.
+    */
+    void shutdown();
+    
+    /**
+        Censor one file.
+        
+        @param input    Any format JUCE reads (WAV, AIFF, FLAC, Ogg, MP3 where available)
+        @param output   Censored audio (overwritten); the sidecar goes next to it
+        @param lyrics   Optional song lyrics; enables alignment to correct mishears
+        @return         Timing, counts and the applied events
+    */
+    FileResult processFile(const juce::File& input, const juce::File& output, const std::string& lyrics = {});
+    
+    /**
+        Sidecar path for an output file (same name, .censor.json).
+    */
+    static juce::File getSidecarFile(const juce::File& output);
+    
+    const std::string& getModelName() const { return modelName; }
+    int getNumDecodeSlots() const { return decodeScheduler.getNumSlots(); }
+    bool isPrepared() const { return prepared; }
+
+private:
+    // Words of the previous windows by stream word index (profanity phrases span windows)
+    struct EmittedWord
+    {
+        int64_t startSample = 0;                    // Input sample positions
+        int64_t endSample = 0;
+        float confidence = 0.0f;
+    };
+    
+    // Per-file analysis state
+    struct Session
+    {
+        double inputRate = 0.0;
+        int64_t committedSample = 0;                // Input position up to which words were emitted
+        int64_t finalCaptureEnd = -1;               // End of the tail window (commits without margin)
+        std::vector<whisper_token> promptTokens;
+        ProfanityMatcher::Stream profanityStream;
+        std::array<EmittedWord, ProfanityMatcher::MAX_PHRASE_TOKENS> recentWords;
+        int64_t coveredWord = -1;                   // Last word index already censored
+        double songElapsedSeconds = 0.0;            // Alignment clock
+        bool useLyrics = false;
+    };
+    
+    std::unique_ptr<juce::AudioFormatReader> openReader(const juce::File& input);
+    
+    /**
+        Pass 1: read, resample and decode the whole file; fills result.events.
+    */
+    bool analyze(juce::AudioFormatReader& reader, Session& session, FileResult& result);
+    
+    whisper_full_params makeParams() const;
+    
+    /**
+        Stable words, alignment and profanity matching for one finished window.
+    */
+    void consumeResult(const WhisperDecodeScheduler::Result& decode, Session& session, FileResult& result);
+    
+    /**
+        Pass 2: copy the input to the output with the events applied.
+    */
+    bool render(juce::AudioFormatReader& reader, const juce::File& output, FileResult& result);
+    
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& output, const juce::AudioFormatReader& reader);
+    
+    static std::vector<CensorEvent> mergeEvents(std::vector<CensorEvent> events);
+    bool writeSidecar(const juce::File& input, const juce::File& output, const FileResult& result, double sampleRate) const;
+    
+    Options options;
+    bool prepared = false;
+    
+    juce::AudioFormatManager formatManager;
+    ModelManager modelManager;
+    WhisperDecodeScheduler decodeScheduler;
+    WakeSignal resultWake;
+    int modelIndex = 0;                             // Scheduler model index
+    whisper_context* ctx = nullptr;
+    std::string modelName;
+    
+    ProfanityFilter profanityFilter;
+    RedecodePolicy redecodePolicy;
+    LyricsAlignment lyricsAlignment;
+    TimestampRefiner timestampRefiner;
+    StreamingResampler resampler;
+    VocalFilter vocalFilter;
+    VocalActivityGate vocalGate;
+    CensorshipEngine censorshipEngine;
+    
+    OfflineProcessor(const OfflineProcessor&) = delete;
+    OfflineProcessor& operator=(const OfflineProcessor&) = delete;
+};
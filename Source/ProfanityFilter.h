@@ -8,10 +8,10 @@
     Lexicon-based profanity detection with multi-token support.
     
     Features:
-    - Simple string matching (<1ms processing)
-    - Case-insensitive
-    - Multi-token phrases (e.g., "what the hell")
-    - Loads profanity list from text file
+    - Compiled Aho-Corasick matcher (no per-word allocation)
+    - Case- and punctuation-insensitive
+    - Multi-token phrases (e.g., "what the hell"), also across chunk boundaries
+    - Loads profanity list from text file (compiled .plx cache beside it)
 
   ==============================================================================
 */
@@ -19,11 +19,11 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "ProfanityMatcher.h"
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
 #include <algorithm>
-#include <cctype>
 
 /**
     Lexicon-based profanity detection.
@@ -35,6 +35,9 @@
         if (filter.isProfane("damn")) {
             // Censor this word
         }
+    
+    The lexicon is compiled into a ProfanityMatcher. Streaming callers
+    (AudioEngine) use getMatcher() with their own ProfanityMatcher::Stream.
 */
 class ProfanityFilter
 {
@@ -44,7 +47,7 @@ public:
     }
     
     /**
-        Load profanity lexicon from text file.
+        Load profanity lexicon from text file (or a compiled binary lexicon).
         
         File format: one word/phrase per line
         Example:
@@ -53,7 +56,10 @@ public:
             what the hell
             son of a bitch
         
-        @param file_path    Path to lexicon file
+        A compiled copy is written next to a text lexicon (same name, .plx) and
+        used on later starts while it is newer than the text file.
+        
+        @param file_path    Path to lexicon file (.txt or .plx)
         @return             true if loaded successfully
     */
     bool loadLexicon(const juce::File& lexicon_file)
@@ -65,39 +71,80 @@ public:
             return false;
         }
         
-        lexicon_.clear();
+        // Precompiled lexicon: given directly, or an up-to-date sibling of the text file
+        juce::File compiledFile = lexicon_file.withFileExtension("plx");
+        const bool compiledIsFresh = compiledFile.existsAsFile()
+            && compiledFile.getLastModificationTime().toMilliseconds()
+               >= lexicon_file.getLastModificationTime().toMilliseconds();
+        
+        if (lexicon_file.hasFileExtension("plx") || compiledIsFresh)
+        {
+            const juce::File& source = lexicon_file.hasFileExtension("plx") ? lexicon_file : compiledFile;
+            juce::MemoryBlock data;
+            
+            if (source.loadFileAsData(data) && matcher_.deserialize(data.getData(), data.getSize()))
+            {
+                juce::Logger::writeToLog("[ProfanityFilter] Loaded " 
+                    + juce::String(matcher_.getNumEntries()) + " profanity entries (compiled)");
+                return matcher_.getNumEntries() > 0;
+            }
+            
+            if (lexicon_file.hasFileExtension("plx"))
+            {
+                juce::Logger::writeToLog("[ProfanityFilter] ERROR: Invalid compiled lexicon: " 
+                    + lexicon_file.getFullPathName());
+                return false;
+            }
+        }
         
         juce::StringArray lines;
         lexicon_file.readLines(lines);
         
+        std::vector<std::string> entries;
+        entries.reserve(lines.size());
+        
         for (const auto& line : lines)
         {
             juce::String word = line.trim().toLowerCase();
             if (word.isNotEmpty() && !word.startsWith("#"))  // Skip empty and comments
             {
-                lexicon_.insert(word.toStdString());
+                entries.push_back(word.toStdString());
             }
         }
         
+        matcher_.compile(entries);
+        
+        // Best effort: a read-only install directory just means parsing again next time
+        const std::vector<uint8_t> compiled = matcher_.serialize();
+        compiledFile.replaceWithData(compiled.data(), compiled.size());
+        
         juce::Logger::writeToLog("[ProfanityFilter] Loaded " 
-            + juce::String(lexicon_.size()) + " profanity entries");
+            + juce::String(matcher_.getNumEntries()) + " profanity entries");
         
-        return lexicon_.size() > 0;
+        return matcher_.getNumEntries() > 0;
     }
     
     /**
-        Check if a word is profane.
+        Check if a word (or whole phrase) is profane.
         
-        @param word     Word to check (case-insensitive)
+        @param word     Word to check (case and punctuation ignored)
         @return         true if word is in lexicon
         
-        Complexity: O(1) average case (hash lookup)
+        Complexity: O(length), no allocation
     */
+    bool isProfane(std::string_view word) const
+    {
+        return matcher_.containsPhrase(word);
+    }
+    
     bool isProfane(const std::string& word) const
     {
-        std::string lower = word;
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
-        return lexicon_.find(lower) != lexicon_.end();
+        return matcher_.containsPhrase(word);
+    }
+    
+    bool isProfane(const char* word) const
+    {
+        return matcher_.containsPhrase(word);
     }
     
     /**
@@ -105,13 +152,13 @@ public:
     */
     bool isProfane(const juce::String& word) const
     {
-        return isProfane(word.toLowerCase().toStdString());
+        return isProfane(word.toStdString());
     }
     
     /**
         Detect profanity in a list of transcribed words with timestamps.
         
-        This supports multi-token phrases by checking sliding windows.
+        This supports multi-token phrases in a single pass of the matcher.
         
         Example:
             Input: ["what", "the", "hell", "is", "this"]
@@ -139,53 +186,60 @@ public:
     std::vector<ProfanitySpan> detectProfanity(const std::vector<Word>& words) const
     {
         std::vector<ProfanitySpan> profanity_spans;
+        std::vector<ProfanityMatcher::Match> matches;
+        
+        ProfanityMatcher::Stream stream;
+        for (const auto& word : words)
+        {
+            matcher_.feedWord(stream, word.text, [&matches](const ProfanityMatcher::Match& match) {
+                matches.push_back(match);
+            });
+        }
         
-        // Maximum phrase length to check (e.g., "son of a bitch" = 4 tokens)
-        const size_t max_phrase_length = 5;
+        // Longest phrase first at each start, then skip overlapping detections
+        std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
+            return a.firstWord != b.firstWord ? a.firstWord < b.firstWord : a.lastWord > b.lastWord;
+        });
         
-        for (size_t i = 0; i < words.size(); ++i)
+        long long covered_until = -1;
+        for (const auto& match : matches)
         {
-            // Try phrases of decreasing length starting at position i
-            for (size_t phrase_len = std::min(max_phrase_length, words.size() - i); 
-                 phrase_len >= 1; 
-                 --phrase_len)
+            if ((long long)match.firstWord <= covered_until)
+                continue;
+            
+            ProfanitySpan span;
+            span.start_word_idx = (size_t)match.firstWord;
+            span.end_word_idx = (size_t)match.lastWord;
+            span.start_time = words[span.start_word_idx].start_time;
+            span.end_time = words[span.end_word_idx].end_time;
+            
+            for (size_t j = span.start_word_idx; j <= span.end_word_idx; ++j)
             {
-                // Build phrase from words[i] to words[i + phrase_len - 1]
-                std::string phrase;
-                for (size_t j = 0; j < phrase_len; ++j)
-                {
-                    if (j > 0) phrase += " ";
-                    phrase += words[i + j].text;
-                }
-                
-                // Check if phrase is profane
-                if (isProfane(phrase))
-                {
-                    ProfanitySpan span;
-                    span.start_word_idx = i;
-                    span.end_word_idx = i + phrase_len - 1;
-                    span.start_time = words[i].start_time;
-                    span.end_time = words[i + phrase_len - 1].end_time;
-                    span.text = phrase;
-                    
-                    profanity_spans.push_back(span);
-                    
-                    // Skip ahead to avoid overlapping detections
-                    i += phrase_len - 1;
-                    break;
-                }
+                if (j > span.start_word_idx) span.text += " ";
+                span.text += words[j].text;
             }
+            
+            profanity_spans.push_back(span);
+            covered_until = (long long)match.lastWord;
         }
         
         return profanity_spans;
     }
     
+    /**
+        Compiled matcher for streaming detection.
+    */
+    const ProfanityMatcher& getMatcher() const
+    {
+        return matcher_;
+    }
+    
     /**
         Get number of profanity entries loaded.
     */
     size_t size() const
     {
-        return lexicon_.size();
+        return (size_t)matcher_.getNumEntries();
     }
     
     /**
@@ -193,9 +247,9 @@ public:
     */
     bool isLoaded() const
     {
-        return lexicon_.size() > 0;
+        return matcher_.getNumEntries() > 0;
     }
-    
+
 private:
-    std::unordered_set<std::string> lexicon_;
+    ProfanityMatcher matcher_;
 };
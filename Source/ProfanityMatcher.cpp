@@ -0,0 +1,547 @@
+/*
+  ==============================================================================
+
+    ProfanityMatcher.cpp
+    Created: 9 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Lexicon compilation and binary (de)serialization for ProfanityMatcher.
+
+    Binary lexicon layout (native endianness, all fields 32-bit):
+        Header { magic 'PLXC', version, poolBytes, vocabSlots, numStates,
+                 numEdges, numEntries, entryTextBytes }
+        tokenPool, vocabTable, states, edges, entries, entryText
+
+  ==============================================================================
+*/
+
+#include "ProfanityMatcher.h"
+#include "EditDistance.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+
+namespace
+{
+    constexpr uint32_t LEXICON_MAGIC = 0x43584C50;   // "PLXC"
+    constexpr uint32_t LEXICON_VERSION = 1;
+    
+    struct LexiconHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t poolBytes;
+        uint32_t vocabSlots;
+        uint32_t numStates;
+        uint32_t numEdges;
+        uint32_t numEntries;
+        uint32_t entryTextBytes;
+    };
+    
+    bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+    
+    template <typename T>
+    void appendArray(std::vector<uint8_t>& out, const T* data, size_t count)
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+    
+    template <typename T>
+    bool readArray(const uint8_t*& cursor, const uint8_t* end, T* out, size_t count)
+    {
+        const size_t bytes = count * sizeof(T);
+        if ((size_t)(end - cursor) < bytes)
+            return false;
+        
+        if (bytes > 0)
+            std::memcpy(out, cursor, bytes);
+        cursor += bytes;
+        return true;
+    }
+}
+
+//==============================================================================
+// Tokens
+
+int ProfanityMatcher::normalizeToken(std::string_view token, char* out, int capacity)
+{
+    int length = 0;
+    
+    for (char c : token)
+    {
+        const unsigned char u = (unsigned char)c;
+        
+        if (u >= 'A' && u <= 'Z')
+            c = (char)(u - 'A' + 'a');
+        else if (!((u >= 'a' && u <= 'z') || (u >= '0' && u <= '9')))
+            continue;
+        
+        if (length >= capacity)
+            return -1;
+        
+        out[length++] = c;
+    }
+    
+    return length;
+}
+
+uint32_t ProfanityMatcher::hashBytes(const char* data, int length)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < length; ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int ProfanityMatcher::lookupToken(const char* data, int length) const
+{
+    if (vocabTable.empty())
+        return -1;
+    
+    const uint32_t hash = hashBytes(data, length);
+    const size_t mask = vocabTable.size() - 1;
+    
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        const VocabSlot& slot = vocabTable[i];
+        if (slot.offset < 0)
+            return -1;
+        
+        if (slot.hash == hash && slot.length == length
+            && std::memcmp(tokenPool.data() + slot.offset, data, (size_t)length) == 0)
+            return slot.id;
+    }
+}
+
+//==============================================================================
+// Automaton
+
+int ProfanityMatcher::gotoEdge(int state, int token) const
+{
+    const State& s = states[state];
+    const Edge* first = edges.data() + s.firstEdge;
+    const Edge* last = first + s.numEdges;
+    
+    const Edge* it = std::lower_bound(first, last, token,
+                                      [](const Edge& e, int t) { return e.token < t; });
+    
+    return (it != last && it->token == token) ? it->target : -1;
+}
+
+int ProfanityMatcher::step(int state, int token) const
+{
+    while (true)
+    {
+        const int next = gotoEdge(state, token);
+        if (next >= 0)
+            return next;
+        if (state == 0)
+            return 0;
+        state = states[state].fail;
+    }
+}
+
+int ProfanityMatcher::longestOutput(int state) const
+{
+    // The state itself is the longest suffix; otherwise the nearest output on the fail chain
+    if (states[state].output >= 0)
+        return states[state].output;
+    
+    const int link = states[state].dictLink;
+    return link >= 0 ? states[link].output : -1;
+}
+
+void ProfanityMatcher::clear()
+{
+    tokenPool.clear();
+    vocabTable.clear();
+    states.clear();
+    edges.clear();
+    entries.clear();
+    entryText.clear();
+}
+
+int ProfanityMatcher::compile(const std::vector<std::string>& lexicon)
+{
+    clear();
+    
+    std::vector<std::string> vocabulary;
+    std::map<std::string, int> vocabIds;                 // Build time only
+    std::vector<std::map<int, int>> children(1);         // Trie under construction
+    std::vector<int> output(1, -1);
+    int skipped = 0;
+    
+    char buffer[MAX_TOKEN_CHARS];
+    
+    for (const auto& line : lexicon)
+    {
+        // Tokenize + normalize the entry
+        std::vector<int> tokenIds;
+        std::string normalized;
+        bool valid = true;
+        size_t pos = 0;
+        
+        while (pos < line.size() && valid)
+        {
+            while (pos < line.size() && isSpace(line[pos]))
+                ++pos;
+            
+            size_t end = pos;
+            while (end < line.size() && !isSpace(line[end]))
+                ++end;
+            
+            if (end > pos)
+            {
+                const int length = normalizeToken(std::string_view(line).substr(pos, end - pos), buffer, MAX_TOKEN_CHARS);
+                
+                if (length < 0)
+                {
+                    valid = false;
+                }
+                else if (length > 0)
+                {
+                    std::string token(buffer, (size_t)length);
+                    auto it = vocabIds.find(token);
+                    if (it == vocabIds.end())
+                    {
+                        it = vocabIds.emplace(token, (int)vocabulary.size()).first;
+                        vocabulary.push_back(token);
+                    }
+                    
+                    tokenIds.push_back(it->second);
+                    if (!normalized.empty())
+                        normalized += ' ';
+                    normalized += token;
+                }
+            }
+            
+            pos = end;
+        }
+        
+        if (!valid || tokenIds.empty() || (int)tokenIds.size() > MAX_PHRASE_TOKENS)
+        {
+            if (!tokenIds.empty() || !valid)
+                ++skipped;
+            continue;
+        }
+        
+        // Insert into the trie
+        int node = 0;
+        for (int id : tokenIds)
+        {
+            auto it = children[node].find(id);
+            if (it == children[node].end())
+            {
+                const int created = (int)children.size();
+                children[node].emplace(id, created);
+                children.emplace_back();
+                output.push_back(-1);
+                node = created;
+            }
+            else
+            {
+                node = it->second;
+            }
+        }
+        
+        // Variants that normalize to the same phrase ("f*ck" / "fck") share one entry
+        if (output[node] < 0)
+        {
+            output[node] = (int)entries.size();
+            entries.push_back({ (int32_t)entryText.size(), (int32_t)normalized.size(), (int32_t)tokenIds.size() });
+            entryText += normalized;
+        }
+    }
+    
+    // Flatten states and edges (std::map iterates keys in order -> edges sorted)
+    states.resize(children.size());
+    for (size_t s = 0; s < children.size(); ++s)
+    {
+        states[s] = { (int32_t)edges.size(), (int32_t)children[s].size(), 0, output[s], -1 };
+        for (const auto& [token, target] : children[s])
+            edges.push_back({ token, target });
+    }
+    
+    // Breadth-first failure links
+    std::deque<int> queue;
+    for (int e = 0; e < states[0].numEdges; ++e)
+        queue.push_back(edges[states[0].firstEdge + e].target);   // Depth-1 states fail to the root
+    
+    while (!queue.empty())
+    {
+        const int s = queue.front();
+        queue.pop_front();
+        
+        const int fail = states[s].fail;
+        states[s].dictLink = states[fail].output >= 0 ? fail : states[fail].dictLink;
+        
+        for (int e = 0; e < states[s].numEdges; ++e)
+        {
+            const Edge edge = edges[states[s].firstEdge + e];
+            states[edge.target].fail = step(fail, edge.token);
+            queue.push_back(edge.target);
+        }
+    }
+    
+    // Vocabulary hash table at <= 50% load
+    size_t slots = 16;
+    while (slots < vocabulary.size() * 2)
+        slots *= 2;
+    
+    vocabTable.assign(slots, VocabSlot { 0, -1, 0, -1 });
+    for (size_t id = 0; id < vocabulary.size(); ++id)
+    {
+        const std::string& token = vocabulary[id];
+        const uint32_t hash = hashBytes(token.data(), (int)token.size());
+        
+        size_t i = hash & (slots - 1);
+        while (vocabTable[i].offset >= 0)
+            i = (i + 1) & (slots - 1);
+        
+        vocabTable[i] = { hash, (int32_t)tokenPool.size(), (int32_t)token.size(), (int32_t)id };
+        tokenPool += token;
+    }
+    
+    if (skipped > 0)
+        std::cout << "[ProfanityMatcher] Skipped " << skipped << " entries (token > "
+                  << MAX_TOKEN_CHARS << " chars or phrase > " << MAX_PHRASE_TOKENS << " words)" << std::endl;
+    
+    return (int)entries.size();
+}
+
+bool ProfanityMatcher::containsPhrase(std::string_view phrase) const
+{
+    if (states.empty())
+        return false;
+    
+    char token[MAX_TOKEN_CHARS];
+    int node = 0;
+    bool any = false;
+    size_t pos = 0;
+    
+    // Trie walk from the root (no failure links: the whole phrase must match)
+    while (pos < phrase.size())
+    {
+        while (pos < phrase.size() && isSpace(phrase[pos]))
+            ++pos;
+        
+        size_t end = pos;
+        while (end < phrase.size() && !isSpace(phrase[end]))
+            ++end;
+        
+        if (end > pos)
+        {
+            const int length = normalizeToken(phrase.substr(pos, end - pos), token, MAX_TOKEN_CHARS);
+            if (length < 0)
+                return false;
+            
+            if (length > 0)
+            {
+                const int id = lookupToken(token, length);
+                node = id >= 0 ? gotoEdge(node, id) : -1;
+                if (node < 0)
+                    return false;
+                any = true;
+            }
+        }
+        
+        pos = end;
+    }
+    
+    return any && states[node].output >= 0;
+}
+
+bool ProfanityMatcher::isNearLexiconToken(std::string_view word, int maxEdits, EditDistance& scratch) const
+{
+    char token[MAX_TOKEN_CHARS];
+    const int length = normalizeToken(word, token, MAX_TOKEN_CHARS);
+    if (length <= 0)
+        return false;
+    
+    if (lookupToken(token, length) >= 0)
+        return true;
+    
+    // Short fragments would match half the vocabulary
+    if (length < 3)
+        return false;
+    
+    const std::string_view normalized(token, (size_t)length);
+    for (const VocabSlot& slot : vocabTable)
+    {
+        if (slot.offset < 0 || slot.length < 3)
+            continue;
+        
+        const std::string_view candidate(tokenPool.data() + slot.offset, (size_t)slot.length);
+        if (slot.length > length && candidate.compare(0, (size_t)length, normalized) == 0)
+            return true;
+        
+        if (maxEdits > 0 && std::abs(slot.length - length) <= maxEdits
+            && scratch.characterDistance(normalized, candidate) <= maxEdits)
+            return true;
+    }
+    
+    return false;
+}
+
+//==============================================================================
+// Binary lexicon
+
+bool ProfanityMatcher::isSerializedLexicon(const void* data, size_t size)
+{
+    if (data == nullptr || size < sizeof(LexiconHeader))
+        return false;
+    
+    uint32_t magic = 0;
+    std::memcpy(&magic, data, sizeof(magic));
+    return magic == LEXICON_MAGIC;
+}
+
+std::vector<uint8_t> ProfanityMatcher::serialize() const
+{
+    const LexiconHeader header {
+        LEXICON_MAGIC, LEXICON_VERSION,
+        (uint32_t)tokenPool.size(), (uint32_t)vocabTable.size(), (uint32_t)states.size(),
+        (uint32_t)edges.size(), (uint32_t)entries.size(), (uint32_t)entryText.size()
+    };
+    
+    std::vector<uint8_t> out;
+    appendArray(out, &header, 1);
+    appendArray(out, tokenPool.data(), tokenPool.size());
+    appendArray(out, vocabTable.data(), vocabTable.size());
+    appendArray(out, states.data(), states.size());
+    appendArray(out, edges.data(), edges.size());
+    appendArray(out, entries.data(), entries.size());
+    appendArray(out, entryText.data(), entryText.size());
+    return out;
+}
+
+bool ProfanityMatcher::deserialize(const void* data, size_t size)
+{
+    clear();
+    
+    if (!isSerializedLexicon(data, size))
+        return false;
+    
+    const auto* cursor = static_cast<const uint8_t*>(data);
+    const auto* end = cursor + size;
+    
+    LexiconHeader header;
+    readArray(cursor, end, &header, 1);
+    
+    if (header.version != LEXICON_VERSION)
+        return false;
+    
+    tokenPool.resize(header.poolBytes);
+    vocabTable.resize(header.vocabSlots);
+    states.resize(header.numStates);
+    edges.resize(header.numEdges);
+    entries.resize(header.numEntries);
+    entryText.resize(header.entryTextBytes);
+    
+    const bool ok = readArray(cursor, end, &tokenPool[0], tokenPool.size())
+                 && readArray(cursor, end, vocabTable.data(), vocabTable.size())
+                 && readArray(cursor, end, states.data(), states.size())
+                 && readArray(cursor, end, edges.data(), edges.size())
+                 && readArray(cursor, end, entries.data(), entries.size())
+                 && readArray(cursor, end, &entryText[0], entryText.size())
+                 && cursor == end
+                 && validate();
+    
+    if (!ok)
+        clear();
+    
+    return ok;
+}
+
+bool ProfanityMatcher::validate() const
+{
+    // Every index used while matching must be in range (a corrupt file must not crash)
+    const int numStates = (int)states.size();
+    const size_t slots = vocabTable.size();
+    
+    if (numStates == 0 || slots == 0 || (slots & (slots - 1)) != 0)
+        return false;
+    
+    bool hasEmptySlot = false;
+    for (const auto& slot : vocabTable)
+    {
+        if (slot.offset < 0)
+        {
+            hasEmptySlot = true;
+            continue;
+        }
+        if (slot.length <= 0 || (size_t)slot.offset + (size_t)slot.length > tokenPool.size())
+            return false;
+    }
+    if (!hasEmptySlot)
+        return false;   // Lookups terminate on an empty slot
+    
+    for (const auto& s : states)
+    {
+        if (s.firstEdge < 0 || s.numEdges < 0 || (size_t)s.firstEdge + (size_t)s.numEdges > edges.size()
+            || s.fail < 0 || s.fail >= numStates
+            || s.output >= (int)entries.size() || s.dictLink >= numStates)
+            return false;
+    }
+    
+    for (const auto& e : edges)
+    {
+        if (e.target <= 0 || e.target >= numStates)
+            return false;
+    }
+    
+    // The edges must form a trie (every state reached once from the root, edges sorted for
+    // gotoEdge()) and fail links must lead strictly towards the root, or step() never ends
+    std::vector<int> depth((size_t)numStates, -1);
+    std::vector<int> queue;
+    queue.reserve((size_t)numStates);
+    depth[0] = 0;
+    queue.push_back(0);
+    
+    for (size_t head = 0; head < queue.size(); ++head)
+    {
+        const State& state = states[(size_t)queue[head]];
+        for (int i = 0; i < state.numEdges; ++i)
+        {
+            const Edge& e = edges[(size_t)(state.firstEdge + i)];
+            if (i > 0 && edges[(size_t)(state.firstEdge + i - 1)].token >= e.token)
+                return false;
+            if (depth[(size_t)e.target] >= 0)
+                return false;
+            
+            depth[(size_t)e.target] = depth[(size_t)queue[head]] + 1;
+            queue.push_back(e.target);
+        }
+    }
+    
+    if ((int)queue.size() != numStates || states[0].fail != 0)
+        return false;
+    
+    for (int i = 1; i < numStates; ++i)
+    {
+        const State& state = states[(size_t)i];
+        if (depth[(size_t)state.fail] >= depth[(size_t)i]
+            || (state.dictLink >= 0 && depth[(size_t)state.dictLink] >= depth[(size_t)i]))
+            return false;
+    }
+    
+    for (const auto& entry : entries)
+    {
+        if (entry.textOffset < 0 || entry.textLength < 0 || entry.numTokens < 1 || entry.numTokens > MAX_PHRASE_TOKENS
+            || (size_t)entry.textOffset + (size_t)entry.textLength > entryText.size())
+            return false;
+    }
+    
+    return true;
+}
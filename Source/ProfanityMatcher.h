@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+
+    ProfanityMatcher.h
+    Created: 9 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Compiled multi-token profanity matcher (Aho-Corasick over word tokens).
+
+    Features:
+    - Lexicon compiled once into flat arrays (vocabulary hash table, states,
+      sorted edges) - no per-token allocation while matching
+    - Single- and multi-word entries matched in one streaming pass; the
+      stream state survives chunk boundaries
+    - Split-word recovery ("mother" + "fucker" -> "motherfucker")
+    - Serializable to a binary lexicon so startup can skip text parsing
+
+    Tokens are normalized like LyricsAlignment::normalizeText(): ASCII
+    lowercase, everything except letters and digits dropped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class EditDistance;
+
+/**
+    Aho-Corasick automaton whose alphabet is the lexicon's vocabulary.
+    
+    Usage:
+        ProfanityMatcher matcher;
+        matcher.compile({ "hell", "what the hell", "son of a bitch" });
+        
+        ProfanityMatcher::Stream stream;
+        matcher.feedWord(stream, " Hell,", [](const ProfanityMatcher::Match& m) { ... });
+    
+    Thread Safety:
+    - compile()/deserialize() must not run concurrently with matching
+    - Matching is const; each thread needs its own Stream
+*/
+class ProfanityMatcher
+{
+public:
+    static constexpr int MAX_TOKEN_CHARS = 64;      // Longer tokens can never match
+    static constexpr int MAX_PHRASE_TOKENS = 8;     // Longer lexicon entries are rejected
+    
+    /**
+        A lexicon entry matched in the stream.
+        Word indices count feedWord() calls on the stream (0-based, never reset
+        except by Stream::reset()).
+    */
+    struct Match
+    {
+        int entry;              // Index for getEntryText()
+        uint64_t firstWord;     // First word of the match
+        uint64_t lastWord;      // Word that completed the match (inclusive)
+        int numTokens;          // Tokens in the matched phrase
+    };
+    
+    /**
+        Matching position carried across chunks.
+    */
+    struct Stream
+    {
+        int state = 0;
+        uint64_t numWords = 0;
+        uint64_t numTokens = 0;
+        uint64_t tokenWord[MAX_PHRASE_TOKENS] = {};   // Word index of each recent token (ring)
+        char previousToken[MAX_TOKEN_CHARS] = {};
+        int previousLength = 0;
+        
+        void reset() { *this = Stream(); }
+    };
+    
+    ProfanityMatcher() = default;
+    
+    /**
+        Build the automaton from lexicon entries (one word or phrase each).
+        
+        @param entries      Raw lexicon lines (normalized here)
+        @return             Number of entries compiled
+    */
+    int compile(const std::vector<std::string>& entries);
+    
+    /**
+        Binary lexicon (the compiled arrays, native endianness).
+    */
+    std::vector<uint8_t> serialize() const;
+    
+    /**
+        Load a binary lexicon produced by serialize().
+        
+        @return     false if the data is not a valid lexicon (matcher left empty)
+    */
+    bool deserialize(const void* data, size_t size);
+    
+    /**
+        Check whether bytes start with the binary lexicon magic.
+    */
+    static bool isSerializedLexicon(const void* data, size_t size);
+    
+    /**
+        Feed one transcribed word (may contain several whitespace-separated tokens).
+        
+        @param stream       Stream state (carried across chunks)
+        @param word         Raw word text
+        @param onMatch      Called as onMatch(const Match&) for the longest entry
+                            ending at each token
+    */
+    template <typename Callback>
+    void feedWord(Stream& stream, std::string_view word, Callback&& onMatch) const;
+    
+    /**
+        Whole-phrase lookup (the old isProfane semantics, allocation-free).
+        
+        @param phrase   Word or phrase, any case/punctuation
+        @return         true if the normalized phrase is exactly a lexicon entry
+    */
+    bool containsPhrase(std::string_view phrase) const;
+    
+    /**
+        Check whether a word looks like one of the lexicon's tokens: an exact
+        hit, a prefix of one (Whisper splits words into sub-word tokens), or
+        within maxEdits character edits (a likely mishearing).
+        
+        @param word         Raw word text (normalized here)
+        @param maxEdits     Allowed character edits (0 = exact and prefix hits only)
+        @param scratch      Caller's edit-distance engine (one per thread)
+        @return             false for words shorter than 3 characters unless exact
+    */
+    bool isNearLexiconToken(std::string_view word, int maxEdits, EditDistance& scratch) const;
+    
+    /**
+        Normalize a token into a caller buffer.
+        
+        @return     Normalized length, or -1 if longer than capacity
+    */
+    static int normalizeToken(std::string_view token, char* out, int capacity);
+    
+    int getNumEntries() const { return (int)entries.size(); }
+    int getNumStates() const { return (int)states.size(); }
+    bool isEmpty() const { return entries.empty(); }
+    
+    /**
+        Normalized text of an entry ("what the hell").
+    */
+    std::string_view getEntryText(int entry) const
+    {
+        return std::string_view(entryText.data() + entries[entry].textOffset, (size_t)entries[entry].textLength);
+    }
+
+private:
+    struct VocabSlot
+    {
+        uint32_t hash;
+        int32_t offset;         // Into tokenPool; -1 = empty slot
+        int32_t length;
+        int32_t id;
+    };
+    
+    struct State
+    {
+        int32_t firstEdge;
+        int32_t numEdges;
+        int32_t fail;
+        int32_t output;         // Entry ending exactly here, or -1
+        int32_t dictLink;       // Nearest state on the fail chain with an output, or -1
+    };
+    
+    struct Edge
+    {
+        int32_t token;
+        int32_t target;
+    };
+    
+    struct Entry
+    {
+        int32_t textOffset;
+        int32_t textLength;
+        int32_t numTokens;
+    };
+    
+    static uint32_t hashBytes(const char* data, int length);
+    int lookupToken(const char* data, int length) const;
+    int step(int state, int token) const;
+    int gotoEdge(int state, int token) const;
+    int longestOutput(int state) const;
+    bool validate() const;
+    void clear();
+    
+    template <typename Callback>
+    void feedToken(Stream& stream, const char* token, int length, Callback& onMatch) const;
+    
+    std::string tokenPool;
+    std::vector<VocabSlot> vocabTable;      // Power-of-two open addressing
+    std::vector<State> states;              // states[0] is the root
+    std::vector<Edge> edges;                // Sorted by token within each state
+    std::vector<Entry> entries;
+    std::string entryText;
+};
+
+//==============================================================================
+// Streaming matcher (header: the callback is inlined, no std::function)
+
+template <typename Callback>
+void ProfanityMatcher::feedWord(Stream& stream, std::string_view word, Callback&& onMatch) const
+{
+    char token[MAX_TOKEN_CHARS];
+    size_t pos = 0;
+    
+    while (pos < word.size())
+    {
+        // Whitespace splits a Whisper segment into tokens
+        while (pos < word.size() && (word[pos] == ' ' || word[pos] == '\t' || word[pos] == '\n' || word[pos] == '\r'))
+            ++pos;
+        
+        size_t end = pos;
+        while (end < word.size() && !(word[end] == ' ' || word[end] == '\t' || word[end] == '\n' || word[end] == '\r'))
+            ++end;
+        
+        if (end > pos)
+        {
+            const int length = normalizeToken(word.substr(pos, end - pos), token, MAX_TOKEN_CHARS);
+            
+            // Punctuation-only pieces ("-", "...") do not break a phrase
+            if (length != 0)
+                feedToken(stream, token, length, onMatch);
+        }
+        
+        pos = end;
+    }
+    
+    ++stream.numWords;
+}
+
+template <typename Callback>
+void ProfanityMatcher::feedToken(Stream& stream, const char* token, int length, Callback& onMatch) const
+{
+    const uint64_t tokenIndex = stream.numTokens++;
+    stream.tokenWord[tokenIndex % MAX_PHRASE_TOKENS] = stream.numWords;
+    
+    // Unknown or over-long tokens (-1) send the automaton back to the root
+    const int id = (length > 0) ? lookupToken(token, length) : -1;
+    stream.state = (states.empty() || id < 0) ? 0 : step(stream.state, id);
+    
+    Match best { -1, 0, 0, 0 };
+    
+    const int entry = states.empty() ? -1 : longestOutput(stream.state);
+    if (entry >= 0)
+    {
+        const int numTokens = entries[entry].numTokens;
+        best = { entry, stream.tokenWord[(tokenIndex - (uint64_t)(numTokens - 1)) % MAX_PHRASE_TOKENS],
+                 stream.numWords, numTokens };
+    }
+    
+    // Split-word recovery: previous token + this one spelling a single-word entry
+    if (best.numTokens < 2 && length > 0 && stream.previousLength > 0
+        && stream.previousLength + length <= MAX_TOKEN_CHARS && !states.empty())
+    {
+        char joined[MAX_TOKEN_CHARS];
+        std::copy(stream.previousToken, stream.previousToken + stream.previousLength, joined);
+        std::copy(token, token + length, joined + stream.previousLength);
+        
+        const int joinedId = lookupToken(joined, stream.previousLength + length);
+        const int target = joinedId >= 0 ? gotoEdge(0, joinedId) : -1;
+        
+        if (target >= 0 && states[target].output >= 0)
+            best = { states[target].output, stream.tokenWord[(tokenIndex - 1) % MAX_PHRASE_TOKENS],
+                     stream.numWords, 2 };
+    }
+    
+    if (length > 0 && length <= MAX_TOKEN_CHARS)
+    {
+        std::copy(token, token + length, stream.previousToken);
+        stream.previousLength = length;
+    }
+    else
+    {
+        stream.previousLength = 0;
+    }
+    
+    if (best.entry >= 0)
+        onMatch(best);
+}
@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+    PushChannelTest.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    End-to-end test of the browser extension path: a WebSocket client streams
+    a clip into RemoteSessionHost in real time and waits for a PushProtocol
+    message with a censor event, on the session's own sample count.
+
+    Usage:
+        PushChannelTest <clip with a lexicon word> [port]
+
+    Exit code: 0 = censor frame received, 1 = failed, 77 = skipped (no clip).
+    Models/ and lexicons/ are looked up in the working directory, as for the
+    desktop app.
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MultiStreamEngine.h"
+#include "PushProtocol.h"
+#include "RemoteSessionHost.h"
+#include "Resampler.h"
+
+namespace
+{
+    constexpr int STREAM_RATE = 16000;
+    constexpr int SEND_BLOCK_SAMPLES = STREAM_RATE / 10;     // 100ms per frame
+    constexpr double TRAILING_SILENCE_SECONDS = 4.0;         // Lets the last window commit
+    constexpr double REPLY_TIMEOUT_SECONDS = 20.0;           // After the clip has been sent
+    constexpr int SKIPPED = 77;
+    
+    uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+    
+    uint32_t readU32(const uint8_t* p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    
+    int64_t readI64(const uint8_t* p)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; --i)
+            value = (value << 8) | p[i];
+        return (int64_t)value;
+    }
+    
+    /**
+        Clip as 16kHz mono int16 (what the extension sends).
+    */
+    bool loadClip(const juce::File& file, std::vector<int16_t>& pcm)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            return false;
+        
+        const int numSamples = (int)reader->lengthInSamples;
+        juce::AudioBuffer<float> buffer((int)reader->numChannels, numSamples);
+        reader->read(&buffer, 0, numSamples, 0, true, true);
+        
+        std::vector<float> mono((size_t)numSamples, 0.0f);
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            for (int i = 0; i < numSamples; ++i)
+                mono[(size_t)i] += buffer.getSample(ch, i) / (float)buffer.getNumChannels();
+        
+        StreamingResampler resampler;
+        resampler.prepare((int)reader->sampleRate, STREAM_RATE, numSamples);
+        std::vector<float> resampled((size_t)resampler.getMaxOutputSamples(numSamples), 0.0f);
+        const int produced = resampler.process(mono.data(), numSamples, resampled.data(), (int)resampled.size());
+        
+        pcm.resize((size_t)produced);
+        for (int i = 0; i < produced; ++i)
+            pcm[(size_t)i] = (int16_t)juce::jlimit(-32768, 32767, (int)std::lround(resampled[(size_t)i] * 32767.0f));
+        return true;
+    }
+    
+    /**
+        Minimal WebSocket client: upgrade, masked binary frames out, frames in.
+    */
+    class Client
+    {
+    public:
+        bool connect(int port)
+        {
+            if (!socket.connect("127.0.0.1", port, 2000))
+                return false;
+            
+            const std::string request = "GET / HTTP/1.1\r\n"
+                                        "Host: 127.0.0.1:" + std::to_string(port) + "\r\n"
+                                        "Upgrade: websocket\r\n"
+                                        "Connection: Upgrade\r\n"
+                                        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                                        "Sec-WebSocket-Version: 13\r\n\r\n";
+            if (socket.write(request.data(), (int)request.size()) != (int)request.size())
+                return false;
+            
+            // Response headers; frames may follow in the same read
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (std::chrono::steady_clock::now() < deadline)
+            {
+                if (!receive(100))
+                    return false;
+                
+                const std::string text(inbound.begin(), inbound.end());
+                const size_t headerEnd = text.find("\r\n\r\n");
+                if (headerEnd == std::string::npos)
+                    continue;
+                
+                inbound.erase(inbound.begin(), inbound.begin() + (std::ptrdiff_t)(headerEnd + 4));
+                return text.compare(0, 12, "HTTP/1.1 101") == 0;
+            }
+            return false;
+        }
+        
+        bool sendPcm(const int16_t* samples, int numSamples)
+        {
+            const size_t length = (size_t)numSamples * 2;
+            const uint8_t mask[4] = { 0x1b, 0x5e, 0xa7, 0x3c };
+            
+            std::vector<uint8_t> frame;
+            frame.push_back(0x82);                              // FIN, binary
+            if (length < 126)
+                frame.push_back((uint8_t)(0x80 | length));
+            else
+            {
+                frame.push_back(0x80 | 126);
+                frame.push_back((uint8_t)(length >> 8));
+                frame.push_back((uint8_t)(length & 0xFF));
+            }
+            frame.insert(frame.end(), mask, mask + 4);
+            
+            for (size_t i = 0; i < length; ++i)
+            {
+                const uint16_t sample = (uint16_t)samples[i / 2];
+                const uint8_t byte = (i & 1) ? (uint8_t)(sample >> 8) : (uint8_t)(sample & 0xFF);
+                frame.push_back(byte ^ mask[i & 3]);
+            }
+            
+            return socket.write(frame.data(), (int)frame.size()) == (int)frame.size();
+        }
+        
+        /**
+            Read what has arrived (waiting up to timeoutMs for the first byte).
+            
+            @return     false if the connection failed
+        */
+        bool receive(int timeoutMs)
+        {
+            const int ready = socket.waitUntilReady(true, timeoutMs);
+            if (ready < 0)
+                return false;
+            if (ready == 0)
+                return true;
+            
+            uint8_t data[4096];
+            const int n = socket.read(data, (int)sizeof(data), false);
+            if (n <= 0)
+                return false;
+            
+            inbound.insert(inbound.end(), data, data + n);
+            return true;
+        }
+        
+        /**
+            Pop the next complete binary message (text flow messages are skipped).
+        */
+        bool popBinary(std::vector<uint8_t>& message)
+        {
+            while (inbound.size() >= 2)
+            {
+                const uint8_t opcode = inbound[0] & 0x0F;
+                size_t length = inbound[1] & 0x7F;
+                size_t headerSize = 2;
+                
+                if (length == 126)
+                {
+                    if (inbound.size() < 4)
+                        return false;
+                    length = ((size_t)inbound[2] << 8) | inbound[3];
+                    headerSize = 4;
+                }
+                else if (length == 127)
+                {
+                    if (inbound.size() < 10)
+                        return false;
+                    length = 0;
+                    for (int i = 2; i < 10; ++i)
+                        length = (length << 8) | inbound[(size_t)i];
+                    headerSize = 10;
+                }
+                
+                if (inbound.size() < headerSize + length)
+                    return false;
+                
+                const auto payload = inbound.begin() + (std::ptrdiff_t)headerSize;
+                const bool binary = opcode == 0x2;
+                if (binary)
+                    message.assign(payload, payload + (std::ptrdiff_t)length);
+                inbound.erase(inbound.begin(), payload + (std::ptrdiff_t)length);
+                
+                if (binary)
+                    return true;
+            }
+            return false;
+        }
+    
+    private:
+        juce::StreamingSocket socket;
+        std::vector<uint8_t> inbound;
+    };
+    
+    /**
+        Check one push message; prints its events.
+        
+        @return     Number of censor events in it (-1 if malformed)
+    */
+    int checkMessage(const std::vector<uint8_t>& message, int64_t samplesSent)
+    {
+        if (message.size() < PushProtocol::HEADER_BYTES || std::memcmp(message.data(), PushProtocol::MAGIC, 4) != 0)
+            return -1;
+        
+        const uint32_t rate = readU32(message.data() + 12);
+        const int64_t streamPosition = readI64(message.data() + 16);
+        const int numEvents = readU16(message.data() + 24);
+        
+        std::cout << "[PushTest] Message: " << numEvents << " event(s), " << rate << " Hz, stream position "
+                  << streamPosition << " (" << samplesSent << " samples sent)" << std::endl;
+        
+        // Positions count the session's samples: nothing can lie past what was sent
+        if (rate != (uint32_t)STREAM_RATE || streamPosition < 0 || streamPosition > samplesSent)
+            return -1;
+        
+        size_t offset = PushProtocol::HEADER_BYTES;
+        for (int i = 0; i < numEvents; ++i)
+        {
+            if (offset + 22 > message.size())
+                return -1;
+            
+            const int64_t start = readI64(message.data() + offset);
+            const int64_t end = readI64(message.data() + offset + 8);
+            const size_t textLength = message[offset + 21];
+            const std::string word(message.begin() + (std::ptrdiff_t)(offset + 22),
+                                   message.begin() + (std::ptrdiff_t)(offset + 22 + textLength));
+            
+            std::cout << "[PushTest]   \"" << word << "\" " << (double)start / rate << "s - "
+                      << (double)end / rate << "s" << std::endl;
+            
+            if (end <= start || end < 0 || start > samplesSent)
+                return -1;
+            
+            offset += 22 + textLength;
+        }
+        
+        return numEvents;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || !juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]).existsAsFile())
+    {
+        std::cout << "[PushTest] SKIPPED: no clip (usage: PushChannelTest <clip with a lexicon word> [port])" << std::endl;
+        return SKIPPED;
+    }
+    
+    std::vector<int16_t> pcm;
+    if (!loadClip(juce::File::getCurrentWorkingDirectory().getChildFile(argv[1]), pcm))
+    {
+        std::cout << "[PushTest] FAILED: could not read " << argv[1] << std::endl;
+        return 1;
+    }
+    pcm.resize(pcm.size() + (size_t)(TRAILING_SILENCE_SECONDS * STREAM_RATE), 0);
+    
+    MultiStreamEngine engine;
+    RemoteSessionHost host(engine);
+    
+    RemoteSessionHost::Options options;
+    options.port = argc > 2 ? juce::String(argv[2]).getIntValue() : 18765;
+    options.maxSessions = 1;
+    options.streamSampleRate = STREAM_RATE;
+    if (!host.start(options))
+    {
+        std::cout << "[PushTest] FAILED: server did not start" << std::endl;
+        return 1;
+    }
+    
+    Client client;
+    if (!client.connect(options.port))
+    {
+        std::cout << "[PushTest] FAILED: WebSocket upgrade failed" << std::endl;
+        return 1;
+    }
+    
+    // Real-time pacing: the engine decodes one window per hop, as for a live tab
+    int64_t samplesSent = 0;
+    int eventsReceived = 0;
+    bool failed = false;
+    std::vector<uint8_t> message;
+    
+    const auto start = std::chrono::steady_clock::now();
+    auto replyDeadline = std::chrono::steady_clock::time_point::max();
+    
+    while (!failed && eventsReceived == 0 && std::chrono::steady_clock::now() < replyDeadline)
+    {
+        if (samplesSent < (int64_t)pcm.size())
+        {
+            const int count = (int)std::min<int64_t>(SEND_BLOCK_SAMPLES, (int64_t)pcm.size() - samplesSent);
+            if (!client.sendPcm(pcm.data() + samplesSent, count))
+            {
+                std::cout << "[PushTest] FAILED: send failed" << std::endl;
+                return 1;
+            }
+            samplesSent += count;
+            
+            if (samplesSent == (int64_t)pcm.size())
+                replyDeadline = std::chrono::steady_clock::now()
+                              + std::chrono::milliseconds((int)(REPLY_TIMEOUT_SECONDS * 1000.0));
+        }
+        
+        // Read until the next block is due (once everything is sent, poll every 100ms)
+        const auto nextSend = samplesSent < (int64_t)pcm.size()
+                                  ? start + std::chrono::milliseconds(samplesSent * 1000 / STREAM_RATE)
+                                  : std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+        do
+        {
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextSend - std::chrono::steady_clock::now());
+            if (!client.receive((int)juce::jlimit<int64_t>(0, 100, (int64_t)wait.count())))
+            {
+                std::cout << "[PushTest] FAILED: connection lost" << std::endl;
+                return 1;
+            }
+            
+            while (client.popBinary(message))
+            {
+                const int events = checkMessage(message, samplesSent);
+                if (events < 0)
+                    failed = true;
+                else
+                    eventsReceived += events;
+            }
+        }
+        while (!failed && eventsReceived == 0 && std::chrono::steady_clock::now() < nextSend);
+    }
+    
+    host.stop();
+    
+    if (failed)
+    {
+        std::cout << "[PushTest] FAILED: malformed push message or position off the session timeline" << std::endl;
+        return 1;
+    }
+    
+    if (eventsReceived == 0)
+    {
+        std::cout << "[PushTest] FAILED: no censor frame within " << REPLY_TIMEOUT_SECONDS
+                  << "s of the end of the clip" << std::endl;
+        return 1;
+    }
+    
+    std::cout << "[PushTest] PASSED: " << eventsReceived << " censor event(s) pushed back" << std::endl;
+    return 0;
+}
@@ -0,0 +1,205 @@
+/*
+  ==============================================================================
+
+    PushProtocol.h
+    Created: 12 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Binary censor-event / transcript push messages for remote clients.
+
+    Features:
+    - One message per decoded window: every event scheduled by that window
+      plus (optionally) the words it committed, so a client censors locally
+      as soon as the engine has decided
+    - Absolute sample positions on the stream timeline (same as CensorEvent)
+    - Little-endian, no padding, length-prefixed text (no JSON on the hot path)
+    - The encoder reuses one buffer (no allocation once it has grown)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Types.h"
+
+/**
+    Wire format (all integers little-endian):
+        
+        Header (28 bytes)
+            char[4]  magic          "EXPM"
+            uint8    version        PushProtocol::VERSION
+            uint8    type           MessageType::Batch
+            uint16   flags          reserved (0)
+            uint32   sequence       Per stream, +1 per message (gaps = lost messages)
+            uint32   sampleRate     Rate of every sample position below
+            int64    streamPosition Capture end of the window that produced the message
+            uint16   eventCount
+            uint16   wordCount
+        
+        eventCount x Event
+            int64    startSample    Censor from (inclusive, padding applied)
+            int64    endSample      ...to (exclusive)
+            float32  confidence     0..1
+            uint8    mode           0 = Reverse, 1 = Mute (CensorEvent::Mode)
+            uint8    textLength
+            char[]   text           UTF-8, not terminated
+        
+        wordCount x Word
+            int64    startSample
+            int64    endSample
+            float32  confidence
+            uint8    textLength
+            char[]   text
+    
+    Usage:
+        PushProtocol::Encoder encoder;
+        encoder.begin(sequence++, sampleRate, captureEndSample);
+        encoder.addEvent(event);
+        encoder.addWord(start, end, confidence, "word");
+        server.broadcastBinary(encoder.finish(), encoder.getSize());
+    
+    Thread Safety:
+    - An Encoder belongs to one thread
+*/
+namespace PushProtocol
+{
+    constexpr char MAGIC[4] = { 'E', 'X', 'P', 'M' };
+    constexpr uint8_t VERSION = 1;
+    constexpr size_t HEADER_BYTES = 28;
+    constexpr size_t MAX_TEXT_BYTES = 63;       // CensorEvent::word without its terminator
+    
+    enum class MessageType : uint8_t
+    {
+        Batch = 1
+    };
+    
+    class Encoder
+    {
+    public:
+        Encoder() { buffer.reserve(1024); }
+        
+        /**
+            Start a new message (discards an unfinished one).
+            
+            @param sequence         Message number on this stream
+            @param sampleRate       Rate of the sample positions
+            @param streamPosition   Capture end of the window being reported
+        */
+        void begin(uint32_t sequence, uint32_t sampleRate, int64_t streamPosition)
+        {
+            buffer.clear();
+            buffer.insert(buffer.end(), MAGIC, MAGIC + 4);
+            putU8(VERSION);
+            putU8((uint8_t)MessageType::Batch);
+            putU16(0);
+            putU32(sequence);
+            putU32(sampleRate);
+            putI64(streamPosition);
+            putU16(0);      // Counts are patched in as records are added
+            putU16(0);
+            numEvents = 0;
+            numWords = 0;
+        }
+        
+        /**
+            Append an event. Events must all be added before the first word.
+            
+            @return     false if the message already holds the maximum number
+        */
+        bool addEvent(const CensorEvent& event)
+        {
+            if (numWords > 0 || numEvents == 0xFFFF)
+                return false;
+            
+            putI64(event.start_sample);
+            putI64(event.end_sample);
+            putF32((float)event.confidence);
+            putU8(event.mode == CensorEvent::Mode::Mute ? 1 : 0);
+            putText(event.word, strnlen(event.word, sizeof(event.word)));
+            patchU16(24, ++numEvents);
+            return true;
+        }
+        
+        /**
+            Append a committed transcript word.
+        */
+        bool addWord(int64_t startSample, int64_t endSample, float confidence, const std::string& text)
+        {
+            if (numWords == 0xFFFF)
+                return false;
+            
+            putI64(startSample);
+            putI64(endSample);
+            putF32(confidence);
+            putText(text.data(), text.size());
+            patchU16(26, ++numWords);
+            return true;
+        }
+        
+        bool isEmpty() const { return numEvents == 0 && numWords == 0; }
+        int getNumEvents() const { return numEvents; }
+        int getNumWords() const { return numWords; }
+        
+        /**
+            @return     The encoded message (valid until the next begin())
+        */
+        const uint8_t* finish() const { return buffer.data(); }
+        size_t getSize() const { return buffer.size(); }
+    
+    private:
+        void putU8(uint8_t value) { buffer.push_back(value); }
+        
+        void putU16(uint16_t value)
+        {
+            buffer.push_back((uint8_t)(value & 0xFF));
+            buffer.push_back((uint8_t)(value >> 8));
+        }
+        
+        void putU32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+                buffer.push_back((uint8_t)((value >> (i * 8)) & 0xFF));
+        }
+        
+        void putI64(int64_t value)
+        {
+            const uint64_t bits = (uint64_t)value;
+            for (int i = 0; i < 8; ++i)
+                buffer.push_back((uint8_t)((bits >> (i * 8)) & 0xFF));
+        }
+        
+        void putF32(float value)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            putU32(bits);
+        }
+        
+        void putText(const char* text, size_t length)
+        {
+            // Truncate on a UTF-8 boundary so the client never sees half a character
+            if (length > MAX_TEXT_BYTES)
+            {
+                length = MAX_TEXT_BYTES;
+                while (length > 0 && ((uint8_t)text[length] & 0xC0) == 0x80)
+                    --length;
+            }
+            putU8((uint8_t)length);
+            buffer.insert(buffer.end(), text, text + length);
+        }
+        
+        void patchU16(size_t offset, int value)
+        {
+            buffer[offset] = (uint8_t)(value & 0xFF);
+            buffer[offset + 1] = (uint8_t)((value >> 8) & 0xFF);
+        }
+        
+        std::vector<uint8_t> buffer;
+        int numEvents = 0;
+        int numWords = 0;
+    };
+}
@@ -16,168 +16,466 @@
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr std::memory_order relaxed = std::memory_order_relaxed;
+    
+    int64_t steadyNowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    uint64_t toMillis(double seconds)
+    {
+        return (uint64_t)std::llround(std::max(0.0, seconds) * 1000.0);
+    }
+    
+    template <size_t N>
+    void copyText(char (&dest)[N], const char* text)
+    {
+        std::strncpy(dest, text, N - 1);
+        dest[N - 1] = '\0';
+    }
+    
+    const char* kindName(int kind)
+    {
+        static const char* const names[] = { "censorship", "rtf", "lookahead", "buffer", "underrun", "model" };
+        return (kind >= 0 && kind < (int)(sizeof(names) / sizeof(names[0]))) ? names[kind] : "unknown";
+    }
+}
 
 QualityAnalyzer::QualityAnalyzer()
 {
+    sessionStartNs.store(steadyNowNs());
     std::cout << "[Phase8] Quality Analyzer initialized" << std::endl;
 }
 
 QualityAnalyzer::~QualityAnalyzer()
 {
+    stopHistorySpill();
 }
 
 void QualityAnalyzer::startSession()
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics.sessionStart = std::chrono::steady_clock::now();
+    sessionStartNs.store(steadyNowNs());
     std::cout << "[Phase8] Analysis session started" << std::endl;
 }
 
 void QualityAnalyzer::endSession()
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
     std::cout << "[Phase8] Analysis session ended" << std::endl;
-    std::cout << "[Phase8] Total words censored: " << metrics.totalWordsCensored << std::endl;
-    std::cout << "[Phase8] Quality score: " << calculateQualityScore() << "/100" << std::endl;
+    std::cout << "[Phase8] Total words censored: " << totalWordsCensored.load() << std::endl;
+    std::cout << "[Phase8] Quality score: " << getCurrentQualityScore() << "/100" << std::endl;
 }
 
 void QualityAnalyzer::reset()
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics = QualityMetrics();
-    censorshipHistory.clear();
+    totalWordsDetected.store(0);
+    totalWordsCensored.store(0);
+    totalWordsSkipped.store(0);
+    multiWordDetections.store(0);
+    
+    rtfStats.clear();
+    rtfHistogram.clear();
+    requiredLookAheadHistogram.clear();
+    lookAheadTargetStats.clear();
+    finalLookAheadTarget.store(0.0);
+    bufferStats.clear();
+    bufferHistogram.clear();
+    gateWindowsDecoded.store(0);
+    gateWindowsSkipped.store(0);
+    gateSecondsSkipped.store(0.0);
+    fastPathWindowsDecoded.store(0);
+    fastPathWindowsSkipped.store(0);
+    fastPathSecondsSkipped.store(0.0);
+    predictedCensorEvents.store(0);
+    timelineWindowsDecoded.store(0);
+    timelineWindowsSkipped.store(0);
+    timelineSecondsSkipped.store(0.0);
+    cachedCensorEvents.store(0);
+    timelineSyncs.store(0);
+    spotterLookAheadHistogram.clear();
+    spotterConfirmed.store(0);
+    spotterWithdrawn.store(0);
+    spotterKept.store(0);
+    sessionDuration.store(0.0);
+    
+    for (auto& slot : modelSlots)
+    {
+        slot.name[0] = '\0';
+        slot.chunks.store(0);
+        slot.audioSeconds.store(0.0);
+        slot.rtf.clear();
+    }
+    numModelSlots.store(0);
+    lastModelSlot.store(-1);
+    modelSwitchCount.store(0);
+    
+    bufferUnderrunCount.store(0);
+    peakLevel.store(0.0f);
+    clippingEvents.store(0);
+    
+    eventsWritten.store(0);
+    stageProfiler.reset();
     std::cout << "[Phase8] Metrics reset" << std::endl;
 }
 
+double QualityAnalyzer::getSessionSeconds() const
+{
+    return (double)(steadyNowNs() - sessionStartNs.load(relaxed)) * 1.0e-9;
+}
+
 void QualityAnalyzer::recordCensorshipEvent(const std::string& word, double timestamp,
                                            bool wasCensored, const std::string& mode,
                                            bool isMultiWord)
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now - metrics.sessionStart).count() / 1000.0;
+    const double elapsed = getSessionSeconds();
     
-    CensorshipEvent event;
-    event.word = word;
+    // Overwrite the oldest slot, then publish it
+    const uint64_t index = eventsWritten.load(relaxed);
+    EventRecord& event = recentEvents[(size_t)(index % RECENT_EVENT_CAPACITY)];
+    copyText(event.word, word.c_str());
+    copyText(event.mode, mode.c_str());
     event.timestamp = timestamp;
     event.detectionTime = elapsed;
-    event.detectionLatency = elapsed - timestamp;
     event.wasCensored = wasCensored;
-    event.mode = mode;
+    eventsWritten.store(index + 1, std::memory_order_release);
     
-    censorshipHistory.push_back(event);
-    
-    // Keep history size manageable
-    if (censorshipHistory.size() > MAX_HISTORY_SIZE)
-    {
-        censorshipHistory.erase(censorshipHistory.begin());
-    }
-    
-    metrics.totalWordsDetected++;
+    totalWordsDetected.fetch_add(1, relaxed);
     
     if (wasCensored)
     {
-        metrics.totalWordsCensored++;
+        totalWordsCensored.fetch_add(1, relaxed);
     }
     else
     {
-        metrics.totalWordsSkipped++;
+        totalWordsSkipped.fetch_add(1, relaxed);
     }
     
     if (isMultiWord)
     {
-        metrics.multiWordDetections++;
+        multiWordDetections.fetch_add(1, relaxed);
     }
+    
+    spill(spillQueue, HistoryRecord::Kind::Censorship, timestamp, wasCensored ? 1.0 : 0.0,
+          word.c_str(), mode.c_str());
 }
 
 void QualityAnalyzer::recordRTF(double rtf)
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    rtfStats.add(rtf);
+    rtfHistogram.add(toMillis(rtf));
+    
+    spill(spillQueue, HistoryRecord::Kind::RTF, rtf);
+}
+
+void QualityAnalyzer::recordLookAhead(double requiredSeconds, double targetSeconds)
+{
+    requiredLookAheadHistogram.add(toMillis(requiredSeconds));
+    lookAheadTargetStats.add(targetSeconds);
+    finalLookAheadTarget.store(targetSeconds, relaxed);
+    
+    spill(spillQueue, HistoryRecord::Kind::LookAhead, requiredSeconds, targetSeconds);
+}
+
+void QualityAnalyzer::recordModelUsage(const std::string& modelName, double audioSeconds, double rtf)
+{
+    const int count = numModelSlots.load(relaxed);
+    int slotIndex = -1;
+    for (int i = 0; i < count; ++i)
+    {
+        if (modelName == modelSlots[(size_t)i].name)
+        {
+            slotIndex = i;
+            break;
+        }
+    }
+    
+    if (slotIndex < 0)
+    {
+        if (count >= MAX_MODELS)
+            return;
+        
+        // Name first, then publish the slot
+        slotIndex = count;
+        copyText(modelSlots[(size_t)slotIndex].name, modelName.c_str());
+        numModelSlots.store(count + 1, std::memory_order_release);
+    }
     
-    metrics.rtfSamples++;
-    metrics.averageRTF = ((metrics.averageRTF * (metrics.rtfSamples - 1)) + rtf) / metrics.rtfSamples;
-    metrics.minRTF = std::min(metrics.minRTF, rtf);
-    metrics.maxRTF = std::max(metrics.maxRTF, rtf);
+    const int previous = lastModelSlot.load(relaxed);
+    if (previous >= 0 && previous != slotIndex)
+    {
+        modelSwitchCount.fetch_add(1, relaxed);
+    }
+    lastModelSlot.store(slotIndex, relaxed);
+    
+    ModelSlot& slot = modelSlots[(size_t)slotIndex];
+    slot.chunks.fetch_add(1, relaxed);
+    slot.audioSeconds.store(slot.audioSeconds.load(relaxed) + audioSeconds, relaxed);
+    slot.rtf.add(rtf);
+    
+    spill(spillQueue, HistoryRecord::Kind::ModelUsage, rtf, audioSeconds, modelName.c_str());
 }
 
 void QualityAnalyzer::recordBufferSize(double bufferSize)
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    bufferStats.add(bufferSize);
+    bufferHistogram.add(toMillis(bufferSize));
     
-    metrics.bufferSamples++;
-    metrics.averageBufferSize = ((metrics.averageBufferSize * (metrics.bufferSamples - 1)) + bufferSize) / metrics.bufferSamples;
-    metrics.minBufferSize = std::min(metrics.minBufferSize, bufferSize);
-    metrics.maxBufferSize = std::max(metrics.maxBufferSize, bufferSize);
+    spill(spillQueue, HistoryRecord::Kind::BufferSize, bufferSize);
 }
 
 void QualityAnalyzer::recordBufferUnderrun()
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics.bufferUnderrunCount++;
+    bufferUnderrunCount.fetch_add(1, relaxed);
+    
+    spill(audioSpillQueue, HistoryRecord::Kind::Underrun, 0.0);
+}
+
+void QualityAnalyzer::recordGateDecision(bool decoded, double audioSeconds)
+{
+    if (decoded)
+    {
+        gateWindowsDecoded.fetch_add(1, relaxed);
+    }
+    else
+    {
+        gateWindowsSkipped.fetch_add(1, relaxed);
+        gateSecondsSkipped.store(gateSecondsSkipped.load(relaxed) + audioSeconds, relaxed);
+    }
+}
+
+void QualityAnalyzer::recordFastPathDecision(bool decoded, double audioSeconds)
+{
+    if (decoded)
+    {
+        fastPathWindowsDecoded.fetch_add(1, relaxed);
+    }
+    else
+    {
+        fastPathWindowsSkipped.fetch_add(1, relaxed);
+        fastPathSecondsSkipped.store(fastPathSecondsSkipped.load(relaxed) + audioSeconds, relaxed);
+    }
+}
+
+void QualityAnalyzer::recordPredictedCensorEvent()
+{
+    predictedCensorEvents.fetch_add(1, relaxed);
+}
+
+void QualityAnalyzer::recordTimelineDecision(bool decoded, double audioSeconds)
+{
+    if (decoded)
+    {
+        timelineWindowsDecoded.fetch_add(1, relaxed);
+    }
+    else
+    {
+        timelineWindowsSkipped.fetch_add(1, relaxed);
+        timelineSecondsSkipped.store(timelineSecondsSkipped.load(relaxed) + audioSeconds, relaxed);
+    }
+}
+
+void QualityAnalyzer::recordCachedCensorEvent()
+{
+    cachedCensorEvents.fetch_add(1, relaxed);
+}
+
+void QualityAnalyzer::recordTimelineSync()
+{
+    timelineSyncs.fetch_add(1, relaxed);
+}
+
+void QualityAnalyzer::recordSpotterProposal(double requiredLookAheadSeconds)
+{
+    spotterLookAheadHistogram.add(toMillis(requiredLookAheadSeconds));
+}
+
+void QualityAnalyzer::recordSpotterOutcome(ProposalOutcome outcome)
+{
+    switch (outcome)
+    {
+        case ProposalOutcome::Confirmed:    spotterConfirmed.fetch_add(1, relaxed); break;
+        case ProposalOutcome::Withdrawn:    spotterWithdrawn.fetch_add(1, relaxed); break;
+        case ProposalOutcome::Kept:         spotterKept.fetch_add(1, relaxed); break;
+    }
 }
 
 void QualityAnalyzer::recordAudioLevel(float level)
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics.peakLevel = std::max(metrics.peakLevel, (double)std::abs(level));
+    const float magnitude = std::abs(level);
+    float current = peakLevel.load(relaxed);
+    while (magnitude > current && !peakLevel.compare_exchange_weak(current, magnitude, relaxed))
+    {
+    }
 }
 
 void QualityAnalyzer::recordClipping()
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics.clippingEvents++;
+    clippingEvents.fetch_add(1, relaxed);
 }
 
 void QualityAnalyzer::updateSessionDuration(double seconds)
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    metrics.sessionDuration = seconds;
+    sessionDuration.store(seconds, relaxed);
 }
 
 QualityMetrics QualityAnalyzer::getMetrics() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    QualityMetrics metrics;
+    
+    metrics.totalWordsDetected = totalWordsDetected.load(relaxed);
+    metrics.totalWordsCensored = totalWordsCensored.load(relaxed);
+    metrics.totalWordsSkipped = totalWordsSkipped.load(relaxed);
+    metrics.multiWordDetections = multiWordDetections.load(relaxed);
+    
+    metrics.rtfSamples = (int)rtfStats.getCount();
+    if (metrics.rtfSamples > 0)
+    {
+        const LogHistogram::Summary rtf = rtfHistogram.summarize();
+        metrics.averageRTF = rtfStats.getMean();
+        metrics.minRTF = rtfStats.getMin();
+        metrics.maxRTF = rtfStats.getMax();
+        metrics.rtfStdDev = rtfStats.getStdDev();
+        metrics.p50RTF = rtf.p50 / 1000.0;
+        metrics.p99RTF = rtf.p99 / 1000.0;
+    }
+    
+    metrics.lookAheadSamples = (int)lookAheadTargetStats.getCount();
+    if (metrics.lookAheadSamples > 0)
+    {
+        const LogHistogram::Summary required = requiredLookAheadHistogram.summarize();
+        metrics.p50RequiredLookAhead = required.p50 / 1000.0;
+        metrics.p99RequiredLookAhead = required.p99 / 1000.0;
+        metrics.finalLookAheadTarget = finalLookAheadTarget.load(relaxed);
+        metrics.minLookAheadTarget = lookAheadTargetStats.getMin();
+        metrics.maxLookAheadTarget = lookAheadTargetStats.getMax();
+    }
+    
+    const int numModels = numModelSlots.load(std::memory_order_acquire);
+    for (int i = 0; i < numModels; ++i)
+    {
+        const ModelSlot& slot = modelSlots[(size_t)i];
+        ModelUsageStats usage;
+        usage.modelName = slot.name;
+        usage.chunksDecoded = slot.chunks.load(relaxed);
+        usage.audioSeconds = slot.audioSeconds.load(relaxed);
+        usage.averageRTF = slot.rtf.getMean();
+        usage.maxRTF = slot.rtf.getMax();
+        metrics.modelUsage.push_back(usage);
+    }
+    
+    const int lastModel = lastModelSlot.load(relaxed);
+    if (lastModel >= 0 && lastModel < numModels)
+        metrics.lastModelName = modelSlots[(size_t)lastModel].name;
+    metrics.modelSwitchCount = modelSwitchCount.load(relaxed);
+    
+    metrics.bufferSamples = (int)bufferStats.getCount();
+    if (metrics.bufferSamples > 0)
+    {
+        const LogHistogram::Summary buffer = bufferHistogram.summarize();
+        metrics.averageBufferSize = bufferStats.getMean();
+        metrics.minBufferSize = bufferStats.getMin();
+        metrics.maxBufferSize = bufferStats.getMax();
+        metrics.bufferStdDev = bufferStats.getStdDev();
+        metrics.p10BufferSize = buffer.p10 / 1000.0;
+        metrics.p50BufferSize = buffer.p50 / 1000.0;
+    }
+    metrics.bufferUnderrunCount = bufferUnderrunCount.load(relaxed);
+    
+    metrics.gateWindowsDecoded = gateWindowsDecoded.load(relaxed);
+    metrics.gateWindowsSkipped = gateWindowsSkipped.load(relaxed);
+    metrics.gateSecondsSkipped = gateSecondsSkipped.load(relaxed);
+    metrics.fastPathWindowsDecoded = fastPathWindowsDecoded.load(relaxed);
+    metrics.fastPathWindowsSkipped = fastPathWindowsSkipped.load(relaxed);
+    metrics.fastPathSecondsSkipped = fastPathSecondsSkipped.load(relaxed);
+    metrics.predictedCensorEvents = predictedCensorEvents.load(relaxed);
+    metrics.timelineWindowsDecoded = timelineWindowsDecoded.load(relaxed);
+    metrics.timelineWindowsSkipped = timelineWindowsSkipped.load(relaxed);
+    metrics.timelineSecondsSkipped = timelineSecondsSkipped.load(relaxed);
+    metrics.cachedCensorEvents = cachedCensorEvents.load(relaxed);
+    metrics.timelineSyncs = timelineSyncs.load(relaxed);
+    
+    const LogHistogram::Summary spotter = spotterLookAheadHistogram.summarize();
+    metrics.spotterProposals = (int)spotter.count;
+    metrics.spotterConfirmed = spotterConfirmed.load(relaxed);
+    metrics.spotterWithdrawn = spotterWithdrawn.load(relaxed);
+    metrics.spotterKept = spotterKept.load(relaxed);
+    metrics.p50SpotterLookAhead = spotter.p50 / 1000.0;
+    metrics.p99SpotterLookAhead = spotter.p99 / 1000.0;
+    
+    metrics.peakLevel = peakLevel.load(relaxed);
+    metrics.clippingEvents = clippingEvents.load(relaxed);
+    
+    metrics.historyRecordsWritten = spillWritten.load(relaxed);
+    metrics.historyRecordsDropped = spillDropped.load(relaxed);
+    
+    metrics.sessionDuration = sessionDuration.load(relaxed);
+    metrics.sessionStart = std::chrono::steady_clock::time_point(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(sessionStartNs.load(relaxed))));
+    
     return metrics;
 }
 
 int QualityAnalyzer::getCensoredWordCount() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    return metrics.totalWordsCensored;
+    return totalWordsCensored.load(relaxed);
 }
 
 int QualityAnalyzer::getSkippedWordCount() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    return metrics.totalWordsSkipped;
+    return totalWordsSkipped.load(relaxed);
 }
 
 double QualityAnalyzer::getAverageRTF() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    return metrics.averageRTF;
+    return rtfStats.getMean();
 }
 
 double QualityAnalyzer::getCurrentQualityScore() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    return calculateQualityScore();
+    return calculateQualityScore(getMetrics());
 }
 
 std::vector<CensorshipEvent> QualityAnalyzer::getRecentEvents(int maxCount) const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    const uint64_t written = eventsWritten.load(std::memory_order_acquire);
+    const uint64_t wanted = (uint64_t)std::max(0, std::min(maxCount, RECENT_EVENT_CAPACITY));
+    const uint64_t first = written - std::min(written, wanted);
     
-    int startIdx = std::max(0, (int)censorshipHistory.size() - maxCount);
-    return std::vector<CensorshipEvent>(
-        censorshipHistory.begin() + startIdx,
-        censorshipHistory.end()
-    );
+    std::vector<CensorshipEvent> events;
+    events.reserve((size_t)(written - first));
+    
+    for (uint64_t i = first; i < written; ++i)
+    {
+        const EventRecord& record = recentEvents[(size_t)(i % RECENT_EVENT_CAPACITY)];
+        
+        CensorshipEvent event;
+        event.word = std::string(record.word, strnlen(record.word, sizeof(record.word)));
+        event.mode = std::string(record.mode, strnlen(record.mode, sizeof(record.mode)));
+        event.timestamp = record.timestamp;
+        event.detectionTime = record.detectionTime;
+        event.detectionLatency = record.detectionTime - record.timestamp;
+        event.wasCensored = record.wasCensored;
+        events.push_back(std::move(event));
+    }
+    
+    // The writer never waits for us: drop the slots it overwrote while we copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t writtenAfter = eventsWritten.load(relaxed);
+    if (writtenAfter >= first + RECENT_EVENT_CAPACITY)
+    {
+        const uint64_t lapped = std::min<uint64_t>(events.size(), writtenAfter - RECENT_EVENT_CAPACITY - first + 1);
+        events.erase(events.begin(), events.begin() + (std::ptrdiff_t)lapped);
+    }
+    
+    return events;
 }
 
-double QualityAnalyzer::calculateQualityScore() const
+double QualityAnalyzer::calculateQualityScore(const QualityMetrics& metrics)
 {
     // Quality score from 0-100 based on multiple factors
     double score = 100.0;
@@ -220,7 +518,7 @@ double QualityAnalyzer::calculateQualityScore() const
 
 std::string QualityAnalyzer::generateReport() const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
+    const QualityMetrics metrics = getMetrics();
     
     std::ostringstream report;
     report << std::fixed << std::setprecision(2);
@@ -231,7 +529,7 @@ std::string QualityAnalyzer::generateReport() const
     
     report << "SESSION OVERVIEW:\n";
     report << "  Duration: " << metrics.sessionDuration << " seconds\n";
-    report << "  Quality Score: " << calculateQualityScore() << "/100\n\n";
+    report << "  Quality Score: " << calculateQualityScore(metrics) << "/100\n\n";
     
     report << "CENSORSHIP STATISTICS:\n";
     report << "  Total Words Detected: " << metrics.totalWordsDetected << "\n";
@@ -247,25 +545,109 @@ std::string QualityAnalyzer::generateReport() const
     report << "\n";
     
     report << "PERFORMANCE METRICS:\n";
-    report << "  Average RTF: " << metrics.averageRTF << "x\n";
+    report << "  Average RTF: " << metrics.averageRTF << "x (std dev " << metrics.rtfStdDev << ")\n";
     report << "  Min RTF: " << metrics.minRTF << "x\n";
     report << "  Max RTF: " << metrics.maxRTF << "x\n";
+    report << "  P50 / P99 RTF: " << metrics.p50RTF << "x / " << metrics.p99RTF << "x\n";
     report << "  Buffer Underruns: " << metrics.bufferUnderrunCount << "\n\n";
     
+    if (!metrics.modelUsage.empty())
+    {
+        int totalChunks = 0;
+        for (const auto& usage : metrics.modelUsage)
+            totalChunks += usage.chunksDecoded;
+        
+        report << "MODEL USAGE:\n";
+        for (const auto& usage : metrics.modelUsage)
+        {
+            report << "  " << usage.modelName << ": " << usage.chunksDecoded << " chunks ("
+                   << (100.0 * usage.chunksDecoded / std::max(1, totalChunks)) << "%), "
+                   << usage.audioSeconds << "s audio, avg RTF " << usage.averageRTF
+                   << "x, max RTF " << usage.maxRTF << "x\n";
+        }
+        report << "  Model Switches: " << metrics.modelSwitchCount << "\n\n";
+    }
+    
+    int gateWindows = metrics.gateWindowsDecoded + metrics.gateWindowsSkipped;
+    if (gateWindows > 0)
+    {
+        report << "VOCAL GATE:\n";
+        report << "  Windows Decoded: " << metrics.gateWindowsDecoded << "\n";
+        report << "  Windows Skipped: " << metrics.gateWindowsSkipped << " ("
+               << (100.0 * metrics.gateWindowsSkipped / gateWindows) << "%)\n";
+        report << "  Audio Skipped: " << metrics.gateSecondsSkipped << "s\n\n";
+    }
+    
+    int fastPathWindows = metrics.fastPathWindowsDecoded + metrics.fastPathWindowsSkipped;
+    if (fastPathWindows > 0)
+    {
+        report << "LYRICS FAST PATH:\n";
+        report << "  Verification Decodes: " << metrics.fastPathWindowsDecoded << "\n";
+        report << "  Windows Skipped: " << metrics.fastPathWindowsSkipped << " ("
+               << (100.0 * metrics.fastPathWindowsSkipped / fastPathWindows) << "%)\n";
+        report << "  Audio Skipped: " << metrics.fastPathSecondsSkipped << "s\n";
+        report << "  Predicted Censor Events: " << metrics.predictedCensorEvents << "\n\n";
+    }
+    
+    int timelineWindows = metrics.timelineWindowsDecoded + metrics.timelineWindowsSkipped;
+    if (timelineWindows > 0 || metrics.timelineSyncs > 0)
+    {
+        report << "CENSOR TIMELINE REPLAY:\n";
+        report << "  Syncs to Cached Songs: " << metrics.timelineSyncs << "\n";
+        report << "  Verification Decodes: " << metrics.timelineWindowsDecoded << "\n";
+        report << "  Windows Skipped: " << metrics.timelineWindowsSkipped << " ("
+               << (timelineWindows > 0 ? 100.0 * metrics.timelineWindowsSkipped / timelineWindows : 0.0) << "%)\n";
+        report << "  Audio Skipped: " << metrics.timelineSecondsSkipped << "s\n";
+        report << "  Cached Censor Events: " << metrics.cachedCensorEvents << "\n\n";
+    }
+    
+    if (metrics.spotterProposals > 0)
+    {
+        report << "KEYWORD SPOTTER:\n";
+        report << "  Proposals: " << metrics.spotterProposals << "\n";
+        report << "  Confirmed by Whisper: " << metrics.spotterConfirmed << " ("
+               << (100.0 * metrics.spotterConfirmed / metrics.spotterProposals) << "%)\n";
+        report << "  Withdrawn (Whisper rejected): " << metrics.spotterWithdrawn << "\n";
+        report << "  Kept Unconfirmed: " << metrics.spotterKept << "\n";
+        report << "  Required Look-ahead P50 / P99: " << metrics.p50SpotterLookAhead << "s / "
+               << metrics.p99SpotterLookAhead << "s\n\n";
+    }
+    
     report << "BUFFER HEALTH:\n";
-    report << "  Average Buffer: " << metrics.averageBufferSize << "s\n";
+    report << "  Average Buffer: " << metrics.averageBufferSize << "s (std dev " << metrics.bufferStdDev << "s)\n";
     report << "  Min Buffer: " << metrics.minBufferSize << "s\n";
-    report << "  Max Buffer: " << metrics.maxBufferSize << "s\n\n";
+    report << "  Max Buffer: " << metrics.maxBufferSize << "s\n";
+    report << "  P10 / P50 Buffer: " << metrics.p10BufferSize << "s / " << metrics.p50BufferSize << "s\n";
+    if (metrics.lookAheadSamples > 0)
+    {
+        report << "  Required Look-ahead P50 / P99: " << metrics.p50RequiredLookAhead << "s / "
+               << metrics.p99RequiredLookAhead << "s\n";
+        report << "  Look-ahead Target: " << metrics.finalLookAheadTarget << "s (range "
+               << metrics.minLookAheadTarget << "-" << metrics.maxLookAheadTarget << "s)\n";
+    }
+    report << "\n";
+    
+    const StageProfiler::Snapshot stages = stageProfiler.getSnapshot();
+    if (stages.stages[(size_t)StageProfiler::Stage::Callback].count > 0)
+    {
+        report << "PIPELINE STAGES:\n";
+        report << stages.toString() << "\n";
+    }
     
     report << "AUDIO QUALITY:\n";
     report << "  Peak Level: " << (metrics.peakLevel * 100.0) << "%\n";
     report << "  Clipping Events: " << metrics.clippingEvents << "\n\n";
     
+    if (metrics.historyRecordsWritten > 0 || metrics.historyRecordsDropped > 0)
+    {
+        report << "HISTORY SPILL:\n";
+        report << "  Records Written: " << metrics.historyRecordsWritten << "\n";
+        report << "  Records Dropped: " << metrics.historyRecordsDropped << "\n\n";
+    }
+    
     report << "RECENT EVENTS:\n";
-    int recentCount = std::min(10, (int)censorshipHistory.size());
-    for (int i = censorshipHistory.size() - recentCount; i < censorshipHistory.size(); i++)
+    for (const auto& event : getRecentEvents(10))
     {
-        const auto& event = censorshipHistory[i];
         report << "  [" << event.timestamp << "s] \"" << event.word << "\" - ";
         report << (event.wasCensored ? event.mode : "SKIPPED") << "\n";
     }
@@ -277,8 +659,6 @@ std::string QualityAnalyzer::generateReport() const
 
 bool QualityAnalyzer::exportToFile(const std::string& filename) const
 {
-    std::lock_guard<std::mutex> lock(metricsMutex);
-    
     std::ofstream file(filename);
     if (!file.is_open())
     {
@@ -292,3 +672,121 @@ bool QualityAnalyzer::exportToFile(const std::string& filename) const
     std::cout << "[Phase8] Report exported to " << filename << std::endl;
     return true;
 }
+
+bool QualityAnalyzer::exportStageProfile(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+        std::cout << "[Phase8] ERROR: Could not open file " << filename << std::endl;
+        return false;
+    }
+    
+    file << stageProfiler.getSnapshot().toJson();
+    file.close();
+    
+    std::cout << "[Phase8] Stage profile exported to " << filename << std::endl;
+    return true;
+}
+
+//==============================================================================
+bool QualityAnalyzer::startHistorySpill(const std::string& filename)
+{
+    stopHistorySpill();
+    
+    spillFile.open(filename, std::ios::out | std::ios::trunc);
+    if (!spillFile.is_open())
+    {
+        std::cout << "[Phase8] ERROR: Could not open history file " << filename << std::endl;
+        return false;
+    }
+    
+    spillFile << "session_seconds,kind,value,extra,text,mode\n";
+    spillWritten.store(0);
+    spillDropped.store(0);
+    stopSpilling.store(false);
+    spillThread = std::thread(&QualityAnalyzer::spillThreadFunction, this);
+    spilling.store(true, std::memory_order_release);
+    
+    std::cout << "[Phase8] Spilling session history to " << filename << std::endl;
+    return true;
+}
+
+void QualityAnalyzer::stopHistorySpill()
+{
+    if (!spillThread.joinable())
+        return;
+    
+    spilling.store(false, std::memory_order_release);
+    stopSpilling.store(true);
+    spillWake.notify();
+    spillThread.join();
+    
+    std::cout << "[Phase8] History spill closed: " << spillWritten.load() << " records written, "
+              << spillDropped.load() << " dropped" << std::endl;
+}
+
+template <typename Queue>
+void QualityAnalyzer::spill(Queue& queue, HistoryRecord::Kind kind, double value, double extra,
+                            const char* text, const char* mode)
+{
+    if (!isSpillingHistory())
+        return;
+    
+    HistoryRecord record;
+    record.kind = kind;
+    record.sessionSeconds = getSessionSeconds();
+    record.value = value;
+    record.extra = extra;
+    copyText(record.text, text);
+    copyText(record.mode, mode);
+    
+    // Never wait for the disk: a full queue loses the record, and says so in the report
+    if (queue.push(record))
+        spillWake.notify();
+    else
+        spillDropped.fetch_add(1, relaxed);
+}
+
+void QualityAnalyzer::spillThreadFunction()
+{
+    while (!stopSpilling.load())
+    {
+        spillWake.wait(100);
+        
+        if (drainSpillQueues())
+            spillFile.flush();
+    }
+    
+    // Whatever was queued before stopHistorySpill()
+    drainSpillQueues();
+    spillFile.close();
+}
+
+bool QualityAnalyzer::drainSpillQueues()
+{
+    bool wrote = false;
+    
+    auto writeRecord = [this](const HistoryRecord& record)
+    {
+        spillFile << std::fixed << std::setprecision(3) << record.sessionSeconds << ','
+                  << kindName((int)record.kind) << ',' << std::setprecision(4) << record.value << ','
+                  << record.extra << ",\"" << record.text << "\"," << record.mode << '\n';
+    };
+    
+    while (auto record = spillQueue.pop())
+    {
+        writeRecord(*record);
+        spillWritten.fetch_add(1, relaxed);
+        wrote = true;
+    }
+    
+    while (auto record = audioSpillQueue.pop())
+    {
+        writeRecord(*record);
+        spillWritten.fetch_add(1, relaxed);
+        wrote = true;
+    }
+    
+    return wrote;
+}
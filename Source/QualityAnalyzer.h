@@ -6,13 +6,18 @@
     Author: Explicitly Audio Systems
 
     PHASE 8: Quality Analysis
-    
+
     Tracks and analyzes:
     - Censorship statistics (words detected, censored, timing)
     - Audio quality metrics (levels, clipping)
     - Performance metrics (RTF, buffer health)
+    - Per-stage pipeline latency (StageProfiler)
     - Real-time quality scoring
 
+    Memory is fixed for the whole session: counters and streaming aggregates
+    instead of growing histories, a ring of recent censorship events, and an
+    optional background spill of the full history to disk (testing mode).
+
   ==============================================================================
 */
 
@@ -20,20 +25,35 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <fstream>
-#include <mutex>
+#include <thread>
+#include "LockFreeQueue.h"
+#include "StageProfiler.h"
+#include "StreamingStats.h"
+#include "WakeSignal.h"
 
 struct CensorshipEvent
 {
     std::string word;
-    double timestamp;           // When the word occurred (in audio time)
+    double timestamp;           // When the word occurred (stream seconds: capture sample / sample rate)
     double detectionTime;       // When we detected it (processing time)
     double detectionLatency;    // How long detection took
     bool wasCensored;          // false if skipped due to underrun
     std::string mode;          // "REVERSE" or "MUTE"
 };
 
+struct ModelUsageStats
+{
+    std::string modelName;          // e.g. "small.en"
+    int chunksDecoded = 0;
+    double audioSeconds = 0.0;      // Audio covered by this model's decodes
+    double averageRTF = 0.0;
+    double maxRTF = 0.0;
+};
+
 struct QualityMetrics
 {
     // Censorship statistics
@@ -46,27 +66,94 @@ struct QualityMetrics
     double averageRTF = 0.0;
     double minRTF = 999.0;
     double maxRTF = 0.0;
+    double rtfStdDev = 0.0;
+    double p50RTF = 0.0;
+    double p99RTF = 0.0;
     int rtfSamples = 0;
     
+    // Adaptive look-ahead (required per decoded window vs. the controller's target)
+    double p50RequiredLookAhead = 0.0;
+    double p99RequiredLookAhead = 0.0;
+    double finalLookAheadTarget = 0.0;
+    double minLookAheadTarget = 999.0;
+    double maxLookAheadTarget = 0.0;
+    int lookAheadSamples = 0;
+    
+    // Adaptive model switching
+    std::vector<ModelUsageStats> modelUsage;
+    std::string lastModelName;
+    int modelSwitchCount = 0;
+    
     // Buffer health
     double averageBufferSize = 0.0;
     double minBufferSize = 999.0;
     double maxBufferSize = 0.0;
+    double bufferStdDev = 0.0;
+    double p10BufferSize = 0.0;     // Low tail: how close playback came to an underrun
+    double p50BufferSize = 0.0;
     int bufferUnderrunCount = 0;
     int bufferSamples = 0;
     
+    // Vocal activity gate (decodes skipped before whisper_full)
+    int gateWindowsDecoded = 0;
+    int gateWindowsSkipped = 0;
+    double gateSecondsSkipped = 0.0;    // New audio per skipped window (one hop)
+    
+    // Lyrics fast path (decodes throttled while lyrics are locked)
+    int fastPathWindowsDecoded = 0;     // Verification decodes
+    int fastPathWindowsSkipped = 0;
+    double fastPathSecondsSkipped = 0.0;
+    int predictedCensorEvents = 0;      // Scheduled from the lyrics ahead of capture
+    
+    // Censor timeline replay (known songs censored from the cache)
+    int timelineWindowsDecoded = 0;     // Spot verification decodes
+    int timelineWindowsSkipped = 0;
+    double timelineSecondsSkipped = 0.0;
+    int cachedCensorEvents = 0;         // Scheduled from a cached timeline
+    int timelineSyncs = 0;              // Times a replay locked onto its cached timeline
+    
+    // Keyword spotter (two-tier detection: proposed early, confirmed by Whisper)
+    int spotterProposals = 0;
+    int spotterConfirmed = 0;
+    int spotterWithdrawn = 0;           // Whisper decoded the range and did not hear it
+    int spotterKept = 0;                // Rejected but confident, or never verified
+    double p50SpotterLookAhead = 0.0;   // Look-ahead a proposal needed (compare p50RequiredLookAhead)
+    double p99SpotterLookAhead = 0.0;
+    
     // Audio quality
     double peakLevel = 0.0;
     int clippingEvents = 0;
     
+    // History spill (testing mode)
+    int64_t historyRecordsWritten = 0;
+    int64_t historyRecordsDropped = 0;  // Spill queue was full
+    
     // Session info
     double sessionDuration = 0.0;   // Total audio processed (seconds)
     std::chrono::steady_clock::time_point sessionStart;
 };
 
+/**
+    Session quality metrics without locks or unbounded storage.
+    
+    Each metric has one writing thread, so recording is a few relaxed atomic
+    stores; readers (report, UI timer) build a QualityMetrics snapshot from the
+    atomics at any time. A snapshot can be off by the one sample being recorded.
+    
+    Thread Safety:
+    - startSession()/reset()/startHistorySpill()/stopHistorySpill(): control
+      thread, while the audio callback and Whisper thread are stopped
+    - recordBufferUnderrun()/recordAudioLevel()/recordClipping(): audio thread
+      (real-time safe)
+    - Every other record/update method: Whisper thread
+    - Getters and reports: any thread
+*/
 class QualityAnalyzer
 {
 public:
+    static constexpr int RECENT_EVENT_CAPACITY = 256;   // getRecentEvents() window
+    static constexpr int MAX_MODELS = 8;
+    
     QualityAnalyzer();
     ~QualityAnalyzer();
     
@@ -76,12 +163,29 @@ public:
     void reset();
     
     // Event tracking
-    void recordCensorshipEvent(const std::string& word, double timestamp, 
+    void recordCensorshipEvent(const std::string& word, double timestamp,
                               bool wasCensored, const std::string& mode,
                               bool isMultiWord = false);
     void recordRTF(double rtf);
+    void recordLookAhead(double requiredSeconds, double targetSeconds);
+    void recordModelUsage(const std::string& modelName, double audioSeconds, double rtf);
     void recordBufferSize(double bufferSize);
     void recordBufferUnderrun();
+    void recordGateDecision(bool decoded, double audioSeconds);
+    void recordFastPathDecision(bool decoded, double audioSeconds);
+    void recordPredictedCensorEvent();
+    void recordTimelineDecision(bool decoded, double audioSeconds);
+    void recordCachedCensorEvent();
+    void recordTimelineSync();
+    
+    enum class ProposalOutcome
+    {
+        Confirmed,
+        Withdrawn,
+        Kept
+    };
+    void recordSpotterProposal(double requiredLookAheadSeconds);
+    void recordSpotterOutcome(ProposalOutcome outcome);
     void recordAudioLevel(float level);
     void recordClipping();
     void updateSessionDuration(double seconds);
@@ -94,16 +198,150 @@ public:
     double getCurrentQualityScore() const;  // 0-100 score
     std::vector<CensorshipEvent> getRecentEvents(int maxCount = 10) const;
     
+    // Pipeline stage timing (recorded lock-free by the audio and Whisper threads)
+    StageProfiler& getStageProfiler() { return stageProfiler; }
+    StageProfiler::Snapshot getStageSnapshot() const { return stageProfiler.getSnapshot(); }
+    
     // Reporting
     std::string generateReport() const;
     bool exportToFile(const std::string& filename) const;
+    bool exportStageProfile(const std::string& filename) const;    // JSON snapshot
+    
+    /**
+        Write every recorded censorship event, RTF, look-ahead, buffer size and
+        underrun to a CSV file from a background thread.
+        
+        @param filename     CSV file (truncated)
+        @return             false if the file could not be opened
+    */
+    bool startHistorySpill(const std::string& filename);
     
+    /**
+        Write what is still queued, then close the spill file.
+    */
+    void stopHistorySpill();
+    
+    bool isSpillingHistory() const { return spilling.load(std::memory_order_acquire); }
+
 private:
-    mutable std::mutex metricsMutex;
-    QualityMetrics metrics;
-    std::vector<CensorshipEvent> censorshipHistory;
+    // Fixed-size copy of a CensorshipEvent for the ring
+    struct EventRecord
+    {
+        char word[64];
+        char mode[12];
+        double timestamp;
+        double detectionTime;
+        bool wasCensored;
+    };
+    
+    // One spilled CSV line
+    struct HistoryRecord
+    {
+        enum class Kind : uint8_t
+        {
+            Censorship,         // value = word time, extra = 1 if censored
+            RTF,                // value = RTF
+            LookAhead,          // value = required, extra = target (seconds)
+            BufferSize,         // value = seconds buffered
+            Underrun,
+            ModelUsage          // value = RTF, extra = audio seconds
+        };
+        
+        Kind kind;
+        double sessionSeconds;
+        double value;
+        double extra;
+        char text[64];          // Word or model name
+        char mode[12];
+    };
+    
+    struct ModelSlot
+    {
+        char name[32] {};
+        std::atomic<int> chunks {0};
+        std::atomic<double> audioSeconds {0.0};
+        RunningStats rtf;
+    };
+    
+    using SpillQueue = LockFreeQueue<HistoryRecord, 1024>;
+    using AudioSpillQueue = LockFreeQueue<HistoryRecord, 64>;
+    
+    // Censorship statistics
+    std::atomic<int> totalWordsDetected {0};
+    std::atomic<int> totalWordsCensored {0};
+    std::atomic<int> totalWordsSkipped {0};
+    std::atomic<int> multiWordDetections {0};
+    
+    // Streaming aggregates (Whisper thread)
+    RunningStats rtfStats;
+    LogHistogram rtfHistogram;                      // Milli-RTF
+    LogHistogram requiredLookAheadHistogram;        // Milliseconds
+    RunningStats lookAheadTargetStats;
+    std::atomic<double> finalLookAheadTarget {0.0};
+    RunningStats bufferStats;
+    LogHistogram bufferHistogram;                   // Milliseconds
+    std::atomic<int> gateWindowsDecoded {0};
+    std::atomic<int> gateWindowsSkipped {0};
+    std::atomic<double> gateSecondsSkipped {0.0};
+    std::atomic<int> fastPathWindowsDecoded {0};
+    std::atomic<int> fastPathWindowsSkipped {0};
+    std::atomic<double> fastPathSecondsSkipped {0.0};
+    std::atomic<int> predictedCensorEvents {0};
+    std::atomic<int> timelineWindowsDecoded {0};
+    std::atomic<int> timelineWindowsSkipped {0};
+    std::atomic<double> timelineSecondsSkipped {0.0};
+    std::atomic<int> cachedCensorEvents {0};
+    std::atomic<int> timelineSyncs {0};
+    LogHistogram spotterLookAheadHistogram;         // Milliseconds (count = proposals)
+    std::atomic<int> spotterConfirmed {0};
+    std::atomic<int> spotterWithdrawn {0};
+    std::atomic<int> spotterKept {0};
+    std::atomic<double> sessionDuration {0.0};
+    
+    // Model usage (Whisper thread; slots are published once named)
+    std::array<ModelSlot, MAX_MODELS> modelSlots;
+    std::atomic<int> numModelSlots {0};
+    std::atomic<int> lastModelSlot {-1};
+    std::atomic<int> modelSwitchCount {0};
+    
+    // Audio thread
+    std::atomic<int> bufferUnderrunCount {0};
+    std::atomic<float> peakLevel {0.0f};
+    std::atomic<int> clippingEvents {0};
+    
+    // Recent censorship events: the writer overwrites the oldest slot, readers
+    // discard slots it lapped while they copied (same scheme as CircularBuffer)
+    std::array<EventRecord, RECENT_EVENT_CAPACITY> recentEvents;
+    std::atomic<uint64_t> eventsWritten {0};
+    
+    std::atomic<int64_t> sessionStartNs {0};    // steady_clock
+    StageProfiler stageProfiler;
+    
+    // History spill: one SPSC queue per writing thread, drained by spillThread
+    SpillQueue spillQueue;                  // Whisper thread -> spill thread
+    AudioSpillQueue audioSpillQueue;        // Audio thread -> spill thread
+    WakeSignal spillWake;
+    std::thread spillThread;
+    std::ofstream spillFile;                // Spill thread only while spilling
+    std::atomic<bool> spilling {false};
+    std::atomic<bool> stopSpilling {false};
+    std::atomic<int64_t> spillWritten {0};
+    std::atomic<int64_t> spillDropped {0};
+    
+    double getSessionSeconds() const;
+    
+    /**
+        Queue a history record for the spill thread (no-op unless spilling).
+    */
+    template <typename Queue>
+    void spill(Queue& queue, HistoryRecord::Kind kind, double value, double extra = 0.0,
+               const char* text = "", const char* mode = "");
+    
+    void spillThreadFunction();
+    bool drainSpillQueues();
     
-    static constexpr int MAX_HISTORY_SIZE = 1000;  // Keep last 1000 events
+    static double calculateQualityScore(const QualityMetrics& metrics);
     
-    double calculateQualityScore() const;
+    QualityAnalyzer(const QualityAnalyzer&) = delete;
+    QualityAnalyzer& operator=(const QualityAnalyzer&) = delete;
 };
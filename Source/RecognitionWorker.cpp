@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    RecognitionWorker.cpp
+    Created: 19 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Implementation of the background song identification worker.
+
+  ==============================================================================
+*/
+
+#include "RecognitionWorker.h"
+#include <iostream>
+
+RecognitionWorker::RecognitionWorker(SongRecognition& recognition)
+    : songRecognition(recognition)
+{
+}
+
+RecognitionWorker::~RecognitionWorker()
+{
+    stop();
+}
+
+void RecognitionWorker::start(int sampleRate, double captureSeconds, ResultCallback onResult)
+{
+    stop();
+    
+    captureRate = sampleRate;
+    captureSamples = juce::jmax(1, (int)(sampleRate * captureSeconds));
+    resultCallback = std::move(onResult);
+    
+    // Capacity rounds up to a power of two, so a full capture never wraps
+    captureRing = std::make_unique<CircularAudioBuffer>(1, captureSamples);
+    snapshot.assign((size_t)captureSamples, 0.0f);
+    
+    capturing.store(false);
+    shouldStop.store(false);
+    workerThread = std::thread(&RecognitionWorker::run, this);
+    
+    std::cout << "[SongRec] Recognition worker started (" << captureSeconds << "s capture @ "
+              << sampleRate << " Hz)" << std::endl;
+}
+
+void RecognitionWorker::stop()
+{
+    capturing.store(false);
+    shouldStop.store(true);
+    captureComplete.notify();
+    
+    if (workerThread.joinable())
+        workerThread.join();
+}
+
+void RecognitionWorker::startCapture()
+{
+    if (captureRing == nullptr || busy.load())
+        return;
+    
+    // Writer is idle while capturing == false, so the reset cannot race with it
+    capturing.store(false);
+    captureRing->reset();
+    capturing.store(true, std::memory_order_release);
+}
+
+void RecognitionWorker::pushAudio(const float* samples, int numSamples)
+{
+    if (!capturing.load(std::memory_order_acquire) || samples == nullptr || numSamples <= 0)
+        return;
+    
+    const int remaining = captureSamples - (int)captureRing->getWritePosition();
+    const int toWrite = juce::jmin(numSamples, remaining);
+    
+    if (toWrite > 0)
+        captureRing->writeSamples(&samples, 1, toWrite);
+    
+    if (toWrite >= remaining)
+    {
+        // Capture complete: stop writing and hand over to the worker
+        capturing.store(false, std::memory_order_release);
+        captureComplete.notify();
+    }
+}
+
+void RecognitionWorker::run()
+{
+    while (!shouldStop.load())
+    {
+        captureComplete.wait(250);
+        
+        if (shouldStop.load())
+            break;
+        
+        if (capturing.load(std::memory_order_acquire) || captureRing->getWritePosition() < captureSamples)
+            continue;
+        
+        busy.store(true);
+        
+        float* dest = snapshot.data();
+        captureRing->readSamples(&dest, 1, 0, captureSamples);
+        captureRing->reset();  // Consumed - a spurious wake-up must not re-submit it
+        
+        std::cout << "[SongRec] Attempting song identification with "
+                  << ((double)captureSamples / captureRate) << " seconds of audio..." << std::endl;
+        
+        SongRecognition::SongInfo song = songRecognition.identifySong(snapshot.data(), captureSamples, captureRate);
+        
+        if (song.identified && song.lyrics.empty() && !shouldStop.load())
+        {
+            std::cout << "[SongRec] Fetching lyrics..." << std::endl;
+            song.lyrics = songRecognition.fetchLyrics(song.artist, song.title);
+        }
+        
+        busy.store(false);
+        
+        if (resultCallback && !shouldStop.load())
+            resultCallback(song);
+    }
+}
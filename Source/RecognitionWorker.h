@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    RecognitionWorker.h
+    Created: 19 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Background song identification (fingerprint + AcoustID + lyrics fetch).
+
+    The audio callback only copies samples into a preallocated ring; the
+    fingerprinting and every network lookup run on this worker's thread,
+    so a slow AcoustID/lyrics response can never stall audio output.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SongRecognition.h"
+#include "CircularBuffer.h"
+#include "WakeSignal.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+    Captures the first few seconds of audio and identifies the song off the
+    real-time thread.
+    
+    Usage:
+        worker.start(16000, 10.0, onResult);   // Message thread
+        worker.startCapture();                  // Arm a new identification
+        worker.pushAudio(mono, n);              // Audio callback (real-time safe)
+    
+    Thread Safety:
+    - pushAudio(): audio callback only (no locks, no allocation)
+    - start()/stop()/startCapture(): control thread, never concurrently with each other
+    - The result callback runs on the worker thread; post to the message
+      thread (juce::MessageManager::callAsync) before touching UI or lyrics state
+*/
+class RecognitionWorker
+{
+public:
+    using ResultCallback = std::function<void(const SongRecognition::SongInfo&)>;
+    
+    explicit RecognitionWorker(SongRecognition& recognition);
+    ~RecognitionWorker();
+    
+    /**
+        Allocate the capture ring and start the worker thread.
+        
+        @param sampleRate       Rate of the audio passed to pushAudio()
+        @param captureSeconds   Audio collected before fingerprinting
+        @param onResult         Called (on the worker thread) after each attempt
+    */
+    void start(int sampleRate, double captureSeconds, ResultCallback onResult);
+    
+    /**
+        Stop the worker thread (waits for an in-flight lookup to time out).
+    */
+    void stop();
+    
+    /**
+        Discard captured audio and collect a fresh capture for identification.
+    */
+    void startCapture();
+    
+    /**
+        Feed mono audio while a capture is armed.
+        
+        @param samples      Mono samples at the rate given to start()
+        @param numSamples   Number of samples
+        
+        Thread: Audio callback (real-time safe)
+    */
+    void pushAudio(const float* samples, int numSamples);
+    
+    /**
+        @return true while audio is being collected for the next attempt
+    */
+    bool isCapturing() const { return capturing.load(std::memory_order_acquire); }
+    
+    /**
+        @return true while fingerprinting / lookups are in progress
+    */
+    bool isBusy() const { return busy.load(std::memory_order_acquire); }
+
+private:
+    void run();
+    
+    SongRecognition& songRecognition;
+    ResultCallback resultCallback;
+    
+    std::unique_ptr<CircularAudioBuffer> captureRing;   // Written by pushAudio() only while capturing
+    std::vector<float> snapshot;                        // Worker-side copy handed to SongRecognition
+    int captureRate = 16000;
+    int captureSamples = 0;
+    
+    std::atomic<bool> capturing {false};
+    std::atomic<bool> busy {false};
+    std::atomic<bool> shouldStop {false};
+    WakeSignal captureComplete;
+    std::thread workerThread;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecognitionWorker)
+};
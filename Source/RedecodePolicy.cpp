@@ -0,0 +1,266 @@
+/*
+  ==============================================================================
+
+    RedecodePolicy.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Confidence-targeted second decoding pass implementation.
+
+  ==============================================================================
+*/
+
+#include "RedecodePolicy.h"
+#include "EditDistance.h"
+#include "ProfanityMatcher.h"
+#include "WhisperTranscript.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    constexpr double MIN_REGION_SECONDS = 1.2;     // whisper_full ignores input under 1s
+    constexpr int AUDIO_CTX_PER_SECOND = 50;       // Encoder frames per second (1500 per 30s)
+    constexpr int AUDIO_CTX_SLACK = 32;
+    
+    double midpoint(const WordSegment& word) { return (word.start + word.end) * 0.5; }
+}
+
+//==============================================================================
+std::string RedecodePolicy::Report::describe() const
+{
+    if (!ran)
+        return "temperature fallback";
+    
+    char line[160];
+    if (regions == 0)
+    {
+        std::snprintf(line, sizeof(line), "greedy (%d low-confidence, %d lexicon-like, %.2fs)",
+                      lowConfidenceWords, lexiconWords, firstPassSeconds);
+        return line;
+    }
+    
+    std::snprintf(line, sizeof(line), "greedy+%s %d region(s)%s %.1fs audio in %.2fs (first pass %.2fs), "
+                                      "%d low-confidence, %d lexicon-like, %d word(s) replaced",
+                  largerModel ? "larger-model" : "beam", regions,
+                  regionsSkipped > 0 ? (" (+" + std::to_string(regionsSkipped) + " over budget)").c_str() : "",
+                  secondPassAudioSeconds, secondPassSeconds, firstPassSeconds,
+                  lowConfidenceWords, lexiconWords, wordsReplaced);
+    return line;
+}
+
+//==============================================================================
+void RedecodePolicy::configureFirstPass(whisper_full_params& params)
+{
+    // temperature_inc = 0 turns whisper.cpp's fallback off: exactly one decode per window
+    params.temperature = 0.0f;
+    params.temperature_inc = 0.0f;
+}
+
+bool RedecodePolicy::isLexiconLike(const std::string& word, EditDistance& scratch) const
+{
+    return lexicon != nullptr && options.lexiconEdits >= 0 && !lexicon->isEmpty()
+        && lexicon->isNearLexiconToken(word, options.lexiconEdits, scratch);
+}
+
+std::vector<RedecodePolicy::Region> RedecodePolicy::findRegions(const std::vector<WordSegment>& words, double windowSeconds,
+                                                                EditDistance& scratch, Report& report) const
+{
+    std::vector<Region> flagged;
+    if (!options.enabled || windowSeconds < MIN_REGION_SECONDS)
+        return flagged;
+    
+    // Flagged words whose context would overlap share one region
+    for (const auto& word : words)
+    {
+        const bool lowConfidence = word.confidence < options.lowConfidence;
+        const bool lexiconLike = isLexiconLike(word.word, scratch);
+        if (!lowConfidence && !lexiconLike)
+            continue;
+        
+        report.lowConfidenceWords += lowConfidence ? 1 : 0;
+        report.lexiconWords += lexiconLike ? 1 : 0;
+        
+        if (!flagged.empty() && word.start - flagged.back().coreEnd < 2.0 * options.contextSeconds)
+        {
+            Region& region = flagged.back();
+            region.coreEnd = std::max(region.coreEnd, word.end);
+            region.lowConfidenceWords += lowConfidence ? 1 : 0;
+            region.lexiconWords += lexiconLike ? 1 : 0;
+            continue;
+        }
+        
+        Region region;
+        region.coreStart = word.start;
+        region.coreEnd = word.end;
+        region.lowConfidenceWords = lowConfidence ? 1 : 0;
+        region.lexiconWords = lexiconLike ? 1 : 0;
+        flagged.push_back(region);
+    }
+    
+    for (auto& region : flagged)
+    {
+        region.start = std::max(0.0, region.coreStart - options.contextSeconds);
+        region.end = std::min(windowSeconds, region.coreEnd + options.contextSeconds);
+        
+        // Grow short regions evenly, then against whichever window edge they hit
+        const double missing = MIN_REGION_SECONDS - (region.end - region.start);
+        if (missing > 0.0)
+        {
+            region.start = std::max(0.0, region.start - missing * 0.5);
+            region.end = std::min(windowSeconds, region.start + MIN_REGION_SECONDS);
+            region.start = std::max(0.0, region.end - MIN_REGION_SECONDS);
+        }
+    }
+    
+    // Budget: lexicon-like words first (the ones recall depends on), then the least confident regions
+    std::vector<Region> chosen;
+    std::vector<Region> byPriority = flagged;
+    std::stable_sort(byPriority.begin(), byPriority.end(), [](const Region& a, const Region& b) {
+        if ((a.lexiconWords > 0) != (b.lexiconWords > 0))
+            return a.lexiconWords > 0;
+        return a.lowConfidenceWords > b.lowConfidenceWords;
+    });
+    
+    const double budget = options.maxFraction * windowSeconds;
+    double used = 0.0;
+    for (const auto& region : byPriority)
+    {
+        const double length = region.end - region.start;
+        if ((int)chosen.size() >= options.maxRegions || used + length > budget)
+        {
+            ++report.regionsSkipped;
+            continue;
+        }
+        
+        used += length;
+        chosen.push_back(region);
+    }
+    
+    std::sort(chosen.begin(), chosen.end(), [](const Region& a, const Region& b) { return a.start < b.start; });
+    return chosen;
+}
+
+whisper_full_params RedecodePolicy::makeSecondPassParams(const whisper_full_params& firstPass, const Region& region) const
+{
+    whisper_full_params params = firstPass;
+    params.strategy = WHISPER_SAMPLING_BEAM_SEARCH;
+    params.beam_search.beam_size = std::max(2, options.beamSize);
+    params.temperature = 0.0f;
+    params.temperature_inc = 0.0f;      // Still no fallback: the beam is the second opinion
+    
+    // The encoder cost follows audio_ctx, not the samples passed in
+    const int audioCtx = (int)std::ceil((region.end - region.start) * AUDIO_CTX_PER_SECOND) + AUDIO_CTX_SLACK;
+    params.audio_ctx = firstPass.audio_ctx > 0 ? std::min(firstPass.audio_ctx, audioCtx) : audioCtx;
+    
+    // The first pass's hooks (ttft probes, progress) are not meant for sub-windows
+    params.new_segment_callback = nullptr;
+    params.progress_callback = nullptr;
+    params.encoder_begin_callback = nullptr;
+    params.logits_filter_callback = nullptr;
+    return params;
+}
+
+void RedecodePolicy::redecodeRegions(whisper_context* ctx, whisper_state* state, const whisper_full_params& firstPass,
+                                     const float* samples, int numSamples, const std::vector<whisper_token>& prompt,
+                                     const std::vector<Region>& regions, std::vector<WordSegment>& words,
+                                     std::vector<whisper_token>& tokens, EditDistance& scratch, Report& report) const
+{
+    std::vector<whisper_token> regionPrompt;
+    std::vector<WordSegment> regionWords;
+    std::vector<whisper_token> regionTokens;
+    const auto startTime = std::chrono::steady_clock::now();
+    
+    for (const auto& region : regions)
+    {
+        const int first = std::max(0, (int)(region.start * WHISPER_SAMPLE_RATE));
+        const int last = std::min(numSamples, (int)(region.end * WHISPER_SAMPLE_RATE));
+        if (last <= first)
+            continue;
+        
+        // Prompt: the carried tokens plus this window's words before the region
+        regionPrompt = prompt;
+        for (size_t i = 0; i < words.size() && i < tokens.size() && words[i].end <= region.start; ++i)
+            regionPrompt.push_back(tokens[i]);
+        
+        whisper_full_params params = makeSecondPassParams(firstPass, region);
+        params.prompt_tokens = regionPrompt.empty() ? nullptr : regionPrompt.data();
+        params.prompt_n_tokens = (int)regionPrompt.size();
+        
+        ++report.regions;
+        report.secondPassAudioSeconds += (double)(last - first) / WHISPER_SAMPLE_RATE;
+        
+        if (whisper_full_with_state(ctx, state, params, samples + first, last - first) != 0)
+            continue;
+        
+        regionWords.clear();
+        regionTokens.clear();
+        WhisperTranscript::extractWords(ctx, state, region.end - region.start, regionWords, regionTokens);
+        report.wordsReplaced += merge(words, tokens, region, regionWords, regionTokens, scratch);
+    }
+    
+    report.secondPassSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int RedecodePolicy::merge(std::vector<WordSegment>& words, std::vector<whisper_token>& tokens, const Region& region,
+                          const std::vector<WordSegment>& regionWords, const std::vector<whisper_token>& regionTokens,
+                          EditDistance& scratch) const
+{
+    // First-pass core: contiguous, since words are time-ordered
+    size_t first = 0;
+    while (first < words.size() && midpoint(words[first]) < region.coreStart)
+        ++first;
+    size_t last = first;
+    while (last < words.size() && midpoint(words[last]) <= region.coreEnd)
+        ++last;
+    
+    std::vector<WordSegment> replacement;
+    std::vector<whisper_token> replacementTokens;
+    for (size_t i = 0; i < regionWords.size() && i < regionTokens.size(); ++i)
+    {
+        WordSegment word = regionWords[i];
+        word.start += region.start;
+        word.end += region.start;
+        if (midpoint(word) < region.coreStart || midpoint(word) > region.coreEnd)
+            continue;       // Context only (the sub-window edges cut words)
+        
+        replacement.push_back(word);
+        replacementTokens.push_back(regionTokens[i]);
+    }
+    
+    if (replacement.empty() || last == first)
+        return 0;
+    
+    double firstConfidence = 0.0;
+    bool firstLexiconLike = false;
+    for (size_t i = first; i < last; ++i)
+    {
+        firstConfidence += words[i].confidence;
+        firstLexiconLike = firstLexiconLike || isLexiconLike(words[i].word, scratch);
+    }
+    firstConfidence /= (double)(last - first);
+    
+    double secondConfidence = 0.0;
+    bool secondLexiconLike = false;
+    for (const auto& word : replacement)
+    {
+        secondConfidence += word.confidence;
+        secondLexiconLike = secondLexiconLike || isLexiconLike(word.word, scratch);
+    }
+    secondConfidence /= (double)replacement.size();
+    
+    // Recall first: a reading that might be profanity is never traded for one that is not
+    if (firstLexiconLike && !secondLexiconLike)
+        return 0;
+    if (secondConfidence <= firstConfidence && !(secondLexiconLike && !firstLexiconLike))
+        return 0;
+    
+    const int replaced = (int)(last - first);
+    words.erase(words.begin() + (std::ptrdiff_t)first, words.begin() + (std::ptrdiff_t)last);
+    words.insert(words.begin() + (std::ptrdiff_t)first, replacement.begin(), replacement.end());
+    tokens.erase(tokens.begin() + (std::ptrdiff_t)first, tokens.begin() + (std::ptrdiff_t)last);
+    tokens.insert(tokens.begin() + (std::ptrdiff_t)first, replacementTokens.begin(), replacementTokens.end());
+    return replaced;
+}
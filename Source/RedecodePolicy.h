@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    RedecodePolicy.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Confidence-targeted second decoding pass.
+
+    Replaces whisper.cpp's temperature fallback (which re-decodes the whole
+    window up to five times on noisy music - the worst RTF spikes):
+    - The first pass is one greedy decode; every word keeps its token probability
+    - Words below a probability threshold, or close to a lexicon token, mark a
+      sub-window (plus some context either side)
+    - Only those sub-windows are decoded again, with beam search and an
+      audio_ctx sized to the sub-window (optionally on a larger model)
+    - A second-pass reading replaces the first one only if it is more
+      confident, and never loses a word that looked like a lexicon entry
+    - Each window reports what ran and what it cost
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <string>
+#include <vector>
+#include "LyricsAlignment.h"  // For WordSegment
+
+class EditDistance;
+class ProfanityMatcher;
+
+/**
+    Decides where a window needs a second pass and merges the result back.
+    
+    Usage:
+        RedecodePolicy policy;
+        policy.setOptions(options);
+        policy.setLexicon(&profanityFilter.getMatcher());
+        job.redecodePolicy = &policy;           // WhisperDecodeScheduler runs the passes
+        
+        // Consumer
+        if (result.redecode.ran)
+            log(result.redecode.describe());
+    
+    Thread Safety:
+    - Configure before decoding starts; afterwards the policy is read-only and
+      shared by every decode worker
+    - The lexicon must not be recompiled while decodes are running
+*/
+class RedecodePolicy
+{
+public:
+    struct Options
+    {
+        bool enabled = true;
+        float lowConfidence = 0.40f;        // Token probability below which a word is re-checked
+        int lexiconEdits = 1;               // Words this close to a lexicon token are re-checked (-1 = never)
+        double contextSeconds = 0.5;        // Audio decoded either side of the flagged words
+        double maxFraction = 0.5;           // Second-pass audio budget per window (share of its length)
+        int maxRegions = 3;
+        int beamSize = 5;
+    };
+    
+    /**
+        Sub-window to decode again (window-relative seconds).
+    */
+    struct Region
+    {
+        double start = 0.0;                 // Including context
+        double end = 0.0;
+        double coreStart = 0.0;             // Flagged words only; replaced from the second pass
+        double coreEnd = 0.0;
+        int lowConfidenceWords = 0;
+        int lexiconWords = 0;
+    };
+    
+    /**
+        What the policy did for one window.
+    */
+    struct Report
+    {
+        bool ran = false;                   // Policy active (words were extracted by the worker)
+        int regions = 0;                    // Sub-windows decoded again
+        int regionsSkipped = 0;             // Flagged but over the budget
+        int lowConfidenceWords = 0;
+        int lexiconWords = 0;
+        int wordsReplaced = 0;              // First-pass words the second pass overruled
+        double firstPassSeconds = 0.0;      // Wall time of the greedy decode
+        double secondPassSeconds = 0.0;     // Wall time of every sub-window decode
+        double secondPassAudioSeconds = 0.0;
+        bool largerModel = false;
+        
+        /**
+            One-line summary, e.g. "greedy+beam 2 region(s) 1.6s audio in 0.21s, 3 word(s) replaced".
+        */
+        std::string describe() const;
+    };
+    
+    RedecodePolicy() = default;
+    
+    void setOptions(const Options& newOptions) { options = newOptions; }
+    const Options& getOptions() const { return options; }
+    
+    /**
+        @param matcher  Compiled lexicon for the proximity check (nullptr = confidence only)
+    */
+    void setLexicon(const ProfanityMatcher* matcher) { lexicon = matcher; }
+    
+    bool isEnabled() const { return options.enabled; }
+    
+    /**
+        First-pass parameters: one greedy decode, no temperature fallback.
+    */
+    static void configureFirstPass(whisper_full_params& params);
+    
+    /**
+        Flag the sub-windows worth a second pass, within the budget.
+        
+        @param words            First-pass words (window-relative, token confidence)
+        @param windowSeconds    Window length
+        @param scratch          Caller's edit-distance engine
+        @param report           Receives the word counts and skipped regions
+    */
+    std::vector<Region> findRegions(const std::vector<WordSegment>& words, double windowSeconds,
+                                    EditDistance& scratch, Report& report) const;
+    
+    /**
+        Second-pass parameters for a region (beam search, audio_ctx sized to it).
+        
+        @param firstPass    The window's first-pass parameters (language, threads, prompt)
+    */
+    whisper_full_params makeSecondPassParams(const whisper_full_params& firstPass, const Region& region) const;
+    
+    /**
+        Decode every region again and merge the readings into the window's words.
+        
+        @param ctx          Second-pass model (same vocabulary as the first pass)
+        @param state        State to decode on (its segments are overwritten)
+        @param firstPass    The window's first-pass parameters (n_threads included)
+        @param samples      The window's 16kHz samples
+        @param numSamples   Window length
+        @param prompt       Tokens carried into the window
+        @param regions      From findRegions()
+        @param words        First-pass words (modified in place)
+        @param tokens       Token id per word
+        @param scratch      Caller's edit-distance engine
+        @param report       Receives the second-pass counts and timing
+    */
+    void redecodeRegions(whisper_context* ctx, whisper_state* state, const whisper_full_params& firstPass,
+                         const float* samples, int numSamples, const std::vector<whisper_token>& prompt,
+                         const std::vector<Region>& regions, std::vector<WordSegment>& words,
+                         std::vector<whisper_token>& tokens, EditDistance& scratch, Report& report) const;
+    
+    /**
+        Replace the region's core words with the second pass's reading if it is better.
+        
+        @param words            Window words (modified in place, stays time-ordered)
+        @param tokens           Token id per word (kept in step with words)
+        @param region           The region that was decoded again
+        @param regionWords      Second-pass words, relative to region.start
+        @param regionTokens     Token id per second-pass word
+        @param scratch          Caller's edit-distance engine
+        @return                 Words replaced (0 = first pass kept)
+    */
+    int merge(std::vector<WordSegment>& words, std::vector<whisper_token>& tokens, const Region& region,
+              const std::vector<WordSegment>& regionWords, const std::vector<whisper_token>& regionTokens,
+              EditDistance& scratch) const;
+
+private:
+    bool isLexiconLike(const std::string& word, EditDistance& scratch) const;
+    
+    Options options;
+    const ProfanityMatcher* lexicon = nullptr;
+};
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    RemoteSessionHost.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    WebSocket sessions -> remote streams.
+
+  ==============================================================================
+*/
+
+#include "RemoteSessionHost.h"
+#include <iostream>
+
+RemoteSessionHost::RemoteSessionHost(MultiStreamEngine& sharedEngine)
+    : engine(sharedEngine)
+{
+}
+
+RemoteSessionHost::~RemoteSessionHost()
+{
+    stop();
+}
+
+bool RemoteSessionHost::start(const Options& newOptions)
+{
+    if (running.load())
+        return true;
+    
+    // Slots and streams are fixed once created (a restart reuses both)
+    if (sessionStreams.empty())
+    {
+        options = newOptions;
+        
+        for (int slot = 0; slot < options.maxSessions; ++slot)
+        {
+            MultiStreamEngine::StreamConfig config;
+            config.name = "Session " + std::to_string(slot);
+            config.mode = options.mode;
+            config.remoteSampleRate = options.streamSampleRate;
+            config.spotter = options.spotter;
+            
+            SessionStream session;
+            session.stream = engine.addStream(config);
+            sessionStreams.push_back(session);
+        }
+        
+        readBuffer.assign(READ_BLOCK_SAMPLES, 0.0f);
+    }
+    
+    // A new server counts generations from 1 again
+    for (auto& session : sessionStreams)
+        session.generation = 0;
+    
+    server = std::make_unique<WebSocketServer>(options.port, options.maxSessions);
+    if (!server->start([this] { wake.notify(); },
+                       [this](int, bool) { wake.notify(); }))
+    {
+        std::cout << "[Remote] ERROR: WebSocket server failed to start on port " << options.port << std::endl;
+        server.reset();
+        return false;
+    }
+    
+    running.store(true);
+    hostThread = std::thread(&RemoteSessionHost::hostLoop, this);
+    
+    std::cout << "[Remote] Listening on port " << options.port << " (" << options.maxSessions
+              << " session(s), " << options.streamSampleRate << " Hz PCM)" << std::endl;
+    return true;
+}
+
+void RemoteSessionHost::stop()
+{
+    if (!running.exchange(false))
+        return;
+    
+    wake.notify();
+    if (hostThread.joinable())
+        hostThread.join();
+    
+    // Streams are stopped (host thread), so nothing reads the rings any more
+    server->stop();
+    server.reset();
+    
+    std::cout << "[Remote] Stopped" << std::endl;
+}
+
+void RemoteSessionHost::hostLoop()
+{
+    while (running.load())
+    {
+        // Audio or a session change wakes us; the timeout retries streams that failed to start
+        wake.wait(POLL_INTERVAL_MS);
+        
+        for (int slot = 0; slot < (int)sessionStreams.size(); ++slot)
+            serviceSlot(slot);
+    }
+    
+    for (int slot = 0; slot < (int)sessionStreams.size(); ++slot)
+        if (sessionStreams[(size_t)slot].active)
+            endSession(slot);
+}
+
+void RemoteSessionHost::serviceSlot(int slot)
+{
+    SessionStream& session = sessionStreams[(size_t)slot];
+    const uint32_t generation = server->getSessionGeneration(slot);
+    const bool open = server->isSessionOpen(slot);      // Before draining: no samples follow a close
+    
+    // The slot went to a new client before the old session was finished
+    if (session.active && generation != session.generation)
+        endSession(slot);
+    
+    if (!session.active)
+    {
+        // Free, or the session that was just finished
+        if (!open || generation == session.generation)
+            return;
+        
+        session.active = true;
+        session.engineRunning = false;
+        session.generation = generation;
+        session.samplesRead = 0;
+        session.nextStartAttempt = std::chrono::steady_clock::now();
+        
+        std::cout << "[Remote] Session " << slot << " connected" << std::endl;
+    }
+    
+    if (!session.engineRunning && open && std::chrono::steady_clock::now() >= session.nextStartAttempt)
+        startSessionStream(slot);
+    
+    // Samples read while the stream is not running are dropped (no backpressure on a stalled stream)
+    AudioEngine& stream = engine.getStream(session.stream);
+    int numRead;
+    while ((numRead = server->readSamples(slot, readBuffer.data(), (int)readBuffer.size())) > 0)
+    {
+        if (session.engineRunning)
+            stream.processRemoteAudio(readBuffer.data(), numRead);
+        session.samplesRead += numRead;
+    }
+    
+    if (!open && server->getNumAvailable(slot) == 0)
+        endSession(slot);
+}
+
+void RemoteSessionHost::startSessionStream(int slot)
+{
+    SessionStream& session = sessionStreams[(size_t)slot];
+    
+    // Censor events go back to this client only, on its own sample count (samples
+    // read before a late start were dropped, so the stream starts at samplesRead)
+    WebSocketServer* sessionServer = server.get();
+    const uint32_t generation = session.generation;
+    engine.getStream(session.stream).setCensorPushCallback(
+        [sessionServer, slot, generation](const uint8_t* data, size_t size) {
+            sessionServer->sendBinary(slot, generation, data, size);
+        },
+        options.pushTranscriptWords, options.streamSampleRate, session.samplesRead);
+    
+    if (!engine.startStream(session.stream))
+    {
+        session.nextStartAttempt = std::chrono::steady_clock::now() + std::chrono::milliseconds(START_RETRY_MS);
+        return;
+    }
+    
+    session.engineRunning = true;
+}
+
+void RemoteSessionHost::endSession(int slot)
+{
+    SessionStream& session = sessionStreams[(size_t)slot];
+    
+    if (session.engineRunning)
+        engine.stopStream(session.stream);
+    
+    std::cout << "[Remote] Session " << slot << " finished (" << session.samplesRead << " samples)" << std::endl;
+    
+    session.active = false;
+    session.engineRunning = false;
+    
+    // Closed and drained: the server may give the slot to the next client
+    server->releaseSession(slot);
+}
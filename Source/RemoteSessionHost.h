@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    RemoteSessionHost.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Filters the browser extension's audio: WebSocketServer sessions feed
+    MultiStreamEngine remote streams.
+
+    Features:
+    - One remote stream per session slot, created up front (no engine is
+      built while clients connect)
+    - A stream starts when its client connects and stops once the client has
+      gone and its remaining samples were filtered
+    - One feeding thread for every session: it drains the session rings into
+      the streams (AudioEngine::processRemoteAudio()) and sleeps on a
+      WakeSignal the server pokes when audio arrives
+    - Each stream's censor events (PushProtocol) go back to its own client,
+      with positions counted in that client's samples since it connected
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "MultiStreamEngine.h"
+#include "WakeSignal.h"
+#include "WebSocketServer.h"
+
+/**
+    Runs a WebSocketServer and one MultiStreamEngine remote stream per session.
+    
+    Usage:
+        MultiStreamEngine engine;
+        RemoteSessionHost host(engine);                 // Destroy before the engine
+        
+        RemoteSessionHost::Options options;
+        options.port = 8765;
+        host.start(options);
+        ...
+        host.stop();
+    
+    Thread Safety:
+    - start()/stop(): control thread
+    - The remote streams are started, fed and stopped on the host thread only
+*/
+class RemoteSessionHost
+{
+public:
+    struct Options
+    {
+        int port = 8765;
+        int maxSessions = 4;                    // Concurrent clients (one remote stream each)
+        int streamSampleRate = 16000;           // Rate the clients send their 16-bit PCM at
+        AudioEngine::CensorMode mode = AudioEngine::CensorMode::Mute;
+        bool pushTranscriptWords = false;       // Also send the committed words
+        KeywordSpotter::Backend spotter = KeywordSpotter::Backend::Off;
+    };
+    
+    explicit RemoteSessionHost(MultiStreamEngine& engine);
+    ~RemoteSessionHost();
+    
+    /**
+        Add the remote streams (first call only), open the server and start
+        the host thread.
+        
+        @return     false if the server could not be started
+    */
+    bool start(const Options& options);
+    void stop();
+    
+    bool isRunning() const { return running.load(); }
+    int getPort() const { return options.port; }
+
+private:
+    struct SessionStream
+    {
+        int stream = -1;                        // MultiStreamEngine stream index
+        bool active = false;                    // A client holds the slot
+        bool engineRunning = false;
+        uint32_t generation = 0;                // Session the stream belongs to
+        juce::int64 samplesRead = 0;            // Session samples taken from the ring so far
+        std::chrono::steady_clock::time_point nextStartAttempt;
+    };
+    
+    void hostLoop();
+    void serviceSlot(int slot);
+    void startSessionStream(int slot);
+    void endSession(int slot);
+    
+    static constexpr int READ_BLOCK_SAMPLES = 4096;
+    static constexpr int POLL_INTERVAL_MS = 100;
+    static constexpr int START_RETRY_MS = 2000;  // A stream that failed to start (no model yet)
+    
+    MultiStreamEngine& engine;
+    Options options;
+    std::unique_ptr<WebSocketServer> server;
+    std::vector<SessionStream> sessionStreams;  // Index = server slot (host thread once started)
+    std::vector<float> readBuffer;              // Host thread
+    
+    std::thread hostThread;
+    std::atomic<bool> running {false};
+    WakeSignal wake;
+    
+    RemoteSessionHost(const RemoteSessionHost&) = delete;
+    RemoteSessionHost& operator=(const RemoteSessionHost&) = delete;
+};
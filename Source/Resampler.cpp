@@ -0,0 +1,228 @@
+/*
+  ==============================================================================
+
+    Resampler.cpp
+    Created: 9 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Streaming polyphase FIR resampler implementation.
+
+  ==============================================================================
+*/
+
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #define EXPLICITLY_RESAMPLER_SSE 1
+ #include <xmmintrin.h>
+#else
+ #define EXPLICITLY_RESAMPLER_SSE 0
+#endif
+
+namespace
+{
+    constexpr double PI = 3.14159265358979323846;
+    
+    // Filter spec relative to the lower of the two Nyquist rates:
+    // -6 dB point at 94% of Nyquist, 2 kHz-equivalent transition @ 16 kHz output,
+    // 80 dB stopband (aliases land only in the top ~500 Hz Whisper's mel bank barely uses)
+    constexpr double CUTOFF_FRACTION = 0.94;
+    constexpr double TRANSITION_FRACTION = 0.25;
+    constexpr double STOPBAND_DB = 80.0;
+    
+    // Zeroth-order modified Bessel function (Kaiser window)
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        const double halfX = x * 0.5;
+        
+        for (int k = 1; k < 50; ++k)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+            if (term < sum * 1e-12)
+                break;
+        }
+        
+        return sum;
+    }
+}
+
+void StreamingResampler::prepare(int inRate, int outRate, int maxBlockSize)
+{
+    inputRate = std::max(1, inRate);
+    outputRate = std::max(1, outRate);
+    maxBlock = maxBlockSize > 0 ? maxBlockSize : 4096;
+    
+    const int divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+    
+    designFilter();
+    
+    // Carried history (tapsPerPhase - 1) followed by one slice of new input
+    history.assign((size_t)(tapsPerPhase + maxBlock), 0.0f);
+    reset();
+}
+
+void StreamingResampler::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    
+    // Start with (tapsPerPhase - 1) samples of silence so the first output has full support
+    historyLength = std::max(0, tapsPerPhase - 1);
+    inputIndex = historyLength;
+    phase = 0;
+}
+
+void StreamingResampler::designFilter()
+{
+    coefficients.clear();
+    
+    if (isPassthrough())
+    {
+        tapsPerPhase = 0;
+        return;
+    }
+    
+    // Kaiser estimate of the filter length, expressed in input samples per phase
+    const double nyquist = 0.5 * std::min(inputRate, outputRate);
+    const double cutoffHz = CUTOFF_FRACTION * nyquist;
+    const double transitionHz = TRANSITION_FRACTION * nyquist;
+    const double taps = (STOPBAND_DB - 7.95) / (14.36 * transitionHz / inputRate);
+    tapsPerPhase = ((int)std::ceil(taps) + 3) & ~3;
+    
+    // Prototype lowpass designed at the upsampled rate (inputRate * L)
+    const int prototypeLength = tapsPerPhase * upFactor;
+    const double normalizedCutoff = cutoffHz / ((double)inputRate * upFactor);
+    const double beta = 0.1102 * (STOPBAND_DB - 8.7);
+    const double centre = 0.5 * (prototypeLength - 1);
+    const double windowNorm = besselI0(beta);
+    
+    std::vector<double> prototype((size_t)prototypeLength);
+    for (int k = 0; k < prototypeLength; ++k)
+    {
+        const double t = k - centre;
+        const double x = 2.0 * normalizedCutoff * t;
+        const double sinc = (std::abs(x) < 1e-12) ? 1.0 : std::sin(PI * x) / (PI * x);
+        const double ratio = t / (centre > 0.0 ? centre : 1.0);
+        const double window = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / windowNorm;
+        
+        prototype[(size_t)k] = 2.0 * normalizedCutoff * sinc * window;
+    }
+    
+    // Split into time-reversed polyphase branches, each normalised to unity DC gain
+    coefficients.assign((size_t)tapsPerPhase * (size_t)upFactor, 0.0f);
+    for (int p = 0; p < upFactor; ++p)
+    {
+        double branchSum = 0.0;
+        for (int j = 0; j < tapsPerPhase; ++j)
+            branchSum += prototype[(size_t)(p + j * upFactor)];
+        
+        const double gain = (std::abs(branchSum) > 1e-12) ? 1.0 / branchSum : 0.0;
+        float* branch = coefficients.data() + (size_t)p * (size_t)tapsPerPhase;
+        
+        for (int j = 0; j < tapsPerPhase; ++j)
+            branch[tapsPerPhase - 1 - j] = (float)(prototype[(size_t)(p + j * upFactor)] * gain);
+    }
+}
+
+float StreamingResampler::dotProduct(const float* a, const float* b, int length)
+{
+#if EXPLICITLY_RESAMPLER_SSE
+    // length is always a multiple of 4 (tapsPerPhase is rounded up)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+    
+    for (; i + 8 <= length; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    
+    for (; i < length; i += 4)
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 0x55));
+    return _mm_cvtss_f32(acc0);
+#else
+    float sum = 0.0f;
+    for (int i = 0; i < length; ++i)
+        sum += a[i] * b[i];
+    return sum;
+#endif
+}
+
+int StreamingResampler::process(const float* input, int numInput, float* output, int maxOutput)
+{
+    if (input == nullptr || output == nullptr || numInput <= 0 || maxOutput <= 0 || maxBlock == 0)
+        return 0;
+    
+    if (isPassthrough())
+    {
+        const int n = std::min(numInput, maxOutput);
+        std::memcpy(output, input, (size_t)n * sizeof(float));
+        return n;
+    }
+    
+    const int carried = tapsPerPhase - 1;
+    int produced = 0;
+    
+    for (int offset = 0; offset < numInput; offset += maxBlock)
+    {
+        const int slice = std::min(maxBlock, numInput - offset);
+        std::memcpy(history.data() + historyLength, input + offset, (size_t)slice * sizeof(float));
+        historyLength += slice;
+        
+        // Every output whose newest input sample is available
+        while (inputIndex < historyLength && produced < maxOutput)
+        {
+            const float* branch = coefficients.data() + (size_t)phase * (size_t)tapsPerPhase;
+            output[produced++] = dotProduct(branch, history.data() + (inputIndex - carried), tapsPerPhase);
+            
+            phase += downFactor;
+            inputIndex += phase / upFactor;
+            phase %= upFactor;
+        }
+        
+        // Output full: drop the unread input rather than overrun the history
+        if (inputIndex < historyLength)
+            inputIndex = historyLength;
+        
+        // Keep only what the next output still needs
+        const int consumed = std::min(inputIndex - carried, historyLength);
+        const int remaining = historyLength - consumed;
+        if (consumed > 0 && remaining > 0)
+            std::memmove(history.data(), history.data() + consumed, (size_t)remaining * sizeof(float));
+        
+        historyLength = remaining;
+        inputIndex -= consumed;
+    }
+    
+    return produced;
+}
+
+int StreamingResampler::getMaxOutputSamples(int numInput) const
+{
+    if (isPassthrough())
+        return numInput;
+    
+    return (int)(((int64_t)numInput * upFactor) / downFactor) + 2;
+}
+
+double StreamingResampler::getLatencyInputSamples() const
+{
+    if (isPassthrough())
+        return 0.0;
+    
+    // Linear-phase prototype delay ((N - 1) / 2 at the upsampled rate)
+    return (double)(tapsPerPhase * upFactor - 1) / (2.0 * upFactor);
+}
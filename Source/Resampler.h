@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+    Created: 9 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Streaming polyphase FIR resampler (device rate -> 16 kHz for Whisper).
+
+    Features:
+    - Exact integer decimation for 48 kHz/96 kHz devices (3:1, 6:1)
+    - Generic rational ratios (44.1 kHz -> 16 kHz is 160/441)
+    - Kaiser-windowed sinc anti-aliasing filter (music above 8 kHz no longer
+      aliases into the band Whisper sees)
+    - Filter history kept across blocks, output written to caller buffers
+    - SSE dot product with scalar fallback
+    - No allocations after prepare() (safe on the audio thread)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+    Stateful polyphase resampler for a single mono stream.
+    
+    Usage:
+        resampler.prepare(48000, 16000, 512);   // Not real-time safe
+        int produced = resampler.process(in, numIn, out, maxOut);  // Real-time safe
+    
+    The up/down factors are the reduced ratio outputRate/inputRate (L/M).
+    Output sample n is taken at upsampled position n*M: its polyphase branch is
+    (n*M mod L) and its newest input sample is floor(n*M / L).
+    
+    Thread Safety:
+    - Single owner; prepare()/reset() must not run concurrently with process()
+*/
+class StreamingResampler
+{
+public:
+    StreamingResampler() = default;
+    
+    /**
+        Design the filter and allocate history storage.
+        
+        @param inputRate        Device sample rate (e.g. 48000, 44100)
+        @param outputRate       Target sample rate (16000 for Whisper)
+        @param maxBlockSize     Largest input block passed to process() in one go
+                                (larger blocks are processed in slices)
+    */
+    void prepare(int inputRate, int outputRate, int maxBlockSize);
+    
+    /**
+        Clear filter history (next output starts a fresh stream).
+    */
+    void reset();
+    
+    /**
+        Resample a block of input.
+        
+        @param input        Input samples at the input rate
+        @param numInput     Number of input samples
+        @param output       Destination for resampled samples
+        @param maxOutput    Capacity of output (use getMaxOutputSamples())
+        @return             Number of output samples written
+        
+        Thread: Audio callback (real-time safe)
+    */
+    int process(const float* input, int numInput, float* output, int maxOutput);
+    
+    /**
+        Upper bound on the output produced by process() for numInput samples.
+    */
+    int getMaxOutputSamples(int numInput) const;
+    
+    /**
+        Filter group delay in input samples.
+        
+        Output produced after N input samples describes the input around
+        (N - latency); callers that map output back onto the input timeline
+        subtract this.
+    */
+    double getLatencyInputSamples() const;
+    
+    int getInputRate() const { return inputRate; }
+    int getOutputRate() const { return outputRate; }
+    int getTapsPerPhase() const { return tapsPerPhase; }
+    bool isPassthrough() const { return upFactor == 1 && downFactor == 1; }
+
+private:
+    void designFilter();
+    static float dotProduct(const float* a, const float* b, int length);
+    
+    int inputRate = 0;
+    int outputRate = 0;
+    int upFactor = 1;           // L
+    int downFactor = 1;         // M
+    int tapsPerPhase = 0;       // Multiple of 4 (SSE width)
+    int maxBlock = 0;
+    
+    // Polyphase branches: phase p occupies [p * tapsPerPhase, (p + 1) * tapsPerPhase),
+    // stored time-reversed so each output is a dot product with contiguous history
+    std::vector<float> coefficients;
+    
+    // (tapsPerPhase - 1) samples of carried history followed by up to maxBlock new samples
+    std::vector<float> history;
+    int historyLength = 0;      // Valid samples in history
+    int inputIndex = 0;         // Newest history sample used by the next output
+    int phase = 0;              // Polyphase branch of the next output
+};
@@ -0,0 +1,175 @@
+/*
+  ==============================================================================
+
+    SessionArena.h
+    Created: 13 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Per-session preallocated buffers for the Whisper thread.
+
+    Features:
+    - Sized once per session from the window length, the number of windows
+      that can be alive at once and the expected words per window
+    - Window sample buffers are pooled: a window's samples travel with its
+      decode job and come back after processTranscription(), so steady-state
+      decoding allocates no sample memory
+    - Per-window word/token/transcript scratch is cleared, never freed
+    - Pool misses are counted (a miss means the sizing was too small and costs
+      one allocation, nothing else)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "LyricsAlignment.h"  // For WordSegment
+#include "ProfanityMatcher.h"
+
+/**
+    Window buffer pool and per-window scratch for one stream.
+    
+    Usage (Whisper thread):
+        arena.prepare({ windowSamples, maxWindows, maxWordsPerWindow });
+        
+        std::vector<float> window = arena.acquireWindow(numSamples);
+        ...                                         // Moved into a decode job
+        arena.recycleWindow(std::move(result.job.samples));
+        
+        SessionArena::WindowScratch& scratch = arena.beginWindow();
+        WhisperTranscript::extractWords(ctx, state, seconds, scratch.transcribedWords, scratch.transcribedTokens);
+    
+    Thread Safety:
+    - Whisper thread only (prepare() before that thread starts)
+*/
+class SessionArena
+{
+public:
+    struct Layout
+    {
+        int windowSamples = 0;              // Longest window (16kHz samples)
+        int maxWindows = 0;                 // Windows alive at once (in flight + the one being read)
+        int maxWordsPerWindow = 0;
+    };
+    
+    /**
+        A lexicon match with its timing resolved (absolute capture samples).
+    */
+    struct ProfanityHit
+    {
+        ProfanityMatcher::Match match;
+        int64_t startSample;
+        int64_t endSample;
+        float confidence;
+    };
+    
+    /**
+        Vectors reused by every window; beginWindow() clears them.
+    */
+    struct WindowScratch
+    {
+        std::vector<WordSegment> transcribedWords;
+        std::vector<whisper_token> transcribedTokens;
+        std::vector<WordSegment> stableWords;
+        std::vector<WordSegment> finalWords;
+        std::string transcript;
+        std::string uiWords;                // One transcript line for the UI state
+        std::vector<ProfanityHit> profanityHits;
+        std::string hitText;                // Lexicon text of the hit being scheduled
+        std::string detectedList;           // Quoted hits for the window summary log
+    };
+    
+    SessionArena() = default;
+    
+    /**
+        Allocate everything for a session (drops the previous session's buffers).
+    */
+    void prepare(const Layout& newLayout)
+    {
+        layout = newLayout;
+        poolMisses = 0;
+        
+        freeWindows.clear();
+        freeWindows.reserve((size_t)layout.maxWindows);
+        for (int i = 0; i < layout.maxWindows; ++i)
+        {
+            freeWindows.emplace_back();
+            freeWindows.back().reserve((size_t)layout.windowSamples);
+        }
+        
+        const size_t words = (size_t)layout.maxWordsPerWindow;
+        scratch.transcribedWords.reserve(words);
+        scratch.transcribedTokens.reserve(words);
+        scratch.stableWords.reserve(words);
+        scratch.finalWords.reserve(words);
+        scratch.transcript.reserve(words * 12);   // Average word plus separator, generously
+        scratch.uiWords.reserve(words * 12);
+        scratch.profanityHits.reserve(words);
+        scratch.hitText.reserve(ProfanityMatcher::MAX_PHRASE_TOKENS * ProfanityMatcher::MAX_TOKEN_CHARS);
+        scratch.detectedList.reserve(words * 12);
+    }
+    
+    /**
+        A window buffer holding numSamples (contents unspecified).
+    */
+    std::vector<float> acquireWindow(int numSamples)
+    {
+        std::vector<float> window;
+        if (!freeWindows.empty())
+        {
+            window = std::move(freeWindows.back());
+            freeWindows.pop_back();
+        }
+        
+        if (window.capacity() < (size_t)numSamples)
+            ++poolMisses;
+        
+        window.resize((size_t)numSamples);
+        return window;
+    }
+    
+    /**
+        Return a window buffer to the pool (moved-from and surplus buffers are dropped).
+    */
+    void recycleWindow(std::vector<float>&& window)
+    {
+        if (window.capacity() == 0 || freeWindows.size() >= freeWindows.capacity())
+            return;
+        
+        window.clear();
+        freeWindows.push_back(std::move(window));
+    }
+    
+    /**
+        Scratch for the next window, cleared (capacity kept).
+    */
+    WindowScratch& beginWindow()
+    {
+        scratch.transcribedWords.clear();
+        scratch.transcribedTokens.clear();
+        scratch.stableWords.clear();
+        scratch.finalWords.clear();
+        scratch.transcript.clear();
+        scratch.uiWords.clear();
+        scratch.profanityHits.clear();
+        scratch.hitText.clear();
+        scratch.detectedList.clear();
+        return scratch;
+    }
+    
+    const Layout& getLayout() const { return layout; }
+    
+    /**
+        Windows acquired that did not fit a pooled buffer (since prepare()).
+    */
+    int getPoolMisses() const { return poolMisses; }
+
+private:
+    Layout layout;
+    std::vector<std::vector<float>> freeWindows;
+    WindowScratch scratch;
+    int poolMisses = 0;
+};
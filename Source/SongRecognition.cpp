@@ -12,9 +12,14 @@
 
 #include "SongRecognition.h"
 #include "LyricsAlignment.h"
+#include "LyricsCache.h"
 #include <juce_core/juce_core.h>
 #include <iostream>
 
+#if EXPLICITLY_USE_CHROMAPRINT
+ #include <chromaprint.h>
+#endif
+
 SongRecognition::SongRecognition()
 {
 }
@@ -24,6 +29,9 @@ bool SongRecognition::initialize(const std::string& fpcalcPath, const std::strin
     fpcalcPath_ = fpcalcPath;
     acoustidApiKey_ = apiKey;
     
+#if EXPLICITLY_USE_CHROMAPRINT
+    std::cout << "[SongRecognition] Using in-process Chromaprint " << chromaprint_get_version() << std::endl;
+#else
     // Validate fpcalc exists
     juce::String fpcalcPathJuce(fpcalcPath_);
     juce::File fpcalc(fpcalcPathJuce);
@@ -33,6 +41,7 @@ bool SongRecognition::initialize(const std::string& fpcalcPath, const std::strin
         enabled_ = false;
         return false;
     }
+#endif
     
     if (acoustidApiKey_.empty())
     {
@@ -72,6 +81,23 @@ SongRecognition::SongInfo SongRecognition::identifySong(const float* audioBuffer
         return result;
     }
     
+    // Same capture seen before: skip the AcoustID round trip
+    if (cache_ != nullptr)
+    {
+        if (auto cached = cache_->findByFingerprint(fingerprint))
+        {
+            result.artist = cached->artist;
+            result.title = cached->title;
+            result.lyrics = cached->lyrics;
+            result.confidence = 1.0f;
+            result.identified = true;
+            
+            std::cout << "[SongRecognition] ✓ Identified from cache: \"" << result.title << "\" by "
+                      << result.artist << std::endl;
+            return result;
+        }
+    }
+    
     int duration = static_cast<int>(numSamples / sampleRate);
     
     // Query AcoustID
@@ -90,6 +116,9 @@ SongRecognition::SongInfo SongRecognition::identifySong(const float* audioBuffer
     {
         std::cout << "[SongRecognition] ✓ Identified: \"" << result.title << "\" by " 
                   << result.artist << " (confidence: " << (int)(result.confidence * 100) << "%)" << std::endl;
+        
+        if (cache_ != nullptr)
+            cache_->storeFingerprint(fingerprint, result.artist, result.title);
     }
     else
     {
@@ -103,7 +132,20 @@ std::string SongRecognition::fetchLyrics(const std::string& artist, const std::s
 {
     std::cout << "[SongRecognition] Fetching lyrics for: \"" << title << "\" by " << artist << std::endl;
     
-    // Use LyricsAlignment::fetchLyrics which tries Genius -> lyrics.ovh
+    // Cache first, then LyricsAlignment::fetchLyrics which tries Genius -> lyrics.ovh
+    if (cache_ != nullptr)
+    {
+        LyricsCache::Entry entry = cache_->fetchOrLoad(artist, title);
+        if (entry.hasLyrics())
+        {
+            std::cout << "[SongRecognition] ✓ Lyrics found: " << entry.lyrics.length() << " chars" << std::endl;
+            return entry.lyrics;
+        }
+        
+        std::cout << "[SongRecognition] ✗ Lyrics not found" << std::endl;
+        return "";
+    }
+    
     ::SongInfo lyricsInfo = LyricsAlignment::fetchLyrics(artist, title);
     
     if (!lyricsInfo.lyrics.empty())
@@ -118,13 +160,7 @@ std::string SongRecognition::fetchLyrics(const std::string& artist, const std::s
 
 std::string SongRecognition::createFingerprint(const float* audioBuffer, int numSamples, double sampleRate)
 {
-    // Write PCM data to temporary raw file
-    juce::File tempFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
-                          .getChildFile("explicitly_fingerprint.raw");
-    
-    std::cout << "[SongRecognition] Writing temp audio: " << tempFile.getFullPathName().toStdString() << std::endl;
-    
-    // Convert float to int16 and write raw PCM
+    // Convert float to int16 PCM (Chromaprint input format)
     std::vector<int16_t> int16Samples(numSamples);
     for (int i = 0; i < numSamples; i++)
     {
@@ -132,6 +168,41 @@ std::string SongRecognition::createFingerprint(const float* audioBuffer, int num
         int16Samples[i] = static_cast<int16_t>(sample * 32767.0f);
     }
     
+#if EXPLICITLY_USE_CHROMAPRINT
+    // In-process fingerprint: no temp file, no child process
+    ChromaprintContext* ctx = chromaprint_new(CHROMAPRINT_ALGORITHM_DEFAULT);
+    if (ctx == nullptr)
+    {
+        std::cout << "[SongRecognition] ERROR: chromaprint_new failed" << std::endl;
+        return "";
+    }
+    
+    std::string result;
+    char* encoded = nullptr;
+    
+    if (chromaprint_start(ctx, (int)sampleRate, 1)
+        && chromaprint_feed(ctx, int16Samples.data(), numSamples)
+        && chromaprint_finish(ctx)
+        && chromaprint_get_fingerprint(ctx, &encoded))
+    {
+        result = encoded;
+        chromaprint_dealloc(encoded);
+        std::cout << "[SongRecognition] Generated fingerprint: " << result.substr(0, 50) << "..." << std::endl;
+    }
+    else
+    {
+        std::cout << "[SongRecognition] ERROR: Chromaprint failed to fingerprint audio" << std::endl;
+    }
+    
+    chromaprint_free(ctx);
+    return result;
+#else
+    // Fallback: write PCM data to temporary raw file for fpcalc
+    juce::File tempFile = juce::File::getSpecialLocation(juce::File::tempDirectory)
+                          .getChildFile("explicitly_fingerprint.raw");
+    
+    std::cout << "[SongRecognition] Writing temp audio: " << tempFile.getFullPathName().toStdString() << std::endl;
+    
     tempFile.replaceWithData(int16Samples.data(), numSamples * sizeof(int16_t));
     
     // Run fpcalc with raw PCM input
@@ -152,7 +223,7 @@ std::string SongRecognition::createFingerprint(const float* audioBuffer, int num
     
     // Read output
     juce::String output = process.readAllProcessOutput();
-    process.waitForProcessToFinish(10000); // 10 second timeout
+    process.waitForProcessToFinish(lookupTimeoutMs_);
     
     tempFile.deleteFile();
     
@@ -170,6 +241,7 @@ std::string SongRecognition::createFingerprint(const float* audioBuffer, int num
     std::cout << "[SongRecognition] Generated fingerprint: " << fingerprint.substring(0, 50).toStdString() << "..." << std::endl;
     
     return fingerprint.toStdString();
+#endif
 }
 
 std::string SongRecognition::queryAcoustID(const std::string& fingerprint, int duration)
@@ -187,7 +259,7 @@ std::string SongRecognition::queryAcoustID(const std::string& fingerprint, int d
     juce::URL apiUrl(url);
     std::unique_ptr<juce::InputStream> stream(apiUrl.createInputStream(
         juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
-            .withConnectionTimeoutMs(10000)
+            .withConnectionTimeoutMs(lookupTimeoutMs_)
             .withNumRedirectsToFollow(3)));
     
     if (stream == nullptr)
@@ -299,7 +371,7 @@ std::string SongRecognition::fetchFromLyricsOVH(const std::string& artist, const
         juce::URL apiUrl(url);
         std::unique_ptr<juce::InputStream> stream(apiUrl.createInputStream(
             juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inAddress)
-                .withConnectionTimeoutMs(5000)
+                .withConnectionTimeoutMs(lookupTimeoutMs_)
                 .withNumRedirectsToFollow(3)));
         
         if (stream == nullptr)
@@ -7,6 +7,10 @@
 
     Song identification using Chromaprint + AcoustID.
     Fetches lyrics from LyricsOVH for known songs.
+    
+    Fingerprinting runs in-process when built against libchromaprint
+    (EXPLICITLY_USE_CHROMAPRINT=1); otherwise fpcalc is spawned as a fallback.
+    All calls block - run them from RecognitionWorker, never the audio thread.
 
   ==============================================================================
 */
@@ -18,6 +22,8 @@
 #include <string>
 #include <vector>
 
+class LyricsCache;
+
 /**
     Song identification and lyrics fetching.
     
@@ -44,9 +50,9 @@ public:
     /**
         Initialize with Chromaprint path and AcoustID API key.
         
-        @param fpcalcPath   Full path to fpcalc.exe (Chromaprint fingerprinter)
+        @param fpcalcPath   Full path to fpcalc.exe (only needed without libchromaprint)
         @param apiKey       AcoustID API key (free from https://acoustid.org/api-key)
-        @return             true if fpcalc exists and API key is valid
+        @return             true if a fingerprinter is available and API key is valid
     */
     bool initialize(const std::string& fpcalcPath, const std::string& apiKey);
     
@@ -86,8 +92,22 @@ public:
     */
     void setEnabled(bool enabled) { enabled_ = enabled; }
     
+    /**
+        Set the connection timeout for AcoustID / lyrics lookups (and fpcalc runtime).
+    */
+    void setLookupTimeoutMs(int timeoutMs) { lookupTimeoutMs_ = timeoutMs; }
+    
+    /**
+        Use a persistent cache for fingerprint -> song and lyrics lookups.
+        
+        @param cache    Cache owned by the caller (nullptr disables caching)
+    */
+    void setCache(LyricsCache* cache) { cache_ = cache; }
+
 private:
     bool enabled_ = false;
+    LyricsCache* cache_ = nullptr;
+    int lookupTimeoutMs_ = 5000;
     std::string fpcalcPath_;
     std::string acoustidApiKey_;
     
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    StageProfiler.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Lock-free per-stage latency histograms.
+
+  ==============================================================================
+*/
+
+#include "StageProfiler.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    constexpr std::memory_order relaxed = std::memory_order_relaxed;
+    
+    const char* const stageNames[StageProfiler::NUM_STAGES] =
+    {
+        "callback",
+        "capture",
+        "resample",
+        "handoff",
+        "decode_queue",
+        "whisper_setup",
+        "whisper_decode",
+        "redecode",
+        "alignment",
+        "profanity_match",
+        "censor_schedule",
+        "post_process"
+    };
+}
+
+//==============================================================================
+void StageProfiler::record(Stage stage, double seconds)
+{
+    if (!(seconds >= 0.0) || stage == Stage::NumStages)
+        return;
+    
+    histograms[(size_t)stage].add((uint64_t)std::llround(seconds * 1.0e6));
+}
+
+void StageProfiler::recordDeadlineSlack(int64_t slackSamples, double sampleRate)
+{
+    if (sampleRate <= 0.0)
+        return;
+    
+    const int64_t micros = (int64_t)std::llround((double)slackSamples * 1.0e6 / sampleRate);
+    
+    if (micros < minSlackMicros.load(relaxed))
+        minSlackMicros.store(micros, relaxed);
+    
+    if (micros < 0)
+        lateEvents.store(lateEvents.load(relaxed) + 1, relaxed);
+    
+    slackHistogram.add((uint64_t)std::max<int64_t>(0, micros));
+}
+
+void StageProfiler::reset()
+{
+    for (auto& histogram : histograms)
+        histogram.clear();
+    
+    slackHistogram.clear();
+    lateEvents.store(0, relaxed);
+    minSlackMicros.store(INT64_MAX, relaxed);
+}
+
+StageProfiler::Snapshot StageProfiler::getSnapshot() const
+{
+    Snapshot snapshot;
+    
+    for (int s = 0; s < NUM_STAGES; ++s)
+    {
+        const LogHistogram::Summary micros = histograms[(size_t)s].summarize();
+        StageSummary& summary = snapshot.stages[(size_t)s];
+        
+        summary.count = micros.count;
+        summary.meanMs = micros.mean / 1000.0;
+        summary.minMs = micros.min / 1000.0;
+        summary.p50Ms = micros.p50 / 1000.0;
+        summary.p90Ms = micros.p90 / 1000.0;
+        summary.p99Ms = micros.p99 / 1000.0;
+        summary.maxMs = micros.max / 1000.0;
+    }
+    
+    const LogHistogram::Summary micros = slackHistogram.summarize();
+    SlackSummary& slack = snapshot.slack;
+    slack.count = micros.count;
+    if (slack.count > 0)
+    {
+        slack.late = lateEvents.load(relaxed);
+        slack.minMs = (double)minSlackMicros.load(relaxed) / 1000.0;
+        slack.p1Ms = micros.p1 / 1000.0;
+        slack.p10Ms = micros.p10 / 1000.0;
+        slack.p50Ms = micros.p50 / 1000.0;
+        slack.maxMs = micros.max / 1000.0;
+    }
+    
+    return snapshot;
+}
+
+const char* StageProfiler::getStageName(Stage stage)
+{
+    const int index = (int)stage;
+    return (index >= 0 && index < NUM_STAGES) ? stageNames[index] : "unknown";
+}
+
+//==============================================================================
+std::string StageProfiler::Snapshot::toString() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    
+    out << "  " << std::left << std::setw(16) << "Stage" << std::right
+        << std::setw(8) << "Count" << std::setw(10) << "Mean" << std::setw(10) << "P50"
+        << std::setw(10) << "P90" << std::setw(10) << "P99" << std::setw(10) << "Max" << "  (ms)\n";
+    
+    for (int s = 0; s < NUM_STAGES; ++s)
+    {
+        const StageSummary& summary = stages[(size_t)s];
+        if (summary.count == 0)
+            continue;
+        
+        out << "  " << std::left << std::setw(16) << getStageName((Stage)s) << std::right
+            << std::setw(8) << summary.count << std::setw(10) << summary.meanMs << std::setw(10) << summary.p50Ms
+            << std::setw(10) << summary.p90Ms << std::setw(10) << summary.p99Ms << std::setw(10) << summary.maxMs << "\n";
+    }
+    
+    if (slack.count > 0)
+    {
+        out << "  Censor deadline slack: " << slack.count << " events, " << slack.late << " late, min "
+            << slack.minMs << " ms, P1 " << slack.p1Ms << " ms, P10 " << slack.p10Ms << " ms, P50 "
+            << slack.p50Ms << " ms\n";
+    }
+    
+    return out.str();
+}
+
+std::string StageProfiler::Snapshot::toJson() const
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    
+    out << "{\n  \"stages\": {\n";
+    for (int s = 0; s < NUM_STAGES; ++s)
+    {
+        const StageSummary& summary = stages[(size_t)s];
+        out << "    \"" << getStageName((Stage)s) << "\": { \"count\": " << summary.count
+            << ", \"mean_ms\": " << summary.meanMs << ", \"min_ms\": " << summary.minMs
+            << ", \"p50_ms\": " << summary.p50Ms << ", \"p90_ms\": " << summary.p90Ms
+            << ", \"p99_ms\": " << summary.p99Ms << ", \"max_ms\": " << summary.maxMs << " }"
+            << (s + 1 < NUM_STAGES ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    
+    out << "  \"censor_deadline_slack\": { \"count\": " << slack.count << ", \"late\": " << slack.late
+        << ", \"min_ms\": " << slack.minMs << ", \"p1_ms\": " << slack.p1Ms << ", \"p10_ms\": " << slack.p10Ms
+        << ", \"p50_ms\": " << slack.p50Ms << ", \"max_ms\": " << slack.maxMs << " }\n";
+    out << "}\n";
+    
+    return out.str();
+}
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Per-stage latency histograms for the capture -> censor pipeline.
+
+    Features:
+    - One fixed-size histogram per pipeline stage (audio callback, capture,
+      resample, handoff, decode queue, Whisper, alignment, profanity match,
+      censor scheduling, post-processing)
+    - Recording is a handful of relaxed atomic stores: no locks, no
+      allocation, safe on the audio thread
+    - Censor deadline slack: how far ahead of the read position each event
+      reached the audio thread (negative = late)
+    - Snapshots with p50/p90/p99 per stage, as text or JSON
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "StreamingStats.h"
+
+/**
+    Lock-free latency instrumentation shared by the audio and Whisper threads.
+    
+    Every stage is written by exactly one thread (the one that runs the stage),
+    so a histogram update is a plain load + store per field rather than a locked
+    read-modify-write. Readers may take a snapshot at any time; a snapshot taken
+    mid-update can be off by the one sample being recorded.
+    
+    Histograms are LogHistograms in microseconds, so percentiles are within
+    ~6% from 1 us up to two minutes.
+    
+    Usage:
+        {
+            StageProfiler::ScopedTimer timer(profiler, StageProfiler::Stage::Resample);
+            resampler.process(...);
+        }
+        
+        profiler.record(StageProfiler::Stage::WhisperDecode, decodeSeconds);
+        std::string json = profiler.getSnapshot().toJson();
+    
+    Thread Safety:
+    - record()/ScopedTimer: the stage's own thread (see Stage)
+    - recordDeadlineSlack(): audio thread
+    - getSnapshot(): any thread
+    - reset(): any thread, but samples recorded concurrently may be lost
+*/
+class StageProfiler
+{
+public:
+    enum class Stage
+    {
+        Callback,           // Whole audio callback                            (audio thread)
+        Capture,            // Downmix, resample, filter, window write         (audio thread)
+        Resample,           // Resampler::process() share of Capture           (audio thread)
+        Handoff,            // Window published -> picked up by Whisper thread (Whisper thread)
+        DecodeQueue,        // Job submitted -> a worker starts decoding       (Whisper thread)
+        WhisperSetup,       // Decode start -> encoder begins (mel, prompt)    (Whisper thread)
+        WhisperDecode,      // Encoder begins -> whisper_full returns          (Whisper thread)
+        Redecode,           // Second pass on flagged sub-windows              (Whisper thread)
+        Alignment,          // LyricsAlignment::alignChunk()                   (Whisper thread)
+        ProfanityMatch,     // Streaming matcher over the emitted words        (Whisper thread)
+        CensorSchedule,     // Hits -> CensorEvents queued                     (Whisper thread)
+        PostProcess,        // Whole processTranscription()                    (Whisper thread)
+        NumStages
+    };
+    
+    static constexpr int NUM_STAGES = (int)Stage::NumStages;
+    
+    struct StageSummary
+    {
+        uint64_t count = 0;
+        double meanMs = 0.0;
+        double minMs = 0.0;
+        double p50Ms = 0.0;
+        double p90Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+    
+    struct SlackSummary
+    {
+        uint64_t count = 0;
+        uint64_t late = 0;              // Events that reached the audio thread after their start
+        double minMs = 0.0;             // Most negative = latest
+        double p1Ms = 0.0;              // Late events count as zero slack in the percentiles
+        double p10Ms = 0.0;
+        double p50Ms = 0.0;
+        double maxMs = 0.0;
+    };
+    
+    struct Snapshot
+    {
+        std::array<StageSummary, NUM_STAGES> stages;
+        SlackSummary slack;
+        
+        std::string toString() const;
+        std::string toJson() const;
+    };
+    
+    /**
+        Times a scope into one stage (steady_clock).
+    */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(StageProfiler& owner, Stage timedStage)
+            : profiler(owner), stage(timedStage), startTime(std::chrono::steady_clock::now()) {}
+        
+        ~ScopedTimer()
+        {
+            profiler.record(stage, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+        }
+    
+    private:
+        StageProfiler& profiler;
+        Stage stage;
+        std::chrono::steady_clock::time_point startTime;
+        
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+    
+    StageProfiler() = default;
+    
+    /**
+        Add one duration to a stage.
+        
+        @param stage    Stage to record into (only from that stage's thread)
+        @param seconds  Duration; negative values are ignored
+        
+        Thread: Stage owner (real-time safe)
+    */
+    void record(Stage stage, double seconds);
+    
+    /**
+        Record how far ahead of the read position a censor event arrived.
+        
+        @param slackSamples     Event start minus the block being played (negative = late)
+        @param sampleRate       Device sample rate
+        
+        Thread: Audio callback (real-time safe)
+    */
+    void recordDeadlineSlack(int64_t slackSamples, double sampleRate);
+    
+    Snapshot getSnapshot() const;
+    void reset();
+    
+    static const char* getStageName(Stage stage);
+
+private:
+    std::array<LogHistogram, NUM_STAGES> histograms;    // Microseconds
+    
+    // Slack: late events are added as zero and also counted separately
+    LogHistogram slackHistogram;
+    std::atomic<uint64_t> lateEvents {0};
+    std::atomic<int64_t> minSlackMicros {INT64_MAX};
+    
+    StageProfiler(const StageProfiler&) = delete;
+    StageProfiler& operator=(const StageProfiler&) = delete;
+};
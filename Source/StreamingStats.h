@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    StreamingStats.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Fixed-size streaming aggregates for long sessions.
+
+    Features:
+    - RunningStats: count, mean, variance (Welford), min and max in O(1) memory
+    - LogHistogram: log-linear buckets (8 per octave) with percentiles,
+      independent of how many samples were recorded
+    - Single writer, any number of readers, no locks or allocation
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+/**
+    Running mean/variance/min/max of a stream of values (Welford's method).
+    
+    Thread Safety:
+    - add()/clear(): one writer thread
+    - Getters: any thread. Fields are individually atomic, so a reader racing
+      add() can see that one sample half-applied.
+*/
+class RunningStats
+{
+public:
+    RunningStats() = default;
+    
+    void add(double value)
+    {
+        const uint64_t n = count.load(std::memory_order_relaxed) + 1;
+        const double oldMean = mean.load(std::memory_order_relaxed);
+        const double newMean = oldMean + (value - oldMean) / (double)n;
+        
+        m2.store(m2.load(std::memory_order_relaxed) + (value - oldMean) * (value - newMean), std::memory_order_relaxed);
+        mean.store(newMean, std::memory_order_relaxed);
+        
+        if (n == 1 || value < minValue.load(std::memory_order_relaxed))
+            minValue.store(value, std::memory_order_relaxed);
+        if (n == 1 || value > maxValue.load(std::memory_order_relaxed))
+            maxValue.store(value, std::memory_order_relaxed);
+        
+        count.store(n, std::memory_order_relaxed);
+    }
+    
+    void clear()
+    {
+        count.store(0, std::memory_order_relaxed);
+        mean.store(0.0, std::memory_order_relaxed);
+        m2.store(0.0, std::memory_order_relaxed);
+        minValue.store(0.0, std::memory_order_relaxed);
+        maxValue.store(0.0, std::memory_order_relaxed);
+    }
+    
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+    double getMean() const { return mean.load(std::memory_order_relaxed); }
+    double getMin() const { return minValue.load(std::memory_order_relaxed); }
+    double getMax() const { return maxValue.load(std::memory_order_relaxed); }
+    
+    double getVariance() const
+    {
+        const uint64_t n = getCount();
+        return n > 1 ? std::max(0.0, m2.load(std::memory_order_relaxed) / (double)(n - 1)) : 0.0;
+    }
+    
+    double getStdDev() const { return std::sqrt(getVariance()); }
+
+private:
+    std::atomic<uint64_t> count {0};
+    std::atomic<double> mean {0.0};
+    std::atomic<double> m2 {0.0};
+    std::atomic<double> minValue {0.0};
+    std::atomic<double> maxValue {0.0};
+    
+    RunningStats(const RunningStats&) = delete;
+    RunningStats& operator=(const RunningStats&) = delete;
+};
+
+/**
+    HDR-style histogram over non-negative integer values (microseconds,
+    milli-RTF, ...).
+    
+    Values below 8 are exact; above, each octave is split into 8 linear
+    buckets, so any percentile is within ~6% of the true value. 200 buckets
+    cover values up to 2^27; larger ones land in the last bucket.
+    
+    Thread Safety:
+    - add()/clear(): one writer thread (a plain load + store per field)
+    - summarize(): any thread; a snapshot taken mid-add() can miss that sample
+*/
+class LogHistogram
+{
+public:
+    static constexpr int SUB_BITS = 3;                  // 2^SUB_BITS buckets per octave
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int NUM_BUCKETS = 200;
+    
+    struct Summary
+    {
+        uint64_t count = 0;
+        double mean = 0.0;
+        double min = 0.0;
+        double p1 = 0.0;
+        double p10 = 0.0;
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+    
+    LogHistogram() = default;
+    
+    void add(uint64_t value)
+    {
+        std::atomic<uint32_t>& bucket = buckets[(size_t)bucketFor(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        
+        if (value < minValue.load(std::memory_order_relaxed))
+            minValue.store(value, std::memory_order_relaxed);
+        if (value > maxValue.load(std::memory_order_relaxed))
+            maxValue.store(value, std::memory_order_relaxed);
+    }
+    
+    void clear()
+    {
+        for (auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        
+        total.store(0, std::memory_order_relaxed);
+        minValue.store(UINT64_MAX, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+    
+    /**
+        Count, mean, extremes and percentiles from one copy of the buckets.
+        Percentiles are bucket midpoints, clamped to the extremes actually seen.
+    */
+    Summary summarize() const
+    {
+        std::array<uint32_t, NUM_BUCKETS> counts;
+        Summary summary;
+        
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+        {
+            counts[(size_t)i] = buckets[(size_t)i].load(std::memory_order_relaxed);
+            summary.count += counts[(size_t)i];
+        }
+        
+        if (summary.count == 0)
+            return summary;
+        
+        summary.mean = (double)total.load(std::memory_order_relaxed) / (double)summary.count;
+        summary.min = (double)minValue.load(std::memory_order_relaxed);
+        summary.max = (double)maxValue.load(std::memory_order_relaxed);
+        
+        auto percentile = [&](double fraction)
+        {
+            const uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(fraction * (double)summary.count));
+            uint64_t seen = 0;
+            int bucket = NUM_BUCKETS - 1;
+            for (int i = 0; i < NUM_BUCKETS; ++i)
+            {
+                seen += counts[(size_t)i];
+                if (seen >= rank)
+                {
+                    bucket = i;
+                    break;
+                }
+            }
+            return std::min(summary.max, std::max(summary.min, bucketMidpoint(bucket)));
+        };
+        
+        summary.p1 = percentile(0.01);
+        summary.p10 = percentile(0.10);
+        summary.p50 = percentile(0.50);
+        summary.p90 = percentile(0.90);
+        summary.p99 = percentile(0.99);
+        return summary;
+    }
+    
+    static int bucketFor(uint64_t value)
+    {
+        if (value < (uint64_t)SUB_BUCKETS)
+            return (int)value;
+        
+        int msb = SUB_BITS;
+        while ((value >> (msb + 1)) != 0)
+            ++msb;
+        
+        // Linear sub-buckets within the octave, from the bits below the leading one
+        const int sub = (int)((value >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1));
+        return std::min(NUM_BUCKETS - 1, SUB_BUCKETS + (msb - SUB_BITS) * SUB_BUCKETS + sub);
+    }
+    
+    static double bucketMidpoint(int bucket)
+    {
+        if (bucket < SUB_BUCKETS)
+            return (double)bucket;
+        
+        const int msb = (bucket - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+        const int sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        const double width = (double)(1ull << (msb - SUB_BITS));
+        return (double)(SUB_BUCKETS + sub) * width + 0.5 * width;
+    }
+
+private:
+    std::array<std::atomic<uint32_t>, NUM_BUCKETS> buckets {};
+    std::atomic<uint64_t> total {0};
+    std::atomic<uint64_t> minValue {UINT64_MAX};
+    std::atomic<uint64_t> maxValue {0};
+    
+    LogHistogram(const LogHistogram&) = delete;
+    LogHistogram& operator=(const LogHistogram&) = delete;
+};
@@ -14,44 +14,56 @@
 #include <iostream>
 #include <numeric>
 #include <iomanip>
+#include <climits>
 
-float TimestampRefiner::calculateEnergy(const std::vector<float>& audio, 
-                                       int start, int length)
+void TimestampRefiner::prepareEnvelope(const std::vector<float>& audio, int sampleRate)
 {
-    if (start < 0 || start + length > (int)audio.size())
-        return 0.0f;
+    const int n = (int)audio.size();
+    
+    // Capacity is kept between chunks (no allocation once the window size is reached)
+    energyPrefix.resize((size_t)n + 1);
+    crossingPrefix.resize((size_t)n + 1);
+    energyPrefix[0] = 0.0;
+    crossingPrefix[0] = 0;
     
-    float sum = 0.0f;
-    for (int i = start; i < start + length; ++i)
+    const float* x = audio.data();
+    double energySum = 0.0;
+    int crossingSum = 0;
+    
+    for (int i = 0; i < n; ++i)
     {
-        float sample = audio[i];
-        sum += sample * sample;
+        energySum += (double)x[i] * x[i];
+        if (i > 0 && (x[i] >= 0.0f) != (x[i - 1] >= 0.0f))
+            crossingSum++;
+        
+        energyPrefix[(size_t)i + 1] = energySum;
+        crossingPrefix[(size_t)i + 1] = crossingSum;
     }
     
-    return std::sqrt(sum / length);
+    envelopeSize = n;
+    envelopeRate = sampleRate;
 }
 
-float TimestampRefiner::calculateZeroCrossing(const std::vector<float>& audio,
-                                             int start, int length)
+float TimestampRefiner::calculateEnergy(int start, int length) const
 {
-    if (start < 0 || start + length > (int)audio.size())
+    if (start < 0 || length <= 0 || start + length > envelopeSize)
         return 0.0f;
     
-    int crossings = 0;
-    for (int i = start + 1; i < start + length; ++i)
-    {
-        if ((audio[i] >= 0.0f && audio[i - 1] < 0.0f) ||
-            (audio[i] < 0.0f && audio[i - 1] >= 0.0f))
-        {
-            crossings++;
-        }
-    }
+    const double sum = energyPrefix[(size_t)(start + length)] - energyPrefix[(size_t)start];
+    return (float)std::sqrt(std::max(0.0, sum) / length);
+}
+
+float TimestampRefiner::calculateZeroCrossing(int start, int length) const
+{
+    if (start < 0 || length <= 0 || start + length > envelopeSize)
+        return 0.0f;
     
+    // Crossings between consecutive samples inside [start, start + length)
+    const int crossings = crossingPrefix[(size_t)(start + length)] - crossingPrefix[(size_t)start + 1];
     return (float)crossings / length;
 }
 
-double TimestampRefiner::findBestBoundary(const std::vector<float>& audio,
-                                         int centerSample,
+double TimestampRefiner::findBestBoundary(int centerSample,
                                          int searchRadius,
                                          int sampleRate,
                                          bool findStart)
@@ -59,20 +71,21 @@ double TimestampRefiner::findBestBoundary(const std::vector<float>& audio,
     // Search direction: backwards for start, forwards for end
     int step = findStart ? -1 : 1;
     int searchStart = std::max(0, centerSample - (findStart ? searchRadius : 0));
-    int searchEnd = std::min((int)audio.size(), centerSample + (findStart ? 0 : searchRadius));
+    int searchEnd = std::min(envelopeSize, centerSample + (findStart ? 0 : searchRadius));
     
     // Find the point with steepest energy change
+    const int windowSize = windowSamples(sampleRate);
     float bestScore = -1.0f;
     int bestSample = centerSample;
     
-    for (int i = searchStart; i < searchEnd; i += WINDOW_SIZE / 4)  // Step by 2.5ms
+    for (int i = searchStart; i < searchEnd; i += windowSize / 4)  // Step by 2.5ms
     {
-        if (i < WINDOW_SIZE || i + WINDOW_SIZE >= (int)audio.size())
+        if (i < windowSize || i + windowSize >= envelopeSize)
             continue;
         
         // Calculate energy gradient
-        float energyBefore = calculateEnergy(audio, i - WINDOW_SIZE, WINDOW_SIZE);
-        float energyAfter = calculateEnergy(audio, i, WINDOW_SIZE);
+        float energyBefore = calculateEnergy(i - windowSize, windowSize);
+        float energyAfter = calculateEnergy(i, windowSize);
         
         float gradient = std::abs(energyAfter - energyBefore);
         
@@ -90,7 +103,6 @@ double TimestampRefiner::findBestBoundary(const std::vector<float>& audio,
 }
 
 std::pair<double, double> TimestampRefiner::searchForSpeech(
-    const std::vector<float>& audio,
     double whisperStart,
     double whisperEnd,
     int sampleRate)
@@ -100,25 +112,26 @@ std::pair<double, double> TimestampRefiner::searchForSpeech(
     int whisperEndSample = (int)(whisperEnd * sampleRate);
     
     // Clamp to buffer bounds
-    whisperStartSample = std::max(0, std::min(whisperStartSample, (int)audio.size() - 1));
-    whisperEndSample = std::max(whisperStartSample, std::min(whisperEndSample, (int)audio.size()));
+    whisperStartSample = std::max(0, std::min(whisperStartSample, envelopeSize - 1));
+    whisperEndSample = std::max(whisperStartSample, std::min(whisperEndSample, envelopeSize));
     
     // Search for actual speech energy around Whisper's guess
     // Strategy: Find energy peaks within search radius
     
-    int searchRadius = SEARCH_RADIUS;
+    const int windowSize = windowSamples(sampleRate);
+    int searchRadius = searchRadiusSamples(sampleRate);
     int searchStart = std::max(0, whisperStartSample - searchRadius);
-    int searchEnd = std::min((int)audio.size(), whisperEndSample + searchRadius);
+    int searchEnd = std::min(envelopeSize, whisperEndSample + searchRadius);
     
     // Find regions with significant energy
     std::vector<std::pair<int, int>> energyRegions;
     bool inSpeech = false;
     int regionStart = 0;
     
-    for (int i = searchStart; i < searchEnd; i += WINDOW_SIZE)
+    for (int i = searchStart; i < searchEnd; i += windowSize)
     {
-        float energy = calculateEnergy(audio, i, WINDOW_SIZE);
-        float zc = calculateZeroCrossing(audio, i, WINDOW_SIZE);
+        float energy = calculateEnergy(i, windowSize);
+        float zc = calculateZeroCrossing(i, windowSize);
         
         bool isSpeech = (energy > ENERGY_THRESHOLD && zc > ZC_THRESHOLD);
         
@@ -169,8 +182,8 @@ std::pair<double, double> TimestampRefiner::searchForSpeech(
     }
     
     // Refine boundaries of best region
-    double refinedStart = findBestBoundary(audio, bestRegion.first, WINDOW_SIZE * 4, sampleRate, true);
-    double refinedEnd = findBestBoundary(audio, bestRegion.second, WINDOW_SIZE * 4, sampleRate, false);
+    double refinedStart = findBestBoundary(bestRegion.first, windowSize * 4, sampleRate, true);
+    double refinedEnd = findBestBoundary(bestRegion.second, windowSize * 4, sampleRate, false);
     
     // Sanity checks
     if (refinedEnd <= refinedStart)
@@ -182,26 +195,30 @@ std::pair<double, double> TimestampRefiner::searchForSpeech(
     return {refinedStart, refinedEnd};
 }
 
-void TimestampRefiner::refineWordTimestamp(WordSegment& word, 
-                                          const std::vector<float>& audio,
-                                          int sampleRate)
+void TimestampRefiner::refineWordTimestamp(WordSegment& word, int sampleRate)
 {
+    // Nothing prepared at this rate: no envelope to refine against
+    if (sampleRate != envelopeRate || envelopeSize == 0)
+        return;
+    
     // Store original Whisper timestamps for debugging
     double originalStart = word.start;
     double originalEnd = word.end;
     
     // Calculate max energy in search region for debugging
-    int searchStart = std::max(0, (int)(originalStart * sampleRate) - SEARCH_RADIUS);
-    int searchEnd = std::min((int)audio.size(), (int)(originalEnd * sampleRate) + SEARCH_RADIUS);
+    const int windowSize = windowSamples(sampleRate);
+    const int searchRadius = searchRadiusSamples(sampleRate);
+    int searchStart = std::max(0, (int)(originalStart * sampleRate) - searchRadius);
+    int searchEnd = std::min(envelopeSize, (int)(originalEnd * sampleRate) + searchRadius);
     float maxEnergy = 0.0f;
-    for (int i = searchStart; i < searchEnd; i += WINDOW_SIZE)
+    for (int i = searchStart; i < searchEnd; i += windowSize)
     {
-        float e = calculateEnergy(audio, i, WINDOW_SIZE);
+        float e = calculateEnergy(i, windowSize);
         maxEnergy = std::max(maxEnergy, e);
     }
     
     // Search for actual speech content
-    auto [refinedStart, refinedEnd] = searchForSpeech(audio, originalStart, originalEnd, sampleRate);
+    auto [refinedStart, refinedEnd] = searchForSpeech(originalStart, originalEnd, sampleRate);
     
     // Update word segment
     word.start = refinedStart;
@@ -228,15 +245,18 @@ std::vector<std::pair<double, double>> TimestampRefiner::findSpeechRegions(
     const std::vector<float>& audio,
     int sampleRate)
 {
+    prepareEnvelope(audio, sampleRate);
+    
     std::vector<std::pair<double, double>> regions;
     
+    const int windowSize = windowSamples(sampleRate);
     bool inSpeech = false;
     int regionStart = 0;
     
-    for (int i = 0; i < (int)audio.size(); i += WINDOW_SIZE)
+    for (int i = 0; i < envelopeSize; i += windowSize)
     {
-        float energy = calculateEnergy(audio, i, WINDOW_SIZE);
-        float zc = calculateZeroCrossing(audio, i, WINDOW_SIZE);
+        float energy = calculateEnergy(i, windowSize);
+        float zc = calculateZeroCrossing(i, windowSize);
         
         bool isSpeech = (energy > ENERGY_THRESHOLD && zc > ZC_THRESHOLD);
         
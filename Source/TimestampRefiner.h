@@ -22,48 +22,58 @@ class TimestampRefiner
 public:
     TimestampRefiner() = default;
     
+    // Build the energy / zero-crossing envelope of a buffer (prefix sums of squares
+    // and sign changes). Call once per chunk before refining its words: every window
+    // query below is then O(1) instead of a rescan of the window.
+    void prepareEnvelope(const std::vector<float>& audio, int sampleRate);
+    
     // Refine a word's timestamp using audio energy analysis
-    // audio: full audio buffer (48kHz)
-    // word: word segment to refine (timestamps in seconds)
-    // sampleRate: audio sample rate
-    void refineWordTimestamp(WordSegment& word, 
-                            const std::vector<float>& audio,
-                            int sampleRate);
+    // word: word segment to refine (timestamps in seconds, relative to the prepared buffer)
+    // sampleRate: audio sample rate (must match prepareEnvelope(); otherwise the word is left as is)
+    // Reads the envelope from the last prepareEnvelope() call, so prepare every chunk first
+    // (a pooled buffer refilled in place is a new chunk)
+    void refineWordTimestamp(WordSegment& word, int sampleRate);
     
     // Find speech regions in audio buffer using energy + zero-crossing
-    // Returns vector of (start, end) time pairs in seconds
+    // Returns vector of (start, end) time pairs in seconds (replaces the prepared envelope)
     std::vector<std::pair<double, double>> findSpeechRegions(
         const std::vector<float>& audio,
         int sampleRate);
 
 private:
-    // Calculate RMS energy for a window of audio
-    float calculateEnergy(const std::vector<float>& audio, 
-                         int start, int length);
+    // Calculate RMS energy for a window of the prepared buffer
+    float calculateEnergy(int start, int length) const;
     
     // Calculate zero-crossing rate (detects voiced speech)
-    float calculateZeroCrossing(const std::vector<float>& audio,
-                               int start, int length);
+    float calculateZeroCrossing(int start, int length) const;
     
     // Find the best word boundary using energy profile
-    double findBestBoundary(const std::vector<float>& audio,
-                           int centerSample,
+    double findBestBoundary(int centerSample,
                            int searchRadius,
                            int sampleRate,
                            bool findStart);
     
     // Search for actual speech content around Whisper's timestamp
     std::pair<double, double> searchForSpeech(
-        const std::vector<float>& audio,
         double whisperStart,
         double whisperEnd,
         int sampleRate);
     
+    // Analysis window / search radius converted to samples at the buffer's rate
+    static int windowSamples(int sampleRate) { return std::max(4, (int)(WINDOW_SECONDS * sampleRate)); }
+    static int searchRadiusSamples(int sampleRate) { return (int)(SEARCH_RADIUS_SECONDS * sampleRate); }
+    
     // Parameters (tuned for music with vocals + tiny model late timestamps)
     static constexpr float ENERGY_THRESHOLD = 0.001f;     // Minimum energy for speech (lowered for music)
     static constexpr float ZC_THRESHOLD = 0.1f;           // Zero-crossing rate threshold (lowered)
-    static constexpr int WINDOW_SIZE = 480;               // 10ms @ 48kHz
-    static constexpr int SEARCH_RADIUS = 38400;           // 0.8s search radius @ 48kHz (increased for tiny model)
+    static constexpr double WINDOW_SECONDS = 0.010;       // 10ms analysis window (480 @ 48kHz, 160 @ 16kHz)
+    static constexpr double SEARCH_RADIUS_SECONDS = 0.8;  // 0.8s search radius (increased for tiny model)
     static constexpr float MIN_WORD_DURATION = 0.05f;     // 50ms minimum word length
     static constexpr float MAX_WORD_DURATION = 2.0f;      // 2s maximum word length
+    
+    // Envelope of the current chunk: prefix[i] covers samples [0, i)
+    std::vector<double> energyPrefix;     // Sum of squares (double: no drift over long buffers)
+    std::vector<int> crossingPrefix;      // Sign changes between samples j-1 and j, for j < i
+    int envelopeSize = 0;
+    int envelopeRate = 0;
 };
@@ -17,8 +17,8 @@
 /**
     Audio chunk metadata passed from Audio thread to ASR thread.
     
-    Metadata-only: ~32 bytes (safe for stack copying in real-time callback)
-    ASRThread reads actual audio data from CircularBuffer using this metadata.
+    Metadata-only: ~40 bytes (safe for stack copying in real-time callback)
+    The Whisper thread reads actual audio data from CircularBuffer using this metadata.
 */
 struct AudioChunk
 {
@@ -26,6 +26,7 @@ struct AudioChunk
     int num_samples;            // Number of samples available in CircularBuffer
     int num_channels;           // Number of channels in CircularBuffer
     double timestamp;           // Timestamp for latency tracking
+    int64_t published_ns;       // steady_clock time of publishing (handoff latency)
 };
 
 /**
@@ -44,6 +45,8 @@ struct CensorEvent
     Mode mode;                  // Censorship mode
     char word[64];              // Detected profanity word (for debugging)
     double confidence;          // ASR confidence (for debugging)
+    bool tentative = false;     // Proposed by the keyword spotter, awaiting Whisper (never merged)
+    bool cancel = false;        // Withdraw the tentative event with exactly this range (if not yet playing)
 };
 
 /**
@@ -58,7 +61,8 @@ struct DebugMessage
         ProfanityDetected,  // Profanity word detected
         CensorApplied,  // Censorship applied to audio
         BufferStatus,   // Buffer position info
-        RawJSON        // Raw Vosk JSON output
+        RawJSON,       // Raw Vosk JSON output
+        Log            // AsyncLogger line (text holds its string arguments)
     };
     
     Type type;
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    UiStateModel.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Engine → UI state channel implementation.
+
+  ==============================================================================
+*/
+
+#include "UiStateModel.h"
+
+void UiStateModel::reset()
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    staged.song = Song();
+    staged.heardWords.clear();
+    staged.lyricsWords.clear();
+    staged.stats = Stats();
+    ++staged.songVersion;
+    ++staged.heardVersion;
+    ++staged.lyricsVersion;
+    ++staged.statsVersion;
+    publish();
+}
+
+void UiStateModel::setSong(const std::string& artist, const std::string& title, float confidence)
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    staged.song.state = SongState::Identified;
+    staged.song.artist = artist;
+    staged.song.title = title;
+    staged.song.confidence = confidence;
+    ++staged.songVersion;
+    
+    // The previous song's lyrics no longer apply (the UI shows the new song loading)
+    staged.lyricsWords.clear();
+    ++staged.lyricsVersion;
+    publish();
+}
+
+void UiStateModel::setSongNotRecognized()
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    staged.song.state = SongState::NotRecognized;
+    staged.song.artist.clear();
+    staged.song.title.clear();
+    staged.song.confidence = 0.0f;
+    ++staged.songVersion;
+    publish();
+}
+
+void UiStateModel::appendHeardWords(const std::string& words)
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    appendWords(staged.heardWords, words);
+    ++staged.heardVersion;
+    publish();
+}
+
+void UiStateModel::appendLyricsWords(const std::string& words)
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    appendWords(staged.lyricsWords, words);
+    ++staged.lyricsVersion;
+    publish();
+}
+
+void UiStateModel::setStats(const Stats& stats)
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    if (stats == staged.stats)
+        return;
+    
+    staged.stats = stats;
+    ++staged.statsVersion;
+    publish();
+}
+
+void UiStateModel::postMessage(const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(producerMutex);
+    
+    staged.messages[(size_t)(staged.messagesPosted % MAX_MESSAGES)] = message;
+    ++staged.messagesPosted;
+    publish();
+}
+
+const UiStateModel::Snapshot& UiStateModel::read()
+{
+    // Nothing new: keep the slot we have
+    if ((handover.load(std::memory_order_relaxed) & FRESH) == 0)
+        return slots[(size_t)front];
+    
+    // Acquire: the producer finished writing the slot before releasing it
+    front = handover.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    return slots[(size_t)front];
+}
+
+void UiStateModel::publish()
+{
+    ++staged.version;
+    
+    // Slot assignment reuses the strings' capacity, so steady publishing does not allocate
+    slots[(size_t)back] = staged;
+    back = handover.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+}
+
+void UiStateModel::appendWords(std::string& line, const std::string& words)
+{
+    if (words.empty())
+        return;
+    
+    if (!line.empty())
+        line += ' ';
+    line += words;
+    
+    // Keep the last MAX_WORDS words
+    int spaces = 0;
+    for (size_t i = line.size(); i-- > 0;)
+    {
+        if (line[i] == ' ' && ++spaces == MAX_WORDS)
+        {
+            line.erase(0, i + 1);
+            break;
+        }
+    }
+}
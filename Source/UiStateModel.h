@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    UiStateModel.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    What the UI shows, handed from the engine threads to the message thread.
+
+    Producers (Whisper thread, media session thread, song recognition on the
+    message thread, logger thread) update one staged state and publish a copy
+    of it; the UI picks up the latest copy on its timer. Nothing crosses
+    threads as a callback, and no producer builds a juce::String or posts to
+    the message thread.
+
+    - Triple-buffered snapshot: publishing and reading never wait for each
+      other, and the UI always sees one complete state
+    - Per-section versions, so the UI repaints only what changed
+    - The transcript keeps the last few words, log lines a short history
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/**
+    Engine → UI state channel.
+    
+    Usage:
+        // Engine threads
+        uiState.setSong(artist, title, confidence);
+        uiState.appendHeardWords("words whisper decoded");
+        
+        // Message thread (timer)
+        const UiStateModel::Snapshot& state = uiState.read();
+        if (state.songVersion != shownSongVersion) ...     // Repaint the song row only
+    
+    Thread Safety:
+    - Producer methods: any thread except the audio thread. Producers are serialized by
+      a short internal lock the UI never takes (a few string copies into reused slots).
+    - read(): one consumer thread (the message thread); wait-free
+*/
+class UiStateModel
+{
+public:
+    static constexpr int MAX_WORDS = 10;        // Per transcript line
+    static constexpr int MAX_MESSAGES = 32;     // Log lines a snapshot keeps
+    
+    enum class SongState
+    {
+        Pending,            // Nothing identified yet
+        Identified,
+        NotRecognized
+    };
+    
+    struct Song
+    {
+        SongState state = SongState::Pending;
+        std::string artist;
+        std::string title;
+        float confidence = 0.0f;
+    };
+    
+    struct Stats
+    {
+        double bufferSeconds = 0.0;     // Delay line fill
+        bool underrun = false;
+        float inputLevel = 0.0f;        // RMS 0.0-1.0
+        
+        bool operator==(const Stats& other) const
+        {
+            return bufferSeconds == other.bufferSeconds && underrun == other.underrun && inputLevel == other.inputLevel;
+        }
+    };
+    
+    struct Snapshot
+    {
+        uint64_t version = 0;           // Advances with every publish
+        
+        // Section versions (each advances when its section changes)
+        uint64_t songVersion = 0;
+        uint64_t heardVersion = 0;
+        uint64_t lyricsVersion = 0;
+        uint64_t statsVersion = 0;
+        uint64_t messagesPosted = 0;    // Log lines ever posted
+        
+        Song song;
+        std::string heardWords;         // Whisper transcription, last MAX_WORDS words
+        std::string lyricsWords;        // Aligned/corrected lyrics, last MAX_WORDS words
+        Stats stats;
+        
+        /**
+            A posted log line, by sequence number (0 = first ever posted).
+            
+            @return     nullptr if it was not posted yet or is older than the last MAX_MESSAGES
+        */
+        const std::string* getMessage(uint64_t sequence) const
+        {
+            if (sequence >= messagesPosted || sequence + MAX_MESSAGES < messagesPosted)
+                return nullptr;
+            return &messages[(size_t)(sequence % MAX_MESSAGES)];
+        }
+        
+        std::array<std::string, MAX_MESSAGES> messages;     // Ring, see getMessage()
+    };
+    
+    UiStateModel() = default;
+    
+    //==========================================================================
+    // Producers
+    
+    /**
+        Back to the idle state (new session). Every section version advances.
+    */
+    void reset();
+    
+    void setSong(const std::string& artist, const std::string& title, float confidence);
+    void setSongNotRecognized();
+    
+    /**
+        Append words to a transcript line (space separated; older words beyond MAX_WORDS drop off).
+    */
+    void appendHeardWords(const std::string& words);
+    void appendLyricsWords(const std::string& words);
+    
+    /**
+        Publishes only if a value changed.
+    */
+    void setStats(const Stats& stats);
+    
+    void postMessage(const std::string& message);
+    
+    //==========================================================================
+    // Consumer
+    
+    /**
+        Latest published state. Valid until the next read().
+        
+        Thread: Consumer only (message thread)
+    */
+    const Snapshot& read();
+
+private:
+    void publish();
+    static void appendWords(std::string& line, const std::string& words);
+    
+    std::mutex producerMutex;
+    Snapshot staged;                                // Producer state (producerMutex)
+    
+    // Triple buffer: the producers own slots[back], the consumer slots[front], the third is handed over
+    static constexpr int FRESH = 4;                 // Set in handover when it holds an unread snapshot
+    std::array<Snapshot, 3> slots;
+    int back = 0;                                   // producerMutex
+    int front = 1;                                  // Consumer only
+    std::atomic<int> handover {2};
+};
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    VocalActivityGate.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Implementation of the pre-decode vocal activity gate.
+
+  ==============================================================================
+*/
+
+#include "VocalActivityGate.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void VocalActivityGate::initialize(int sampleRate)
+{
+    frameSamples = std::max(16, (int)(FRAME_SECONDS * sampleRate));
+    highPassTemplate = makeHighPass(BAND_LOW_HZ, sampleRate);
+    lowPassTemplate = makeLowPass(BAND_HIGH_HZ, sampleRate);
+    initialized = true;
+    
+    reset();
+    
+    std::cout << "[VocalGate] Initialized: " << sampleRate << " Hz, band " << BAND_LOW_HZ << "-"
+              << BAND_HIGH_HZ << " Hz, " << frameSamples << "-sample frames" << std::endl;
+}
+
+void VocalActivityGate::reset()
+{
+    hangoverLeft = 0;
+    consecutiveSkips = 0;
+}
+
+VocalActivityGate::Biquad VocalActivityGate::makeHighPass(double cutoffHz, double sampleRate)
+{
+    // 2nd-order Butterworth (RBJ cookbook, Q = 1/sqrt(2)); analyze() runs two in series
+    // so loud bass (-24 dB/oct) stays below the band floor
+    const double omega = 2.0 * M_PI * cutoffHz / sampleRate;
+    const double cosOmega = std::cos(omega);
+    const double alpha = std::sin(omega) / (2.0 * 0.7071067811865476);
+    const double a0 = 1.0 + alpha;
+    
+    Biquad filter;
+    filter.b0 = (float)((1.0 + cosOmega) / 2.0 / a0);
+    filter.b1 = (float)(-(1.0 + cosOmega) / a0);
+    filter.b2 = filter.b0;
+    filter.a1 = (float)(-2.0 * cosOmega / a0);
+    filter.a2 = (float)((1.0 - alpha) / a0);
+    return filter;
+}
+
+VocalActivityGate::Biquad VocalActivityGate::makeLowPass(double cutoffHz, double sampleRate)
+{
+    const double omega = 2.0 * M_PI * cutoffHz / sampleRate;
+    const double cosOmega = std::cos(omega);
+    const double alpha = std::sin(omega) / (2.0 * 0.7071067811865476);
+    const double a0 = 1.0 + alpha;
+    
+    Biquad filter;
+    filter.b0 = (float)((1.0 - cosOmega) / 2.0 / a0);
+    filter.b1 = (float)((1.0 - cosOmega) / a0);
+    filter.b2 = filter.b0;
+    filter.a1 = (float)(-2.0 * cosOmega / a0);
+    filter.a2 = (float)((1.0 - alpha) / a0);
+    return filter;
+}
+
+VocalActivityGate::Decision VocalActivityGate::analyze(const float* samples, int numSamples)
+{
+    Decision decision;
+    
+    if (!enabled || !initialized || samples == nullptr || numSamples < frameSamples)
+    {
+        decision.reason = "disabled";
+        return decision;
+    }
+    
+    // Windows overlap in streaming mode, so every window starts from clean filter state
+    Biquad highPass1 = highPassTemplate;
+    Biquad highPass2 = highPassTemplate;
+    Biquad lowPass = lowPassTemplate;
+    
+    const int numFrames = numSamples / frameSamples;
+    int vocalFrames = 0;
+    int activeFrames = 0;
+    float peakRms = 0.0f;
+    
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        const float* x = samples + (size_t)frame * frameSamples;
+        
+        float totalEnergy = 0.0f;
+        float upperEnergy = 0.0f;       // Above the band's low edge
+        float bandEnergy = 0.0f;
+        int crossings = 0;
+        float previous = 0.0f;
+        
+        for (int i = 0; i < frameSamples; ++i)
+        {
+            const float upper = highPass2.process(highPass1.process(x[i]));
+            const float band = lowPass.process(upper);
+            
+            totalEnergy += x[i] * x[i];
+            upperEnergy += upper * upper;
+            bandEnergy += band * band;
+            crossings += ((band >= 0.0f) != (previous >= 0.0f)) ? 1 : 0;
+            previous = band;
+        }
+        
+        const float rms = std::sqrt(totalEnergy / (float)frameSamples);
+        const float bandRms = std::sqrt(bandEnergy / (float)frameSamples);
+        peakRms = std::max(peakRms, rms);
+        
+        if (rms < SILENCE_RMS)
+            continue;
+        
+        ++activeFrames;
+        
+        // Bass and kick alone never reach the band floor; hiss and cymbals put
+        // most of the energy above 300 Hz outside the band
+        if (bandRms < SILENCE_RMS)
+            continue;
+        
+        const float bandShare = bandEnergy / std::max(upperEnergy, 1.0e-12f);
+        const float zcr = (float)crossings / (float)frameSamples;
+        
+        if (bandShare >= MIN_BAND_SHARE && zcr >= MIN_VOICED_ZCR && zcr <= MAX_VOICED_ZCR)
+            ++vocalFrames;
+    }
+    
+    decision.vocalFraction = (numFrames > 0) ? (float)vocalFrames / (float)numFrames : 0.0f;
+    decision.peakLevel = peakRms;
+    decision.vocal = decision.vocalFraction >= MIN_VOCAL_FRACTION;
+    
+    if (decision.vocal)
+    {
+        hangoverLeft = HANGOVER_WINDOWS;
+        consecutiveSkips = 0;
+        decision.decode = true;
+        decision.reason = "vocal";
+    }
+    else if (hangoverLeft > 0)
+    {
+        --hangoverLeft;
+        consecutiveSkips = 0;
+        decision.decode = true;
+        decision.reason = "hangover";
+    }
+    else if (consecutiveSkips >= MAX_CONSECUTIVE_SKIPS && activeFrames > 0)
+    {
+        // Periodic probe (never for pure silence - there is nothing to mis-detect)
+        consecutiveSkips = 0;
+        decision.decode = true;
+        decision.reason = "probe";
+    }
+    else
+    {
+        ++consecutiveSkips;
+        decision.decode = false;
+        decision.reason = (activeFrames == 0) ? "silence" : "instrumental";
+    }
+    
+    return decision;
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    VocalActivityGate.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Cheap pre-decode vocal activity detection.
+
+    Instrumental intros, bridges and silence between tracks go through
+    whisper_full like everything else, and isNonLyricalContent() can only
+    tell after the decode has been paid for. The gate looks at the 16kHz
+    window first (frame energy, vocal-band energy share, zero-crossing rate)
+    and lets the decode be skipped when nothing sounds like a voice.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+/**
+    Decides per Whisper window whether a decode is worthwhile.
+    
+    A 20ms frame counts as vocal when its vocal band (300 Hz - 3.4 kHz) is
+    above the silence floor, most of its energy above 300 Hz sits inside that
+    band (rules out hiss and cymbals) and its band-passed zero-crossing rate
+    is in the voiced range.
+    A window is vocal when enough of its frames are.
+    
+    The gate errs towards decoding: a vocal window keeps the gate open for
+    HANGOVER_WINDOWS more windows (soft phrase tails), and after
+    MAX_CONSECUTIVE_SKIPS skipped windows one probe decode is forced so a
+    misjudged quiet vocal cannot stay uncensored.
+    
+    Thread Safety:
+    - Not thread-safe; owned by the Whisper thread
+*/
+class VocalActivityGate
+{
+public:
+    struct Decision
+    {
+        bool decode = true;             // Run whisper_full on this window
+        bool vocal = true;              // Frames say vocals are present
+        float vocalFraction = 1.0f;     // Vocal frames / frames
+        float peakLevel = 0.0f;         // Highest frame RMS in the window
+        const char* reason = "";        // Short tag for logs ("vocal", "hangover", "probe", "silence", "instrumental")
+    };
+    
+    VocalActivityGate() = default;
+    
+    /**
+        Prepare the band filters for the given rate.
+        
+        @param sampleRate   Rate of the analyzed audio (16000 for Whisper windows)
+    */
+    void initialize(int sampleRate);
+    
+    /**
+        Analyze one window and decide whether to decode it.
+        
+        @param samples      Mono samples
+        @param numSamples   Number of samples
+        @return             Decision (always decode when disabled or uninitialized)
+    */
+    Decision analyze(const float* samples, int numSamples);
+    
+    /**
+        Forget hangover/probe history (new session or stream discontinuity).
+    */
+    void reset();
+    
+    void setEnabled(bool shouldBeEnabled) { enabled = shouldBeEnabled; }
+    bool isEnabled() const { return enabled; }
+
+private:
+    struct Biquad
+    {
+        float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+        float a1 = 0.0f, a2 = 0.0f;
+        float z1 = 0.0f, z2 = 0.0f;     // Transposed direct form II state
+        
+        float process(float x)
+        {
+            const float y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+    };
+    
+    static Biquad makeHighPass(double cutoffHz, double sampleRate);
+    static Biquad makeLowPass(double cutoffHz, double sampleRate);
+    
+    // Parameters (tuned conservative: a wasted decode is cheaper than a missed word)
+    static constexpr double FRAME_SECONDS = 0.020;          // 20ms analysis frames
+    static constexpr double BAND_LOW_HZ = 300.0;
+    static constexpr double BAND_HIGH_HZ = 3400.0;
+    static constexpr float SILENCE_RMS = 0.004f;            // ~-48 dBFS frame floor
+    static constexpr float MIN_BAND_SHARE = 0.60f;          // Vocal-band energy / energy above 300 Hz
+    static constexpr float MIN_VOICED_ZCR = 0.01f;          // Crossings per sample (band-passed)
+    static constexpr float MAX_VOICED_ZCR = 0.30f;
+    static constexpr float MIN_VOCAL_FRACTION = 0.10f;      // Vocal frames needed per window
+    static constexpr int HANGOVER_WINDOWS = 1;
+    static constexpr int MAX_CONSECUTIVE_SKIPS = 4;
+    
+    bool enabled = true;
+    bool initialized = false;
+    int frameSamples = 320;
+    Biquad highPassTemplate;
+    Biquad lowPassTemplate;
+    
+    int hangoverLeft = 0;
+    int consecutiveSkips = 0;
+};
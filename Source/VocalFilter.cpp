@@ -5,14 +5,23 @@
     Created: 10 Dec 2024
     Author: Explicitly Audio Systems
 
-    Implementation of lightweight vocal frequency isolation.
+    Implementation of the streaming vocal band filter.
 
   ==============================================================================
 */
 
 #include "VocalFilter.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #define EXPLICITLY_VOCALFILTER_SSE 1
+ #include <xmmintrin.h>
+#else
+ #define EXPLICITLY_VOCALFILTER_SSE 0
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -27,19 +36,35 @@ void VocalFilter::initialize(double sampleRate)
     
     // Calculate filter coefficients for bandpass (150 Hz - 5000 Hz)
     // Extra wide range to minimize static while still isolating vocals
-    highPassCoeffs_ = calculateHighPass(150.0, sampleRate);
-    lowPassCoeffs_ = calculateLowPass(5000.0, sampleRate);
+    numSections = 0;
+    setSection(numSections++, calculateHighPass(150.0, sampleRate));
+    setSection(numSections++, calculateLowPass(5000.0, sampleRate));
+    
+    // Unused lanes pass through (their output is never read)
+    for (int k = numSections; k < MAX_SECTIONS; ++k)
+        setSection(k, { 1.0, 0.0, 0.0, 0.0, 0.0 });
     
     reset();
     initialized_ = true;
     
-    std::cout << "[VocalFilter] Initialized: " << sampleRate << " Hz, bandpass 150-5000 Hz" << std::endl;
+    std::cout << "[VocalFilter] Initialized: " << sampleRate << " Hz, bandpass 150-5000 Hz, " 
+              << numSections << " sections (latency " << getLatencySamples() << " samples)" << std::endl;
 }
 
 void VocalFilter::reset()
 {
-    highPassState_ = BiquadState();
-    lowPassState_ = BiquadState();
+    std::fill(z1_, z1_ + MAX_SECTIONS, 0.0f);
+    std::fill(z2_, z2_ + MAX_SECTIONS, 0.0f);
+    std::fill(y_, y_ + MAX_SECTIONS, 0.0f);
+}
+
+void VocalFilter::setSection(int section, const BiquadCoeffs& coeffs)
+{
+    b0_[section] = (float)coeffs.b0;
+    b1_[section] = (float)coeffs.b1;
+    b2_[section] = (float)coeffs.b2;
+    a1_[section] = (float)coeffs.a1;
+    a2_[section] = (float)coeffs.a2;
 }
 
 VocalFilter::BiquadCoeffs VocalFilter::calculateHighPass(double cutoffHz, double sampleRate)
@@ -82,19 +107,70 @@ VocalFilter::BiquadCoeffs VocalFilter::calculateLowPass(double cutoffHz, double
     return coeffs;
 }
 
-double VocalFilter::processSample(double sample, const BiquadCoeffs& coeffs, BiquadState& state)
+void VocalFilter::process(float* samples, int numSamples)
 {
-    // Direct Form II biquad implementation
-    double output = coeffs.b0 * sample + coeffs.b1 * state.x1 + coeffs.b2 * state.x2
-                  - coeffs.a1 * state.y1 - coeffs.a2 * state.y2;
+    if (!initialized_ || samples == nullptr || numSamples <= 0)
+        return;
+    
+    // Each step, lane k filters what lane k-1 produced on the previous step:
+    //   x = [input, y0, y1, y2]
+    //   y = b0*x + z1;  z1 = b1*x - a1*y + z2;  z2 = b2*x - a2*y
+    // The last section's output therefore trails the input by (numSections - 1) samples.
+    const int outputLane = numSections - 1;
+
+#if EXPLICITLY_VOCALFILTER_SSE
+    const __m128 b0 = _mm_load_ps(b0_);
+    const __m128 b1 = _mm_load_ps(b1_);
+    const __m128 b2 = _mm_load_ps(b2_);
+    const __m128 a1 = _mm_load_ps(a1_);
+    const __m128 a2 = _mm_load_ps(a2_);
+    __m128 z1 = _mm_load_ps(z1_);
+    __m128 z2 = _mm_load_ps(z2_);
+    __m128 y = _mm_load_ps(y_);
+    alignas(16) float lanes[MAX_SECTIONS];
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // [y0, y0, y1, y2] with the new input moved into lane 0
+        const __m128 x = _mm_move_ss(_mm_shuffle_ps(y, y, _MM_SHUFFLE(2, 1, 0, 0)), _mm_set_ss(samples[i]));
+        
+        y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        
+        _mm_store_ps(lanes, y);
+        samples[i] = lanes[outputLane];
+    }
     
-    // Update state
-    state.x2 = state.x1;
-    state.x1 = sample;
-    state.y2 = state.y1;
-    state.y1 = output;
+    _mm_store_ps(z1_, z1);
+    _mm_store_ps(z2_, z2);
+    _mm_store_ps(y_, y);
+#else
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float x[MAX_SECTIONS];
+        x[0] = samples[i];
+        for (int k = 1; k < MAX_SECTIONS; ++k)
+            x[k] = y_[k - 1];
+        
+        for (int k = 0; k < MAX_SECTIONS; ++k)
+        {
+            y_[k] = b0_[k] * x[k] + z1_[k];
+            z1_[k] = b1_[k] * x[k] - a1_[k] * y_[k] + z2_[k];
+            z2_[k] = b2_[k] * x[k] - a2_[k] * y_[k];
+        }
+        
+        samples[i] = y_[outputLane];
+    }
+#endif
     
-    return output;
+    // Decayed state would sink into denormals over a silent stretch (slow on x86)
+    for (int k = 0; k < MAX_SECTIONS; ++k)
+    {
+        if (std::abs(z1_[k]) < 1.0e-15f) z1_[k] = 0.0f;
+        if (std::abs(z2_[k]) < 1.0e-15f) z2_[k] = 0.0f;
+        if (std::abs(y_[k]) < 1.0e-15f) y_[k] = 0.0f;
+    }
 }
 
 void VocalFilter::processBuffer(std::vector<float>& buffer)
@@ -105,16 +181,5 @@ void VocalFilter::processBuffer(std::vector<float>& buffer)
         return;
     }
     
-    for (size_t i = 0; i < buffer.size(); ++i)
-    {
-        double sample = buffer[i];
-        
-        // Apply high-pass (remove bass/drums)
-        sample = processSample(sample, highPassCoeffs_, highPassState_);
-        
-        // Apply low-pass (remove cymbals/hi-hats)
-        sample = processSample(sample, lowPassCoeffs_, lowPassState_);
-        
-        buffer[i] = static_cast<float>(sample);
-    }
+    process(buffer.data(), (int)buffer.size());
 }
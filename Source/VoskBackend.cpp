@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    VoskBackend.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Vosk streaming recognizer implementation.
+
+  ==============================================================================
+*/
+
+#include "VoskBackend.h"
+#include <algorithm>
+#include <iostream>
+
+#if EXPLICITLY_USE_VOSK
+ #include <vosk_api.h>
+#endif
+
+VoskBackend::VoskBackend(const juce::File& directory)
+    : modelDirectory(directory)
+{
+    if (modelDirectory == juce::File())
+    {
+        juce::File exeDir = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory();
+        modelDirectory = exeDir.getChildFile("Models").getChildFile("vosk-model-small-en-us");
+    }
+}
+
+VoskBackend::~VoskBackend()
+{
+    release();
+}
+
+#if EXPLICITLY_USE_VOSK
+
+bool VoskBackend::prepare(int rate)
+{
+    release();
+    sampleRate = rate;
+    
+    if (!modelDirectory.isDirectory())
+    {
+        lastError = "Vosk model not found at: " + modelDirectory.getFullPathName();
+        std::cout << "[Vosk] ERROR: " << lastError << std::endl;
+        return false;
+    }
+    
+    vosk_set_log_level(-1);
+    model = vosk_model_new(modelDirectory.getFullPathName().toRawUTF8());
+    if (model == nullptr)
+    {
+        lastError = "Failed to load Vosk model from: " + modelDirectory.getFullPathName();
+        std::cout << "[Vosk] ERROR: " << lastError << std::endl;
+        return false;
+    }
+    
+    recognizer = vosk_recognizer_new(model, (float)sampleRate);
+    if (recognizer == nullptr)
+    {
+        lastError = "Failed to create Vosk recognizer";
+        std::cout << "[Vosk] ERROR: " << lastError << std::endl;
+        release();
+        return false;
+    }
+    
+    // Word timing on finals AND partials (the partials are what make the spotter early)
+    vosk_recognizer_set_max_alternatives(recognizer, 0);
+    vosk_recognizer_set_words(recognizer, 1);
+    vosk_recognizer_set_partial_words(recognizer, 1);
+    
+    pcm.reserve((size_t)sampleRate / 4);
+    std::cout << "[Vosk] Model loaded: " << modelDirectory.getFileName() << " @ " << sampleRate << " Hz" << std::endl;
+    return true;
+}
+
+void VoskBackend::acceptAudio(const float* samples, int numSamples)
+{
+    if (recognizer == nullptr || numSamples <= 0)
+        return;
+    
+    pcm.resize((size_t)numSamples);
+    for (int i = 0; i < numSamples; ++i)
+        pcm[(size_t)i] = (short)(std::max(-1.0f, std::min(1.0f, samples[i])) * 32767.0f);
+    
+    const int status = vosk_recognizer_accept_waveform_s(recognizer, pcm.data(), numSamples);
+    if (status < 0)
+    {
+        lastError = "vosk_recognizer_accept_waveform failed";
+        return;
+    }
+    
+    Hypothesis hypothesis;
+    if (status == 1)
+    {
+        // Utterance closed: its words are final, the next partial starts a new utterance
+        hypothesis.isFinal = true;
+        lastPartial.clear();
+        if (parseResult(vosk_recognizer_result(recognizer), hypothesis))
+            pending.push_back(std::move(hypothesis));
+        return;
+    }
+    
+    const char* partial = vosk_recognizer_partial_result(recognizer);
+    if (partial == nullptr || lastPartial == partial)
+        return;
+    
+    lastPartial = partial;
+    if (parseResult(partial, hypothesis))
+        pending.push_back(std::move(hypothesis));
+}
+
+void VoskBackend::reset()
+{
+    if (recognizer != nullptr)
+        vosk_recognizer_reset(recognizer);
+    
+    pending.clear();
+    lastPartial.clear();
+}
+
+void VoskBackend::release()
+{
+    if (recognizer != nullptr)
+    {
+        vosk_recognizer_free(recognizer);
+        recognizer = nullptr;
+    }
+    
+    if (model != nullptr)
+    {
+        vosk_model_free(model);
+        model = nullptr;
+    }
+    
+    pending.clear();
+    lastPartial.clear();
+}
+
+#else
+
+bool VoskBackend::prepare(int rate)
+{
+    sampleRate = rate;
+    lastError = "Built without Vosk (set VOSK_SDK_DIR and reconfigure)";
+    std::cout << "[Vosk] " << lastError << std::endl;
+    return false;
+}
+
+void VoskBackend::acceptAudio(const float*, int) {}
+void VoskBackend::reset() {}
+void VoskBackend::release() {}
+
+#endif
+
+bool VoskBackend::popHypothesis(Hypothesis& hypothesis)
+{
+    if (pending.empty())
+        return false;
+    
+    hypothesis = std::move(pending.front());
+    pending.pop_front();
+    return true;
+}
+
+bool VoskBackend::parseResult(const char* json, Hypothesis& hypothesis)
+{
+    hypothesis.words.clear();
+    if (json == nullptr)
+        return false;
+    
+    juce::var parsed = juce::JSON::parse(juce::String::fromUTF8(json));
+    auto* object = parsed.getDynamicObject();
+    if (object == nullptr)
+        return false;
+    
+    // Finals carry "result", partials "partial_result" (with set_partial_words)
+    juce::var words = object->getProperty("result");
+    if (!words.isArray())
+        words = object->getProperty("partial_result");
+    if (!words.isArray())
+        return false;
+    
+    for (const auto& entry : *words.getArray())
+    {
+        auto* wordObject = entry.getDynamicObject();
+        if (wordObject == nullptr)
+            continue;
+        
+        Word word;
+        word.text = wordObject->getProperty("word").toString().toLowerCase().toStdString();
+        word.start = (double)wordObject->getProperty("start");
+        word.end = (double)wordObject->getProperty("end");
+        if (wordObject->hasProperty("conf"))
+            word.confidence = (float)(double)wordObject->getProperty("conf");
+        
+        if (!word.text.empty())
+            hypothesis.words.push_back(std::move(word));
+    }
+    
+    return !hypothesis.words.empty();
+}
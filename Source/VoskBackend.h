@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    VoskBackend.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Vosk (Kaldi) streaming recognizer as an AsrBackend.
+
+    Features:
+    - A partial hypothesis with word timing after every accepted block, so a
+      lexicon word can be proposed ~100ms after it was sung
+    - A final hypothesis when Vosk closes the utterance (endpointing)
+    - Identical consecutive partials are dropped (nothing new to match)
+    - Built only with EXPLICITLY_USE_VOSK=1 (CMake sets it when the Vosk SDK
+      is found); otherwise prepare() fails and the spotter stays off
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "AsrBackend.h"
+
+#ifndef EXPLICITLY_USE_VOSK
+ #define EXPLICITLY_USE_VOSK 0
+#endif
+
+struct VoskModel;
+struct VoskRecognizer;
+
+/**
+    Thread Safety:
+    - Not thread safe (see AsrBackend)
+*/
+class VoskBackend : public AsrBackend
+{
+public:
+    /**
+        @param modelDirectory   Unpacked Vosk model; default Models/vosk-model-small-en-us
+                                next to the executable
+    */
+    explicit VoskBackend(const juce::File& modelDirectory = juce::File());
+    ~VoskBackend() override;
+    
+    /**
+        Built with the Vosk SDK (otherwise prepare() always fails).
+    */
+    static constexpr bool isAvailable() { return EXPLICITLY_USE_VOSK != 0; }
+    
+    std::string getName() const override { return "vosk"; }
+    bool isStreaming() const override { return true; }
+    
+    bool prepare(int sampleRate) override;
+    void acceptAudio(const float* samples, int numSamples) override;
+    bool popHypothesis(Hypothesis& hypothesis) override;
+    void reset() override;
+    
+    juce::String getLastError() const override { return lastError; }
+    
+    /**
+        Parse a Vosk result or partial-result JSON document into words.
+        
+        @param json         vosk_recognizer_result() / _partial_result() output
+        @param hypothesis   Words replaced; isFinal is left to the caller
+        @return             false if the document holds no timed words
+    */
+    static bool parseResult(const char* json, Hypothesis& hypothesis);
+
+private:
+    void release();
+    
+    juce::File modelDirectory;
+    VoskModel* model = nullptr;
+    VoskRecognizer* recognizer = nullptr;
+    int sampleRate = 16000;
+    
+    std::vector<short> pcm;                 // int16 conversion scratch (Vosk's input format)
+    std::deque<Hypothesis> pending;
+    std::string lastPartial;                // Previous partial JSON (duplicates are skipped)
+    juce::String lastError;
+    
+    VoskBackend(const VoskBackend&) = delete;
+    VoskBackend& operator=(const VoskBackend&) = delete;
+};
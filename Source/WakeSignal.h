@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    WakeSignal.h
+    Created: 9 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Non-blocking wake-up signal from the audio thread to a worker thread.
+
+    Replaces sleep-polling and condition variables (which need a mutex on
+    the notifying side) with an OS semaphore:
+    - Windows: Win32 semaphore (ReleaseSemaphore never blocks)
+    - macOS: dispatch semaphore
+    - Linux/other POSIX: sem_t (sem_post is async-signal-safe)
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <windows.h>
+#elif defined(__APPLE__)
+ #include <dispatch/dispatch.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+ #include <ctime>
+#endif
+
+/**
+    Auto-reset wake-up signal (one waiter, any number of notifiers).
+    
+    Notifications coalesce: several notify() calls before the worker wakes
+    produce a single wake-up, so the worker must drain all pending work
+    (e.g. pop its queue until empty) after wait() returns.
+    
+    Thread Safety:
+    - notify(): any thread, real-time safe (no locks, no allocation, never blocks)
+    - wait(): single consumer thread
+*/
+class WakeSignal
+{
+public:
+    WakeSignal()
+    {
+#if defined(_WIN32)
+        semaphore = CreateSemaphoreW(nullptr, 0, 1, nullptr);
+#elif defined(__APPLE__)
+        semaphore = dispatch_semaphore_create(0);
+#else
+        sem_init(&semaphore, 0, 0);
+#endif
+    }
+    
+    ~WakeSignal()
+    {
+#if defined(_WIN32)
+        if (semaphore != nullptr)
+            CloseHandle(semaphore);
+#elif defined(__APPLE__)
+        dispatch_release(semaphore);
+#else
+        sem_destroy(&semaphore);
+#endif
+    }
+    
+    /**
+        Wake the waiting thread (or make its next wait() return immediately).
+        
+        Thread: Any (audio callback safe)
+    */
+    void notify()
+    {
+        // Only the first notification since the last wake-up touches the semaphore
+        if (pending.exchange(true))
+            return;
+
+#if defined(_WIN32)
+        ReleaseSemaphore(semaphore, 1, nullptr);
+#elif defined(__APPLE__)
+        dispatch_semaphore_signal(semaphore);
+#else
+        sem_post(&semaphore);
+#endif
+    }
+    
+    /**
+        Block until notified or until the timeout expires.
+        
+        @param timeout_ms   Maximum time to wait in milliseconds
+        @return             true if woken by notify(), false on timeout
+        
+        Thread: Consumer only
+    */
+    bool wait(int timeout_ms)
+    {
+        bool signalled = false;
+
+#if defined(_WIN32)
+        signalled = WaitForSingleObject(semaphore, (DWORD)timeout_ms) == WAIT_OBJECT_0;
+#elif defined(__APPLE__)
+        signalled = dispatch_semaphore_wait(semaphore,
+                        dispatch_time(DISPATCH_TIME_NOW, (int64_t)timeout_ms * 1000000)) == 0;
+#else
+        timespec deadline {};
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        
+        int result;
+        do
+        {
+            result = sem_timedwait(&semaphore, &deadline);
+        }
+        while (result != 0 && errno == EINTR);
+        
+        signalled = (result == 0);
+#endif
+        
+        // Re-arm before the caller drains its work: a notify() racing with the
+        // drain posts again, so nothing published after this point is missed
+        if (signalled)
+            pending.store(false);
+        
+        return signalled;
+    }
+
+private:
+    std::atomic<bool> pending {false};
+
+#if defined(_WIN32)
+    HANDLE semaphore = nullptr;
+#elif defined(__APPLE__)
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+    
+    WakeSignal(const WakeSignal&) = delete;
+    WakeSignal& operator=(const WakeSignal&) = delete;
+};
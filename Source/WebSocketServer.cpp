@@ -5,85 +5,457 @@
     Created: 12 Dec 2024
     Author: Explicitly Audio Systems
 
-    WebSocket server implementation using Windows Sockets.
+    Multi-client WebSocket audio ingest (non-blocking event loop).
 
   ==============================================================================
 */
 
-#define WIN32_LEAN_AND_MEAN
-#include <winsock2.h>
-#include <ws2tcpip.h>
-#pragma comment(lib, "ws2_32.lib")
-
 #include "WebSocketServer.h"
-#include <vector>
-#include <string>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
 #include <sstream>
-#include <iomanip>
 
-// SHA-1 implementation for WebSocket handshake
-namespace {
-    // Simple SHA-1 for WebSocket key generation
-    std::string base64Encode(const unsigned char* data, size_t len) {
+#if defined(_WIN32)
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #include <winsock2.h>
+ #include <ws2tcpip.h>
+#else
+ #include <arpa/inet.h>
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <netinet/in.h>
+ #include <netinet/tcp.h>
+ #include <poll.h>
+ #include <sys/socket.h>
+ #include <unistd.h>
+ #if defined(__linux__)
+  #include <sys/epoll.h>
+ #endif
+#endif
+
+namespace
+{
+   #if defined(_WIN32)
+    using NativeSocket = SOCKET;
+    const NativeSocket invalidSocket = INVALID_SOCKET;
+    constexpr int SEND_FLAGS = 0;
+    
+    void closeNativeSocket(NativeSocket s) { closesocket(s); }
+    bool lastCallWouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+    
+    bool setNonBlocking(NativeSocket s)
+    {
+        u_long mode = 1;
+        return ioctlsocket(s, FIONBIO, &mode) == 0;
+    }
+   #else
+    using NativeSocket = int;
+    const NativeSocket invalidSocket = -1;
+    #if defined(MSG_NOSIGNAL)
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL;       // A vanished client must not raise SIGPIPE
+    #else
+    constexpr int SEND_FLAGS = 0;                  // macOS: SO_NOSIGPIPE per socket
+    #endif
+    
+    void closeNativeSocket(NativeSocket s) { ::close(s); }
+    bool lastCallWouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+    
+    bool setNonBlocking(NativeSocket s)
+    {
+        const int flags = fcntl(s, F_GETFL, 0);
+        return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+   #endif
+    
+    NativeSocket toNative(std::intptr_t s) { return (NativeSocket)s; }
+    
+    constexpr size_t INBOUND_BUFFER_BYTES = 64 * 1024;     // Per session; one read at most
+    constexpr size_t MAX_HANDSHAKE_BYTES = 8 * 1024;
+    constexpr size_t MAX_OUTBOUND_BYTES = 64 * 1024;       // Client not reading control frames -> dropped
+    constexpr size_t MAX_PUSH_QUEUE_BYTES = 256 * 1024;    // Push messages waiting for the socket, per session
+    constexpr double PAUSE_FILL = 0.75;                    // Ring fill that stops reading a session
+    constexpr double RESUME_FILL = 0.25;                   // ...and the fill that resumes it
+    constexpr int LISTENER_TOKEN = -1;
+    constexpr int WAKE_TOKEN = -2;
+    
+    constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+    constexpr uint8_t OPCODE_TEXT = 0x1;
+    constexpr uint8_t OPCODE_BINARY = 0x2;
+    constexpr uint8_t OPCODE_CLOSE = 0x8;
+    constexpr uint8_t OPCODE_PING = 0x9;
+    constexpr uint8_t OPCODE_PONG = 0xA;
+    
+    constexpr uint16_t CLOSE_PROTOCOL_ERROR = 1002;
+    constexpr uint16_t CLOSE_GOING_AWAY = 1001;
+    
+    std::string base64Encode(const unsigned char* data, size_t len)
+    {
         static const char* base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
         std::string ret;
         int i = 0;
         unsigned char char_array_3[3];
         unsigned char char_array_4[4];
-
-        while (len--) {
+        
+        while (len--)
+        {
             char_array_3[i++] = *(data++);
-            if (i == 3) {
+            if (i == 3)
+            {
                 char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
                 char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
                 char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
                 char_array_4[3] = char_array_3[2] & 0x3f;
-
-                for(i = 0; i < 4; i++)
+                
+                for (i = 0; i < 4; i++)
                     ret += base64_chars[char_array_4[i]];
                 i = 0;
             }
         }
-
-        if (i) {
-            for(int j = i; j < 3; j++)
+        
+        if (i)
+        {
+            for (int j = i; j < 3; j++)
                 char_array_3[j] = '\0';
-
+            
             char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
             char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
             char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-
+            
             for (int j = 0; j < i + 1; j++)
                 ret += base64_chars[char_array_4[j]];
-
-            while(i++ < 3)
+            
+            while (i++ < 3)
                 ret += '=';
         }
-
+        
         return ret;
     }
-
-    // Simplified SHA-1 (for WebSocket accept key)
-    std::string sha1(const std::string& input) {
-        // For simplicity, using a hash approximation
-        // In production, use proper SHA-1 from OpenSSL or CryptoAPI
-        unsigned char hash[20] = {0};
+    
+    /**
+        SHA-1 (FIPS 180-1) for the Sec-WebSocket-Accept key; browsers reject anything else.
+    */
+    std::array<unsigned char, 20> sha1(const std::string& message)
+    {
+        auto rotl = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
         
-        // Simple hash for demo (NOT cryptographically secure)
-        for (size_t i = 0; i < input.length(); i++) {
-            hash[i % 20] ^= input[i];
-            hash[(i + 1) % 20] += input[i];
+        uint32_t h[5] = { 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+        
+        std::string data = message;
+        const uint64_t bitLength = (uint64_t)message.size() * 8;
+        data += (char)0x80;
+        while (data.size() % 64 != 56)
+            data += (char)0x00;
+        for (int i = 7; i >= 0; --i)
+            data += (char)((bitLength >> (i * 8)) & 0xFF);
+        
+        for (size_t chunk = 0; chunk < data.size(); chunk += 64)
+        {
+            uint32_t w[80];
+            for (int i = 0; i < 16; ++i)
+            {
+                const auto* p = reinterpret_cast<const unsigned char*>(data.data() + chunk + i * 4);
+                w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+            }
+            for (int i = 16; i < 80; ++i)
+                w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+            
+            uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; ++i)
+            {
+                uint32_t f, k;
+                if (i < 20)      { f = (b & c) | (~b & d);           k = 0x5A827999u; }
+                else if (i < 40) { f = b ^ c ^ d;                    k = 0x6ED9EBA1u; }
+                else if (i < 60) { f = (b & c) | (b & d) | (c & d);  k = 0x8F1BBCDCu; }
+                else             { f = b ^ c ^ d;                    k = 0xCA62C1D6u; }
+                
+                const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = temp;
+            }
+            
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
         }
         
-        return std::string((char*)hash, 20);
+        std::array<unsigned char, 20> digest {};
+        for (int i = 0; i < 20; ++i)
+            digest[(size_t)i] = (unsigned char)((h[i / 4] >> (24 - (i % 4) * 8)) & 0xFF);
+        return digest;
+    }
+    
+    std::string toLowerAscii(std::string text)
+    {
+        for (auto& c : text)
+            if (c >= 'A' && c <= 'Z')
+                c = (char)(c - 'A' + 'a');
+        return text;
+    }
+    
+    int nextPowerOfTwo(int value)
+    {
+        int result = 1;
+        while (result < value)
+            result <<= 1;
+        return result;
     }
 }
 
-WebSocketServer::WebSocketServer(int p)
+//==============================================================================
+// Shared between the server thread (producer) and the consumer
+struct WebSocketServer::Slot
+{
+    enum State { Free, Open, Closed };
+    
+    // Who may touch the ring while the slot is not Free: claimed by the consumer
+    // on its first read, or reclaimed by the server for reuse (never both)
+    enum Reader { Unclaimed, Claimed, Reclaimed };
+    
+    explicit Slot(int capacity)
+        : ring((size_t)capacity, 0.0f), mask((uint64_t)capacity - 1) {}
+    
+    uint64_t getNumAvailable() const
+    {
+        return writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_acquire);
+    }
+    
+    std::atomic<int> state {Free};
+    std::atomic<int> reader {Reclaimed};
+    std::atomic<uint32_t> generation {0};
+    
+    std::vector<float> ring;
+    const uint64_t mask;
+    alignas(64) std::atomic<uint64_t> readPosition {0};     // Consumer
+    alignas(64) std::atomic<uint64_t> writePosition {0};    // Server thread
+    
+    std::atomic<uint64_t> samplesReceived {0};
+    std::atomic<uint64_t> framesReceived {0};
+    std::atomic<uint32_t> pauses {0};
+    std::atomic<bool> paused {false};
+    
+    // Outbound push messages (any producer thread -> server thread)
+    std::mutex pushMutex;
+    std::deque<std::string> pushQueue;
+    size_t pushQueueBytes = 0;
+    std::atomic<bool> pushPending {false};
+    std::atomic<uint64_t> messagesSent {0};
+    std::atomic<uint64_t> messagesDropped {0};
+};
+
+//==============================================================================
+// Connection and frame parser state (server thread only)
+struct WebSocketServer::Session
+{
+    enum class Phase { Idle, Handshake, Open };
+    
+    Session() : inbound(INBOUND_BUFFER_BYTES) {}
+    
+    void reset()
+    {
+        socket = (std::intptr_t)invalidSocket;
+        phase = Phase::Idle;
+        opened = false;
+        paused = false;
+        failed = false;
+        wantWrite = false;
+        inboundLength = 0;
+        outbound.clear();
+        outboundOffset = 0;
+        inPayload = false;
+        messageOpcode = 0;
+        hasLowByte = false;
+        controlLength = 0;
+    }
+    
+    int index = 0;                          // Slot this session feeds
+    std::intptr_t socket = (std::intptr_t)invalidSocket;
+    Phase phase = Phase::Idle;
+    bool opened = false;                    // Handshake done, slot handed to the consumer
+    bool paused = false;                    // Backpressure: not reading
+    bool failed = false;                    // Close after the current event
+    bool wantWrite = false;
+    std::string remoteAddress;
+    
+    std::vector<uint8_t> inbound;
+    size_t inboundLength = 0;
+    std::string outbound;
+    size_t outboundOffset = 0;
+    
+    // Current frame
+    bool inPayload = false;
+    bool fin = false;
+    uint8_t frameOpcode = 0;
+    uint8_t messageOpcode = 0;              // Opcode of the (possibly fragmented) message
+    uint8_t maskKey[4] = {};
+    uint32_t maskIndex = 0;
+    uint64_t remaining = 0;
+    
+    // Sample split across two reads
+    bool hasLowByte = false;
+    uint8_t lowByte = 0;
+    
+    uint8_t control[125] = {};
+    size_t controlLength = 0;
+};
+
+//==============================================================================
+// Readiness notification: epoll on Linux, WSAPoll/poll elsewhere (level-triggered)
+class WebSocketServer::EventLoop
+{
+public:
+    struct Event
+    {
+        int token = 0;
+        bool readable = false;
+        bool writable = false;
+        bool error = false;
+    };
+    
+    ~EventLoop() { close(); }
+
+   #if defined(__linux__)
+    bool open()
+    {
+        epollFd = epoll_create1(0);
+        return epollFd >= 0;
+    }
+    
+    void close()
+    {
+        if (epollFd >= 0)
+            ::close(epollFd);
+        epollFd = -1;
+    }
+    
+    void add(NativeSocket s, int token, bool read, bool write) { control(EPOLL_CTL_ADD, s, token, read, write); }
+    void modify(NativeSocket s, int token, bool read, bool write) { control(EPOLL_CTL_MOD, s, token, read, write); }
+    void remove(NativeSocket s, int) { epoll_ctl(epollFd, EPOLL_CTL_DEL, s, nullptr); }
+    
+    void wait(int timeoutMs, std::vector<Event>& events)
+    {
+        events.clear();
+        epoll_event ready[64];
+        const int n = epoll_wait(epollFd, ready, 64, timeoutMs);
+        for (int i = 0; i < n; ++i)
+        {
+            Event event;
+            event.token = ready[i].data.fd;
+            event.readable = (ready[i].events & EPOLLIN) != 0;
+            event.writable = (ready[i].events & EPOLLOUT) != 0;
+            event.error = (ready[i].events & (EPOLLERR | EPOLLHUP)) != 0;
+            events.push_back(event);
+        }
+    }
+
+private:
+    void control(int operation, NativeSocket s, int token, bool read, bool write)
+    {
+        epoll_event event {};
+        event.events = (read ? EPOLLIN : 0u) | (write ? EPOLLOUT : 0u);
+        event.data.fd = token;
+        epoll_ctl(epollFd, operation, s, &event);
+    }
+    
+    int epollFd = -1;
+   #else
+    bool open() { return true; }
+    void close() { entries.clear(); }
+    
+    void add(NativeSocket s, int token, bool read, bool write) { entries.push_back({ s, token, read, write }); }
+    
+    void modify(NativeSocket, int token, bool read, bool write)
+    {
+        for (auto& entry : entries)
+        {
+            if (entry.token == token)
+            {
+                entry.read = read;
+                entry.write = write;
+            }
+        }
+    }
+    
+    void remove(NativeSocket, int token)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(), [token](const Entry& e) { return e.token == token; }),
+                      entries.end());
+    }
+    
+    void wait(int timeoutMs, std::vector<Event>& events)
+    {
+        events.clear();
+        pollFds.resize(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            pollFds[i] = {};
+            pollFds[i].fd = entries[i].socket;
+            pollFds[i].events = (short)((entries[i].read ? POLLIN : 0) | (entries[i].write ? POLLOUT : 0));
+        }
+
+       #if defined(_WIN32)
+        // WSAPoll rejects an empty or all-idle set; the listener is always in it
+        const int n = WSAPoll(pollFds.data(), (ULONG)pollFds.size(), timeoutMs);
+       #else
+        const int n = ::poll(pollFds.data(), (nfds_t)pollFds.size(), timeoutMs);
+       #endif
+        if (n <= 0)
+            return;
+        
+        for (size_t i = 0; i < pollFds.size(); ++i)
+        {
+            if (pollFds[i].revents == 0)
+                continue;
+            
+            Event event;
+            event.token = entries[i].token;
+            event.readable = (pollFds[i].revents & POLLIN) != 0;
+            event.writable = (pollFds[i].revents & POLLOUT) != 0;
+            event.error = (pollFds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+            events.push_back(event);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        NativeSocket socket;
+        int token;
+        bool read;
+        bool write;
+    };
+
+   #if defined(_WIN32)
+    using PollFd = WSAPOLLFD;
+   #else
+    using PollFd = pollfd;
+   #endif
+    
+    std::vector<Entry> entries;
+    std::vector<PollFd> pollFds;
+   #endif
+};
+
+//==============================================================================
+WebSocketServer::WebSocketServer(int p, int numSessions, int ringSamples)
     : port(p)
-    , running(false)
-    , serverSocket(INVALID_SOCKET)
-    , clientSocket(INVALID_SOCKET)
+    , maxSessions(std::max(1, numSessions))
+    , ringCapacity(nextPowerOfTwo(std::max(1024, ringSamples)))
+    , listenSocket((std::intptr_t)invalidSocket)
+    , wakeSocket((std::intptr_t)invalidSocket)
 {
 }
 
@@ -92,254 +464,905 @@ WebSocketServer::~WebSocketServer()
     stop();
 }
 
-bool WebSocketServer::start(AudioCallback callback)
+bool WebSocketServer::start(AudioAvailableCallback onAudioAvailable, SessionCallback onSessionChanged)
 {
-    if (running)
+    if (running.load())
         return true;
-
-    audioCallback = callback;
-
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "[WebSocket] Starting server on port " << port << std::endl;
-    std::cout << "========================================\n" << std::endl;
-
-    // Initialize Winsock
+    
+    audioAvailableCallback = std::move(onAudioAvailable);
+    sessionCallback = std::move(onSessionChanged);
+    
+    std::cout << "[WebSocket] Starting server on port " << port << " (" << maxSessions << " sessions, "
+              << ringCapacity << " samples per ring)" << std::endl;
+
+   #if defined(_WIN32)
     WSADATA wsaData;
-    int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-    if (result != 0) {
-        std::cout << "[WebSocket] ✗ WSAStartup failed: " << result << std::endl;
+    const int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    if (result != 0)
+    {
+        std::cout << "[WebSocket] ERROR: WSAStartup failed: " << result << std::endl;
         return false;
     }
-
-    running = true;
+   #endif
+    
+    // Everything the sessions need is allocated here, before the first client
+    slots.clear();
+    sessions.clear();
+    for (int i = 0; i < maxSessions; ++i)
+    {
+        slots.push_back(std::make_unique<Slot>(ringCapacity));
+        sessions.push_back(std::make_unique<Session>());
+        sessions.back()->index = i;
+    }
+    
+    eventLoop = std::make_unique<EventLoop>();
+    if (!eventLoop->open() || !openListener() || !openWakeSocket())
+    {
+        if (toNative(listenSocket) != invalidSocket)
+            closeNativeSocket(toNative(listenSocket));
+        listenSocket = (std::intptr_t)invalidSocket;
+        eventLoop.reset();
+       #if defined(_WIN32)
+        WSACleanup();
+       #endif
+        return false;
+    }
+    
+    running.store(true, std::memory_order_release);
     serverThread = std::thread(&WebSocketServer::serverLoop, this);
-
-    std::cout << "[WebSocket] ✓ Server started successfully" << std::endl;
-    std::cout << "[WebSocket] Browser extension can now connect\n" << std::endl;
-
+    
+    std::cout << "[WebSocket] Listening for browser connections..." << std::endl;
     return true;
 }
 
 void WebSocketServer::stop()
 {
-    if (!running)
+    if (!running.exchange(false))
         return;
-
+    
     std::cout << "[WebSocket] Stopping server..." << std::endl;
-
-    running = false;
-
-    if (clientSocket != INVALID_SOCKET) {
-        closesocket(clientSocket);
-        clientSocket = INVALID_SOCKET;
-    }
-
-    if (serverSocket != INVALID_SOCKET) {
-        closesocket(serverSocket);
-        serverSocket = INVALID_SOCKET;
-    }
-
+    
     if (serverThread.joinable())
         serverThread.join();
+    
+    if (toNative(wakeSocket) != invalidSocket)
+        closeNativeSocket(toNative(wakeSocket));
+    wakeSocket = (std::intptr_t)invalidSocket;
+    eventLoop.reset();
 
+   #if defined(_WIN32)
     WSACleanup();
+   #endif
+    
+    std::cout << "[WebSocket] Server stopped" << std::endl;
+}
 
-    std::cout << "[WebSocket] Server stopped\n" << std::endl;
+int WebSocketServer::getNumOpenSessions() const
+{
+    int open = 0;
+    for (const auto& slot : slots)
+        if (slot->state.load(std::memory_order_acquire) == Slot::Open)
+            ++open;
+    return open;
 }
 
-bool WebSocketServer::isRunning() const
+//==============================================================================
+bool WebSocketServer::isSessionOpen(int slot) const
 {
-    return running;
+    return slot >= 0 && slot < (int)slots.size() && slots[(size_t)slot]->state.load(std::memory_order_acquire) == Slot::Open;
 }
 
-bool WebSocketServer::hasClient() const
+bool WebSocketServer::isSessionClosed(int slot) const
 {
-    return clientSocket != INVALID_SOCKET;
+    return slot >= 0 && slot < (int)slots.size() && slots[(size_t)slot]->state.load(std::memory_order_acquire) == Slot::Closed;
 }
 
-void WebSocketServer::serverLoop()
+uint32_t WebSocketServer::getSessionGeneration(int slot) const
 {
-    // Create socket
-    serverSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (serverSocket == INVALID_SOCKET) {
-        std::cout << "[WebSocket] ✗ Failed to create socket" << std::endl;
-        running = false;
+    if (slot < 0 || slot >= (int)slots.size())
+        return 0;
+    return slots[(size_t)slot]->generation.load(std::memory_order_acquire);
+}
+
+int WebSocketServer::getNumAvailable(int slot) const
+{
+    if (slot < 0 || slot >= (int)slots.size() || slots[(size_t)slot]->state.load(std::memory_order_acquire) == Slot::Free)
+        return 0;
+    return (int)slots[(size_t)slot]->getNumAvailable();
+}
+
+int WebSocketServer::readSamples(int slotIndex, float* dest, int maxSamples)
+{
+    if (slotIndex < 0 || slotIndex >= (int)slots.size() || maxSamples <= 0)
+        return 0;
+    
+    Slot& slot = *slots[(size_t)slotIndex];
+    if (slot.state.load(std::memory_order_acquire) == Slot::Free)
+        return 0;
+    
+    // First read claims the slot so the server will not reuse it under us
+    int reader = slot.reader.load(std::memory_order_acquire);
+    if (reader == Slot::Unclaimed && !slot.reader.compare_exchange_strong(reader, Slot::Claimed))
+        reader = slot.reader.load(std::memory_order_acquire);
+    if (reader == Slot::Reclaimed)
+        return 0;
+    
+    const uint64_t readPosition = slot.readPosition.load(std::memory_order_relaxed);
+    const uint64_t writePosition = slot.writePosition.load(std::memory_order_acquire);
+    const int n = (int)std::min<uint64_t>(writePosition - readPosition, (uint64_t)maxSamples);
+    if (n <= 0)
+        return 0;
+    
+    // Two spans at most (wrap-around)
+    const size_t start = (size_t)(readPosition & slot.mask);
+    const size_t first = std::min((size_t)n, slot.ring.size() - start);
+    std::memcpy(dest, slot.ring.data() + start, first * sizeof(float));
+    if ((size_t)n > first)
+        std::memcpy(dest + first, slot.ring.data(), ((size_t)n - first) * sizeof(float));
+    
+    slot.readPosition.store(readPosition + (uint64_t)n, std::memory_order_release);
+    return n;
+}
+
+void WebSocketServer::releaseSession(int slotIndex)
+{
+    if (slotIndex < 0 || slotIndex >= (int)slots.size())
+        return;
+    
+    Slot& slot = *slots[(size_t)slotIndex];
+    if (slot.state.load(std::memory_order_acquire) != Slot::Closed)
         return;
+    
+    slot.reader.store(Slot::Reclaimed, std::memory_order_release);
+    slot.state.store(Slot::Free, std::memory_order_release);
+}
+
+WebSocketServer::SessionStats WebSocketServer::getSessionStats(int slotIndex) const
+{
+    SessionStats stats;
+    if (slotIndex < 0 || slotIndex >= (int)slots.size())
+        return stats;
+    
+    const Slot& slot = *slots[(size_t)slotIndex];
+    stats.samplesReceived = slot.samplesReceived.load(std::memory_order_relaxed);
+    stats.framesReceived = slot.framesReceived.load(std::memory_order_relaxed);
+    stats.pauses = slot.pauses.load(std::memory_order_relaxed);
+    stats.paused = slot.paused.load(std::memory_order_relaxed);
+    stats.messagesSent = slot.messagesSent.load(std::memory_order_relaxed);
+    stats.messagesDropped = slot.messagesDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+//==============================================================================
+bool WebSocketServer::sendBinary(int slotIndex, uint32_t generation, const void* data, size_t length)
+{
+    if (slotIndex < 0 || slotIndex >= (int)slots.size() || !running.load(std::memory_order_acquire))
+        return false;
+    
+    if (!enqueuePush(*slots[(size_t)slotIndex], generation, data, length))
+        return false;
+    
+    wakeServer();
+    return true;
+}
+
+int WebSocketServer::broadcastBinary(const void* data, size_t length)
+{
+    if (!running.load(std::memory_order_acquire))
+        return 0;
+    
+    int queued = 0;
+    for (auto& slot : slots)
+        if (slot->state.load(std::memory_order_acquire) == Slot::Open
+            && enqueuePush(*slot, slot->generation.load(std::memory_order_acquire), data, length))
+            ++queued;
+    
+    if (queued > 0)
+        wakeServer();
+    return queued;
+}
+
+bool WebSocketServer::enqueuePush(Slot& slot, uint32_t generation, const void* data, size_t length)
+{
+    // State and generation are checked under the lock the handshake clears the queue with,
+    // so a message can never reach the client that took the slot over
+    std::lock_guard<std::mutex> lock(slot.pushMutex);
+    if (slot.state.load(std::memory_order_acquire) != Slot::Open
+        || slot.generation.load(std::memory_order_acquire) != generation)
+        return false;
+    
+    if (length + 10 > MAX_OUTBOUND_BYTES || slot.pushQueueBytes + length > MAX_PUSH_QUEUE_BYTES)
+    {
+        slot.messagesDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
+    
+    slot.pushQueue.emplace_back(static_cast<const char*>(data), length);
+    slot.pushQueueBytes += length;
+    slot.pushPending.store(true, std::memory_order_release);
+    return true;
+}
 
-    // Bind to port
-    sockaddr_in serverAddr{};
+void WebSocketServer::clearPushQueue(Slot& slot)
+{
+    std::lock_guard<std::mutex> lock(slot.pushMutex);
+    slot.pushQueue.clear();
+    slot.pushQueueBytes = 0;
+    slot.pushPending.store(false, std::memory_order_relaxed);
+}
+
+//==============================================================================
+bool WebSocketServer::openListener()
+{
+    const NativeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == invalidSocket)
+    {
+        std::cout << "[WebSocket] ERROR: Failed to create socket" << std::endl;
+        return false;
+    }
+    
+    const int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    
+    sockaddr_in serverAddr {};
     serverAddr.sin_family = AF_INET;
     serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(port);
-
-    if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        std::cout << "[WebSocket] ✗ Bind failed (port may be in use)" << std::endl;
-        closesocket(serverSocket);
-        serverSocket = INVALID_SOCKET;
-        running = false;
-        return;
+    serverAddr.sin_port = htons((uint16_t)port);
+    
+    if (bind(s, (sockaddr*)&serverAddr, sizeof(serverAddr)) != 0)
+    {
+        std::cout << "[WebSocket] ERROR: Bind failed (port " << port << " may be in use)" << std::endl;
+        closeNativeSocket(s);
+        return false;
+    }
+    
+    if (listen(s, SOMAXCONN) != 0 || !setNonBlocking(s))
+    {
+        std::cout << "[WebSocket] ERROR: Listen failed" << std::endl;
+        closeNativeSocket(s);
+        return false;
     }
+    
+    listenSocket = (std::intptr_t)s;
+    eventLoop->add(s, LISTENER_TOKEN, true, false);
+    return true;
+}
 
-    // Listen
-    if (listen(serverSocket, 1) == SOCKET_ERROR) {
-        std::cout << "[WebSocket] ✗ Listen failed" << std::endl;
-        closesocket(serverSocket);
-        serverSocket = INVALID_SOCKET;
-        running = false;
-        return;
+bool WebSocketServer::openWakeSocket()
+{
+    // A datagram to ourselves wakes the event loop on every platform (no pipes on Windows)
+    const NativeSocket s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == invalidSocket)
+    {
+        std::cout << "[WebSocket] ERROR: Failed to create wake socket" << std::endl;
+        return false;
+    }
+    
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+    
+    if (bind(s, (sockaddr*)&address, sizeof(address)) != 0
+        || getsockname(s, (sockaddr*)&address, &addressLength) != 0
+        || connect(s, (sockaddr*)&address, addressLength) != 0
+        || !setNonBlocking(s))
+    {
+        std::cout << "[WebSocket] ERROR: Failed to set up wake socket" << std::endl;
+        closeNativeSocket(s);
+        return false;
     }
+    
+    wakeSocket = (std::intptr_t)s;
+    eventLoop->add(s, WAKE_TOKEN, true, false);
+    return true;
+}
 
-    std::cout << "[WebSocket] Listening for browser connections..." << std::endl;
+void WebSocketServer::wakeServer()
+{
+    // One datagram per batch of pushes; the server clears the flag before sending them
+    if (wakePending.exchange(true, std::memory_order_acq_rel))
+        return;
+    
+    const char byte = 1;
+    send(toNative(wakeSocket), &byte, 1, SEND_FLAGS);
+}
 
-    // Accept loop
-    while (running) {
-        fd_set readSet;
-        FD_ZERO(&readSet);
-        FD_SET(serverSocket, &readSet);
-
-        timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-
-        int selectResult = select(0, &readSet, nullptr, nullptr, &timeout);
-        if (selectResult > 0) {
-            clientSocket = accept(serverSocket, nullptr, nullptr);
-            if (clientSocket != INVALID_SOCKET) {
-                std::cout << "\n[WebSocket] ✓ Browser extension connected!" << std::endl;
-
-                if (performHandshake()) {
-                    std::cout << "[WebSocket] ✓ Handshake complete - receiving audio" << std::endl;
-                    handleClient();
-                } else {
-                    std::cout << "[WebSocket] ✗ Handshake failed" << std::endl;
-                }
-
-                closesocket(clientSocket);
-                clientSocket = INVALID_SOCKET;
-                std::cout << "[WebSocket] Browser disconnected\n" << std::endl;
+void WebSocketServer::serverLoop()
+{
+    std::vector<EventLoop::Event> events;
+    events.reserve(64);
+    
+    while (running.load(std::memory_order_acquire))
+    {
+        // Paused sessions are polled for consumer progress more often
+        bool anyPaused = false;
+        for (const auto& session : sessions)
+            anyPaused = anyPaused || session->paused;
+        
+        eventLoop->wait(anyPaused ? 10 : 100, events);
+        
+        for (const auto& event : events)
+        {
+            if (event.token == LISTENER_TOKEN)
+            {
+                acceptClients();
+                continue;
+            }
+            
+            if (event.token == WAKE_TOKEN)
+            {
+                wakePending.store(false, std::memory_order_release);
+                char drain[64];
+                while (recv(toNative(wakeSocket), drain, (int)sizeof(drain), 0) > 0) {}
+                continue;
             }
+            
+            Session& session = *sessions[(size_t)event.token];
+            if (session.phase == Session::Phase::Idle)
+                continue;
+            
+            if (event.writable)
+                handleWritable(session);
+            if ((event.readable || event.error) && !session.failed)
+                handleReadable(session);
+            if (session.failed)
+                closeSession(session);
+        }
+        
+        // Push messages go out as soon as the loop is awake (woken or not, nothing waits a timeout)
+        for (auto& sessionPtr : sessions)
+        {
+            Session& session = *sessionPtr;
+            if (session.phase == Session::Phase::Open && slots[(size_t)session.index]->pushPending.load(std::memory_order_acquire))
+                drainPushQueue(session);
+            if (session.failed)
+                closeSession(session);
+        }
+        
+        // Resume sessions the consumer has drained (bytes held back in inbound first)
+        for (auto& sessionPtr : sessions)
+        {
+            Session& session = *sessionPtr;
+            if (!session.paused)
+                continue;
+            
+            const Slot& slot = *slots[(size_t)session.index];
+            if ((double)slot.getNumAvailable() > RESUME_FILL * ringCapacity)
+                continue;
+            
+            setPaused(session, false);
+            parseFrames(session);
+            if (session.failed)
+                closeSession(session);
         }
     }
+    
+    for (auto& session : sessions)
+        if (session->phase != Session::Phase::Idle)
+            closeSession(*session, CLOSE_GOING_AWAY);
+    
+    if (toNative(listenSocket) != invalidSocket)
+    {
+        eventLoop->remove(toNative(listenSocket), LISTENER_TOKEN);
+        closeNativeSocket(toNative(listenSocket));
+        listenSocket = (std::intptr_t)invalidSocket;
+    }
 }
 
-bool WebSocketServer::performHandshake()
+void WebSocketServer::acceptClients()
 {
-    char buffer[2048];
-    int bytesReceived = recv(clientSocket, buffer, sizeof(buffer) - 1, 0);
+    while (true)
+    {
+        sockaddr_in address {};
+        socklen_t addressLength = sizeof(address);
+        const NativeSocket client = accept(toNative(listenSocket), (sockaddr*)&address, &addressLength);
+        if (client == invalidSocket)
+            return;
+        
+        // A slot is free once its previous session is closed and drained (or was never read)
+        int index = -1;
+        for (int i = 0; i < maxSessions && index < 0; ++i)
+            if (sessions[(size_t)i]->phase == Session::Phase::Idle && slots[(size_t)i]->state.load(std::memory_order_acquire) == Slot::Free)
+                index = i;
+        
+        if (index < 0 || !setNonBlocking(client))
+        {
+            static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+            send(client, busy, (int)sizeof(busy) - 1, SEND_FLAGS);
+            closeNativeSocket(client);
+            std::cout << "[WebSocket] Connection refused: all " << maxSessions << " sessions in use" << std::endl;
+            continue;
+        }
+        
+        const int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+       #if defined(SO_NOSIGPIPE)
+        const int noSigPipe = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+       #endif
+        
+        char host[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &address.sin_addr, host, sizeof(host));
+        
+        Session& session = *sessions[(size_t)index];
+        session.reset();
+        session.socket = (std::intptr_t)client;
+        session.phase = Session::Phase::Handshake;
+        session.remoteAddress = std::string(host) + ":" + std::to_string(ntohs(address.sin_port));
+        eventLoop->add(client, index, true, false);
+        
+        std::cout << "[WebSocket] Connection from " << session.remoteAddress << " (session " << index << ")" << std::endl;
+    }
+}
 
-    if (bytesReceived <= 0)
-        return false;
+void WebSocketServer::handleReadable(Session& session)
+{
+    if (session.paused)
+        return;
+    
+    const size_t space = session.inbound.size() - session.inboundLength;
+    if (space == 0)
+    {
+        // Only a stuck payload fills the buffer; parseFrames() pauses in that case
+        parseFrames(session);
+        return;
+    }
+    
+    const int received = recv(toNative(session.socket), reinterpret_cast<char*>(session.inbound.data() + session.inboundLength),
+                              (int)space, 0);
+    if (received == 0 || (received < 0 && !lastCallWouldBlock()))
+    {
+        session.failed = true;
+        return;
+    }
+    if (received < 0)
+        return;
+    
+    session.inboundLength += (size_t)received;
+    
+    if (session.phase == Session::Phase::Handshake && !completeHandshake(session))
+        return;
+    
+    parseFrames(session);
+}
 
-    buffer[bytesReceived] = '\0';
-    std::string request(buffer);
+void WebSocketServer::handleWritable(Session& session)
+{
+    flushOutbound(session);
+    
+    // Push messages held back while the socket was full
+    if (session.phase == Session::Phase::Open && !session.failed)
+        drainPushQueue(session);
+}
 
-    // Extract WebSocket key
-    size_t keyPos = request.find("Sec-WebSocket-Key: ");
-    if (keyPos == std::string::npos)
-        return false;
+void WebSocketServer::drainPushQueue(Session& session)
+{
+    Slot& slot = *slots[(size_t)session.index];
+    int appended = 0;
+    
+    {
+        // Frames are only appended under the lock; the send() happens after it
+        std::lock_guard<std::mutex> lock(slot.pushMutex);
+        while (!slot.pushQueue.empty())
+        {
+            const std::string& message = slot.pushQueue.front();
+            const size_t pending = session.outbound.size() - session.outboundOffset;
+            if (pending + message.size() + 10 > MAX_OUTBOUND_BYTES)
+                break;      // Rest waits for the socket to drain (write interest is set)
+            
+            queueFrame(session, OPCODE_BINARY, message.data(), message.size(), false);
+            slot.pushQueueBytes -= message.size();
+            slot.pushQueue.pop_front();
+            ++appended;
+        }
+        slot.pushPending.store(false, std::memory_order_release);     // Leftovers go on the next writable event
+    }
+    
+    if (appended == 0)
+        return;
+    
+    slot.messagesSent.fetch_add((uint64_t)appended, std::memory_order_relaxed);
+    flushOutbound(session);
+}
 
-    keyPos += 19;
-    size_t keyEnd = request.find("\r\n", keyPos);
+bool WebSocketServer::completeHandshake(Session& session)
+{
+    const char* begin = reinterpret_cast<const char*>(session.inbound.data());
+    const std::string request(begin, session.inboundLength);
+    const size_t headerEnd = request.find("\r\n\r\n");
+    
+    if (headerEnd == std::string::npos)
+    {
+        if (session.inboundLength >= MAX_HANDSHAKE_BYTES)
+            session.failed = true;
+        return false;
+    }
+    
+    // Header names are case-insensitive
+    const std::string lower = toLowerAscii(request.substr(0, headerEnd + 2));
+    size_t keyPos = lower.find("\r\nsec-websocket-key:");
+    if (keyPos == std::string::npos || lower.find("websocket") == std::string::npos)
+    {
+        queueRaw(session, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+        session.failed = true;
+        return false;
+    }
+    
+    keyPos += 20;
+    const size_t keyEnd = request.find("\r\n", keyPos);
     std::string key = request.substr(keyPos, keyEnd - keyPos);
-
-    // Generate accept key
-    std::string acceptKey = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
-    std::string hash = sha1(acceptKey);
-    std::string accept = base64Encode((unsigned char*)hash.data(), hash.length());
-
-    // Send response
+    key.erase(0, key.find_first_not_of(" \t"));
+    key.erase(key.find_last_not_of(" \t") + 1);
+    
+    const auto digest = sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    const std::string accept = base64Encode(digest.data(), digest.size());
+    
     std::stringstream response;
     response << "HTTP/1.1 101 Switching Protocols\r\n";
     response << "Upgrade: websocket\r\n";
     response << "Connection: Upgrade\r\n";
     response << "Sec-WebSocket-Accept: " << accept << "\r\n";
     response << "\r\n";
-
-    std::string responseStr = response.str();
-    send(clientSocket, responseStr.c_str(), (int)responseStr.length(), 0);
-
+    queueRaw(session, response.str());
+    if (session.failed)
+        return false;
+    
+    // Frames may follow the request in the same read
+    const size_t consumed = headerEnd + 4;
+    std::memmove(session.inbound.data(), session.inbound.data() + consumed, session.inboundLength - consumed);
+    session.inboundLength -= consumed;
+    
+    // Hand the slot to the consumer: empty ring, new generation
+    const int slotIndex = session.index;
+    Slot& slot = *slots[(size_t)slotIndex];
+    {
+        // Under the push lock: senders holding the previous generation are refused from here on
+        std::lock_guard<std::mutex> lock(slot.pushMutex);
+        slot.pushQueue.clear();
+        slot.pushQueueBytes = 0;
+        slot.pushPending.store(false, std::memory_order_relaxed);
+        slot.generation.fetch_add(1, std::memory_order_relaxed);
+    }
+    slot.messagesSent.store(0, std::memory_order_relaxed);
+    slot.messagesDropped.store(0, std::memory_order_relaxed);
+    slot.readPosition.store(0, std::memory_order_relaxed);
+    slot.writePosition.store(0, std::memory_order_relaxed);
+    slot.samplesReceived.store(0, std::memory_order_relaxed);
+    slot.framesReceived.store(0, std::memory_order_relaxed);
+    slot.pauses.store(0, std::memory_order_relaxed);
+    slot.paused.store(false, std::memory_order_relaxed);
+    slot.reader.store(Slot::Unclaimed, std::memory_order_relaxed);
+    slot.state.store(Slot::Open, std::memory_order_release);
+    
+    session.phase = Session::Phase::Open;
+    session.opened = true;
+    
+    std::cout << "[WebSocket] Session " << slotIndex << " open (" << session.remoteAddress << ", "
+              << getNumOpenSessions() << " active)" << std::endl;
+    
+    if (sessionCallback)
+        sessionCallback(slotIndex, true);
     return true;
 }
 
-void WebSocketServer::handleClient()
+//==============================================================================
+void WebSocketServer::parseFrames(Session& session)
 {
-    std::vector<char> buffer(16384);
-    int audioPacketCount = 0;
-
-    while (running && clientSocket != INVALID_SOCKET) {
-        int bytesReceived = recv(clientSocket, buffer.data(), (int)buffer.size(), 0);
-
-        if (bytesReceived <= 0)
-            break;
-
-        if (bytesReceived < 2)
+    uint8_t* data = session.inbound.data();
+    const size_t length = session.inboundLength;
+    size_t position = 0;
+    bool wroteAudio = false;
+    
+    while (session.phase == Session::Phase::Open && !session.failed && position < length)
+    {
+        if (!session.inPayload)
+        {
+            // Header: 2 bytes, extended length (2 or 8), masking key (4)
+            const uint8_t* header = data + position;
+            const size_t available = length - position;
+            if (available < 2)
+                break;
+            
+            const bool fin = (header[0] & 0x80) != 0;
+            const uint8_t opcode = header[0] & 0x0F;
+            const bool masked = (header[1] & 0x80) != 0;
+            uint64_t payloadLength = header[1] & 0x7F;
+            size_t headerSize = 2;
+            
+            if (payloadLength == 126)
+            {
+                if (available < 4)
+                    break;
+                payloadLength = ((uint64_t)header[2] << 8) | header[3];
+                headerSize = 4;
+            }
+            else if (payloadLength == 127)
+            {
+                if (available < 10)
+                    break;
+                payloadLength = 0;
+                for (int i = 0; i < 8; ++i)
+                    payloadLength = (payloadLength << 8) | header[2 + i];
+                headerSize = 10;
+            }
+            
+            if (available < headerSize + 4)
+                break;
+            
+            // Clients must mask; control frames are short and never fragmented; a data frame
+            // continues the open fragmented message, or starts one when none is open (RFC 6455 5.4)
+            const bool isControl = (opcode & 0x08) != 0;
+            if (!masked || (isControl && (!fin || payloadLength > sizeof(session.control)))
+                || (!isControl && opcode == OPCODE_CONTINUATION && session.messageOpcode == 0)
+                || (!isControl && opcode != OPCODE_CONTINUATION && session.messageOpcode != 0))
+            {
+                closeSession(session, CLOSE_PROTOCOL_ERROR);
+                return;
+            }
+            
+            std::memcpy(session.maskKey, header + headerSize, 4);
+            headerSize += 4;
+            
+            session.inPayload = true;
+            session.fin = fin;
+            session.frameOpcode = opcode;
+            session.maskIndex = 0;
+            session.remaining = payloadLength;
+            session.controlLength = 0;
+            if (!isControl && opcode != OPCODE_CONTINUATION)
+                session.messageOpcode = opcode;
+            
+            position += headerSize;
+            
+            if (session.remaining == 0)
+                finishFrame(session);
             continue;
-
-        // Parse WebSocket frame
-        unsigned char firstByte = buffer[0];
-        unsigned char secondByte = buffer[1];
-
-        int opcode = firstByte & 0x0F;
-        bool isMasked = (secondByte & 0x80) != 0;
-        int payloadLength = secondByte & 0x7F;
-
-        int headerSize = 2;
-
-        // Extended payload length
-        if (payloadLength == 126) {
-            if (bytesReceived < 4) continue;
-            payloadLength = (buffer[2] << 8) | buffer[3];
-            headerSize = 4;
-        } else if (payloadLength == 127) {
-            continue; // Skip very large frames
         }
-
-        // Masking key
-        unsigned char maskingKey[4] = {0};
-        if (isMasked) {
-            if (bytesReceived < headerSize + 4) continue;
-            memcpy(maskingKey, &buffer[headerSize], 4);
-            headerSize += 4;
+        
+        const size_t available = (size_t)std::min<uint64_t>(length - position, session.remaining);
+        size_t taken = available;
+        
+        if ((session.frameOpcode & 0x08) != 0)
+        {
+            for (size_t i = 0; i < available; ++i)
+                session.control[session.controlLength++] = data[position + i] ^ session.maskKey[session.maskIndex++ & 3];
         }
+        else if (session.messageOpcode == OPCODE_BINARY)
+        {
+            taken = consumeAudio(session, data + position, available);
+            wroteAudio = wroteAudio || taken > 0;
+        }
+        
+        position += taken;
+        session.remaining -= taken;
+        
+        if (session.remaining == 0)
+            finishFrame(session);
+        else if (taken < available)
+        {
+            // Ring full: hold the rest of the payload in inbound until the consumer catches up
+            setPaused(session, true);
+            break;
+        }
+    }
+    
+    if (wroteAudio && audioAvailableCallback)
+        audioAvailableCallback();
+    
+    if (session.phase == Session::Phase::Idle)
+        return;
+    
+    if (position > 0)
+    {
+        std::memmove(data, data + position, length - position);
+        session.inboundLength = length - position;
+    }
+}
 
-        if (bytesReceived < headerSize + payloadLength)
+size_t WebSocketServer::consumeAudio(Session& session, const uint8_t* data, size_t length)
+{
+    Slot& slot = *slots[(size_t)session.index];
+    
+    uint64_t writePosition = slot.writePosition.load(std::memory_order_relaxed);
+    const uint64_t freeSamples = (uint64_t)ringCapacity - (writePosition - slot.readPosition.load(std::memory_order_acquire));
+    
+    // Bytes that fit: a carried low byte completes one sample with the first byte
+    const uint64_t maxBytes = freeSamples * 2 - (session.hasLowByte && freeSamples > 0 ? 1 : 0);
+    const size_t take = (size_t)std::min<uint64_t>(length, freeSamples > 0 ? maxBytes : 0);
+    
+    // Unmask and convert little-endian int16 straight into the ring
+    float* ring = slot.ring.data();
+    const uint64_t mask = slot.mask;
+    const uint64_t startPosition = writePosition;
+    
+    for (size_t i = 0; i < take; ++i)
+    {
+        const uint8_t byte = data[i] ^ session.maskKey[session.maskIndex++ & 3];
+        if (!session.hasLowByte)
+        {
+            session.lowByte = byte;
+            session.hasLowByte = true;
             continue;
+        }
+        
+        const int16_t sample = (int16_t)(uint16_t)(session.lowByte | ((uint16_t)byte << 8));
+        ring[writePosition & mask] = (float)sample * (1.0f / 32768.0f);
+        ++writePosition;
+        session.hasLowByte = false;
+    }
+    
+    slot.writePosition.store(writePosition, std::memory_order_release);
+    slot.samplesReceived.fetch_add(writePosition - startPosition, std::memory_order_relaxed);
+    
+    // Ask the client to back off before the ring is actually full
+    if ((double)(writePosition - slot.readPosition.load(std::memory_order_acquire)) >= PAUSE_FILL * ringCapacity)
+        setPaused(session, true);
+    
+    return take;
+}
 
-        // Handle different frame types
-        if (opcode == 0x02) { // Binary frame (audio data)
-            // Unmask payload
-            std::vector<char> payload(payloadLength);
-            for (int i = 0; i < payloadLength; i++) {
-                payload[i] = buffer[headerSize + i] ^ maskingKey[i % 4];
-            }
+void WebSocketServer::finishFrame(Session& session)
+{
+    session.inPayload = false;
+    const uint8_t opcode = session.frameOpcode;
+    
+    if ((opcode & 0x08) == 0)
+    {
+        if (session.messageOpcode == OPCODE_BINARY)
+            slots[(size_t)session.index]->framesReceived.fetch_add(1, std::memory_order_relaxed);
+        
+        if (session.fin)
+        {
+            session.messageOpcode = 0;
+            session.hasLowByte = false;     // Odd byte at the end of a message is not a sample
+        }
+        return;
+    }
+    
+    if (opcode == OPCODE_PING)
+        queueFrame(session, OPCODE_PONG, session.control, session.controlLength);
+    else if (opcode == OPCODE_CLOSE)
+    {
+        // Echo the status code, then close
+        const uint8_t normal[2] = { 0x03, 0xE8 };
+        queueFrame(session, OPCODE_CLOSE, session.controlLength >= 2 ? session.control : normal, 2);
+        std::cout << "[WebSocket] Session " << session.index << " sent close" << std::endl;
+        closeSession(session);
+    }
+}
 
-            // Convert to int16 samples
-            int numSamples = payloadLength / 2;
-            const int16_t* samples = reinterpret_cast<const int16_t*>(payload.data());
+void WebSocketServer::queueFrame(Session& session, uint8_t opcode, const void* payload, size_t length, bool flushNow)
+{
+    // Server frames are never masked
+    std::string frame;
+    frame.reserve(length + 10);
+    frame += (char)(0x80 | opcode);
+    if (length < 126)
+        frame += (char)length;
+    else if (length <= 0xFFFF)
+    {
+        frame += (char)126;
+        frame += (char)((length >> 8) & 0xFF);
+        frame += (char)(length & 0xFF);
+    }
+    else
+    {
+        frame += (char)127;
+        for (int i = 7; i >= 0; --i)
+            frame += (char)(((uint64_t)length >> (i * 8)) & 0xFF);
+    }
+    frame.append(static_cast<const char*>(payload), length);
+    
+    queueRaw(session, frame, flushNow);
+}
 
-            // Call audio callback
-            if (audioCallback && numSamples > 0) {
-                audioCallback(samples, numSamples);
+void WebSocketServer::queueRaw(Session& session, const std::string& data, bool flushNow)
+{
+    if (session.outbound.size() - session.outboundOffset + data.size() > MAX_OUTBOUND_BYTES)
+    {
+        session.failed = true;
+        return;
+    }
+    
+    session.outbound += data;
+    if (flushNow)
+        flushOutbound(session);
+}
 
-                // Log progress
-                audioPacketCount++;
-                if (audioPacketCount % 100 == 0) {
-                    std::cout << "[WebSocket] Received " << audioPacketCount 
-                              << " audio packets (" << numSamples << " samples each)" << std::endl;
-                }
-            }
-        }
-        else if (opcode == 0x08) { // Close frame
-            std::cout << "[WebSocket] Close frame received" << std::endl;
-            break;
-        }
-        else if (opcode == 0x09) { // Ping frame
-            // Send pong
-            unsigned char pong[] = {0x8A, 0x00};
-            send(clientSocket, (char*)pong, 2, 0);
+void WebSocketServer::flushOutbound(Session& session)
+{
+    while (session.outboundOffset < session.outbound.size())
+    {
+        const int sent = send(toNative(session.socket), session.outbound.data() + session.outboundOffset,
+                              (int)(session.outbound.size() - session.outboundOffset), SEND_FLAGS);
+        if (sent > 0)
+        {
+            session.outboundOffset += (size_t)sent;
+            continue;
         }
+        
+        if (sent < 0 && !lastCallWouldBlock())
+            session.failed = true;
+        break;
     }
+    
+    if (session.outboundOffset >= session.outbound.size())
+    {
+        session.outbound.clear();
+        session.outboundOffset = 0;
+    }
+    
+    updateInterest(session);
+}
+
+void WebSocketServer::setPaused(Session& session, bool paused)
+{
+    if (session.paused == paused)
+        return;
+    
+    Slot& slot = *slots[(size_t)session.index];
+    session.paused = paused;
+    slot.paused.store(paused, std::memory_order_relaxed);
+    if (paused)
+        slot.pauses.fetch_add(1, std::memory_order_relaxed);
+    
+    updateInterest(session);
+    
+    // Explicit flow control on top of TCP's: the extension can stop capturing instead of buffering
+    const uint64_t buffered = slot.getNumAvailable();
+    const std::string message = std::string("{\"type\":\"flow\",\"paused\":") + (paused ? "true" : "false")
+                              + ",\"buffered\":" + std::to_string(buffered) + "}";
+    queueFrame(session, OPCODE_TEXT, message.data(), message.size());
+    
+    std::cout << "[WebSocket] Session " << session.index << (paused ? " paused" : " resumed") << " ("
+              << buffered << " samples buffered)" << std::endl;
+}
+
+void WebSocketServer::updateInterest(Session& session)
+{
+    if (session.phase == Session::Phase::Idle)
+        return;
+    
+    const bool read = !session.paused;
+    const bool write = session.outboundOffset < session.outbound.size();
+    eventLoop->modify(toNative(session.socket), session.index, read, write);
+    session.wantWrite = write;
+}
 
-    std::cout << "[WebSocket] Total audio packets received: " << audioPacketCount << std::endl;
+void WebSocketServer::closeSession(Session& session, uint16_t statusCode)
+{
+    if (session.phase == Session::Phase::Idle)
+        return;
+    
+    if (statusCode != 0 && session.phase == Session::Phase::Open && !session.failed)
+    {
+        const uint8_t status[2] = { (uint8_t)(statusCode >> 8), (uint8_t)(statusCode & 0xFF) };
+        queueFrame(session, OPCODE_CLOSE, status, 2);
+    }
+    
+    eventLoop->remove(toNative(session.socket), session.index);
+    closeNativeSocket(toNative(session.socket));
+    
+    const bool wasOpen = session.opened;
+    const int index = session.index;
+    std::cout << "[WebSocket] Session " << index << " closed (" << session.remoteAddress << ")" << std::endl;
+    session.reset();
+    
+    if (!wasOpen)
+        return;
+    
+    // Remaining samples stay readable; a slot nobody ever read from is reused right away
+    Slot& slot = *slots[(size_t)index];
+    slot.paused.store(false, std::memory_order_relaxed);
+    slot.state.store(Slot::Closed, std::memory_order_release);
+    clearPushQueue(slot);
+    
+    int expected = Slot::Unclaimed;
+    if (slot.reader.compare_exchange_strong(expected, Slot::Reclaimed))
+        slot.state.store(Slot::Free, std::memory_order_release);
+    
+    if (sessionCallback)
+        sessionCallback(index, false);
 }
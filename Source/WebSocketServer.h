@@ -1,34 +1,206 @@
+/*
+  ==============================================================================
+
+    WebSocketServer.h
+    Created: 12 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Multi-client WebSocket audio ingest for the browser extension.
+
+    Features:
+    - One non-blocking event loop thread for every session (epoll on Linux,
+      WSAPoll on Windows, poll elsewhere)
+    - Frames are parsed incrementally across reads; binary payloads are
+      unmasked and converted int16 -> float straight into the session's
+      preallocated sample ring (no per-frame buffers)
+    - Backpressure: a session whose ring fills up stops being read (TCP flow
+      control pushes back on the sender) and is told so with a text frame;
+      reading resumes once the consumer has drained it
+    - Pull API for the ASR side: sessions live in fixed slots and are read
+      like an SPSC queue
+    - Push API back to the clients: binary messages (PushProtocol) are queued
+      from any thread and the event loop is woken to send them right away;
+      messages queued before it wakes leave in one send()
+
+  ==============================================================================
+*/
+
 #pragma once
+
 #include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 
-// Forward declare socket type to avoid including winsock2.h here
-typedef uintptr_t SOCKET;
-
-class WebSocketServer {
+/**
+    WebSocket server that streams each client's 16-bit mono PCM into its own ring.
+    
+    Usage:
+        WebSocketServer server(8765);
+        server.start([&] { wake.notify(); },                    // Audio arrived (any session)
+                     [&](int slot, bool opened) { ... });       // Session opened/closed
+        
+        // Consumer thread
+        for (int slot = 0; slot < server.getMaxSessions(); ++slot)
+        {
+            int n = server.readSamples(slot, buffer, bufferSize);
+            ...
+            if (server.isSessionClosed(slot) && server.getNumAvailable(slot) == 0)
+                server.releaseSession(slot);
+        }
+    
+    Flow control messages (text frames, server -> client):
+        {"type":"flow","paused":true,"buffered":<samples>}
+        {"type":"flow","paused":false,"buffered":<samples>}
+    
+    Censor events and transcript words (binary frames, server -> client):
+        server.sendBinary(slot, generation, data, size);    // One session
+        server.broadcastBinary(data, size);                 // Every open session
+    
+    Thread Safety:
+    - start()/stop(): control thread
+    - readSamples()/releaseSession(): one consumer thread per slot
+    - sendBinary()/broadcastBinary(): any thread (short per-slot lock, never the audio thread)
+    - Getters: any thread
+    - Callbacks run on the server thread and should only wake the consumer
+*/
+class WebSocketServer
+{
 public:
-    using AudioCallback = std::function<void(const int16_t*, int)>;
+    using AudioAvailableCallback = std::function<void()>;
+    using SessionCallback = std::function<void(int slot, bool opened)>;
+    
+    struct SessionStats
+    {
+        uint64_t samplesReceived = 0;
+        uint64_t framesReceived = 0;
+        uint32_t pauses = 0;                    // Times backpressure stopped reading
+        bool paused = false;
+        uint64_t messagesSent = 0;              // Binary push messages handed to the socket
+        uint64_t messagesDropped = 0;           // Push queue full (client not reading)
+    };
     
-    WebSocketServer(int port = 8765);
+    /**
+        @param port             TCP port to listen on
+        @param maxSessions      Concurrent clients (each gets a slot and a ring)
+        @param ringSamples      Ring capacity per session, rounded up to a power of two
+    */
+    WebSocketServer(int port = 8765, int maxSessions = 16, int ringSamples = 1 << 18);
     ~WebSocketServer();
     
-    bool start(AudioCallback callback);
+    /**
+        Allocate the session rings and start the event loop thread.
+        
+        @return     false if the socket layer could not be initialised
+    */
+    bool start(AudioAvailableCallback onAudioAvailable = nullptr, SessionCallback onSessionChanged = nullptr);
     void stop();
-    bool isRunning() const;
-    bool hasClient() const;
+    
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+    bool hasClient() const { return getNumOpenSessions() > 0; }
+    int getNumOpenSessions() const;
+    int getMaxSessions() const { return maxSessions; }
+    
+    //==========================================================================
+    // Consumer side (per slot)
+    
+    bool isSessionOpen(int slot) const;
+    
+    /**
+        The client disconnected; remaining samples can still be read.
+    */
+    bool isSessionClosed(int slot) const;
+    
+    /**
+        Changes whenever the slot is given to a new client.
+    */
+    uint32_t getSessionGeneration(int slot) const;
+    
+    int getNumAvailable(int slot) const;
+    
+    /**
+        Pop up to maxSamples converted samples.
+        
+        @return     Samples copied (0 if the slot is free or empty)
+    */
+    int readSamples(int slot, float* dest, int maxSamples);
+    
+    /**
+        Hand a closed, drained slot back to the server for the next client.
+        Slots that were never read from are reclaimed automatically.
+    */
+    void releaseSession(int slot);
+    
+    SessionStats getSessionStats(int slot) const;
+    
+    //==========================================================================
+    // Push side (any thread)
+    
+    /**
+        Queue one binary message for a session and wake the server thread.
+        
+        @param slot         Session slot
+        @param generation   getSessionGeneration() the message was produced for;
+                            a message for a client that has since gone is dropped
+        @param data         Message bytes (copied)
+        @param length       Message size
+        @return             false if the session is not open or its push queue is full
+    */
+    bool sendBinary(int slot, uint32_t generation, const void* data, size_t length);
+    
+    /**
+        Queue the same binary message for every open session.
+        
+        @return     Sessions the message was queued for
+    */
+    int broadcastBinary(const void* data, size_t length);
 
 private:
+    struct Slot;
+    struct Session;
+    class EventLoop;
+    
     void serverLoop();
-    bool performHandshake();
-    void handleClient();
-
-    int port;
-    bool running;
-    SOCKET serverSocket;
-    SOCKET clientSocket;
+    bool openListener();
+    bool openWakeSocket();
+    void wakeServer();
+    void acceptClients();
+    void handleReadable(Session& session);
+    void handleWritable(Session& session);
+    void drainPushQueue(Session& session);
+    void clearPushQueue(Slot& slot);
+    bool enqueuePush(Slot& slot, uint32_t generation, const void* data, size_t length);
+    bool completeHandshake(Session& session);
+    void parseFrames(Session& session);
+    size_t consumeAudio(Session& session, const uint8_t* data, size_t length);
+    void finishFrame(Session& session);
+    void queueFrame(Session& session, uint8_t opcode, const void* payload, size_t length, bool flushNow = true);
+    void queueRaw(Session& session, const std::string& data, bool flushNow = true);
+    void flushOutbound(Session& session);
+    void setPaused(Session& session, bool paused);
+    void closeSession(Session& session, uint16_t statusCode = 0);
+    void updateInterest(Session& session);
+    
+    const int port;
+    const int maxSessions;
+    const int ringCapacity;
+    
+    std::atomic<bool> running {false};
     std::thread serverThread;
-    AudioCallback audioCallback;
+    std::intptr_t listenSocket;
+    std::intptr_t wakeSocket;                           // Loopback datagram socket, connected to itself
+    std::atomic<bool> wakePending {false};
+    
+    std::vector<std::unique_ptr<Slot>> slots;           // Shared with the consumer
+    std::vector<std::unique_ptr<Session>> sessions;     // Server thread only, same index as slots
+    std::unique_ptr<EventLoop> eventLoop;
+    
+    AudioAvailableCallback audioAvailableCallback;
+    SessionCallback sessionCallback;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WebSocketServer)
 };
@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    WhisperBackend.cpp
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Windowed Whisper recognizer implementation.
+
+  ==============================================================================
+*/
+
+#include "WhisperBackend.h"
+#include "WhisperTranscript.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+WhisperBackend::WhisperBackend(whisper_context* context, const std::string& name, const Options& newOptions)
+    : ctx(context), modelName(name), options(newOptions)
+{
+    // Same greedy setup as a live first pass, without the prompt (windows are too short to need it)
+    params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = std::max(1, options.threads);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.translate = false;
+    params.language = "en";
+    params.no_context = true;
+    params.single_segment = false;
+    params.token_timestamps = false;
+    params.temperature = 0.0f;
+    params.temperature_inc = 0.0f;     // A missed proposal is caught by the confirming pass
+    if (options.audioContext > 0)
+        params.audio_ctx = options.audioContext;
+}
+
+WhisperBackend::~WhisperBackend()
+{
+    if (state != nullptr)
+        whisper_free_state(state);
+}
+
+bool WhisperBackend::prepare(int sampleRate)
+{
+    if (ctx == nullptr)
+    {
+        lastError = "No Whisper model";
+        return false;
+    }
+    
+    if (sampleRate != WHISPER_SAMPLE_RATE)
+    {
+        lastError = "Whisper needs 16kHz audio";
+        return false;
+    }
+    
+    if (state == nullptr)
+        state = whisper_init_state(ctx);
+    if (state == nullptr)
+    {
+        lastError = "whisper_init_state failed";
+        std::cout << "[WhisperBackend] ERROR: " << lastError << std::endl;
+        return false;
+    }
+    
+    windowSamples = std::max(WHISPER_SAMPLE_RATE / 4, (int)std::lround(options.windowSeconds * WHISPER_SAMPLE_RATE));
+    window.reserve((size_t)windowSamples);
+    words.reserve(32);
+    tokens.reserve(32);
+    reset();
+    return true;
+}
+
+void WhisperBackend::acceptAudio(const float* samples, int numSamples)
+{
+    if (state == nullptr)
+        return;
+    
+    while (numSamples > 0)
+    {
+        const int take = std::min(numSamples, windowSamples - (int)window.size());
+        window.insert(window.end(), samples, samples + take);
+        samples += take;
+        numSamples -= take;
+        
+        if ((int)window.size() == windowSamples)
+        {
+            decodeWindow();
+            windowStartSeconds += (double)windowSamples / WHISPER_SAMPLE_RATE;
+            window.clear();
+        }
+    }
+}
+
+void WhisperBackend::decodeWindow()
+{
+    if (whisper_full_with_state(ctx, state, params, window.data(), (int)window.size()) != 0)
+    {
+        lastError = "whisper_full failed";
+        return;
+    }
+    
+    words.clear();
+    tokens.clear();
+    const double windowSeconds = (double)window.size() / WHISPER_SAMPLE_RATE;
+    WhisperTranscript::extractWords(ctx, state, windowSeconds, words, tokens);
+    if (words.empty())
+        return;
+    
+    Hypothesis hypothesis;
+    hypothesis.isFinal = true;
+    hypothesis.words.reserve(words.size());
+    for (const auto& segment : words)
+    {
+        Word word;
+        word.text = segment.word;
+        word.start = windowStartSeconds + segment.start;
+        word.end = windowStartSeconds + segment.end;
+        word.confidence = (float)segment.confidence;
+        hypothesis.words.push_back(std::move(word));
+    }
+    
+    pending.push_back(std::move(hypothesis));
+}
+
+bool WhisperBackend::popHypothesis(Hypothesis& hypothesis)
+{
+    if (pending.empty())
+        return false;
+    
+    hypothesis = std::move(pending.front());
+    pending.pop_front();
+    return true;
+}
+
+void WhisperBackend::reset()
+{
+    window.clear();
+    windowStartSeconds = 0.0;
+    pending.clear();
+}
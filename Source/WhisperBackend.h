@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    WhisperBackend.h
+    Created: 14 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Whisper on short consecutive windows as an AsrBackend.
+
+    Features:
+    - Borrows a loaded model (normally tiny.en from ModelManager) and decodes
+      on its own whisper_state, beside the decode scheduler's states
+    - One final hypothesis per window (no partials: isStreaming() is false)
+    - Short windows (1s by default) keep the proposal latency near one window
+      when Vosk is not built in; the confirming Whisper pass is unchanged
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <deque>
+#include <vector>
+#include "AsrBackend.h"
+#include "LyricsAlignment.h"  // For WordSegment
+
+/**
+    Thread Safety:
+    - Not thread safe (see AsrBackend); the borrowed context must outlive it
+*/
+class WhisperBackend : public AsrBackend
+{
+public:
+    struct Options
+    {
+        double windowSeconds = 1.0;     // Audio per decode
+        int threads = 2;                // n_threads (taken from the decode workers' budget)
+        int audioContext = 0;           // audio_ctx (0 = whisper.cpp default)
+    };
+    
+    /**
+        @param ctx          Loaded model (not owned)
+        @param modelName    For logs ("tiny.en")
+    */
+    WhisperBackend(whisper_context* ctx, const std::string& modelName, const Options& options);
+    WhisperBackend(whisper_context* ctx, const std::string& modelName)
+        : WhisperBackend(ctx, modelName, Options()) {}
+    ~WhisperBackend() override;
+    
+    std::string getName() const override { return "whisper " + modelName; }
+    bool isStreaming() const override { return false; }
+    
+    bool prepare(int sampleRate) override;
+    void acceptAudio(const float* samples, int numSamples) override;
+    bool popHypothesis(Hypothesis& hypothesis) override;
+    void reset() override;
+    
+    juce::String getLastError() const override { return lastError; }
+
+private:
+    void decodeWindow();
+    
+    whisper_context* ctx;
+    whisper_state* state = nullptr;
+    std::string modelName;
+    Options options;
+    whisper_full_params params;
+    
+    int windowSamples = 16000;
+    std::vector<float> window;              // Samples of the window being filled
+    double windowStartSeconds = 0.0;        // Stream time of window[0]
+    std::vector<WordSegment> words;         // Decode scratch
+    std::vector<whisper_token> tokens;
+    std::deque<Hypothesis> pending;
+    juce::String lastError;
+    
+    WhisperBackend(const WhisperBackend&) = delete;
+    WhisperBackend& operator=(const WhisperBackend&) = delete;
+};
@@ -0,0 +1,472 @@
+/*
+  ==============================================================================
+
+    WhisperDecodeScheduler.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Parallel Whisper decoding implementation.
+
+  ==============================================================================
+*/
+
+#include "WhisperDecodeScheduler.h"
+#include "EditDistance.h"
+#include "WhisperTranscript.h"
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+WhisperDecodeScheduler::~WhisperDecodeScheduler()
+{
+    shutdown();
+}
+
+int WhisperDecodeScheduler::recommendedConcurrentDecodes()
+{
+    // Whisper stops scaling at roughly 4 threads per decode on CPU, so wide
+    // machines get more decodes rather than more threads per decode
+    const int physicalCores = std::max(1, juce::SystemStats::getNumPhysicalCpus());
+    return std::max(1, std::min(3, physicalCores / 4));
+}
+
+int WhisperDecodeScheduler::recommendedThreadsPerDecode(int concurrentDecodes)
+{
+    const int physicalCores = std::max(1, juce::SystemStats::getNumPhysicalCpus());
+    return std::max(1, physicalCores / std::max(1, concurrentDecodes));
+}
+
+void WhisperDecodeScheduler::prepare(int concurrentDecodes, std::function<void()> resultCallback)
+{
+    shutdown();
+    
+    numSlots = concurrentDecodes > 0 ? concurrentDecodes : recommendedConcurrentDecodes();
+    threadsPerDecode = recommendedThreadsPerDecode(numSlots);
+    
+    models.clear();
+    freeStates.clear();
+    statesCreated.clear();
+    streams.clear();
+    numPending = 0;
+    stopping = false;
+    
+    // Stream 0 is the single-stream caller's; a closed placeholder otherwise
+    streams.emplace_back();
+    streams.back().open = resultCallback != nullptr;
+    streams.back().onResult = std::move(resultCallback);
+    running = true;
+    
+    for (int i = 0; i < numSlots; ++i)
+        workers.emplace_back(&WhisperDecodeScheduler::workerLoop, this);
+    
+    std::cout << "[Scheduler] " << numSlots << " concurrent decode(s) x " << threadsPerDecode
+              << " thread(s) (" << juce::SystemStats::getNumPhysicalCpus() << " physical / "
+              << juce::SystemStats::getNumCpus() << " logical cores)" << std::endl;
+}
+
+int WhisperDecodeScheduler::addModel(whisper_context* ctx, whisper_state* warmState)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (!running || stopping || ctx == nullptr)
+    {
+        if (warmState)
+            whisper_free_state(warmState);
+        return -1;
+    }
+    
+    models.push_back(ctx);
+    freeStates.emplace_back();
+    statesCreated.push_back(0);
+    
+    if (warmState)
+    {
+        freeStates.back().push_back(warmState);
+        statesCreated.back() = 1;
+    }
+    
+    return (int)models.size() - 1;
+}
+
+int WhisperDecodeScheduler::getNumModels() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (int)models.size();
+}
+
+int WhisperDecodeScheduler::addStream(std::function<void()> resultCallback)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (!running || stopping)
+        return -1;
+    
+    streams.emplace_back();
+    streams.back().open = true;
+    streams.back().onResult = std::move(resultCallback);
+    return (int)streams.size() - 1;
+}
+
+void WhisperDecodeScheduler::removeStream(int stream)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    if (stream < 0 || stream >= (int)streams.size() || !streams[(size_t)stream].open)
+        return;
+    
+    Stream& closed = streams[(size_t)stream];
+    closed.open = false;
+    closed.onResult = nullptr;
+    
+    numPending -= (int)closed.pending.size();
+    closed.pending.clear();
+    
+    for (auto& entry : closed.completed)
+    {
+        if (entry.second.state)
+            freeStates[(size_t)entry.second.job.model].push_back(entry.second.state);
+    }
+    closed.completed.clear();
+    
+    // States may have come back
+    workAvailable.notify_all();
+    
+    // A running decode still reads the caller's job data (its redecode policy): wait it out
+    workAvailable.wait(lock, [this, stream] { return streams[(size_t)stream].decoding == 0; });
+}
+
+void WhisperDecodeScheduler::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+            return;
+        
+        stopping = true;
+    }
+    
+    workAvailable.notify_all();
+    
+    for (auto& worker : workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+    workers.clear();
+    
+    // Unreleased results still own their states
+    for (auto& stream : streams)
+    {
+        for (auto& entry : stream.completed)
+        {
+            if (entry.second.state)
+                freeStates[(size_t)entry.second.job.model].push_back(entry.second.state);
+        }
+    }
+    streams.clear();
+    numPending = 0;
+    
+    for (auto& pool : freeStates)
+    {
+        for (auto* state : pool)
+            whisper_free_state(state);
+    }
+    
+    freeStates.clear();
+    statesCreated.clear();
+    models.clear();
+    running = false;
+}
+
+bool WhisperDecodeScheduler::submit(Job&& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        if (!running || stopping || job.model < 0 || job.model >= (int)models.size()
+            || job.stream < 0 || job.stream >= (int)streams.size() || !streams[(size_t)job.stream].open)
+            return false;
+        
+        Stream& stream = streams[(size_t)job.stream];
+        job.sequence = stream.nextSequence++;
+        job.submitTime = std::chrono::steady_clock::now();
+        stream.pending.push_back(std::move(job));
+        ++numPending;
+    }
+    
+    // All: a worker parked in acquireState() shares the condition variable
+    workAvailable.notify_all();
+    return true;
+}
+
+bool WhisperDecodeScheduler::popCompleted(Result& result, int stream)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    if (stream < 0 || stream >= (int)streams.size())
+        return false;
+    
+    Stream& source = streams[(size_t)stream];
+    auto it = source.completed.find(source.nextToDeliver);
+    if (it == source.completed.end())
+        return false;
+    
+    result = std::move(it->second);
+    source.completed.erase(it);
+    ++source.nextToDeliver;
+    return true;
+}
+
+void WhisperDecodeScheduler::release(Result& result)
+{
+    if (result.state == nullptr)
+        return;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        
+        if (running && result.job.model >= 0 && result.job.model < (int)freeStates.size())
+            freeStates[(size_t)result.job.model].push_back(result.state);
+        else
+            whisper_free_state(result.state);
+    }
+    
+    result.state = nullptr;
+    workAvailable.notify_all();
+}
+
+whisper_state* WhisperDecodeScheduler::acquireState(int model, std::unique_lock<std::mutex>& lock, bool wait)
+{
+    while (!stopping)
+    {
+        auto& pool = freeStates[(size_t)model];
+        if (!pool.empty())
+        {
+            whisper_state* state = pool.back();
+            pool.pop_back();
+            return state;
+        }
+        
+        // States are created on first use: models never picked by the adaptive
+        // switcher cost no KV cache memory
+        if (statesCreated[(size_t)model] < numSlots)
+        {
+            statesCreated[(size_t)model]++;
+            whisper_context* ctx = models[(size_t)model];
+            
+            lock.unlock();
+            whisper_state* state = whisper_init_state(ctx);
+            lock.lock();
+            
+            if (state != nullptr)
+                return state;
+            
+            statesCreated[(size_t)model]--;
+            std::cout << "[Scheduler] ERROR: whisper_init_state failed for model " << model << std::endl;
+            return nullptr;
+        }
+        
+        // Every state of this model is busy or held by an unreleased result
+        if (!wait)
+            return nullptr;
+        workAvailable.wait(lock);
+    }
+    
+    return nullptr;
+}
+
+bool WhisperDecodeScheduler::onEncoderBegin(whisper_context* ctx, whisper_state* state, void* userData)
+{
+    auto* timing = static_cast<EncoderTiming*>(userData);
+    
+    // Audio longer than one 30s segment encodes again: keep the first
+    if (!timing->began)
+    {
+        timing->encoderBegin = std::chrono::steady_clock::now();
+        timing->began = true;
+    }
+    
+    return timing->chained ? timing->chained(ctx, state, timing->chainedUserData) : true;
+}
+
+void WhisperDecodeScheduler::runSecondPass(Result& result, std::unique_lock<std::mutex>& lock)
+{
+    // Called unlocked, with the first pass's segments still in result.state
+    const Job& job = result.job;
+    const RedecodePolicy& policy = *job.redecodePolicy;
+    RedecodePolicy::Report& report = result.redecode;
+    const double windowSeconds = (double)job.samples.size() / WHISPER_SAMPLE_RATE;
+    
+    report.ran = true;
+    report.firstPassSeconds = result.decodeSeconds;
+    WhisperTranscript::extractWords(result.ctx, result.state, windowSeconds, result.words, result.tokens);
+    
+    EditDistance scratch;
+    const auto regions = policy.findRegions(result.words, windowSeconds, scratch, report);
+    if (regions.empty())
+        return;
+    
+    // A larger model only if its tokens can go straight back into the prompt
+    whisper_context* ctx = result.ctx;
+    whisper_state* state = result.state;
+    int secondModel = -1;
+    const int requested = job.redecodeModel;
+    if (requested >= 0 && requested != job.model)
+    {
+        lock.lock();
+        if (requested < (int)models.size()
+            && whisper_n_vocab(models[(size_t)requested]) == whisper_n_vocab(result.ctx)
+            && whisper_is_multilingual(models[(size_t)requested]) == whisper_is_multilingual(result.ctx))
+        {
+            // Never wait here: every state of that model may be held by results queued behind this one
+            state = acquireState(requested, lock, false);
+            if (state != nullptr)
+            {
+                ctx = models[(size_t)requested];
+                secondModel = requested;
+            }
+            else
+                state = result.state;
+        }
+        lock.unlock();
+    }
+    report.largerModel = secondModel >= 0;
+    
+    whisper_full_params params = job.params;
+    params.n_threads = threadsPerDecode;
+    policy.redecodeRegions(ctx, state, params, job.samples.data(), (int)job.samples.size(), job.prompt,
+                           regions, result.words, result.tokens, scratch, report);
+    
+    if (secondModel >= 0)
+    {
+        lock.lock();
+        freeStates[(size_t)secondModel].push_back(state);
+        lock.unlock();
+        workAvailable.notify_all();
+    }
+}
+
+WhisperDecodeScheduler::Stream* WhisperDecodeScheduler::takeMostUrgent(Job& job)
+{
+    // Each stream decodes in order, and a window is only taken once its model has a state
+    // for it: a later window can then never hold the state an earlier one waits for (results
+    // are delivered in order). Across streams, least slack first.
+    Stream* chosen = nullptr;
+    for (auto& stream : streams)
+    {
+        if (stream.pending.empty())
+            continue;
+        
+        const Job& head = stream.pending.front();
+        const size_t model = (size_t)head.model;
+        if (freeStates[model].empty() && statesCreated[model] >= numSlots)
+            continue;
+        
+        if (chosen == nullptr)
+        {
+            chosen = &stream;
+            continue;
+        }
+        
+        const Job& best = chosen->pending.front();
+        if (head.deadline < best.deadline || (head.deadline == best.deadline && head.submitTime < best.submitTime))
+            chosen = &stream;
+    }
+    
+    if (chosen != nullptr)
+    {
+        job = std::move(chosen->pending.front());
+        chosen->pending.pop_front();
+        --numPending;
+        ++chosen->decoding;
+    }
+    
+    return chosen;
+}
+
+void WhisperDecodeScheduler::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    
+    while (true)
+    {
+        workAvailable.wait(lock, [this] { return stopping || numPending > 0; });
+        
+        if (stopping)
+            return;
+        
+        Result result;
+        if (takeMostUrgent(result.job) == nullptr)
+        {
+            // Every queued window's model is out of states: wait for a release
+            workAvailable.wait(lock);
+            continue;
+        }
+        
+        result.ctx = models[(size_t)result.job.model];
+        result.state = acquireState(result.job.model, lock);
+        
+        if (stopping)
+        {
+            if (result.state)
+                freeStates[(size_t)result.job.model].push_back(result.state);
+            --streams[(size_t)result.job.stream].decoding;
+            return;
+        }
+        
+        if (result.state != nullptr)
+        {
+            lock.unlock();
+            
+            Job& job = result.job;
+            job.params.n_threads = threadsPerDecode;
+            job.params.prompt_tokens = job.prompt.empty() ? nullptr : job.prompt.data();
+            job.params.prompt_n_tokens = (int)job.prompt.size();
+            
+            // Mark where the encoder starts (whisper exposes no finer split), then hand on
+            // to the caller's own callback if there was one
+            EncoderTiming timing;
+            timing.chained = job.params.encoder_begin_callback;
+            timing.chainedUserData = job.params.encoder_begin_callback_user_data;
+            job.params.encoder_begin_callback = &WhisperDecodeScheduler::onEncoderBegin;
+            job.params.encoder_begin_callback_user_data = &timing;
+            
+            const auto startTime = std::chrono::steady_clock::now();
+            result.status = whisper_full_with_state(result.ctx, result.state, job.params,
+                                                    job.samples.data(), (int)job.samples.size());
+            const auto endTime = std::chrono::steady_clock::now();
+            
+            job.params.encoder_begin_callback = timing.chained;
+            job.params.encoder_begin_callback_user_data = timing.chainedUserData;
+            
+            result.decodeSeconds = std::chrono::duration<double>(endTime - startTime).count();
+            result.queueSeconds = std::chrono::duration<double>(startTime - job.submitTime).count();
+            if (timing.began)
+                result.setupSeconds = std::chrono::duration<double>(timing.encoderBegin - startTime).count();
+            
+            if (result.status == 0 && job.redecodePolicy != nullptr && job.redecodePolicy->isEnabled())
+                runSecondPass(result, lock);
+            
+            lock.lock();
+        }
+        
+        // The stream was closed while this window decoded: nobody will read it
+        Stream& stream = streams[(size_t)result.job.stream];
+        --stream.decoding;
+        if (!stream.open)
+        {
+            if (result.state)
+                freeStates[(size_t)result.job.model].push_back(result.state);
+            workAvailable.notify_all();
+            continue;
+        }
+        
+        // Failed jobs are still delivered so the sequence keeps moving
+        stream.completed.emplace(result.job.sequence, std::move(result));
+        
+        // Under the lock: removeStream() can then never race a callback into a stream being torn down
+        if (stream.onResult)
+            stream.onResult();
+    }
+}
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    WhisperDecodeScheduler.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Parallel Whisper decoding over shared models.
+
+    Features:
+    - Models are loaded once; each concurrent decode runs on its own
+      whisper_state (whisper_init_state / whisper_full_with_state)
+    - Window N+1 starts encoding while window N is still decoding, so one
+      long window no longer stalls the next one
+    - Worker count and threads per decode come from the physical core count
+      instead of a hardcoded n_threads
+    - One job queue for every loaded model; each model keeps a small state pool
+    - Results are handed back strictly in submission order (per stream)
+    - Several streams can share the workers and models (MultiStreamEngine):
+      each has its own queue and result order, and a free worker takes the
+      stream whose next window has the least deadline slack left
+    - Optional confidence-targeted second pass (RedecodePolicy) on the worker,
+      so the ordered consumer never waits for it
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "RedecodePolicy.h"
+
+/**
+    Runs whisper_full_with_state() for queued windows on a pool of worker threads.
+    
+    Usage:
+        scheduler.prepare(0, [] { wake.notify(); });   // 0 = from core topology
+        scheduler.addModel(tinyCtx, warmState);        // Models may join while running
+        
+        WhisperDecodeScheduler::Job job;
+        job.model = tier;  job.samples = window;  job.params = wparams;  job.prompt = tokens;
+        scheduler.submit(std::move(job));
+        
+        WhisperDecodeScheduler::Result result;
+        while (scheduler.popCompleted(result))
+        {
+            // read segments with the whisper_full_*_from_state() getters
+            scheduler.release(result);
+        }
+    
+    Multi-stream:
+        scheduler.prepare(0, nullptr);                  // No default stream
+        const int stream = scheduler.addStream([] { wake.notify(); });
+        job.stream = stream;  job.deadline = latestStart;
+        scheduler.popCompleted(result, stream);
+        scheduler.removeStream(stream);
+    
+    Thread Safety:
+    - prepare()/shutdown(): control thread, not concurrently with anything else
+    - addModel(): one thread at a time
+    - addStream()/removeStream(): any thread
+    - submit()/popCompleted()/release(): one consumer thread per stream (its Whisper
+      thread, or the control thread while that thread is stopped)
+    - onResult is called on a worker thread with the scheduler locked; it should
+      only wake the consumer
+*/
+class WhisperDecodeScheduler
+{
+public:
+    struct Job
+    {
+        uint64_t sequence = 0;                  // Assigned by submit() (per stream)
+        int stream = 0;                         // Index returned by addStream() (0 = prepare()'s)
+        int model = 0;                          // Index returned by addModel()
+        std::vector<float> samples;             // 16kHz mono
+        std::vector<whisper_token> prompt;      // Carried tokens (params.prompt_tokens points here)
+        whisper_full_params params {};          // n_threads and prompt pointers are set by the worker
+        int64_t captureEndSample = 0;           // Caller's timeline position, passed through
+        const RedecodePolicy* redecodePolicy = nullptr;     // Second pass on low-confidence sub-windows
+        int redecodeModel = -1;                 // Model for that pass (-1 = this job's; needs the same vocabulary)
+        std::chrono::steady_clock::time_point submitTime;   // Set by submit()
+        
+        // Latest start that still meets the caller's deadline: across streams the
+        // least slack goes first (default: never late, i.e. submission order)
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    };
+    
+    struct Result
+    {
+        Job job;
+        whisper_context* ctx = nullptr;
+        whisper_state* state = nullptr;         // Holds the segments until release()
+        int status = -1;                        // whisper_full_with_state() return code
+        double decodeSeconds = 0.0;             // Wall time of the decode itself
+        double queueSeconds = 0.0;              // submit() -> a worker started the decode
+        double setupSeconds = 0.0;              // Decode start -> encoder begins (mel, prompt); 0 if it never did
+        
+        // With a redecode policy the worker extracts the words (the state then holds the
+        // last sub-window's segments, not the window's)
+        std::vector<WordSegment> words;         // Window-relative, token confidence
+        std::vector<whisper_token> tokens;      // Token id per word
+        RedecodePolicy::Report redecode;        // redecode.ran: words/tokens are valid
+    };
+    
+    WhisperDecodeScheduler() = default;
+    ~WhisperDecodeScheduler();
+    
+    /**
+        Start the workers (models are added with addModel()).
+        
+        @param concurrentDecodes    Decodes in flight at once (0 = from core topology)
+        @param onResult             Called on a worker thread whenever a result of stream 0
+                                    is ready (nullptr = no default stream, see addStream())
+    */
+    void prepare(int concurrentDecodes, std::function<void()> onResult);
+    
+    /**
+        Open a stream on the running scheduler (own queue, own result order).
+        
+        @param onResult     Called on a worker thread whenever a result of the stream is ready
+        @return             Stream index for Job::stream and popCompleted(), or -1 if not running
+    */
+    int addStream(std::function<void()> onResult);
+    
+    /**
+        Close a stream: its queued jobs and unread results are dropped. Blocks
+        until the stream's running decodes finished (they are discarded), so the
+        caller may free what its jobs pointed to. Indices are not reused.
+    */
+    void removeStream(int stream);
+    
+    /**
+        Make a loaded model available to jobs.
+        
+        @param ctx          Model (owned by the caller, must outlive shutdown())
+        @param warmState    Optional state already created for ctx; the scheduler takes ownership
+        @return             Job model index, or -1 if the scheduler is not running
+    */
+    int addModel(whisper_context* ctx, whisper_state* warmState = nullptr);
+    
+    /**
+        Stop the workers, drop queued jobs and free every state.
+    */
+    void shutdown();
+    
+    /**
+        Queue a window for decoding.
+        
+        @return     false if the scheduler is not running or the model index is invalid
+    */
+    bool submit(Job&& job);
+    
+    /**
+        Take the stream's next finished decode (submission order; a later window
+        that finished first waits for the earlier one).
+        
+        @return     false if the next result is not ready yet
+    */
+    bool popCompleted(Result& result, int stream = 0);
+    
+    /**
+        Return the result's state to its model's pool.
+    */
+    void release(Result& result);
+    
+    int getNumSlots() const { return numSlots; }
+    int getNumModels() const;
+    int getThreadsPerDecode() const { return threadsPerDecode; }
+    bool isRunning() const { return running; }
+    
+    /**
+        Decodes worth running side by side on this machine.
+    */
+    static int recommendedConcurrentDecodes();
+    
+    /**
+        Whisper threads for each of the given number of concurrent decodes
+        (physical cores split evenly, hyperthreads left to the rest of the app).
+    */
+    static int recommendedThreadsPerDecode(int concurrentDecodes);
+
+private:
+    struct EncoderTiming
+    {
+        std::chrono::steady_clock::time_point encoderBegin;
+        bool began = false;
+        whisper_encoder_begin_callback chained = nullptr;
+        void* chainedUserData = nullptr;
+    };
+    
+    static bool onEncoderBegin(whisper_context* ctx, whisper_state* state, void* userData);
+    
+    struct Stream
+    {
+        bool open = false;
+        std::deque<Job> pending;
+        std::map<uint64_t, Result> completed;
+        std::function<void()> onResult;
+        uint64_t nextSequence = 0;
+        uint64_t nextToDeliver = 0;
+        int decoding = 0;                       // Taken by a worker, not finished yet
+    };
+    
+    void workerLoop();
+    Stream* takeMostUrgent(Job& job);
+    void runSecondPass(Result& result, std::unique_lock<std::mutex>& lock);
+    whisper_state* acquireState(int model, std::unique_lock<std::mutex>& lock, bool wait = true);
+    
+    std::vector<whisper_context*> models;
+    std::vector<std::vector<whisper_state*>> freeStates;    // Per model
+    std::vector<int> statesCreated;                         // Per model (capped at numSlots)
+    
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;                  // Jobs queued or a state released
+    std::vector<Stream> streams;                            // Index = stream id
+    int numPending = 0;                                     // Jobs queued over every stream
+    
+    int numSlots = 0;
+    int threadsPerDecode = 1;
+    bool running = false;
+    bool stopping = false;
+    
+    WhisperDecodeScheduler(const WhisperDecodeScheduler&) = delete;
+    WhisperDecodeScheduler& operator=(const WhisperDecodeScheduler&) = delete;
+};
@@ -12,6 +12,7 @@
 
 #include "WhisperThread.h"
 #include "CircularBuffer.h"
+#include "WhisperDecodeScheduler.h"
 #include <juce_core/juce_core.h>
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <iostream>
@@ -19,6 +20,7 @@
 WhisperThread::WhisperThread(int sr)
     : sampleRate(sr)
 {
+    resampler.prepare(sampleRate, WHISPER_SAMPLE_RATE, 4096);
 }
 
 WhisperThread::~WhisperThread()
@@ -45,6 +47,7 @@ bool WhisperThread::start(LockFreeQueue<AudioChunk, 64>* audioQ,
     audioQueue = audioQ;
     censorQueue = censorQ;
     circularBuffer = circBuffer;
+    resampler.reset();
     
     // Load Whisper model
     juce::File exeDir = juce::File::getSpecialLocation(juce::File::currentExecutableFile).getParentDirectory();
@@ -80,7 +83,7 @@ bool WhisperThread::start(LockFreeQueue<AudioChunk, 64>* audioQ,
     whisperParams.print_special = false;
     whisperParams.translate = false;
     whisperParams.language = "en";
-    whisperParams.n_threads = 4;
+    whisperParams.n_threads = WhisperDecodeScheduler::recommendedThreadsPerDecode(1);  // Physical cores
     whisperParams.offset_ms = 0;
     whisperParams.no_context = true;
     whisperParams.single_segment = false;
@@ -132,6 +135,7 @@ void WhisperThread::stop()
         return;
     
     running.store(false);
+    audioAvailable.notify();  // Wake the thread if it is waiting for audio
     
     if (processingThread && processingThread->joinable())
     {
@@ -279,9 +283,7 @@ void WhisperThread::run()
                     monoBuffer = audioData;
                 }
                 
-                // Convert to vector for resampling
                 const float* samples = monoBuffer.getReadPointer(0);
-                std::vector<float> monoData(samples, samples + chunk.num_samples);
                 
                 if (chunksProcessed == 0)
                 {
@@ -289,20 +291,19 @@ void WhisperThread::run()
                         juce::String(sampleRate) + " Hz to " + juce::String(WHISPER_SAMPLE_RATE) + " Hz");
                 }
                 
-                // Resample to 16kHz if needed (Whisper requirement)
-                if (sampleRate != WHISPER_SAMPLE_RATE)
+                // Resample to 16kHz (Whisper requirement, pass-through at 16kHz)
+                resampledChunk.resize((size_t)resampler.getMaxOutputSamples(chunk.num_samples));
+                const int resampledSamples = resampler.process(samples, chunk.num_samples,
+                                                               resampledChunk.data(), (int)resampledChunk.size());
+                
+                if (chunksProcessed == 0)
                 {
-                    monoData = resampleTo16kHz(monoData);
-                    
-                    if (chunksProcessed == 0)
-                    {
-                        juce::Logger::writeToLog("[WhisperThread] Resampled to " + 
-                            juce::String(monoData.size()) + " samples");
-                    }
+                    juce::Logger::writeToLog("[WhisperThread] Resampled to " + 
+                        juce::String(resampledSamples) + " samples");
                 }
                 
                 // Accumulate audio
-                accumulatedAudio.insert(accumulatedAudio.end(), monoData.begin(), monoData.end());
+                accumulatedAudio.insert(accumulatedAudio.end(), resampledChunk.begin(), resampledChunk.begin() + resampledSamples);
                 
                 if (chunksProcessed % 10 == 0)
                 {
@@ -390,7 +391,8 @@ void WhisperThread::run()
             }
                 if (!chunkOpt.has_value())
                 {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                    // Queue drained: sleep until the producer signals (timeout re-checks running)
+                    audioAvailable.wait(100);
                 }
             }
             catch (const std::exception& e)
@@ -477,36 +479,3 @@ void WhisperThread::processTranscript(const char* text, int64_t bufferPosition)
         }
     }
 }
-
-std::vector<float> WhisperThread::resampleTo16kHz(const std::vector<float>& input)
-{
-    if (sampleRate == WHISPER_SAMPLE_RATE)
-        return input;
-    
-    // Simple linear interpolation resampling
-    const double ratio = static_cast<double>(WHISPER_SAMPLE_RATE) / static_cast<double>(sampleRate);
-    const size_t outputSize = static_cast<size_t>(input.size() * ratio);
-    
-    std::vector<float> output;
-    output.reserve(outputSize);
-    
-    for (size_t i = 0; i < outputSize; ++i)
-    {
-        const double srcPos = i / ratio;
-        const size_t srcIndex = static_cast<size_t>(srcPos);
-        
-        if (srcIndex + 1 < input.size())
-        {
-            // Linear interpolation
-            const double frac = srcPos - srcIndex;
-            const float sample = input[srcIndex] * (1.0f - frac) + input[srcIndex + 1] * frac;
-            output.push_back(sample);
-        }
-        else if (srcIndex < input.size())
-        {
-            output.push_back(input[srcIndex]);
-        }
-    }
-    
-    return output;
-}
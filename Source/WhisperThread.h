@@ -23,6 +23,8 @@
 #include "Types.h"
 #include "LockFreeQueue.h"
 #include "ProfanityFilter.h"
+#include "Resampler.h"
+#include "WakeSignal.h"
 
 class CircularAudioBuffer;
 
@@ -44,6 +46,13 @@ public:
               CircularAudioBuffer* circularBuffer);
     void stop();
     
+    /**
+        Wake the processing thread after pushing to the audio queue.
+        
+        Thread: Producer (audio callback safe - never blocks)
+    */
+    void notifyAudioAvailable() { audioAvailable.notify(); }
+    
     // Get last error message
     juce::String getLastError() const { return lastError; }
     
@@ -63,9 +72,6 @@ private:
     // Parse Whisper results and detect profanity
     void processTranscript(const char* text, int64_t bufferPosition);
     
-    // Resample audio from native sample rate to 16kHz (Whisper requirement)
-    std::vector<float> resampleTo16kHz(const std::vector<float>& input);
-    
     // Whisper context
     whisper_context* whisperCtx = nullptr;
     whisper_full_params whisperParams;
@@ -80,10 +86,15 @@ private:
     LockFreeQueue<AudioChunk, 64>* audioQueue = nullptr;
     LockFreeQueue<CensorEvent, 256>* censorQueue = nullptr;
     CircularAudioBuffer* circularBuffer = nullptr;
+    WakeSignal audioAvailable;      // Signalled by the producer instead of polling the queue
     
     // Audio processing buffer
     std::vector<float> audioBuffer;
     
+    // Native rate -> 16kHz (Whisper requirement); filter state carries across chunks
+    StreamingResampler resampler;
+    std::vector<float> resampledChunk;
+    
     // Configuration
     int sampleRate;
     juce::String lastError;
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    WhisperTranscript.cpp
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Word extraction from a finished Whisper decode.
+
+  ==============================================================================
+*/
+
+#include "WhisperTranscript.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+std::string WhisperTranscript::cleanText(const std::string& text)
+{
+    std::string cleaned;
+    cleanText(text.c_str(), cleaned);
+    return cleaned;
+}
+
+void WhisperTranscript::cleanText(const char* text, std::string& cleaned)
+{
+    // One pass over the bytes (this runs for every token of every window)
+    cleaned.clear();
+    
+    for (const char* c = text; *c != '\0'; ++c)
+    {
+        // Remove parenthetical content like "( up beat music )", "(laughs)", etc.
+        if (*c == '(')
+        {
+            if (const char* close = std::strchr(c + 1, ')'))
+                c = close;
+            continue;
+        }
+        
+        // Fix Unicode quote characters: ΓÖ¬ (U+00C3 U+0096 U+00AC), left and right single quotes -> '
+        if (std::strncmp(c, "\xC3\x96\xAC", 3) == 0
+            || std::strncmp(c, "\xE2\x80\x98", 3) == 0
+            || std::strncmp(c, "\xE2\x80\x99", 3) == 0)
+        {
+            cleaned += '\'';
+            c += 2;
+            continue;
+        }
+        
+        // Keep: letters, numbers, apostrophes, hyphens, spaces
+        // (curly double quotes and any other punctuation are dropped)
+        if (std::isalnum(static_cast<unsigned char>(*c)) || *c == '\'' || *c == '-' || *c == ' ')
+        {
+            cleaned += *c;
+        }
+    }
+    
+    // Trim whitespace
+    cleaned.erase(0, cleaned.find_first_not_of(' '));
+    cleaned.erase(cleaned.find_last_not_of(' ') + 1);
+}
+
+void WhisperTranscript::extractWords(whisper_context* ctx, whisper_state* state, double windowSeconds,
+                                     std::vector<WordSegment>& words, std::vector<whisper_token>& tokens)
+{
+    const int numSegments = whisper_full_n_segments_from_state(state);
+    std::string word;       // Reused for every token
+    
+    for (int i = 0; i < numSegments; ++i)
+    {
+        // Get segment-level timestamps (these are accurate!)
+        int64_t segmentStart = whisper_full_get_segment_t0_from_state(state, i);
+        int64_t segmentEnd = whisper_full_get_segment_t1_from_state(state, i);
+        double segStartSec = segmentStart * 0.01;  // centiseconds to seconds
+        double segEndSec = segmentEnd * 0.01;
+        
+        // Words go straight into the output; their times are filled in below
+        const size_t firstWord = words.size();
+        int numTokens = whisper_full_n_tokens_from_state(state, i);
+        
+        for (int j = 0; j < numTokens; ++j)
+        {
+            whisper_token_data token = whisper_full_get_token_data_from_state(state, i, j);
+            
+            // Skip special tokens
+            if (token.id >= whisper_token_eot(ctx))
+                continue;
+            
+            cleanText(whisper_full_get_token_text_from_state(ctx, state, i, j), word);
+            
+            if (!word.empty())
+            {
+                // Token probability (drives RedecodePolicy and alignment gating)
+                words.emplace_back(word, 0.0, 0.0, token.p);
+                tokens.push_back(token.id);
+            }
+        }
+        
+        // Distribute words evenly across segment duration
+        const size_t segmentWords = words.size() - firstWord;
+        if (segmentWords > 0)
+        {
+            double segmentDuration = segEndSec - segStartSec;
+            double wordDuration = segmentDuration / segmentWords;
+            
+            for (size_t k = 0; k < segmentWords; ++k)
+            {
+                double wordStart = segStartSec + (k * wordDuration);
+                double wordEnd = wordStart + wordDuration;
+                
+                // Clamp to window range
+                wordStart = std::max(0.0, std::min(windowSeconds, wordStart));
+                wordEnd = std::max(wordStart + 0.05, std::min(windowSeconds, wordEnd));
+                
+                words[firstWord + k].start = wordStart;
+                words[firstWord + k].end = wordEnd;
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    WhisperTranscript.h
+    Created: 11 Dec 2024
+    Author: Explicitly Audio Systems
+
+    Word extraction from a finished Whisper decode.
+
+    Features:
+    - Cleans token text (parenthetical tags, Unicode quotes, punctuation) in
+      one pass, without regex or temporary strings
+    - Segment-level timestamps spread evenly over the segment's words
+      (token timestamps are unreliable on music)
+    - Keeps the token id of every word for the next window's prompt
+    - Word confidence is the token's probability
+    - Shared by the live AudioEngine and the OfflineProcessor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <whisper.h>
+#include <string>
+#include <vector>
+#include "LyricsAlignment.h"  // For WordSegment
+
+/**
+    Turns the segments held by a whisper_state into timed words.
+    
+    Usage:
+        std::vector<WordSegment> words;
+        std::vector<whisper_token> tokens;
+        WhisperTranscript::extractWords(ctx, state, windowSeconds, words, tokens);
+    
+    Thread Safety:
+    - Stateless; the whisper_state must not be decoding concurrently
+*/
+class WhisperTranscript
+{
+public:
+    /**
+        Clean one token's text for matching and display.
+        
+        @param text     Raw token text
+        @return         Letters, digits, apostrophes, hyphens and spaces only (trimmed)
+    */
+    static std::string cleanText(const std::string& text);
+    
+    /**
+        Same as above, into a caller-owned string (no allocation once it has grown).
+        
+        @param text     Raw token text (null-terminated)
+        @param cleaned  Overwritten with the cleaned text
+    */
+    static void cleanText(const char* text, std::string& cleaned);
+    
+    /**
+        Append the decode's words with window-relative times.
+        
+        @param ctx              Model the state was decoded with
+        @param state            Finished decode
+        @param windowSeconds    Window length (word times are clamped to it)
+        @param words            Receives one entry per non-empty cleaned token
+        @param tokens           Receives the token id of each word (same order)
+    */
+    static void extractWords(whisper_context* ctx, whisper_state* state, double windowSeconds,
+                             std::vector<WordSegment>& words, std::vector<whisper_token>& tokens);
+};